@@ -0,0 +1,89 @@
+#include "BenchHarness.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+BenchHarness::BenchHarness(int warmup, int sampleCount, const char *nameFilter)
+{
+    warmupSamples = warmup;
+    samples       = sampleCount;
+    filter        = nameFilter;
+}
+
+bool BenchHarness::selected(const char *name) const
+{
+    return filter == nullptr || strstr(name, filter) != nullptr;
+}
+
+// Nearest-rank percentile of an ascending vector.
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = (size_t) (p / 100.0 * sorted.size() + 0.5);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    if (rank > sorted.size())
+    {
+        rank = sorted.size();
+    }
+    return sorted[rank - 1];
+}
+
+void BenchHarness::record(const char *name, uint32_t opsPerSample, std::vector<double> &nsPerOp)
+{
+    if (nsPerOp.empty())
+    {
+        return;
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    double sum = 0;
+    for (size_t i = 0; i < nsPerOp.size(); i++)
+    {
+        sum += nsPerOp[i];
+    }
+
+    BenchResult result;
+    result.name         = name;
+    result.opsPerSample = opsPerSample;
+    result.minNs        = nsPerOp.front();
+    result.p50Ns        = percentile(nsPerOp, 50);
+    result.p90Ns        = percentile(nsPerOp, 90);
+    result.p99Ns        = percentile(nsPerOp, 99);
+    result.maxNs        = nsPerOp.back();
+    result.meanNs       = sum / nsPerOp.size();
+    results.push_back(result);
+
+    fprintf(stderr, "  %-34s p50 %10.1f ns/op\n", name, result.p50Ns);
+}
+
+void BenchHarness::printTable(FILE *out) const
+{
+    fprintf(out, "%-34s %10s %10s %10s %10s %10s\n", "benchmark (ns/op)", "min", "p50", "p90",
+            "p99", "max");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &r = results[i];
+        fprintf(out, "%-34s %10.1f %10.1f %10.1f %10.1f %10.1f\n", r.name.c_str(), r.minNs,
+                r.p50Ns, r.p90Ns, r.p99Ns, r.maxNs);
+    }
+}
+
+void BenchHarness::printJson(FILE *out) const
+{
+    fprintf(out, "{\n  \"schema\": 1,\n  \"warmup_samples\": %d,\n  \"samples\": %d,\n",
+            warmupSamples, samples);
+    fprintf(out, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &r = results[i];
+        fprintf(out,
+                "    {\"name\": \"%s\", \"ops_per_sample\": %u, \"ns_per_op\": {\"min\": %.2f, "
+                "\"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f, \"mean\": %.2f}}%s\n",
+                r.name.c_str(), (unsigned) r.opsPerSample, r.minNs, r.p50Ns, r.p90Ns, r.p99Ns,
+                r.maxNs, r.meanNs, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
@@ -0,0 +1,82 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Keeps the optimizer from discarding a value that is otherwise unused.
+template <typename T>
+inline void benchKeep(const T &value)
+{
+    __asm__ __volatile__("" : : "g"(&value) : "memory");
+}
+
+struct BenchResult
+{
+    std::string name;
+    uint32_t    opsPerSample;
+    double      minNs;
+    double      p50Ns;
+    double      p90Ns;
+    double      p99Ns;
+    double      maxNs;
+    double      meanNs;
+};
+
+// Minimal microbenchmark runner. Each benchmark runs a fixed number of
+// operations per sample, so results from different runs (and different
+// commits) measure the same work. Warm-up samples are discarded; the rest
+// are reduced to nanoseconds per operation and summarized as percentiles.
+class BenchHarness
+{
+   public:
+    BenchHarness(int warmupSamples, int samples, const char *filter);
+
+    template <typename Body>
+    void run(const char *name, uint32_t opsPerSample, Body body)
+    {
+        if (!selected(name))
+        {
+            return;
+        }
+
+        std::vector<double> nsPerOp;
+        nsPerOp.reserve(samples);
+        uint32_t op = 0;
+        for (int sample = 0; sample < warmupSamples + samples; sample++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < opsPerSample; i++)
+            {
+                body(op++);
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            if (sample >= warmupSamples)
+            {
+                nsPerOp.push_back(std::chrono::duration<double, std::nano>(end - start).count() /
+                                  opsPerSample);
+            }
+        }
+        record(name, opsPerSample, nsPerOp);
+    }
+
+    void printTable(FILE *out) const;
+    // Stable, diffable output; see tools/bench_compare.py.
+    void printJson(FILE *out) const;
+
+   private:
+    int                      warmupSamples;
+    int                      samples;
+    const char              *filter;
+    std::vector<BenchResult> results;
+
+    bool selected(const char *name) const;
+    void record(const char *name, uint32_t opsPerSample, std::vector<double> &nsPerOp);
+};
+
+#endif  // BENCH_HARNESS_H
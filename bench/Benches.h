@@ -0,0 +1,20 @@
+#ifndef BENCHES_H
+#define BENCHES_H
+
+#include <stddef.h>
+
+#include "BenchHarness.h"
+
+// A representative status frame from a Centauri Carbon mid-print, shared so
+// the SdcpCodec and status JSON benches start from the same bytes.
+extern const char   SDCP_STATUS_FRAME[];
+extern const size_t SDCP_STATUS_FRAME_LENGTH;
+
+// Flow tracker, log store / codec, SDCP codec and logging macros (no
+// external deps).
+void registerCoreBenches(BenchHarness &harness);
+// /sensor_status JSON and settings load/save through StatusJson and
+// SettingsJson (ArduinoJson).
+void registerJsonBenches(BenchHarness &harness);
+
+#endif  // BENCHES_H
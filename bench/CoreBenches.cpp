@@ -0,0 +1,443 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/BatchDetector.h"
+#include "../src/EventBus.h"
+#include "../src/FilamentFlowTracker.h"
+#include "../src/FlowReplay.h"
+#include "../src/GzipStream.h"
+#include "../src/LogCategory.h"
+#include "../src/LogCodec.h"
+#include "../src/LogStore.h"
+#include "../src/SdcpCodec.h"
+#include "../src/TimeService.h"
+#include "Benches.h"
+
+// Same formatting and storage path as Logger::logf(level, category, ...),
+// without the serial port and sinks.
+struct BenchLogger
+{
+    LogStore store;
+
+    void logf(log_level_t level, log_category_t category, const char *format, ...)
+    {
+        char    buffer[512];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (length < 0)
+        {
+            return;
+        }
+        if ((size_t) length >= sizeof(buffer))
+        {
+            length = sizeof(buffer) - 1;
+        }
+        store.append(timeService.nowUs(), buffer, (size_t) length, level, category);
+    }
+};
+
+static BenchLogger benchLogger;
+#define logger benchLogger
+
+volatile uint32_t logCategoryMask = LOG_CATEGORY_BIT(LOG_CAT_GENERAL);
+
+static void benchTracker(BenchHarness &harness)
+{
+    static FilamentFlowTracker tracker;
+
+    // One SDCP delta plus the sensor pulses that match it, then the
+    // outstanding/deficit evaluation the loop runs every pass.
+    harness.run("tracker.add_consume", 10000,
+                [](uint32_t op)
+                {
+                    unsigned long now = op * 250UL;
+                    tracker.addExpected(1.5f, now, 0);
+                    tracker.addActual(0.75f);
+                    tracker.addActual(0.70f);
+                    float outstanding = tracker.outstanding(now, 0);
+                    benchKeep(tracker.deficitSatisfied(outstanding, now, 8.4f, 1500));
+                });
+
+    // Expected keeps outrunning actual, so the chunk ring stays full.
+    harness.run("tracker.add_consume_backlog", 10000,
+                [](uint32_t op)
+                {
+                    unsigned long now = op * 250UL;
+                    tracker.addExpected(1.5f, now, 0);
+                    tracker.addActual(0.5f);
+                    benchKeep(tracker.outstanding(now, 0));
+                });
+}
+
+// One op is one telemetry sample for MAX_CONFIGS configurations: an SDCP
+// delta, a sensor pulse and an evaluation. Configurations per second is
+// MAX_CONFIGS * 1e9 / ns-per-op.
+static void benchBatchDetector(BenchHarness &harness)
+{
+    static BatchDetector       batch;
+    static FilamentFlowTracker trackers[BatchDetector::MAX_CONFIGS];
+    static float               mmPerPulse[BatchDetector::MAX_CONFIGS];
+
+    for (size_t i = 0; i < BatchDetector::MAX_CONFIGS; i++)
+    {
+        mmPerPulse[i] = 1.2f + 0.02f * (float) i;
+        batch.addConfig(4.0f + 0.25f * (float) i, 1000 + 50 * (uint32_t) i, mmPerPulse[i]);
+    }
+
+    harness.run("batch_detector.delta_x32", 10000,
+                [](uint32_t op)
+                {
+                    batch.setMode(BATCH_MODE_DELTA);
+                    batch.onTelemetry(false, 0, true, 1.5f);
+                    batch.onPulse();
+                    benchKeep(batch.evaluate(op * 250U));
+                });
+
+    harness.run("batch_detector.tracker_x32", 10000,
+                [](uint32_t op)
+                {
+                    batch.setMode(BATCH_MODE_TRACKER);
+                    batch.onTelemetry(false, 0, true, 1.5f);
+                    batch.onPulse();
+                    benchKeep(batch.evaluate(op * 250U));
+                });
+
+    // The same work as tracker_x32 with one FilamentFlowTracker per
+    // configuration, for comparison.
+    harness.run("batch_detector.scalar_tracker_x32", 10000,
+                [](uint32_t op)
+                {
+                    unsigned long now       = op * 250UL;
+                    size_t        triggered = 0;
+                    for (size_t i = 0; i < BatchDetector::MAX_CONFIGS; i++)
+                    {
+                        trackers[i].addExpected(1.5f, now, 0);
+                        trackers[i].addActual(mmPerPulse[i]);
+                        float outstanding = trackers[i].outstanding(now, 0);
+                        triggered += trackers[i].deficitSatisfied(outstanding, now,
+                                                                  4.0f + 0.25f * (float) i,
+                                                                  1000 + 50 * i);
+                    }
+                    benchKeep(triggered);
+                });
+}
+
+// Two hours of 250 ms telemetry for six configurations, with a jam every
+// ten minutes. seek_keyframed goes through a one-minute index; seek_full
+// replays from the start to the same random targets.
+static void benchFlowReplay(BenchHarness &harness)
+{
+    static const size_t     STEPS       = 2 * 3600 * 4;
+    static const size_t     MAX_RECORDS = STEPS * 3;
+    static const size_t     KEYFRAMES   = 2 * 60 + 1;
+    static trace_record_t   records[MAX_RECORDS];
+    static trace_keyframe_t keyframes[KEYFRAMES];
+    static uint8_t          states[KEYFRAMES * BatchDetector::MAX_STATE_SIZE];
+    static BatchDetector    detector;
+    static FlowReplay       replay(detector);
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        detector.addConfig(4.0f + 2.0f * (float) i, 1000 + 500 * (uint32_t) i, 1.5f);
+    }
+
+    size_t count = 0;
+    float  total = 0.0f;
+    for (size_t step = 0; step < STEPS; step++)
+    {
+        uint32_t now = (uint32_t) step * 250;
+        total += 0.75f;
+        records[count++] = {now, TRACE_TELEMETRY, TRACE_HAS_TOTAL | TRACE_HAS_DELTA, 0,
+                            total, 0.75f};
+        if ((step % 2400) < 2300 && (step % 2) == 0)
+        {
+            records[count++] = {now, TRACE_PULSE, 0, 0, 0.0f, 0.0f};
+        }
+        records[count++] = {now, TRACE_EVALUATE, 0, 0, 0.0f, 0.0f};
+    }
+
+    replay.attach(records, count);
+    replay.attachIndex(keyframes, KEYFRAMES, states, sizeof(states));
+    replay.buildIndex(60000);
+
+    harness.run("flow_replay.seek_keyframed", 2000,
+                [](uint32_t op)
+                {
+                    replay.seek((op * 2654435761U) % (STEPS * 250));
+                    benchKeep(replay.position());
+                });
+
+    harness.run("flow_replay.seek_full", 20,
+                [](uint32_t op)
+                {
+                    replay.rewind();
+                    replay.runUntil((op * 2654435761U) % (STEPS * 250));
+                    benchKeep(replay.position());
+                });
+}
+
+static void benchLogging(BenchHarness &harness)
+{
+    static uint8_t storage[64 * 1024];
+    benchLogger.store.attach(storage, sizeof(storage));
+
+    logCategoryMask = LOG_CATEGORY_BIT(LOG_CAT_GENERAL) | LOG_CATEGORY_BIT(LOG_CAT_FLOW);
+    harness.run("logger.logf_flow_debug", 2000,
+                [](uint32_t op)
+                {
+                    LOGD(LOG_CAT_FLOW,
+                         "Flow debug: cycle tele=%d expected=%.2fmm actual=%.2fmm "
+                         "deficit=%.2fmm threshold=%.2fmm ratio=%.2f pulses=%lu",
+                         1, op * 0.37f, op * 0.35f, 0.02f * (op % 100), 8.4f,
+                         0.002f * (op % 100), (unsigned long) op);
+                });
+
+    logCategoryMask = LOG_CATEGORY_BIT(LOG_CAT_GENERAL);
+    harness.run("logger.logf_category_disabled", 1000000,
+                [](uint32_t op)
+                {
+                    LOGD(LOG_CAT_FLOW,
+                         "Flow debug: cycle tele=%d expected=%.2fmm actual=%.2fmm "
+                         "deficit=%.2fmm threshold=%.2fmm ratio=%.2f pulses=%lu",
+                         1, op * 0.37f, op * 0.35f, 0.02f * (op % 100), 8.4f,
+                         0.002f * (op % 100), (unsigned long) op);
+                });
+}
+
+// 64 KB of flow debug lines with a few warnings mixed in. query_warnings
+// only decompresses the blocks whose header says they hold one; walk_all
+// is the unfiltered export for comparison.
+static void benchLogQuery(BenchHarness &harness)
+{
+    static uint8_t  storage[64 * 1024];
+    static LogStore store;
+    store.attach(storage, sizeof(storage));
+
+    char message[160];
+    for (uint32_t i = 0; i < 4000; i++)
+    {
+        bool warning = (i % 500) == 0;
+        int  n       = snprintf(message, sizeof(message),
+                                warning ? "Pause condition met: deficit=%lu.%02lumm"
+                                        : "Flow debug: cycle tele=1 expected=%lu.%02lumm",
+                                (unsigned long) (i * 7), (unsigned long) (i % 100));
+        store.append(i, message, (size_t) n, warning ? LOG_LEVEL_WARN : LOG_LEVEL_DEBUG,
+                     warning ? LOG_CAT_GENERAL : LOG_CAT_FLOW);
+    }
+
+    static LogStore::Filter warnings;
+    warnings.maxLevel = LOG_LEVEL_WARN;
+    warnings.text     = "pause condition";
+
+    harness.run("log_store.query_warnings", 200,
+                [](uint32_t)
+                {
+                    uint32_t matched = 0;
+                    store.visitFrom(
+                        0, warnings,
+                        [](const LogStore::Record &, void *context)
+                        {
+                            (*static_cast<uint32_t *>(context))++;
+                            return true;
+                        },
+                        &matched);
+                    benchKeep(matched);
+                });
+
+    harness.run("log_store.walk_all", 200,
+                [](uint32_t)
+                {
+                    uint32_t bytes = 0;
+                    store.forEach(
+                        [](const LogStore::Record &record, void *context)
+                        {
+                            *static_cast<uint32_t *>(context) += record.length;
+                            return true;
+                        },
+                        &bytes);
+                    benchKeep(bytes);
+                });
+}
+
+static void benchCodec(BenchHarness &harness)
+{
+    static uint8_t  block[LogStore::BLOCK_SIZE];
+    static uint8_t  packed[LogStore::BLOCK_SIZE];
+    static uint8_t  unpacked[LogStore::BLOCK_SIZE];
+    static uint16_t hashTable[LogCodec::HASH_ENTRIES];
+    static size_t   blockLength = 0;
+    static size_t   packedLength = 0;
+
+    while (blockLength + 128 < sizeof(block))
+    {
+        blockLength += snprintf((char *) block + blockLength, sizeof(block) - blockLength,
+                                "Flow debug: cycle tele=1 expected=%.2fmm actual=%.2fmm "
+                                "pulses=%u\n",
+                                blockLength * 0.11f, blockLength * 0.1f, (unsigned) blockLength);
+    }
+    packedLength = LogCodec::compress(block, blockLength, packed, sizeof(packed), hashTable);
+
+    harness.run("log_codec.compress_block", 50,
+                [](uint32_t)
+                {
+                    benchKeep(LogCodec::compress(block, blockLength, packed, sizeof(packed),
+                                                 hashTable));
+                });
+    harness.run("log_codec.decompress_block", 200,
+                [](uint32_t)
+                {
+                    benchKeep(LogCodec::decompress(packed, packedLength, unpacked,
+                                                   sizeof(unpacked)));
+                });
+}
+
+const char SDCP_STATUS_FRAME[] =
+    "{\"Status\":{\"CurrentStatus\":[1],\"PreviousStatus\":0,\"PrintScreen\":0,"
+    "\"ReleaseFilm\":0,\"TempOfUVLED\":0,\"TimeLapseStatus\":0,\"TempOfNozzle\":220.12,"
+    "\"TempTargetNozzle\":220,\"TempOfHotbed\":60.03,\"TempTargetHotbed\":60,"
+    "\"TempOfBox\":31.5,\"TempTargetBox\":0,\"CurrenCoord\":\"112.40,98.21,12.60\","
+    "\"CurrentFanSpeed\":{\"ModelFan\":100,\"ModeFan\":100,\"AuxiliaryFan\":0,"
+    "\"BoxFan\":0},\"ZOffset\":0.0,\"LightStatus\":{\"SecondLight\":1},"
+    "\"PrintInfo\":{\"Status\":13,\"CurrentLayer\":63,\"TotalLayer\":240,"
+    "\"CurrentTicks\":2710,\"TotalTicks\":9840,\"Filename\":\"benchy_pla.gcode\","
+    "\"TaskId\":\"5d1e2f0a9b7c4e21a3f6d8b0c2e4f6a8\",\"PrintSpeedPct\":100,"
+    "\"Progress\":27,\"TotalExtrusion\":1834.52,\"CurrentExtrusion\":1.47}},"
+    "\"MainboardID\":\"a1b2c3d4e5f60718\",\"TimeStamp\":1700000123,"
+    "\"Topic\":\"sdcp/status/a1b2c3d4e5f60718\"}";
+const size_t SDCP_STATUS_FRAME_LENGTH = sizeof(SDCP_STATUS_FRAME) - 1;
+
+static void benchSdcp(BenchHarness &harness)
+{
+    static sdcp_message_t message;
+    static sdcp_message_t pause;
+    static char           frame[512];
+    static size_t         ackLength = 0;
+
+    pause.kind                       = SDCP_MESSAGE_REQUEST;
+    pause.hasTimeStamp               = true;
+    pause.request.cmd                = SDCP_COMMAND_PAUSE_PRINT;
+    pause.request.printStatus        = SDCP_PRINT_STATUS_PRINTING;
+    pause.request.machineStatusCount = 1;
+    pause.request.machineStatuses[0] = SDCP_MACHINE_STATUS_PRINTING;
+    strcpy(pause.mainboardId, "a1b2c3d4e5f60718");
+
+    message.kind         = SDCP_MESSAGE_ACK;
+    message.hasTimeStamp = true;
+    message.timeStamp    = 1700000123;
+    message.ack.cmd      = SDCP_COMMAND_PAUSE_PRINT;
+    strcpy(message.ack.requestId, "5d1e2f0a9b7c4e21a3f6d8b0c2e4f6a8");
+    strcpy(message.mainboardId, pause.mainboardId);
+    ackLength = SdcpCodec::encode(message, frame, sizeof(frame));
+
+    harness.run("sdcp.decode_status", 5000,
+                [](uint32_t)
+                {
+                    SdcpCodec::decode(SDCP_STATUS_FRAME, SDCP_STATUS_FRAME_LENGTH, message);
+                    benchKeep(message.status.printInfo.currentLayer);
+                });
+    harness.run("sdcp.decode_ack", 10000,
+                [](uint32_t)
+                {
+                    SdcpCodec::decode(frame, ackLength, message);
+                    benchKeep(message.ack.cmd);
+                });
+    harness.run("sdcp.build_pause_command", 10000,
+                [](uint32_t op)
+                {
+                    // Same request ID shape as ElegooCC::sendCommand
+                    snprintf(pause.request.requestId, sizeof(pause.request.requestId),
+                             "%08lx%08lx%08lx%08lx", (unsigned long) op, 0x5d1e2f0aUL,
+                             0x9b7c4e21UL, 0xa3f6d8b0UL);
+                    pause.timeStamp = 1700000123.0 + op;
+                    benchKeep(SdcpCodec::encode(pause, frame + 256, 256));
+                });
+}
+
+static void countEvent(const event_t &event, void *context)
+{
+    *static_cast<uint32_t *>(context) += event.data.pulse.count;
+}
+
+static void benchEventBus(BenchHarness &harness)
+{
+    static EventBus bus;
+    static uint32_t delivered = 0;
+    // Three subscribers, two of which want pulses: the firmware's typical fan-out.
+    bus.subscribe(EVENT_BIT(EVENT_PULSE) | EVENT_BIT(EVENT_FRAME), countEvent, &delivered);
+    bus.subscribe(EVENT_BIT(EVENT_PULSE), countEvent, &delivered);
+    bus.subscribe(EVENT_BIT(EVENT_SETTINGS_CHANGED), countEvent, &delivered);
+
+    harness.run("event_bus.publish_dispatch", 10000,
+                [](uint32_t op)
+                {
+                    event_t event          = {};
+                    event.type             = EVENT_PULSE;
+                    event.timestampUs      = op;
+                    event.data.pulse.count = 1;
+                    bus.publish(event);
+                    bus.dispatch();
+                    benchKeep(delivered);
+                });
+}
+
+static void benchTimeService(BenchHarness &harness)
+{
+    timeService.setEpoch(1700000000000000ULL, timeService.nowUs());
+
+    // Taken once per sensor pulse and per log line.
+    harness.run("time_service.now_us", 100000,
+                [](uint32_t op)
+                {
+                    (void) op;
+                    benchKeep(timeService.nowUs());
+                });
+
+    // Paid per record on export.
+    harness.run("time_service.to_epoch_seconds", 100000,
+                [](uint32_t op) { benchKeep(timeService.toEpochSeconds(op * 1000ULL)); });
+}
+
+static void benchGzip(BenchHarness &harness)
+{
+    static uint8_t text[GzipStream::MAX_INPUT * 8];
+    static uint8_t chunk[1436];  // one TCP segment, as AsyncWebServer asks for
+    static size_t  textLength = 0;
+
+    while (textLength + 128 < sizeof(text))
+    {
+        textLength += snprintf((char *) text + textLength, sizeof(text) - textLength,
+                               "{\"timestamp\":%u,\"message\":\"Flow debug: cycle tele=1 "
+                               "expected=%.2fmm actual=%.2fmm\"},\n",
+                               (unsigned) (1700000000 + textLength), textLength * 0.11f,
+                               textLength * 0.1f);
+    }
+
+    // One op = one 1 KB chunk through a long-lived stream, so ns/op is the
+    // CPU cost per KB on the wire path.
+    harness.run("gzip.compress_1k_chunk", 200,
+                [](uint32_t op)
+                {
+                    static GzipStream gzip;
+                    size_t            offset = (op % 8) * GzipStream::MAX_INPUT;
+                    memcpy(gzip.inputBuffer(), text + offset, GzipStream::MAX_INPUT);
+                    benchKeep(gzip.compress(GzipStream::MAX_INPUT, false, chunk, sizeof(chunk)));
+                });
+}
+
+void registerCoreBenches(BenchHarness &harness)
+{
+    benchTracker(harness);
+    benchBatchDetector(harness);
+    benchFlowReplay(harness);
+    benchLogging(harness);
+    benchLogQuery(harness);
+    benchCodec(harness);
+    benchSdcp(harness);
+    benchEventBus(harness);
+    benchTimeService(harness);
+    benchGzip(harness);
+}
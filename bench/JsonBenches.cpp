@@ -0,0 +1,103 @@
+// JSON-heavy paths, timed through the same functions the firmware calls:
+// StatusJson for /sensor_status and SettingsJson for /user_settings.json.
+// Only the file store differs: a std::string stands in for LittleFS.
+
+#include <ArduinoJson.h>
+#include <string.h>
+
+#include <string>
+
+#include "../src/SdcpCodec.h"
+#include "../src/SettingsJson.h"
+#include "../src/StatusJson.h"
+#include "Benches.h"
+
+// What ElegooCC::getCurrentInformation() would report after the frame
+static void printerInfoFromFrame(printer_info_t &info)
+{
+    sdcp_message_t message;
+    SdcpCodec::decode(SDCP_STATUS_FRAME, SDCP_STATUS_FRAME_LENGTH, message);
+    const sdcp_print_info_t &printInfo = message.status.printInfo;
+
+    memset(&info, 0, sizeof(info));
+    strncpy(info.mainboardID, message.mainboardId, sizeof(info.mainboardID) - 1);
+    info.printStatus          = (sdcp_print_status_t) printInfo.status;
+    info.currentLayer         = printInfo.currentLayer;
+    info.totalLayer           = printInfo.totalLayer;
+    info.progress             = printInfo.progress;
+    info.currentTicks         = printInfo.currentTicks;
+    info.totalTicks           = printInfo.totalTicks;
+    info.PrintSpeedPct        = printInfo.printSpeedPct;
+    info.isWebsocketConnected = true;
+    info.isPrinting           = true;
+    info.currentZ             = message.status.coord[2];
+    info.expectedFilamentMM   = printInfo.totalExtrusion;
+    info.actualFilamentMM     = printInfo.totalExtrusion - 2.1f;
+    info.lastExpectedDeltaMM  = printInfo.currentExtrusion;
+    info.telemetryAvailable   = true;
+    info.currentDeficitMm     = 2.1f;
+    info.deficitThresholdMm   = 8.4f;
+    info.deficitRatio         = 0.25f;
+    info.jobNumber            = 1;
+}
+
+static std::string settingsFile;
+
+// SettingsManager::save() without the file write
+static size_t saveSettings(const user_settings &settings, const DetectionProfiles &profiles)
+{
+    DynamicJsonDocument doc(4096);
+    settingsToJson(settings, profiles, doc, true);
+    settingsFile.clear();
+    return serializeJson(doc, settingsFile);
+}
+
+// SettingsManager::load() without the file read
+static bool loadSettings(user_settings &settings, DetectionProfiles &profiles)
+{
+    DynamicJsonDocument doc(4096);
+    if (deserializeJson(doc, settingsFile))
+    {
+        return false;
+    }
+    settingsFromJson(doc, settings);
+    detectionProfilesFromJson(doc["detection_profiles"].as<JsonArrayConst>(), settings, profiles);
+    return true;
+}
+
+void registerJsonBenches(BenchHarness &harness)
+{
+    static printer_info_t    info;
+    static std::string       payload;
+    static user_settings     settings;
+    static DetectionProfiles profiles;
+
+    printerInfoFromFrame(info);
+    harness.run("http.serialize_sensor_status", 1000,
+                [](uint32_t op)
+                {
+                    DynamicJsonDocument doc(672);
+                    info.movementPulseCount = op;
+                    sensorStatusToJson(info, 1000, 1000, "default", doc);
+                    payload.clear();
+                    benchKeep(serializeJson(doc, payload));
+                });
+
+    settingsDefaults(settings);
+    settings.ssid        = "workshop-2g";
+    settings.passwd      = "correct horse battery staple";
+    settings.elegooip    = "192.168.1.42";
+    settings.syslog_host = "192.168.1.10";
+    profiles.add("TPU", "tpu|tpe|95a", 20.0f, 4000, 1.4f);
+    profiles.add("PETG", "petg", 10.0f, 2000, 1.5f);
+    saveSettings(settings, profiles);
+
+    harness.run("settings.save", 500,
+                [](uint32_t op)
+                {
+                    settings.start_print_timeout = 10000 + (int) (op & 1);
+                    benchKeep(saveSettings(settings, profiles));
+                });
+    harness.run("settings.load", 500,
+                [](uint32_t) { benchKeep(loadSettings(settings, profiles)); });
+}
@@ -0,0 +1,78 @@
+// Native microbenchmarks for the firmware's hot paths.
+//
+//   pio run -e native_bench -t exec                  # table on stderr, JSON on stdout
+//   .pio/build/native_bench/program --json out.json  # JSON to a file
+//   .pio/build/native_bench/program --filter tracker --samples 200
+//
+// Compare two runs with tools/bench_compare.py.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BenchHarness.h"
+#include "Benches.h"
+
+int main(int argc, char **argv)
+{
+    int         warmup   = 5;
+    int         samples  = 50;
+    const char *filter   = nullptr;
+    const char *jsonPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+        {
+            samples = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            warmup = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--samples N] [--warmup N] [--filter SUBSTR] [--json FILE]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (samples < 1)
+    {
+        samples = 1;
+    }
+
+    BenchHarness harness(warmup, samples, filter);
+    fprintf(stderr, "Running benchmarks (%d warm-up + %d samples each)\n", warmup, samples);
+    registerCoreBenches(harness);
+    registerJsonBenches(harness);
+
+    fprintf(stderr, "\n");
+    harness.printTable(stderr);
+
+    FILE *out = stdout;
+    if (jsonPath != nullptr)
+    {
+        out = fopen(jsonPath, "w");
+        if (out == nullptr)
+        {
+            perror(jsonPath);
+            return 1;
+        }
+    }
+    harness.printJson(out);
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
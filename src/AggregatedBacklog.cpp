@@ -0,0 +1,144 @@
+#include "AggregatedBacklog.h"
+
+AggregatedBacklog::AggregatedBacklog()
+{
+    clear();
+    lastTotalMm = 0.0f;
+}
+
+void AggregatedBacklog::clear()
+{
+    outstandingMm  = 0.0f;
+    pulseDeductMm  = 0.0f;
+    baselineMm     = 0.0f;
+    baselineValid  = false;
+    deficitActive  = false;
+    deficitStartMs = 0;
+}
+
+void AggregatedBacklog::rebase(float totalMm)
+{
+    baselineMm    = totalMm;
+    baselineValid = true;
+    pulseDeductMm = 0.0f;
+    outstandingMm = 0.0f;
+    lastTotalMm   = totalMm;
+}
+
+void AggregatedBacklog::resume(batch_mode_t mode, float expectedMm)
+{
+    if (mode == BATCH_MODE_TOTAL)
+    {
+        rebase(expectedMm);
+    }
+    else if (mode == BATCH_MODE_DELTA)
+    {
+        clear();
+    }
+}
+
+void AggregatedBacklog::onTelemetry(batch_mode_t mode, bool hasTotal, float totalMm,
+                                    bool hasDelta, float deltaMm)
+{
+    if (hasTotal)
+    {
+        lastTotalMm = totalMm < 0 ? 0 : totalMm;
+    }
+
+    if (hasDelta && mode == BATCH_MODE_DELTA)
+    {
+        if (deltaMm > 0)
+        {
+            outstandingMm += deltaMm;
+        }
+        else if (deltaMm < 0)
+        {
+            outstandingMm += deltaMm;
+            if (outstandingMm < 0.0f)
+            {
+                outstandingMm = 0.0f;
+            }
+        }
+    }
+
+    if (mode == BATCH_MODE_TOTAL && hasTotal)
+    {
+        if (!baselineValid)
+        {
+            baselineMm    = totalMm;
+            baselineValid = true;
+        }
+        recalculateTotal();
+    }
+}
+
+void AggregatedBacklog::onPulse(batch_mode_t mode, float mmPerPulse)
+{
+    if (mode == BATCH_MODE_TOTAL)
+    {
+        pulseDeductMm += mmPerPulse;
+        recalculateTotal();
+    }
+    else if (mode == BATCH_MODE_DELTA)
+    {
+        outstandingMm -= mmPerPulse;
+        if (outstandingMm < 0.0f)
+        {
+            outstandingMm = 0.0f;
+        }
+    }
+}
+
+void AggregatedBacklog::recalculateTotal()
+{
+    if (!baselineValid)
+    {
+        return;
+    }
+    float requested = lastTotalMm - baselineMm;
+    if (requested < 0.0f)
+    {
+        requested = 0.0f;
+    }
+    if (pulseDeductMm > requested)
+    {
+        pulseDeductMm = requested;
+    }
+    outstandingMm = requested - pulseDeductMm;
+    if (outstandingMm < 0.0f)
+    {
+        outstandingMm = 0.0f;
+    }
+}
+
+bool AggregatedBacklog::deficitSatisfied(float outstanding, unsigned long now, float threshold,
+                                         unsigned long holdWindowMs)
+{
+    if (threshold <= 0 || holdWindowMs == 0)
+    {
+        deficitActive  = false;
+        deficitStartMs = 0;
+        return false;
+    }
+
+    if (outstanding >= threshold)
+    {
+        if (!deficitActive)
+        {
+            deficitActive  = true;
+            deficitStartMs = now;
+        }
+    }
+    else
+    {
+        deficitActive  = false;
+        deficitStartMs = 0;
+    }
+
+    if (!deficitActive)
+    {
+        return false;
+    }
+
+    return (now - deficitStartMs) >= holdWindowMs;
+}
@@ -0,0 +1,59 @@
+#ifndef AGGREGATED_BACKLOG_H
+#define AGGREGATED_BACKLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Which backlog the deficit is measured on; matches the live settings
+typedef enum
+{
+    BATCH_MODE_TRACKER = 0,  // FilamentFlowTracker chunks (the default)
+    BATCH_MODE_DELTA   = 1,  // use_total_extrusion_deficit: summed SDCP deltas
+    BATCH_MODE_TOTAL   = 2,  // use_total_extrusion_backlog: TotalExtrusion - pulses
+} batch_mode_t;
+
+// The deficit backlog and hold timer used in the delta and total modes.
+//
+// Delta mode adds every SDCP CurrentExtrusion and subtracts a pulse's worth
+// of filament per sensor pulse, never going below zero. Total mode takes
+// TotalExtrusion since a baseline minus the pulses seen since then. In
+// tracker mode the backlog is left alone (FilamentFlowTracker is used), but
+// the last TotalExtrusion is still recorded for a later switch.
+//
+// ElegooCC runs one of these on the live stream; BatchDetector must give
+// the same results lane by lane, which its tests check against this class.
+class AggregatedBacklog
+{
+   public:
+    AggregatedBacklog();
+
+    // New print: drops the backlog, baseline and hold timer
+    void clear();
+    // Restarts the total backlog from `totalMm`, keeping the hold timer
+    void rebase(float totalMm);
+    // After a jam pause is resumed
+    void resume(batch_mode_t mode, float expectedMm);
+
+    void onTelemetry(batch_mode_t mode, bool hasTotal, float totalMm, bool hasDelta,
+                     float deltaMm);
+    void onPulse(batch_mode_t mode, float mmPerPulse);
+
+    float outstanding() const { return outstandingMm; }
+    // Like FilamentFlowTracker::deficitSatisfied(): true once `outstanding`
+    // has stayed at or above `threshold` for `holdWindowMs`
+    bool deficitSatisfied(float outstanding, unsigned long now, float threshold,
+                          unsigned long holdWindowMs);
+
+   private:
+    float         outstandingMm;
+    float         pulseDeductMm;  // total mode
+    float         baselineMm;
+    bool          baselineValid;
+    float         lastTotalMm;
+    bool          deficitActive;
+    unsigned long deficitStartMs;
+
+    void recalculateTotal();
+};
+
+#endif  // AGGREGATED_BACKLOG_H
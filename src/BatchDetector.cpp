@@ -0,0 +1,414 @@
+#include "BatchDetector.h"
+
+#include <string.h>
+
+#include "DetectionProfile.h"
+
+BatchDetector::BatchDetector()
+{
+    mode = BATCH_MODE_TRACKER;
+    clearConfigs();
+    reset();
+}
+
+void BatchDetector::setMode(batch_mode_t newMode)
+{
+    if (newMode != mode)
+    {
+        mode = newMode;
+        reset();
+    }
+}
+
+void BatchDetector::clearConfigs()
+{
+    configCount = 0;
+    for (size_t i = 0; i < MAX_CONFIGS; i++)
+    {
+        // Unused lanes in the last block run along but never trigger
+        threshold[i]  = 0.0f;
+        holdMs[i]     = 0;
+        mmPerPulse[i] = 0.0f;
+    }
+}
+
+int BatchDetector::addConfig(float thresholdMm, uint32_t hold, float mmPerPulseValue)
+{
+    if (configCount >= MAX_CONFIGS)
+    {
+        return -1;
+    }
+    size_t index = configCount++;
+    threshold[index]  = thresholdMm;
+    holdMs[index]     = hold;
+    // Same fallback as ElegooCC::recordMovementPulse()
+    mmPerPulse[index] =
+        mmPerPulseValue > 0.0f ? mmPerPulseValue : DETECTION_PROFILE_DEFAULT_MM_PER_PULSE;
+    resetLane(index);
+    firstSatisfied[index] = 0;
+    return (int) index;
+}
+
+bool BatchDetector::setConfig(size_t index, float thresholdMm, uint32_t hold,
+                              float mmPerPulseValue)
+{
+    if (index >= configCount)
+    {
+        return false;
+    }
+    threshold[index]  = thresholdMm;
+    holdMs[index]     = hold;
+    mmPerPulse[index] =
+        mmPerPulseValue > 0.0f ? mmPerPulseValue : DETECTION_PROFILE_DEFAULT_MM_PER_PULSE;
+    return true;
+}
+
+void BatchDetector::resetLane(size_t index)
+{
+    outstanding[index]  = 0.0f;
+    pulseDeduct[index]  = 0.0f;
+    deficit[index]      = 0.0f;
+    active[index]       = 0;
+    startMs[index]      = 0;
+    satisfiedNow[index] = 0;
+    chunkHead[index]    = 0;
+    chunkCount[index]   = 0;
+}
+
+void BatchDetector::reset()
+{
+    for (size_t i = 0; i < MAX_CONFIGS; i++)
+    {
+        resetLane(i);
+        firstSatisfied[i] = 0;
+    }
+    memset(chunkRemaining, 0, sizeof(chunkRemaining));
+    lastTotalMm   = 0.0f;
+    baselineMm    = 0.0f;
+    baselineValid = false;
+}
+
+void BatchDetector::resume(float expectedMm)
+{
+    const size_t n = configCount;
+    for (size_t i = 0; i < n; i++)
+    {
+        outstanding[i] = 0.0f;
+        pulseDeduct[i] = 0.0f;
+        chunkHead[i]   = 0;
+        chunkCount[i]  = 0;
+    }
+    if (mode == BATCH_MODE_TOTAL)
+    {
+        // AggregatedBacklog::rebase() leaves the hold timer alone
+        baselineMm    = expectedMm;
+        baselineValid = true;
+        lastTotalMm   = expectedMm;
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        active[i]  = 0;
+        startMs[i] = 0;
+    }
+    baselineMm    = 0.0f;
+    baselineValid = false;
+}
+
+void BatchDetector::onTelemetry(bool hasTotal, float totalMm, bool hasDelta, float deltaMm)
+{
+    const size_t lanes = paddedLanes();
+
+    if (hasTotal)
+    {
+        lastTotalMm = totalMm < 0 ? 0 : totalMm;
+    }
+
+    if (hasDelta && deltaMm != 0.0f)
+    {
+        if (mode == BATCH_MODE_DELTA)
+        {
+            for (size_t base = 0; base < lanes; base += LANE_BLOCK)
+            {
+                float *out = outstanding + base;
+                for (size_t i = 0; i < LANE_BLOCK; i++)
+                {
+                    float value = out[i] + deltaMm;
+                    out[i]      = value < 0.0f ? 0.0f : value;
+                }
+            }
+        }
+        else if (mode == BATCH_MODE_TRACKER)
+        {
+            if (deltaMm > 0)
+            {
+                trackerAdd(deltaMm);
+            }
+            else
+            {
+                float amount = -deltaMm;
+                trackerConsume(&amount, false);
+            }
+        }
+    }
+
+    if (mode == BATCH_MODE_TOTAL && hasTotal)
+    {
+        if (!baselineValid)
+        {
+            baselineMm    = totalMm;
+            baselineValid = true;
+        }
+        recalculateTotal();
+    }
+}
+
+void BatchDetector::onPulse()
+{
+    const size_t lanes = paddedLanes();
+
+    if (mode == BATCH_MODE_TOTAL)
+    {
+        for (size_t base = 0; base < lanes; base += LANE_BLOCK)
+        {
+            float       *deduct = pulseDeduct + base;
+            const float *mm     = mmPerPulse + base;
+            for (size_t i = 0; i < LANE_BLOCK; i++)
+            {
+                deduct[i] += mm[i];
+            }
+        }
+        recalculateTotal();
+    }
+    else if (mode == BATCH_MODE_DELTA)
+    {
+        for (size_t base = 0; base < lanes; base += LANE_BLOCK)
+        {
+            float       *out = outstanding + base;
+            const float *mm  = mmPerPulse + base;
+            for (size_t i = 0; i < LANE_BLOCK; i++)
+            {
+                float value = out[i] - mm[i];
+                out[i]      = value < 0.0f ? 0.0f : value;
+            }
+        }
+    }
+    else
+    {
+        trackerConsume(mmPerPulse, true);
+    }
+}
+
+size_t BatchDetector::evaluate(uint32_t nowMs)
+{
+    const size_t lanes     = paddedLanes();
+    uint32_t     triggered = 0;
+    for (size_t base = 0; base < lanes; base += LANE_BLOCK)
+    {
+        const float    *out   = outstanding + base;
+        const float    *limit = threshold + base;
+        const uint32_t *hold  = holdMs + base;
+        uint32_t       *on    = active + base;
+        uint32_t       *since = startMs + base;
+        uint32_t       *sat   = satisfiedNow + base;
+        uint32_t       *first = firstSatisfied + base;
+        float          *value = deficit + base;
+        for (size_t i = 0; i < LANE_BLOCK; i++)
+        {
+            float    d     = out[i] < 0.0f ? 0.0f : out[i];
+            uint32_t armed = (limit[i] > 0) & (hold[i] != 0);
+            uint32_t over  = armed & (d >= limit[i]);
+            uint32_t start = on[i] ? since[i] : nowMs;
+            since[i]       = over ? start : 0;
+            on[i]          = over;
+            uint32_t held  = over & ((nowMs - since[i]) >= hold[i]);
+
+            value[i] = d;
+            sat[i]   = held;
+            first[i] = (held && first[i] == 0) ? nowMs : first[i];
+            triggered += held;
+        }
+    }
+    return triggered;
+}
+
+// FilamentFlowTracker::addExpected() on every lane
+void BatchDetector::trackerAdd(float amount)
+{
+    const size_t n = configCount;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (chunkCount[i] >= MAX_CHUNKS)
+        {
+            // Oldest chunk coalesced away without reducing the total
+            chunkHead[i] = (chunkHead[i] + 1) % MAX_CHUNKS;
+            chunkCount[i]--;
+        }
+        chunkRemaining[(chunkHead[i] + chunkCount[i]) % MAX_CHUNKS][i] = amount;
+        chunkCount[i]++;
+        outstanding[i] += amount;
+    }
+}
+
+// FilamentFlowTracker::addActual() on every lane, with one shared amount or
+// one per lane
+void BatchDetector::trackerConsume(const float *amount, bool perLane)
+{
+    const size_t n = configCount;
+    for (size_t i = 0; i < n; i++)
+    {
+        float remaining = perLane ? amount[i] : amount[0];
+        while (remaining > 0 && chunkCount[i] > 0)
+        {
+            float &chunk = chunkRemaining[chunkHead[i]][i];
+            float  use   = chunk < remaining ? chunk : remaining;
+            chunk -= use;
+            remaining -= use;
+            outstanding[i] -= use;
+
+            if (chunk <= 0.0001f)
+            {
+                chunkHead[i] = (chunkHead[i] + 1) % MAX_CHUNKS;
+                chunkCount[i]--;
+            }
+        }
+        if (outstanding[i] < 0)
+        {
+            outstanding[i] = 0;
+        }
+    }
+}
+
+// AggregatedBacklog::recalculateTotal() on every lane
+void BatchDetector::recalculateTotal()
+{
+    if (!baselineValid)
+    {
+        return;
+    }
+    float requested = lastTotalMm - baselineMm;
+    if (requested < 0.0f)
+    {
+        requested = 0.0f;
+    }
+    const size_t lanes = paddedLanes();
+    for (size_t base = 0; base < lanes; base += LANE_BLOCK)
+    {
+        float *deduct = pulseDeduct + base;
+        float *out    = outstanding + base;
+        for (size_t i = 0; i < LANE_BLOCK; i++)
+        {
+            float capped = deduct[i] > requested ? requested : deduct[i];
+            float value  = requested - capped;
+            deduct[i]    = capped;
+            out[i]       = value < 0.0f ? 0.0f : value;
+        }
+    }
+}
+
+// Layout: magic, mode, lane count, the shared TOTAL-mode fields, then per
+// lane its LANE_FIELDS 32-bit fields, chunk count and chunks oldest first.
+size_t BatchDetector::saveState(uint8_t *out, size_t capacity) const
+{
+    size_t n    = configCount;
+    size_t size = STATE_HEADER_SIZE;
+    for (size_t i = 0; i < n; i++)
+    {
+        size += LANE_FIELDS * 4 + 1 + chunkCount[i] * sizeof(float);
+    }
+    if (out == nullptr || capacity < size)
+    {
+        return 0;
+    }
+
+    uint8_t *p        = out;
+    uint32_t magic    = STATE_MAGIC;
+    uint8_t  header[] = {(uint8_t) mode, (uint8_t) n, (uint8_t) (baselineValid ? 1 : 0), 0};
+    memcpy(p, &magic, 4);
+    memcpy(p + 4, header, 4);
+    memcpy(p + 8, &lastTotalMm, 4);
+    memcpy(p + 12, &baselineMm, 4);
+    memset(p + 16, 0, 4);
+    p += STATE_HEADER_SIZE;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const void *fields[LANE_FIELDS] = {&threshold[i],   &holdMs[i],      &mmPerPulse[i],
+                                           &outstanding[i], &pulseDeduct[i], &deficit[i],
+                                           &active[i],      &startMs[i],     &satisfiedNow[i],
+                                           &firstSatisfied[i]};
+        for (size_t f = 0; f < LANE_FIELDS; f++)
+        {
+            memcpy(p, fields[f], 4);
+            p += 4;
+        }
+        *p++ = (uint8_t) chunkCount[i];
+        for (uint32_t c = 0; c < chunkCount[i]; c++)
+        {
+            memcpy(p, &chunkRemaining[(chunkHead[i] + c) % MAX_CHUNKS][i], sizeof(float));
+            p += sizeof(float);
+        }
+    }
+    return size;
+}
+
+bool BatchDetector::loadState(const uint8_t *data, size_t length)
+{
+    if (data == nullptr || length < STATE_HEADER_SIZE)
+    {
+        return false;
+    }
+    uint32_t magic;
+    memcpy(&magic, data, 4);
+    size_t n = data[5];
+    if (magic != STATE_MAGIC || data[4] > BATCH_MODE_TOTAL || n > MAX_CONFIGS)
+    {
+        return false;
+    }
+
+    // Check the lane records fit before touching any state
+    size_t offset = STATE_HEADER_SIZE;
+    for (size_t i = 0; i < n; i++)
+    {
+        offset += LANE_FIELDS * 4;
+        if (offset >= length || data[offset] > MAX_CHUNKS)
+        {
+            return false;
+        }
+        offset += 1 + data[offset] * sizeof(float);
+    }
+    if (offset != length)
+    {
+        return false;
+    }
+
+    clearConfigs();
+    reset();
+    mode          = (batch_mode_t) data[4];
+    configCount   = n;
+    baselineValid = data[6] != 0;
+    memcpy(&lastTotalMm, data + 8, 4);
+    memcpy(&baselineMm, data + 12, 4);
+
+    const uint8_t *p = data + STATE_HEADER_SIZE;
+    for (size_t i = 0; i < n; i++)
+    {
+        void *fields[LANE_FIELDS] = {&threshold[i],   &holdMs[i],      &mmPerPulse[i],
+                                     &outstanding[i], &pulseDeduct[i], &deficit[i],
+                                     &active[i],      &startMs[i],     &satisfiedNow[i],
+                                     &firstSatisfied[i]};
+        for (size_t f = 0; f < LANE_FIELDS; f++)
+        {
+            memcpy(fields[f], p, 4);
+            p += 4;
+        }
+        chunkCount[i] = *p++;
+        chunkHead[i]  = 0;
+        for (uint32_t c = 0; c < chunkCount[i]; c++)
+        {
+            memcpy(&chunkRemaining[c][i], p, sizeof(float));
+            p += sizeof(float);
+        }
+    }
+    return true;
+}
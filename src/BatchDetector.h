@@ -0,0 +1,116 @@
+#ifndef BATCH_DETECTOR_H
+#define BATCH_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "AggregatedBacklog.h"
+#include "FilamentFlowTracker.h"
+
+// Runs up to MAX_CONFIGS jam detector configurations over one telemetry
+// stream.
+//
+// Each configuration is a threshold, hold window and mm per pulse, i.e. the
+// parameters of a detection profile. State is kept as one array per field,
+// so a telemetry sample, a pulse or an evaluation is a flat loop over
+// configurations with no branches in its body. Lanes are walked in blocks of
+// LANE_BLOCK with a fixed inner trip count, which GCC vectorizes at -O2 on
+// the host; on the device they are plain loops, still cheaper than N
+// separate detectors.
+//
+// Results are bit-identical to running FilamentFlowTracker, or
+// AggregatedBacklog, once per configuration: every lane does
+// the same float operations in the same order. The one loop that can't be
+// flat is consuming tracker chunks, since each lane's chunk ring drains at
+// its own rate.
+//
+// Times are 32-bit milliseconds, like millis() on the device.
+class BatchDetector
+{
+   public:
+    static const size_t   MAX_CONFIGS       = 32;
+    static const size_t   LANE_BLOCK        = 8;
+    static const size_t   MAX_CHUNKS        = FilamentFlowTracker::MAX_CHUNKS;
+    static const uint32_t STATE_MAGIC       = 0x31534442;  // "BDS1"
+    static const size_t   STATE_HEADER_SIZE = 20;
+    static const size_t   LANE_FIELDS       = 10;
+    // Upper bound for saveState(): every lane with a full chunk ring
+    static const size_t   MAX_STATE_SIZE =
+        STATE_HEADER_SIZE + MAX_CONFIGS * (LANE_FIELDS * 4 + 1 + MAX_CHUNKS * sizeof(float));
+
+    BatchDetector();
+
+    // Changing the mode resets tracking
+    void         setMode(batch_mode_t newMode);
+    batch_mode_t getMode() const { return mode; }
+
+    void clearConfigs();
+    // Returns the configuration's index, or -1 when full
+    int    addConfig(float thresholdMm, uint32_t holdMs, float mmPerPulse);
+    // Changes a configuration's parameters from now on, keeping its backlog
+    // and hold timer
+    bool   setConfig(size_t index, float thresholdMm, uint32_t holdMs, float mmPerPulse);
+    size_t count() const { return configCount; }
+
+    // New print: clears every backlog and hold timer
+    void reset();
+    // Resume after a jam pause; mirrors the live resume handling, which
+    // re-bases the total backlog at the current TotalExtrusion
+    void resume(float expectedMm);
+
+    // One SDCP status: TotalExtrusion and/or CurrentExtrusion
+    void onTelemetry(bool hasTotal, float totalMm, bool hasDelta, float deltaMm);
+    // One movement sensor pulse
+    void onPulse();
+    // Updates every hold timer at `nowMs`; returns how many configurations
+    // would pause the print now
+    size_t evaluate(uint32_t nowMs);
+
+    float    thresholdMm(size_t index) const { return threshold[index]; }
+    uint32_t holdWindowMs(size_t index) const { return holdMs[index]; }
+    float    deficitMm(size_t index) const { return deficit[index]; }
+    bool     satisfied(size_t index) const { return satisfiedNow[index] != 0; }
+    // First time the hold was satisfied since reset(); 0 if never
+    uint32_t firstSatisfiedMs(size_t index) const { return firstSatisfied[index]; }
+
+    // Serializes the mode, configurations and all tracking state (host byte
+    // order). Restoring it and feeding the same input continues bit-exactly.
+    // Returns the bytes written, or 0 if `capacity` is too small.
+    size_t saveState(uint8_t *out, size_t capacity) const;
+    // Returns false, leaving the detector untouched, if the data is invalid
+    bool   loadState(const uint8_t *data, size_t length);
+
+   private:
+    batch_mode_t mode;
+    size_t       configCount;
+
+    // Per configuration
+    float    threshold[MAX_CONFIGS];
+    uint32_t holdMs[MAX_CONFIGS];
+    float    mmPerPulse[MAX_CONFIGS];
+    float    outstanding[MAX_CONFIGS];
+    float    pulseDeduct[MAX_CONFIGS];  // BATCH_MODE_TOTAL
+    float    deficit[MAX_CONFIGS];      // as of the last evaluate()
+    uint32_t active[MAX_CONFIGS];
+    uint32_t startMs[MAX_CONFIGS];
+    uint32_t satisfiedNow[MAX_CONFIGS];
+    uint32_t firstSatisfied[MAX_CONFIGS];
+
+    // BATCH_MODE_TRACKER: one chunk ring per configuration, slot-major
+    float    chunkRemaining[MAX_CHUNKS][MAX_CONFIGS];
+    uint32_t chunkHead[MAX_CONFIGS];
+    uint32_t chunkCount[MAX_CONFIGS];
+
+    // BATCH_MODE_TOTAL: shared by every configuration
+    float lastTotalMm;
+    float baselineMm;
+    bool  baselineValid;
+
+    size_t paddedLanes() const { return (configCount + LANE_BLOCK - 1) & ~(LANE_BLOCK - 1); }
+    void   resetLane(size_t index);
+    void trackerAdd(float amount);
+    void trackerConsume(const float *amount, bool perLane);
+    void recalculateTotal();
+};
+
+#endif  // BATCH_DETECTOR_H
@@ -0,0 +1,67 @@
+#include "BootTimeline.h"
+
+#include "Logger.h"
+
+BootTimeline &BootTimeline::getInstance()
+{
+    static BootTimeline instance;
+    return instance;
+}
+
+BootTimeline::BootTimeline()
+{
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        phaseUs[i] = 0;
+        reached[i] = false;
+    }
+}
+
+void BootTimeline::mark(boot_phase_t phase)
+{
+    if (phase < 0 || phase >= BOOT_PHASE_COUNT || reached[phase])
+    {
+        return;
+    }
+
+    phaseUs[phase] = micros();
+    reached[phase] = true;
+    logger.logf("Boot phase %s reached at %lums", phaseName(phase), phaseUs[phase] / 1000);
+}
+
+bool BootTimeline::hasReached(boot_phase_t phase) const
+{
+    return phase >= 0 && phase < BOOT_PHASE_COUNT && reached[phase];
+}
+
+unsigned long BootTimeline::getPhaseUs(boot_phase_t phase) const
+{
+    return hasReached(phase) ? phaseUs[phase] : 0;
+}
+
+const char *BootTimeline::phaseName(boot_phase_t phase)
+{
+    switch (phase)
+    {
+        case BOOT_PHASE_SETUP_START:
+            return "setup_start";
+        case BOOT_PHASE_FILESYSTEM_MOUNTED:
+            return "filesystem_mounted";
+        case BOOT_PHASE_SETTINGS_LOADED:
+            return "settings_loaded";
+        case BOOT_PHASE_WIFI_CONNECTED:
+            return "wifi_connected";
+        case BOOT_PHASE_ELEGOO_STARTED:
+            return "elegoo_started";
+        case BOOT_PHASE_WEBSERVER_STARTED:
+            return "webserver_started";
+        case BOOT_PHASE_WEBSOCKET_CONNECTED:
+            return "websocket_connected";
+        case BOOT_PHASE_PROTECTING:
+            return "protecting";
+        case BOOT_PHASE_NTP_SYNCED:
+            return "ntp_synced";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <Arduino.h>
+
+// Boot phases in the order they are normally reached. "Protecting" is the
+// first point at which jam detection is evaluating live printer status.
+typedef enum
+{
+    BOOT_PHASE_SETUP_START         = 0,
+    BOOT_PHASE_FILESYSTEM_MOUNTED  = 1,
+    BOOT_PHASE_SETTINGS_LOADED     = 2,
+    BOOT_PHASE_WIFI_CONNECTED      = 3,
+    BOOT_PHASE_ELEGOO_STARTED      = 4,
+    BOOT_PHASE_WEBSERVER_STARTED   = 5,
+    BOOT_PHASE_WEBSOCKET_CONNECTED = 6,
+    BOOT_PHASE_PROTECTING          = 7,
+    BOOT_PHASE_NTP_SYNCED          = 8,
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+class BootTimeline
+{
+   private:
+    unsigned long phaseUs[BOOT_PHASE_COUNT];
+    bool          reached[BOOT_PHASE_COUNT];
+
+    BootTimeline();
+
+    BootTimeline(const BootTimeline &)            = delete;
+    BootTimeline &operator=(const BootTimeline &) = delete;
+
+   public:
+    static BootTimeline &getInstance();
+
+    // Records the first time a phase is reached; later calls are ignored.
+    void mark(boot_phase_t phase);
+
+    bool          hasReached(boot_phase_t phase) const;
+    unsigned long getPhaseUs(boot_phase_t phase) const;
+
+    static const char *phaseName(boot_phase_t phase);
+};
+
+#define bootTimeline BootTimeline::getInstance()
+
+#endif  // BOOT_TIMELINE_H
@@ -0,0 +1,140 @@
+#include "DetectionProfile.h"
+
+#include <ctype.h>
+#include <string.h>
+
+const char *DetectionProfiles::DEFAULT_NAME = "default";
+
+static void copyField(char *dest, const char *src, size_t size)
+{
+    strncpy(dest, src != nullptr ? src : "", size - 1);
+    dest[size - 1] = '\0';
+}
+
+DetectionProfiles::DetectionProfiles()
+{
+    memset(&defaultProfile, 0, sizeof(defaultProfile));
+    memset(profiles, 0, sizeof(profiles));
+    copyField(defaultProfile.name, DEFAULT_NAME, sizeof(defaultProfile.name));
+    memset(pendingName, 0, sizeof(pendingName));
+    profileCount  = 0;
+    activeIndex   = DEFAULT_INDEX;
+    setDefault(8.4f, 1500, DETECTION_PROFILE_DEFAULT_MM_PER_PULSE);
+}
+
+void DetectionProfiles::setDefault(float expectedDeficitMm, uint32_t flowWindowMs,
+                                   float mmPerPulse)
+{
+    defaultProfile.expectedDeficitMm = expectedDeficitMm;
+    defaultProfile.flowWindowMs      = flowWindowMs;
+    defaultProfile.mmPerPulse        = mmPerPulse;
+}
+
+void DetectionProfiles::clear()
+{
+    // Remember the active name before the slots are overwritten.
+    copyField(pendingName, active().name, sizeof(pendingName));
+    activeIndex  = DEFAULT_INDEX;
+    profileCount = 0;
+}
+
+bool DetectionProfiles::add(const char *name, const char *match, float expectedDeficitMm,
+                            uint32_t flowWindowMs, float mmPerPulse)
+{
+    if (profileCount >= MAX_PROFILES || name == nullptr || name[0] == '\0' ||
+        strcmp(name, DEFAULT_NAME) == 0 || find(name) != NOT_FOUND)
+    {
+        return false;
+    }
+
+    detection_profile_t &profile = profiles[profileCount];
+    copyField(profile.name, name, sizeof(profile.name));
+    copyField(profile.match, match, sizeof(profile.match));
+    profile.expectedDeficitMm = expectedDeficitMm;
+    profile.flowWindowMs      = flowWindowMs;
+    profile.mmPerPulse        = mmPerPulse;
+
+    if (strcmp(profile.name, pendingName) == 0)
+    {
+        activeIndex = (int) profileCount;
+    }
+    profileCount++;
+    return true;
+}
+
+int DetectionProfiles::find(const char *name) const
+{
+    if (name == nullptr || name[0] == '\0' || strcmp(name, DEFAULT_NAME) == 0)
+    {
+        return DEFAULT_INDEX;
+    }
+    for (size_t i = 0; i < profileCount; i++)
+    {
+        if (strcmp(profiles[i].name, name) == 0)
+        {
+            return (int) i;
+        }
+    }
+    return NOT_FOUND;
+}
+
+bool DetectionProfiles::selectByName(const char *name)
+{
+    int index = find(name);
+    if (index == NOT_FOUND)
+    {
+        return false;
+    }
+    activeIndex = index;
+    return true;
+}
+
+bool DetectionProfiles::matches(const char *pattern, const char *filename)
+{
+    size_t filenameLength = strlen(filename);
+    while (*pattern != '\0')
+    {
+        const char *end = strchr(pattern, '|');
+        size_t      length = end != nullptr ? (size_t) (end - pattern) : strlen(pattern);
+        for (size_t start = 0; length > 0 && start + length <= filenameLength; start++)
+        {
+            size_t i = 0;
+            while (i < length &&
+                   tolower((unsigned char) filename[start + i]) ==
+                       tolower((unsigned char) pattern[i]))
+            {
+                i++;
+            }
+            if (i == length)
+            {
+                return true;
+            }
+        }
+        if (end == nullptr)
+        {
+            break;
+        }
+        pattern = end + 1;
+    }
+    return false;
+}
+
+const detection_profile_t &DetectionProfiles::selectForJob(const char *forcedName,
+                                                           const char *filename)
+{
+    if (forcedName != nullptr && forcedName[0] != '\0' && selectByName(forcedName))
+    {
+        return active();
+    }
+
+    activeIndex = DEFAULT_INDEX;
+    for (size_t i = 0; filename != nullptr && i < profileCount; i++)
+    {
+        if (matches(profiles[i].match, filename))
+        {
+            activeIndex = (int) i;
+            break;
+        }
+    }
+    return active();
+}
@@ -0,0 +1,75 @@
+#ifndef DETECTION_PROFILE_H
+#define DETECTION_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DETECTION_PROFILE_NAME_LEN 16
+#define DETECTION_PROFILE_MATCH_LEN 32
+// Sensor travel per movement edge when nothing else is configured, and the
+// fallback wherever a profile's value is not positive.
+#define DETECTION_PROFILE_DEFAULT_MM_PER_PULSE 1.5f
+
+// Jam detection parameters that depend on the filament being printed.
+typedef struct
+{
+    char     name[DETECTION_PROFILE_NAME_LEN];
+    // '|'-separated, case-insensitive substrings of the job filename,
+    // e.g. "tpu|tpe|95a". Empty never matches.
+    char     match[DETECTION_PROFILE_MATCH_LEN];
+    float    expectedDeficitMm;
+    uint32_t flowWindowMs;
+    float    mmPerPulse;
+} detection_profile_t;
+
+// The built-in "default" profile (the global settings) plus up to
+// MAX_PROFILES named ones. Exactly one is active, kept as an index so a
+// copy of the table is self-contained.
+class DetectionProfiles
+{
+   public:
+    static const size_t MAX_PROFILES = 6;
+    static const char  *DEFAULT_NAME;
+
+    DetectionProfiles();
+
+    void setDefault(float expectedDeficitMm, uint32_t flowWindowMs, float mmPerPulse);
+    // clear() followed by add() replaces the named profiles. If the active
+    // profile is added back under the same name it becomes active again,
+    // otherwise the default is active.
+    void   clear();
+    bool   add(const char *name, const char *match, float expectedDeficitMm,
+               uint32_t flowWindowMs, float mmPerPulse);
+    size_t count() const { return profileCount; }
+    const detection_profile_t &get(size_t index) const { return profiles[index]; }
+
+    const detection_profile_t &active() const
+    {
+        return activeIndex == DEFAULT_INDEX ? defaultProfile : profiles[activeIndex];
+    }
+    const detection_profile_t &defaults() const { return defaultProfile; }
+
+    // Selects by name ("default" or empty selects the default profile).
+    // Returns false and keeps the current profile if the name is unknown.
+    bool selectByName(const char *name);
+    // Picks the profile for a new job: the forced name if one is given and
+    // exists, otherwise the first profile whose pattern matches the
+    // filename, otherwise the default.
+    const detection_profile_t &selectForJob(const char *forcedName, const char *filename);
+
+   private:
+    static const int DEFAULT_INDEX = -1;
+    static const int NOT_FOUND     = -2;
+
+    detection_profile_t        defaultProfile;
+    detection_profile_t        profiles[MAX_PROFILES];
+    size_t                     profileCount;
+    int                        activeIndex;  // into profiles[], or DEFAULT_INDEX
+    char                       pendingName[DETECTION_PROFILE_NAME_LEN];  // see clear()
+
+    // DEFAULT_INDEX for the default, NOT_FOUND if there is no such profile
+    int                        find(const char *name) const;
+    static bool                matches(const char *pattern, const char *filename);
+};
+
+#endif  // DETECTION_PROFILE_H
@@ -1,22 +1,22 @@
 #include "ElegooCC.h"
 
-#include <ArduinoJson.h>
 #include <WiFi.h>
 #include <WiFiUdp.h>
 
+#include "BootTimeline.h"
 #include "FilamentFlowTracker.h"
 #include "Logger.h"
+#include "PulseCapture.h"
 #include "SettingsManager.h"
+#include "TimeService.h"
 
 #define ACK_TIMEOUT_MS 5000
 constexpr float        DEFAULT_FILAMENT_DEFICIT_THRESHOLD_MM = 8.4f;
 constexpr unsigned int EXPECTED_FILAMENT_SAMPLE_MS           = 250;
 constexpr unsigned int EXPECTED_FILAMENT_STALE_MS            = 1000;
-constexpr unsigned int SDCP_LOSS_TIMEOUT_MS                  = 10000;
 constexpr unsigned int PAUSE_REARM_DELAY_MS                  = 3000;
-static const char*     TOTAL_EXTRUSION_HEX_KEY       = "54 6F 74 61 6C 45 78 74 72 75 73 69 6F 6E 00";
-static const char*     CURRENT_EXTRUSION_HEX_KEY =
-    "43 75 72 72 65 6E 74 45 78 74 72 75 73 69 6F 6E 00";
+constexpr unsigned int SDCP_LOSS_TIMEOUT_MS                  = 10000;
+constexpr unsigned int DIAGNOSTICS_PUBLISH_MS                = 250;
 // UDP discovery port used by the Elegoo SDCP implementation (matches the
 // Home Assistant integration and printer firmware).
 static const uint16_t  SDCP_DISCOVERY_PORT = 3000;
@@ -54,6 +54,12 @@ ElegooCC::ElegooCC()
     lastSuccessfulTelemetryMs  = 0;
     lastTelemetryReceiveMs     = 0;
     lastStatusReceiveMs          = 0;
+    frameAgeMs                   = 0;
+    frameStaleMs                 = 0;
+    rttRequestId                 = "";
+    rttSentMs                    = 0;
+    hasReceivedStatus            = false;
+    sdcpLost                     = false;
     telemetryAvailableLastStatus = false;
     currentDeficitMm             = 0.0f;
     deficitThresholdMm           = 0.0f;
@@ -63,16 +69,19 @@ ElegooCC::ElegooCC()
     lastSummaryLogMs             = 0;
     jamPauseRequested            = false;
     trackingFrozen               = false;
-    aggregatedOutstandingMm      = 0.0f;
-    aggregatedDeficitActive      = false;
-    aggregatedDeficitStartMs     = 0;
+    trackedJob                   = 0;
     aggregatedDeltaPositiveSum   = 0.0f;
     aggregatedDeltaNetSum        = 0.0f;
-    aggregatedTotalBaselineMm    = 0.0f;
-    aggregatedPulseDeductMm      = 0.0f;
-    aggregatedTotalBaselineValid = false;
-    lastTotalExtrusionValue      = 0.0f;
+    lastPulseUs                  = 0;
+    expectedAtLastPulseMm        = 0.0f;
+    hasLastPulse                 = false;
+    deficitCrossedUs             = 0;
+    deficitCrossed               = false;
+    holdSatisfiedUs              = 0;
     flowTracker.reset();
+    memset(shadowNames, 0, sizeof(shadowNames));
+    memset(&shadowSnapshot, 0, sizeof(shadowSnapshot));
+    memset(&detectionProfile, 0, sizeof(detectionProfile));
 
     waitingForAck       = false;
     pendingAckCommand   = -1;
@@ -80,6 +89,9 @@ ElegooCC::ElegooCC()
     ackWaitStartTime    = 0;
     lastPauseRequestMs  = 0;
 
+    stateMux                 = portMUX_INITIALIZER_UNLOCKED;
+    lastDiagnosticsPublishMs = 0;
+
     // TODO: send a UDP broadcast, M99999 on Port 30000, maybe using AsyncUDP.h and listen for the
     // result. this will give us the printer IP address.
 
@@ -95,6 +107,34 @@ void ElegooCC::setup()
     {
         connect();
     }
+    // Reconnect the websocket when a new printer IP is saved
+    eventBus.subscribe(
+        EVENT_BIT(EVENT_SETTINGS_CHANGED),
+        [](const event_t &event, void *context)
+        {
+            ElegooCC *self = static_cast<ElegooCC *>(context);
+            if ((event.data.settingsChanged.changed & SETTINGS_CHANGED_PRINTER_IP) &&
+                !settingsManager.isAPMode())
+            {
+                self->connect();
+            }
+            // Pick again for the current job, so clearing a forced profile
+            // or editing the active one applies without waiting for the next
+            if (event.data.settingsChanged.changed & SETTINGS_CHANGED_DETECTION)
+            {
+                self->selectDetectionProfile(
+                    self->jobTracker.hasJob() ? self->jobTracker.current().filename : "");
+            }
+        },
+        this);
+    detectionProfile = settingsManager.getActiveProfile();
+}
+
+void ElegooCC::publishEvent(event_type_t type, event_t &event)
+{
+    event.type        = type;
+    event.timestampUs = timeService.nowUs();
+    eventBus.publish(event);
 }
 
 void ElegooCC::webSocketEvent(WStype_t type, uint8_t *payload, size_t length)
@@ -108,32 +148,55 @@ void ElegooCC::webSocketEvent(WStype_t type, uint8_t *payload, size_t length)
             pendingAckCommand   = -1;
             pendingAckRequestId = "";
             ackWaitStartTime    = 0;
+            {
+                event_t event        = {};
+                event.data.link.link = EVENT_LINK_PRINTER;
+                publishEvent(EVENT_LINK_DOWN, event);
+            }
             break;
         case WStype_CONNECTED:
+        {
             logger.log("Connected to Carbon Centauri");
+            bootTimeline.mark(BOOT_PHASE_WEBSOCKET_CONNECTED);
+            linkLiveness.reset(millis());
             sendCommand(SDCP_COMMAND_STATUS);
-
+            event_t event        = {};
+            event.data.link.link = EVENT_LINK_PRINTER;
+            publishEvent(EVENT_LINK_UP, event);
             break;
+        }
         case WStype_TEXT:
         {
-            StaticJsonDocument<2048> doc;
-            DeserializationError     error = deserializeJson(doc, payload);
-
-            if (error)
+            sdcp_message_t message;
+            if (!SdcpCodec::decode((const char *) payload, length, message))
             {
-                logger.logf("JSON parsing failed: %s", error.c_str());
+                logger.logf("SDCP message parsing failed (%u bytes)", (unsigned) length);
                 return;
             }
 
-            // Check if this is a command acknowledgment response
-            if (doc.containsKey("Id") && doc.containsKey("Data"))
-            {
-                handleCommandResponse(doc);
-            }
-            // Check if this is a status response
-            else if (doc.containsKey("Status"))
+            switch (message.kind)
             {
-                handleStatus(doc);
+                case SDCP_MESSAGE_ACK:
+                    handleCommandResponse(message);
+                    break;
+                case SDCP_MESSAGE_STATUS:
+                    // Only status frames show the printer is still reporting;
+                    // pongs and acks can keep flowing without them.
+                    linkLiveness.onFrame(millis());
+                    if (sdcpLost)
+                    {
+                        logger.log("Printer status frames are back");
+                        sdcpLost = false;
+                    }
+                    handleStatus(message);
+                    break;
+                case SDCP_MESSAGE_ATTRIBUTES:
+                    logger.logf("Printer attributes: %s firmware %s",
+                                message.attributes.machineName,
+                                message.attributes.firmwareVersion);
+                    break;
+                default:
+                    break;
             }
         }
         break;
@@ -152,95 +215,109 @@ void ElegooCC::webSocketEvent(WStype_t type, uint8_t *payload, size_t length)
     }
 }
 
-void ElegooCC::handleCommandResponse(JsonDocument &doc)
+void ElegooCC::handleCommandResponse(const sdcp_message_t &message)
 {
-    String     id   = doc["Id"];
-    JsonObject data = doc["Data"];
+    const sdcp_ack_t &ack = message.ack;
 
-    if (data.containsKey("Cmd") && data.containsKey("RequestID"))
-    {
-        int    cmd         = data["Cmd"];
-        int    ack         = data["Data"]["Ack"];
-        String requestId   = data["RequestID"];
-        String mainboardId = data["MainboardID"];
+    logger.logf("Command %d acknowledged (Ack: %d) for request %s", (int) ack.cmd, (int) ack.ack,
+                ack.requestId);
 
-        logger.logf("Command %d acknowledged (Ack: %d) for request %s", cmd, ack,
-                    requestId.c_str());
+    if (!rttRequestId.isEmpty() && rttRequestId == ack.requestId)
+    {
+        printerClock.addRoundTrip(millis() - rttSentMs);
+        rttRequestId = "";
+    }
+    samplePrinterClock(message.hasTimeStamp ? message.timeStamp : 0.0);
 
-        // Check if this is the acknowledgment we're waiting for
-        if (waitingForAck && cmd == pendingAckCommand && requestId == pendingAckRequestId)
+    // Check if this is the acknowledgment we're waiting for
+    if (waitingForAck && ack.cmd == pendingAckCommand && pendingAckRequestId == ack.requestId)
+    {
+        logger.logf("Received expected acknowledgment for command %d", (int) ack.cmd);
+        if (ack.cmd == SDCP_COMMAND_PAUSE_PRINT)
         {
-            logger.logf("Received expected acknowledgment for command %d", cmd);
-            waitingForAck       = false;
-            pendingAckCommand   = -1;
-            pendingAckRequestId = "";
-            ackWaitStartTime    = 0;
+            pauseTracer.mark(PAUSE_STAGE_ACK_RECEIVED, micros());
         }
+        waitingForAck       = false;
+        pendingAckCommand   = -1;
+        pendingAckRequestId = "";
+        ackWaitStartTime    = 0;
+    }
 
-        // Store mainboard ID if we don't have it yet
-        if (mainboardID.isEmpty() && !mainboardId.isEmpty())
-        {
-            mainboardID = mainboardId;
-            logger.logf("Stored MainboardID: %s", mainboardID.c_str());
-        }
+    // Store mainboard ID if we don't have it yet
+    if (mainboardID.isEmpty() && message.mainboardId[0] != '\0')
+    {
+        mainboardID = message.mainboardId;
+        logger.logf("Stored MainboardID: %s", mainboardID.c_str());
     }
 }
 
-void ElegooCC::handleStatus(JsonDocument &doc)
+void ElegooCC::handleStatus(const sdcp_message_t &message)
 {
-    JsonObject status      = doc["Status"];
-    String     mainboardId = doc["MainboardID"];
+    const sdcp_status_t &status = message.status;
     unsigned long statusTimestamp = millis();
     lastStatusReceiveMs          = statusTimestamp;
-    bool useTotalBacklogMode = settingsManager.getUseTotalExtrusionBacklog();
-    bool useDeltaBacklog     = settingsManager.getUseTotalExtrusionDeficit();
+    frameStaleMs = samplePrinterClock(message.hasTimeStamp ? message.timeStamp : 0.0);
     // Parse current status (which contains machine status array)
-    if (status.containsKey("CurrentStatus"))
+    if (status.hasMachineStatuses)
     {
-        JsonArray currentStatus = status["CurrentStatus"];
-
-        // Convert JsonArray to int array for machine statuses
-        int statuses[5];  // Max 5 statuses
-        int count = min((int) currentStatus.size(), 5);
-        for (int i = 0; i < count; i++)
+        int statuses[SDCP_MAX_MACHINE_STATUSES];
+        for (int i = 0; i < status.machineStatusCount; i++)
         {
-            statuses[i] = currentStatus[i].as<int>();
+            statuses[i] = status.machineStatuses[i];
         }
 
         // Set all machine statuses at once
-        setMachineStatuses(statuses, count);
+        setMachineStatuses(statuses, status.machineStatusCount);
     }
 
-    // Parse CurrentCoords to extract Z coordinate
-    if (status.containsKey("CurrenCoord"))
+    // CurrenCoord is "x,y,z"; only Z is used
+    if (status.hasCoord)
     {
-        String coordsStr   = status["CurrenCoord"].as<String>();
-        int    firstComma  = coordsStr.indexOf(',');
-        int    secondComma = coordsStr.indexOf(',', firstComma + 1);
-        if (firstComma != -1 && secondComma != -1)
-        {
-            String zStr = coordsStr.substring(secondComma + 1);
-            currentZ    = zStr.toFloat();
-        }
+        currentZ = status.coord[2];
     }
 
     // Parse print info
-    if (status.containsKey("PrintInfo"))
+    if (status.hasPrintInfo)
     {
-        JsonObject          printInfo = status["PrintInfo"];
-        sdcp_print_status_t newStatus = printInfo["Status"].as<sdcp_print_status_t>();
+        const sdcp_print_info_t &printInfo = status.printInfo;
+        sdcp_print_status_t      newStatus = (sdcp_print_status_t) printInfo.status;
+        bool                firstStatus = !hasReceivedStatus;
+        hasReceivedStatus               = true;
 
         // Any time we receive a well-formed PrintInfo block, treat SDCP
         // telemetry as available at the connection level, even if this
         // particular payload doesn't include extrusion fields. Extrusion
         // freshness is tracked separately via expectedTelemetryAvailable.
         telemetryAvailableLastStatus = true;
-        lastSuccessfulTelemetryMs    = statusTimestamp;
+        lastSuccessfulTelemetryMs    = statusTimestamp - frameStaleMs;
+
+        // Tracking state is kept per job. A job the printer reports that is
+        // not the one being tracked ends the old job, whatever the status
+        // transition says; without a job identity only transitions count.
+        job_change_t jobChange = jobTracker.observe(printInfo);
+        if (jobChange != JOB_CHANGE_NONE)
+        {
+            logger.logf("Job %lu (%s): %s", (unsigned long) jobTracker.jobNumber(),
+                        JobTracker::changeName(jobChange),
+                        printInfo.filename[0] != '\0' ? printInfo.filename : "unnamed job");
+        }
+        bool knownJob = jobTracker.hasJob();
+        bool sameJob  = knownJob && trackedJob == jobTracker.jobNumber();
+        bool otherJob = knownJob && !sameJob;
 
         if (newStatus != printStatus)
         {
+            event_t event              = {};
+            event.data.printState.from = (int16_t) printStatus;
+            event.data.printState.to   = (int16_t) newStatus;
+            publishEvent(EVENT_PRINT_STATE, event);
+
             bool wasPrinting   = (printStatus == SDCP_PRINT_STATUS_PRINTING);
             bool isPrintingNow = (newStatus == SDCP_PRINT_STATUS_PRINTING);
+            bool jobEnded      = newStatus == SDCP_PRINT_STATUS_STOPPING ||
+                            newStatus == SDCP_PRINT_STATUS_STOPED ||
+                            newStatus == SDCP_PRINT_STATUS_COMPLETE ||
+                            newStatus == SDCP_PRINT_STATUS_IDLE;
 
             if (isPrintingNow)
             {
@@ -248,42 +325,53 @@ void ElegooCC::handleStatus(JsonDocument &doc)
                 // If we previously issued a jam-driven pause, treat the next
                 // PRINTING state as a resume regardless of any intermediate
                 // statuses (e.g. HEATING or other transitional codes).
-                if (jamPauseRequested ||
-                    printStatus == SDCP_PRINT_STATUS_PAUSED ||
-                    printStatus == SDCP_PRINT_STATUS_PAUSING)
+                if (!otherJob && (jamPauseRequested ||
+                                  printStatus == SDCP_PRINT_STATUS_PAUSED ||
+                                  printStatus == SDCP_PRINT_STATUS_PAUSING))
                 {
                     logger.log("Print status changed to printing (resume)");
+                    // Feed after a resume is wanted; stop verifying the pause
+                    pauseVerifier.cancel(statusTimestamp);
                     trackingFrozen = false;
                     // On resume, clear the accumulated deficit so jam
                     // detection starts fresh from this point in the print.
                     flowTracker.reset();
+                    shadowDetector.resume(expectedFilamentMM);
                     currentDeficitMm        = 0.0f;
                     deficitRatio            = 0.0f;
                     jamPauseRequested       = false;
                     filamentStopped         = false;
-                    if (useTotalBacklogMode)
+                    batch_mode_t mode = backlogMode();
+                    if (mode != BATCH_MODE_TRACKER)
                     {
-                        resetTotalBacklog(expectedFilamentMM);
-                        if (settingsManager.getZeroDeficitLogging())
-                        {
-                            logger.log("Deficit reset to 0.00mm (resume after jam)");
-                        }
-                    }
-                    else if (useDeltaBacklog)
-                    {
-                        clearAggregatedBacklog();
-                        if (settingsManager.getZeroDeficitLogging())
-                        {
-                            logger.log("Deficit reset to 0.00mm (resume after jam)");
-                        }
+                        aggregatedBacklog.resume(mode, expectedFilamentMM);
+                        LOGD(LOG_CAT_DEFICIT_RESET, "Deficit reset to 0.00mm (resume after jam)");
                     }
                 }
+                else if (firstStatus)
+                {
+                    // First status since boot already shows a print underway (we
+                    // rebooted or reconnected mid-print). The start-print grace
+                    // period is for heat-up/priming, so arm detection right away.
+                    logger.log("Print already in progress, arming detection immediately");
+                    startedAt = millis() - settingsManager.getStartPrintTimeout();
+                    beginJobTracking(printInfo);
+                }
+                else if (sameJob)
+                {
+                    // Back from a transitional status (heating, leveling,
+                    // unknown codes) within the job being tracked: keep the
+                    // baselines, history and grace period.
+                    logger.logf("Print status changed to printing (job %lu continues)",
+                                (unsigned long) trackedJob);
+                }
                 else
                 {
                     // Treat all other transitions into PRINTING as a new print.
                     logger.log("Print status changed to printing");
+                    pauseVerifier.cancel(statusTimestamp);
                     startedAt = millis();
-                    resetFilamentTracking();
+                    beginJobTracking(printInfo);
                 }
             }
             else if (wasPrinting)
@@ -302,6 +390,11 @@ void ElegooCC::handleStatus(JsonDocument &doc)
                         logger.log("Freezing filament tracking while paused after jam");
                     }
                 }
+                else if (sameJob && !jobEnded)
+                {
+                    logger.logf("Print status changed to %d within job %lu, keeping tracking",
+                                (int) newStatus, (unsigned long) trackedJob);
+                }
                 else
                 {
                     // Print has ended (stopped/completed/etc). Log a summary and
@@ -314,39 +407,143 @@ void ElegooCC::handleStatus(JsonDocument &doc)
                         movementPulseCount);
                     logger.log("Print left printing state, resetting filament tracking");
                     resetFilamentTracking();
+                    trackedJob = 0;
                 }
             }
+            else if (jobEnded)
+            {
+                // Ended from a paused or transitional status; the next print
+                // starts clean even if a jam pause is still pending
+                trackedJob = 0;
+            }
+            else if (firstStatus && knownJob &&
+                     (newStatus == SDCP_PRINT_STATUS_PAUSED ||
+                      newStatus == SDCP_PRINT_STATUS_PAUSING))
+            {
+                // Booted while a print is paused; its resume is a resume
+                logger.log("Print paused at startup, tracking its job");
+                startedAt = millis() - settingsManager.getStartPrintTimeout();
+                beginJobTracking(printInfo);
+            }
+        }
+        else if (newStatus == SDCP_PRINT_STATUS_PRINTING && otherJob)
+        {
+            if (trackedJob == 0)
+            {
+                // The printer named the job only after it started printing
+                trackedJob = jobTracker.jobNumber();
+            }
+            else
+            {
+                // Still printing, but not the job being tracked (restarted
+                // while the websocket was down, or replaced from the screen)
+                logger.log("Printing a different job, resetting filament tracking");
+                pauseVerifier.cancel(statusTimestamp);
+                startedAt = millis();
+                beginJobTracking(printInfo);
+            }
         }
         printStatus  = newStatus;
-        currentLayer = printInfo["CurrentLayer"];
-        totalLayer   = printInfo["TotalLayer"];
-        progress     = printInfo["Progress"];
-        currentTicks = printInfo["CurrentTicks"];
-        totalTicks   = printInfo["TotalTicks"];
-        PrintSpeedPct = printInfo["PrintSpeedPct"];
+        currentLayer = printInfo.currentLayer;
+        totalLayer   = printInfo.totalLayer;
+        portENTER_CRITICAL(&stateMux);
+        layerStats.setTotalLayers(totalLayer);
+        portEXIT_CRITICAL(&stateMux);
+        progress     = printInfo.progress;
+        currentTicks = printInfo.currentTicks;
+        totalTicks   = printInfo.totalTicks;
+        PrintSpeedPct = printInfo.printSpeedPct;
 
         // Update extrusion tracking (expected/actual/deficit) based on any
         // TotalExtrusion / CurrentExtrusion fields present in this payload.
         processFilamentTelemetry(printInfo, statusTimestamp);
 
-        if (settingsManager.getVerboseLogging())
+        event_t frame                = {};
+        frame.data.frame.printStatus = (int16_t) printStatus;
+        frame.data.frame.layer       = (int16_t) currentLayer;
+        frame.data.frame.expectedMm  = expectedFilamentMM;
+        publishEvent(EVENT_FRAME, frame);
+
+        if (pauseTracer.isActive() && (printStatus == SDCP_PRINT_STATUS_PAUSING ||
+                                       printStatus == SDCP_PRINT_STATUS_PAUSED))
         {
-            logger.logf(
-                "Flow debug: SDCP status print=%d layer=%d/%d progress=%d expected=%.2fmm "
-                "delta=%.2fmm telemetry=%d",
-                (int) printStatus, currentLayer, totalLayer, progress, expectedFilamentMM,
-                lastExpectedDeltaMM, telemetryAvailableLastStatus ? 1 : 0);
+            pauseTracer.markStopped(printStatus == SDCP_PRINT_STATUS_PAUSED
+                                        ? PAUSE_STAGE_PAUSED
+                                        : PAUSE_STAGE_PAUSING,
+                                    micros(), expectedFilamentMM);
+            if (!pauseTracer.isActive())
+            {
+                logPauseTrace(pauseTracer.history(0));
+            }
         }
+
+        // From the first well-formed status onward, shouldPausePrint() is
+        // evaluating live printer state.
+        bootTimeline.mark(BOOT_PHASE_PROTECTING);
+
+        LOGD(LOG_CAT_FLOW,
+             "Flow debug: SDCP status print=%d layer=%d/%d progress=%d expected=%.2fmm "
+             "delta=%.2fmm telemetry=%d",
+             (int) printStatus, currentLayer, totalLayer, progress, expectedFilamentMM,
+             lastExpectedDeltaMM, telemetryAvailableLastStatus ? 1 : 0);
     }
 
     // Store mainboard ID if we don't have it yet (I'm unsure if we actually need this)
-    if (mainboardID.isEmpty() && !mainboardId.isEmpty())
+    if (mainboardID.isEmpty() && message.mainboardId[0] != '\0')
     {
-        mainboardID = mainboardId;
+        mainboardID = message.mainboardId;
         logger.logf("Stored MainboardID: %s", mainboardID.c_str());
     }
 }
 
+void ElegooCC::beginJobTracking(const sdcp_print_info_t &printInfo)
+{
+    resetFilamentTracking();
+    trackedJob = jobTracker.jobNumber();
+    portENTER_CRITICAL(&stateMux);
+    layerStats.begin(printInfo.totalLayer);
+    portEXIT_CRITICAL(&stateMux);
+    selectDetectionProfile(printInfo.filename);
+}
+
+void ElegooCC::selectDetectionProfile(const char *filename)
+{
+    detectionProfile = settingsManager.selectProfileForJob(filename);
+    logger.logf("Detection profile %s for %s (deficit %.1fmm, hold %lums, %.2fmm/pulse)",
+                detectionProfile.name, filename[0] != '\0' ? filename : "unnamed job",
+                detectionProfile.expectedDeficitMm, (unsigned long) detectionProfile.flowWindowMs,
+                detectionProfile.mmPerPulse);
+    loadShadowProfiles();
+}
+
+void ElegooCC::loadShadowProfiles()
+{
+    DetectionProfiles profiles = settingsManager.getDetectionProfiles();
+    shadowDetector.clearConfigs();
+    for (size_t i = 0; i <= profiles.count(); i++)
+    {
+        const detection_profile_t &profile = i == 0 ? profiles.defaults() : profiles.get(i - 1);
+        // Same fallbacks as the live check in checkFilamentMovement()
+        float         threshold = profile.expectedDeficitMm;
+        unsigned long holdMs    = profile.flowWindowMs;
+        if (threshold <= 0)
+        {
+            threshold = DEFAULT_FILAMENT_DEFICIT_THRESHOLD_MM;
+        }
+        if (holdMs == 0)
+        {
+            holdMs = EXPECTED_FILAMENT_STALE_MS;
+        }
+        int index = shadowDetector.addConfig(threshold, (uint32_t) holdMs, profile.mmPerPulse);
+        if (index < 0)
+        {
+            break;
+        }
+        strncpy(shadowNames[index], profile.name, DETECTION_PROFILE_NAME_LEN - 1);
+    }
+    shadowDetector.reset();
+}
+
 void ElegooCC::resetFilamentTracking()
 {
     lastMovementValue          = -1;
@@ -365,12 +562,12 @@ void ElegooCC::resetFilamentTracking()
     lastFlowLogMs              = 0;
     jamPauseRequested          = false;
     trackingFrozen             = false;
-    if (settingsManager.getZeroDeficitLogging())
-    {
-        logger.log("Deficit reset to 0.00mm (tracking reset)");
-    }
+    hasLastPulse               = false;
+    deficitCrossed             = false;
+    LOGD(LOG_CAT_DEFICIT_RESET, "Deficit reset to 0.00mm (tracking reset)");
     clearAggregatedBacklog();
     flowTracker.reset();
+    shadowDetector.reset();
 }
 
 void ElegooCC::updateExpectedFilament(unsigned long currentTime)
@@ -398,41 +595,24 @@ void ElegooCC::updateExpectedFilament(unsigned long currentTime)
     }
 }
 
-bool ElegooCC::tryReadExtrusionValue(JsonObject &printInfo, const char *key, const char *hexKey,
-                                     float &output)
+bool ElegooCC::processFilamentTelemetry(const sdcp_print_info_t &printInfo,
+                                        unsigned long            currentTime)
 {
-    if (printInfo.containsKey(key) && !printInfo[key].isNull())
-    {
-        output = printInfo[key].as<float>();
-        return true;
-    }
-
-    if (hexKey != nullptr && printInfo.containsKey(hexKey) && !printInfo[hexKey].isNull())
-    {
-        output = printInfo[hexKey].as<float>();
-        return true;
-    }
-
-    return false;
-}
-
-bool ElegooCC::processFilamentTelemetry(JsonObject &printInfo, unsigned long currentTime)
-{
-    float totalValue = 0;
-    float deltaValue = 0;
-    bool  hasTotal   = tryReadExtrusionValue(printInfo, "TotalExtrusion", TOTAL_EXTRUSION_HEX_KEY,
-                                            totalValue);
-    bool  hasDelta   = tryReadExtrusionValue(printInfo, "CurrentExtrusion",
-                                            CURRENT_EXTRUSION_HEX_KEY, deltaValue);
-    bool  useTotalBacklogMode = settingsManager.getUseTotalExtrusionBacklog();
-    bool  useDeltaBacklog     = settingsManager.getUseTotalExtrusionDeficit();
-    bool  usingDeltaLogic     = useDeltaBacklog && !useTotalBacklogMode;
-    bool  packetFlowLogging   = settingsManager.getPacketFlowLogging();
+    bool         hasTotal   = printInfo.hasTotalExtrusion;
+    bool         hasDelta   = printInfo.hasCurrentExtrusion;
+    float        totalValue = printInfo.totalExtrusion;
+    float        deltaValue = printInfo.currentExtrusion;
+    batch_mode_t mode       = backlogMode();
+
+    shadowDetector.setMode(mode);
+    shadowDetector.onTelemetry(hasTotal, totalValue, hasDelta, deltaValue);
+    aggregatedBacklog.onTelemetry(mode, hasTotal, totalValue, hasDelta, deltaValue);
+    pauseVerifier.onTelemetry(currentTime, printInfo.status == SDCP_PRINT_STATUS_PRINTING,
+                              hasTotal, totalValue, hasDelta, deltaValue);
 
     if (hasTotal)
     {
         expectedFilamentMM = totalValue < 0 ? 0 : totalValue;
-        lastTotalExtrusionValue = expectedFilamentMM;
     }
 
     if (hasDelta)
@@ -440,61 +620,39 @@ bool ElegooCC::processFilamentTelemetry(JsonObject &printInfo, unsigned long cur
         lastExpectedDeltaMM = deltaValue;
         if (deltaValue > 0)
         {
-            if (usingDeltaLogic)
-            {
-                aggregatedOutstandingMm += deltaValue;
-            }
             aggregatedDeltaPositiveSum += deltaValue;
             aggregatedDeltaNetSum += deltaValue;
             flowTracker.addExpected(deltaValue, currentTime, 0);
         }
         else if (deltaValue < 0)
         {
-            if (usingDeltaLogic)
-            {
-                aggregatedOutstandingMm += deltaValue;
-                if (aggregatedOutstandingMm < 0.0f)
-                {
-                    aggregatedOutstandingMm = 0.0f;
-                }
-            }
             flowTracker.addActual(-deltaValue);
             aggregatedDeltaNetSum += deltaValue;
         }
     }
 
-    if (useTotalBacklogMode && hasTotal)
-    {
-        if (!aggregatedTotalBaselineValid)
-        {
-            aggregatedTotalBaselineMm    = totalValue;
-            aggregatedTotalBaselineValid = true;
-        }
-        recalculateTotalBacklog();
-    }
-
     // Track freshness of extrusion telemetry separately from general SDCP
     // connectivity. We only mark extrusion telemetry as available when
     // we actually observe TotalExtrusion or CurrentExtrusion in a status
     // payload, and let updateExpectedFilament() mark it stale over time.
     if (hasTotal || hasDelta)
     {
+        // Dated from when the printer sent it, so a frame that sat in a
+        // queue goes stale as early as it would have on time.
         expectedTelemetryAvailable = true;
-        lastTelemetryReceiveMs     = currentTime;
-        if (packetFlowLogging)
-        {
-            logger.logf(
-                "Packet log: time=%lu total=%.2f delta=%.2f delta_pos=%.2f delta_net=%.2f aggregated=%.2f pulses=%lu telem=%d",
-                currentTime, expectedFilamentMM, deltaValue, aggregatedDeltaPositiveSum,
-                aggregatedDeltaNetSum, aggregatedOutstandingMm, movementPulseCount,
-                expectedTelemetryAvailable ? 1 : 0);
-        }
-        if (settingsManager.getTotalVsDeltaLogging() && hasTotal)
+        lastTelemetryReceiveMs     = currentTime - frameStaleMs;
+        LOGV(LOG_CAT_PACKET,
+             "Packet log: time=%lu total=%.2f delta=%.2f delta_pos=%.2f delta_net=%.2f aggregated=%.2f pulses=%lu telem=%d age=%lu",
+             currentTime, expectedFilamentMM, deltaValue, aggregatedDeltaPositiveSum,
+             aggregatedDeltaNetSum, aggregatedBacklog.outstanding(), movementPulseCount,
+             expectedTelemetryAvailable ? 1 : 0, (unsigned long) frameAgeMs);
+        if (hasTotal)
         {
-            logger.logf("Telemetry compare: total=%.2f delta_pos=%.2f delta_net=%.2f "
-                        "aggregated=%.2f pulses=%lu",
-                        expectedFilamentMM, aggregatedDeltaPositiveSum, aggregatedDeltaNetSum,
-                        aggregatedOutstandingMm, movementPulseCount);
+            LOGV(LOG_CAT_TELEMETRY_COMPARE,
+                 "Telemetry compare: total=%.2f delta_pos=%.2f delta_net=%.2f "
+                 "aggregated=%.2f pulses=%lu",
+                 expectedFilamentMM, aggregatedDeltaPositiveSum, aggregatedDeltaNetSum,
+                 aggregatedBacklog.outstanding(), movementPulseCount);
         }
     }
 
@@ -512,7 +670,229 @@ void ElegooCC::pausePrint()
     jamPauseRequested   = true;
     trackingFrozen      = false;
     lastPauseRequestMs = millis();
+    beginPauseTrace();
     sendCommand(SDCP_COMMAND_PAUSE_PRINT, true);
+    pauseVerifier.setEscalation(!settingsManager.getPauseEscalation() ? PAUSE_STEP_PAUSE
+                                : settingsManager.getPauseEscalationStop() ? PAUSE_STEP_STOP
+                                                                           : PAUSE_STEP_REPAUSE);
+    pauseVerifier.begin(pauseTracer.current().id, millis());
+}
+
+void ElegooCC::verifyPause(unsigned long currentTime)
+{
+    pause_action_t action = pauseVerifier.update(currentTime);
+    int            command;
+    switch (action)
+    {
+        case PAUSE_ACTION_REPAUSE:
+            command = SDCP_COMMAND_PAUSE_PRINT;
+            break;
+        case PAUSE_ACTION_STOP_FEEDING:
+            command = SDCP_COMMAND_STOP_FEEDING_MATERIAL;
+            break;
+        case PAUSE_ACTION_STOP:
+            command = SDCP_COMMAND_STOP_PRINT;
+            break;
+        case PAUSE_ACTION_FINISHED:
+            logPauseVerification(pauseVerifier.history(0));
+            return;
+        default:
+            return;
+    }
+
+    const PauseVerification &record = pauseVerifier.current();
+    logger.logf(LOG_LEVEL_WARN,
+                "Pause #%lu did not stop extrusion (%.2fmm after %s), escalating to %s",
+                (unsigned long) record.id, record.stepMm[record.steps - 2],
+                PauseVerifier::stepName((pause_step_t) (record.steps - 2)),
+                PauseVerifier::stepName((pause_step_t) (record.steps - 1)));
+    // The earlier command is superseded; don't let its missing ack block this one
+    waitingForAck       = false;
+    pendingAckCommand   = -1;
+    pendingAckRequestId = "";
+    sendCommand(command, true);
+}
+
+void ElegooCC::logPauseVerification(const PauseVerification &record)
+{
+    char   line[256];
+    size_t used = snprintf(line, sizeof(line), "Pause #%lu verification %s after %lums:",
+                           (unsigned long) record.id,
+                           PauseVerifier::outcomeName((pause_outcome_t) record.outcome),
+                           (unsigned long) record.durationMs);
+    for (uint8_t i = 0; i < record.steps && used < sizeof(line); i++)
+    {
+        used += snprintf(line + used, sizeof(line) - used, " %s=%.2fmm",
+                         PauseVerifier::stepName((pause_step_t) i), record.stepMm[i]);
+    }
+    logger.log(record.outcome == PAUSE_OUTCOME_STILL_EXTRUDING ? LOG_LEVEL_ERROR : LOG_LEVEL_INFO,
+               line);
+}
+
+void ElegooCC::beginPauseTrace()
+{
+    bool     runoutPause = filamentRunout && !filamentStopped;
+    uint32_t id          = pauseTracer.begin(runoutPause, micros());
+    if (!runoutPause)
+    {
+        if (hasLastPulse)
+        {
+            pauseTracer.mark(PAUSE_STAGE_JAM_ONSET, lastPulseUs);
+            pauseTracer.setExpectedAtOnset(expectedAtLastPulseMm);
+        }
+        if (deficitCrossed)
+        {
+            pauseTracer.mark(PAUSE_STAGE_THRESHOLD_CROSSED, deficitCrossedUs);
+        }
+        if (filamentStopped)
+        {
+            pauseTracer.mark(PAUSE_STAGE_HOLD_SATISFIED, holdSatisfiedUs);
+        }
+    }
+    logger.logf("Pause trace #%lu started (%s)", (unsigned long) id,
+                runoutPause ? "runout" : "jam");
+}
+
+void ElegooCC::logPauseTrace(const PauseTrace &trace)
+{
+    char   line[320];
+    size_t used = snprintf(line, sizeof(line), "Pause trace #%lu %s:", (unsigned long) trace.id,
+                           trace.complete ? "complete" : "incomplete");
+    for (int i = 0; i < PAUSE_STAGE_COUNT && used < sizeof(line); i++)
+    {
+        pause_stage_t stage = static_cast<pause_stage_t>(i);
+        if (trace.hasStage(stage))
+        {
+            used += snprintf(line + used, sizeof(line) - used, " %s=%.1fms",
+                             PauseTracer::stageName(stage), trace.offsetUs(stage) / 1000.0f);
+        }
+    }
+    if (used < sizeof(line) && trace.hasStage(PAUSE_STAGE_JAM_ONSET))
+    {
+        snprintf(line + used, sizeof(line) - used, " overrun=%.2fmm", trace.overrunMm());
+    }
+    logger.log(line);
+}
+
+void ElegooCC::publishDiagnostics(unsigned long currentTime)
+{
+    if (currentTime - lastDiagnosticsPublishMs < DIAGNOSTICS_PUBLISH_MS)
+    {
+        return;
+    }
+    lastDiagnosticsPublishMs = currentTime;
+
+    // Only the loop writes the live objects, so they can be read here
+    // without the lock; it just keeps readers off the snapshots.
+    portENTER_CRITICAL(&stateMux);
+    pauseTracerSnapshot   = pauseTracer;
+    pauseVerifierSnapshot = pauseVerifier;
+    printerClockSnapshot  = printerClock;
+    linkLivenessSnapshot  = linkLiveness;
+    shadowSnapshot.mode   = shadowDetector.getMode();
+    shadowSnapshot.count  = shadowDetector.count();
+    for (size_t i = 0; i < shadowSnapshot.count; i++)
+    {
+        shadow_result_t &result = shadowSnapshot.results[i];
+        memcpy(result.name, shadowNames[i], sizeof(result.name));
+        result.thresholdMm      = shadowDetector.thresholdMm(i);
+        result.holdMs           = shadowDetector.holdWindowMs(i);
+        result.deficitMm        = shadowDetector.deficitMm(i);
+        result.satisfied        = shadowDetector.satisfied(i);
+        result.firstSatisfiedMs = shadowDetector.firstSatisfiedMs(i);
+    }
+    portEXIT_CRITICAL(&stateMux);
+}
+
+shadow_snapshot_t ElegooCC::getShadowSnapshot()
+{
+    portENTER_CRITICAL(&stateMux);
+    shadow_snapshot_t copy = shadowSnapshot;
+    portEXIT_CRITICAL(&stateMux);
+    return copy;
+}
+
+void ElegooCC::copyLayerStats(LayerFlowStats &out)
+{
+    portENTER_CRITICAL(&stateMux);
+    out = layerStats;
+    portEXIT_CRITICAL(&stateMux);
+}
+
+PauseTracer ElegooCC::getPauseTracer()
+{
+    portENTER_CRITICAL(&stateMux);
+    PauseTracer copy = pauseTracerSnapshot;
+    portEXIT_CRITICAL(&stateMux);
+    return copy;
+}
+
+PauseVerifier ElegooCC::getPauseVerifier()
+{
+    portENTER_CRITICAL(&stateMux);
+    PauseVerifier copy = pauseVerifierSnapshot;
+    portEXIT_CRITICAL(&stateMux);
+    return copy;
+}
+
+PrinterClock ElegooCC::getPrinterClock()
+{
+    portENTER_CRITICAL(&stateMux);
+    PrinterClock copy = printerClockSnapshot;
+    portEXIT_CRITICAL(&stateMux);
+    return copy;
+}
+
+LinkLiveness ElegooCC::getLinkLiveness()
+{
+    portENTER_CRITICAL(&stateMux);
+    LinkLiveness copy = linkLivenessSnapshot;
+    portEXIT_CRITICAL(&stateMux);
+    return copy;
+}
+
+void ElegooCC::checkLinkLiveness(unsigned long currentTime)
+{
+    link_action_t action = linkLiveness.update(currentTime);
+    if (action == LINK_ACTION_PROBE)
+    {
+        LOGD(LOG_CAT_FLOW, "No SDCP frame for %lu ms, probing with a status request",
+             (unsigned long) linkLiveness.silenceTimeoutMs());
+        sendCommand(SDCP_COMMAND_STATUS);
+    }
+    else if (action == LINK_ACTION_LOST)
+    {
+        logger.logf("Printer link lost: no reply to status probe within %lu ms",
+                    (unsigned long) linkLiveness.probeTimeoutMs());
+        sdcpLost = true;
+    }
+    // Fallback while the learned timeout is backed off past the fixed one
+    if (!sdcpLost && isPrinting() && lastSuccessfulTelemetryMs > 0 &&
+        currentTime - lastSuccessfulTelemetryMs > SDCP_LOSS_TIMEOUT_MS)
+    {
+        logger.logf("Printer link lost: no status for %lu ms",
+                    (unsigned long) (currentTime - lastSuccessfulTelemetryMs));
+        sdcpLost = true;
+    }
+}
+
+uint32_t ElegooCC::samplePrinterClock(double timestamp)
+{
+    if (timestamp <= 0)
+    {
+        return 0;
+    }
+
+    uint16_t quantumMs;
+    int64_t  printerMs = PrinterClock::timestampToMs((uint64_t) timestamp, quantumMs);
+    frameAgeMs         = printerClock.addSample((int64_t) (timeService.nowUs() / 1000), printerMs,
+                                                quantumMs);
+    uint32_t staleMs   = printerClock.staleAgeMs(frameAgeMs);
+    if (staleMs > 0)
+    {
+        LOGD(LOG_CAT_PACKET, "SDCP frame arrived %lu ms late", (unsigned long) staleMs);
+    }
+    return staleMs;
 }
 
 void ElegooCC::continuePrint()
@@ -543,43 +923,43 @@ void ElegooCC::sendCommand(int command, bool waitForAck)
     // Get current timestamp
     unsigned long timestamp = getTime();
 
-    StaticJsonDocument<512> doc;
-    doc["Id"] = uuidStr;
-    JsonObject data = doc.createNestedObject("Data");
-    data["Cmd"]     = command;
-    data["RequestID"]   = uuidStr;
-    data["MainboardID"] = mainboardID;
-    data["TimeStamp"]   = timestamp;
+    sdcp_message_t message = {};
+    message.kind           = SDCP_MESSAGE_REQUEST;
+    message.hasTimeStamp   = true;
+    message.timeStamp      = timestamp;
+    // Without a MainboardID the Topic ("sdcp/request/<MainboardID>", as used
+    // by the Elegoo HA integration) is left out
+    strlcpy(message.mainboardId, mainboardID.c_str(), sizeof(message.mainboardId));
+
+    sdcp_request_t &request = message.request;
+    request.cmd             = command;
+    strlcpy(request.requestId, uuidStr.c_str(), sizeof(request.requestId));
     // Match the Home Assistant integration's client identity for SDCP commands.
     // From = 0 is used there and is known to work reliably for pause/stop.
-    data["From"] = 0;
-
-    // Explicit empty Data object (matches existing payload structure)
-    data.createNestedObject("Data");
+    request.from = 0;
 
     // Include current SDCP print and machine status, mirroring the status payload fields.
-    data["PrintStatus"] = static_cast<int>(printStatus);
-    JsonArray currentStatus = data.createNestedArray("CurrentStatus");
+    request.printStatus = (int16_t) printStatus;
     for (int s = 0; s <= 4; ++s)
     {
         if (hasMachineStatus(static_cast<sdcp_machine_status_t>(s)))
         {
-            currentStatus.add(s);
+            request.machineStatuses[request.machineStatusCount++] = (int16_t) s;
         }
     }
 
-    // When we know the MainboardID, include a Topic field that matches the
-    // "sdcp/request/<MainboardID>" pattern used by the Elegoo HA integration.
-    if (!mainboardID.isEmpty())
+    char   jsonPayload[512];
+    size_t jsonLength = SdcpCodec::encode(message, jsonPayload, sizeof(jsonPayload));
+    if (jsonLength == 0)
+    {
+        logger.logf("Can't encode command %d", command);
+        return;
+    }
+    if (command == SDCP_COMMAND_PAUSE_PRINT)
     {
-        String topic = "sdcp/request/";
-        topic += mainboardID;
-        doc["Topic"] = topic;
+        pauseTracer.mark(PAUSE_STAGE_COMMAND_BUILT, micros());
     }
 
-    String jsonPayload;
-    serializeJson(doc, jsonPayload);
-
     // If this command requires an ack, set the tracking state
     if (waitForAck)
     {
@@ -591,7 +971,18 @@ void ElegooCC::sendCommand(int command, bool waitForAck)
                     uuidStr.c_str());
     }
 
-    webSocket.sendTXT(jsonPayload);
+    // One round trip in flight at a time is plenty for the delay bound
+    if (rttRequestId.isEmpty() || millis() - rttSentMs >= ACK_TIMEOUT_MS)
+    {
+        rttRequestId = uuidStr;
+        rttSentMs    = millis();
+    }
+
+    webSocket.sendTXT(jsonPayload, jsonLength);
+    if (command == SDCP_COMMAND_PAUSE_PRINT)
+    {
+        pauseTracer.mark(PAUSE_STAGE_SOCKET_WRITTEN, micros());
+    }
 }
 
 void ElegooCC::connect()
@@ -610,12 +1001,6 @@ void ElegooCC::loop()
 {
     unsigned long currentTime = millis();
 
-    // websocket IP changed, reconnect
-    if (ipAddress != settingsManager.getElegooIP())
-    {
-        connect();  // this will reconnnect if already connected
-    }
-
     if (webSocket.isConnected())
     {
         // Check for acknowledgment timeout (5 seconds)
@@ -631,16 +1016,24 @@ void ElegooCC::loop()
         }
         else if (currentTime - lastPing > 29900)
         {
-            if (settingsManager.getVerboseLogging())
-            {
-                logger.log("Sending Ping");
-            }
+            LOGD(LOG_CAT_FLOW, "Sending Ping");
             // For all who venture to this line of code wondering why I didn't use sendPing(), it's
             // because for some reason that doesn't work. but this does!
             this->webSocket.sendTXT("ping");
             lastPing = currentTime;
         }
+        checkLinkLiveness(currentTime);
+    }
+
+    if (pauseTracer.isActive())
+    {
+        pauseTracer.expire(micros());
+        if (!pauseTracer.isActive())
+        {
+            logPauseTrace(pauseTracer.history(0));
+        }
     }
+    verifyPause(currentTime);
 
     // Update expected filament feed if the printer is reporting it
     updateExpectedFilament(currentTime);
@@ -649,6 +1042,18 @@ void ElegooCC::loop()
     checkFilamentMovement(currentTime);
     checkFilamentRunout(currentTime);
 
+    if (isPrinting() && !trackingFrozen)
+    {
+        portENTER_CRITICAL(&stateMux);
+        layerStats.sample(currentLayer, expectedFilamentMM, actualFilamentMM,
+                          movementPulseCount, currentDeficitMm, currentTime);
+        portEXIT_CRITICAL(&stateMux);
+    }
+    else
+    {
+        layerStats.resync();
+    }
+
     // Check if we should pause the print
     if (shouldPausePrint(currentTime))
     {
@@ -656,81 +1061,108 @@ void ElegooCC::loop()
         pausePrint();
     }
 
+    // A half-open socket never errors out by itself; drop it (after any
+    // loss pause above had its chance) and let the client reconnect.
+    if (linkLiveness.state() == LINK_STATE_LOST && webSocket.isConnected())
+    {
+        webSocket.disconnect();
+    }
+
     webSocket.loop();
+
+    publishDiagnostics(currentTime);
 }
 
 void ElegooCC::checkFilamentRunout(unsigned long currentTime)
 {
-    // The signal output of the switch sensor is at low level when no filament is detected
-    bool newFilamentRunout = digitalRead(FILAMENT_RUNOUT_PIN) == LOW;
+    // The signal output of the switch sensor is at low level when no filament is detected.
+    // The level is latched by the runout pin interrupt.
+    bool newFilamentRunout = !pulseCapture.getRunoutLevel();
     if (newFilamentRunout != filamentRunout)
     {
         logger.log(filamentRunout ? "Filament has run out" : "Filament has been detected");
     }
+    if (newFilamentRunout && !filamentRunout)
+    {
+        event_t event         = {};
+        event.data.jam.runout = 1;
+        publishEvent(EVENT_JAM, event);
+    }
     filamentRunout = newFilamentRunout;
 }
 
+void ElegooCC::recordMovementPulse(int fromValue, int toValue)
+{
+    float movementMm = detectionProfile.mmPerPulse;
+    if (movementMm <= 0.0f)
+    {
+        movementMm = DETECTION_PROFILE_DEFAULT_MM_PER_PULSE;
+    }
+    aggregatedBacklog.onPulse(backlogMode(), movementMm);
+    actualFilamentMM += movementMm;
+    flowTracker.addActual(movementMm);
+    shadowDetector.onPulse();
+    movementPulseCount++;
+
+    LOGD(LOG_CAT_FLOW,
+         "Flow debug: movement pulse (value %d -> %d), pulses=%lu, actual=%.2fmm", fromValue,
+         toValue, movementPulseCount, actualFilamentMM);
+}
+
 void ElegooCC::checkFilamentMovement(unsigned long currentTime)
 {
-    if (trackingFrozen)
+    bool debugFlow           = LOG_CATEGORY_ENABLED(LOG_CAT_FLOW);
+    bool summaryFlow         = LOG_CATEGORY_ENABLED(LOG_CAT_FLOW_SUMMARY);
+    bool aggregatedMode      = backlogMode() != BATCH_MODE_TRACKER;
+    bool currentlyPrinting   = isPrinting();
+
+    // Track movement pulses so we know how much filament actually moved. Edges
+    // are captured by the sensor interrupt, so pulses that arrive while this
+    // loop is blocked are still counted. When tracking is frozen (printer
+    // paused after a jam), drain them without touching the deficit or totals.
+    bool countPulses = !trackingFrozen && currentlyPrinting;
+    // Pause verification sees every pulse, paused or not, and decides
+    // whether the printer is extruding
+    float verifyMm = 0.0f;
+    if (pauseVerifier.isActive())
     {
-        // When tracking is frozen (printer paused after a jam), leave the
-        // computed deficit and totals unchanged until the job is resumed.
-        int currentMovementValue = digitalRead(MOVEMENT_SENSOR_PIN);
-        if (currentMovementValue != lastMovementValue)
+        verifyMm = detectionProfile.mmPerPulse;
+        if (verifyMm <= 0.0f)
         {
-            lastMovementValue = currentMovementValue;
-            lastChangeTime    = currentTime;
+            verifyMm = DETECTION_PROFILE_DEFAULT_MM_PER_PULSE;
         }
-        return;
     }
-
-    int  currentMovementValue = digitalRead(MOVEMENT_SENSOR_PIN);
-    bool debugFlow            = settingsManager.getVerboseLogging();
-    bool summaryFlow          = settingsManager.getFlowSummaryLogging();
-    bool useTotalBacklogMode  = settingsManager.getUseTotalExtrusionBacklog();
-    bool useDeltaBacklog      = settingsManager.getUseTotalExtrusionDeficit();
-    bool usingDeltaLogic      = useDeltaBacklog && !useTotalBacklogMode;
-    bool currentlyPrinting    = isPrinting();
-
-    // Track movement pulses so we know how much filament actually moved
-    if (currentMovementValue != lastMovementValue)
+    pulse_edge_t  edge;
+    while (pulseCapture.popMovementEdge(edge))
     {
-        if (lastMovementValue != -1 && isPrinting())
+        pauseVerifier.onMovement(currentTime, verifyMm);
+        int previousValue = lastMovementValue;
+        lastMovementValue = edge.level;
+        lastChangeTime    = (unsigned long) (edge.timestampUs / 1000);
+        if ((long) (lastChangeTime - currentTime) > 0)
         {
-            float movementMm = settingsManager.getMovementMmPerPulse();
-            if (movementMm <= 0.0f)
-            {
-                movementMm = 1.5f;
-            }
-            if (useTotalBacklogMode)
-            {
-                aggregatedPulseDeductMm += movementMm;
-                recalculateTotalBacklog();
-            }
-            else if (usingDeltaLogic)
-            {
-                aggregatedOutstandingMm -= movementMm;
-                if (aggregatedOutstandingMm < 0.0f)
-                {
-                    aggregatedOutstandingMm = 0.0f;
-                }
-            }
-            actualFilamentMM += movementMm;
-            flowTracker.addActual(movementMm);
-            movementPulseCount++;
-
-            if (debugFlow)
-            {
-                logger.logf("Flow debug: movement pulse (value %d -> %d), pulses=%lu, "
-                            "actual=%.2fmm",
-                            lastMovementValue, currentMovementValue, movementPulseCount,
-                            actualFilamentMM);
-            }
+            // Edge arrived after this loop pass started
+            lastChangeTime = currentTime;
         }
+        if (countPulses)
+        {
+            recordMovementPulse(previousValue, edge.level);
+            lastPulseUs           = (uint32_t) edge.timestampUs;
+            expectedAtLastPulseMm = expectedFilamentMM;
+            hasLastPulse          = true;
+        }
+    }
+    // Edges the interrupt counted but could not queue are still real movement.
+    uint32_t unqueuedPulses = pulseCapture.takeMovementOverflows();
+    pauseVerifier.onMovement(currentTime, verifyMm * unqueuedPulses);
+    for (uint32_t i = 0; countPulses && i < unqueuedPulses; i++)
+    {
+        recordMovementPulse(lastMovementValue, lastMovementValue);
+    }
 
-        lastMovementValue = currentMovementValue;
-        lastChangeTime    = currentTime;
+    if (trackingFrozen)
+    {
+        return;
     }
 
     // If we don't have expected telemetry from SDCP, don't attempt movement-only detection.
@@ -743,14 +1175,15 @@ void ElegooCC::checkFilamentMovement(unsigned long currentTime)
         return;
     }
 
+      const detection_profile_t &profile = detectionProfile;
       float deficit          = 0;
       bool  deficitTriggered = false;
-      float threshold        = settingsManager.getExpectedDeficitMM();
+      float threshold        = profile.expectedDeficitMm;
       if (threshold <= 0)
       {
           threshold = DEFAULT_FILAMENT_DEFICIT_THRESHOLD_MM;
       }
-      unsigned long holdMs = settingsManager.getExpectedFlowWindowMs();
+      unsigned long holdMs = profile.flowWindowMs;
       if (holdMs == 0)
       {
           holdMs = EXPECTED_FILAMENT_STALE_MS;
@@ -758,10 +1191,9 @@ void ElegooCC::checkFilamentMovement(unsigned long currentTime)
       // Time-based pruning of expected filament is disabled; only sensor
       // pulses, negative SDCP deltas, or explicit print resets can reduce
       // the outstanding deficit.
-      bool aggregatedMode = useTotalBacklogMode || usingDeltaLogic;
       if (aggregatedMode)
       {
-          deficit = aggregatedOutstandingMm;
+          deficit = aggregatedBacklog.outstanding();
       }
       else
       {
@@ -772,11 +1204,17 @@ void ElegooCC::checkFilamentMovement(unsigned long currentTime)
         deficit = 0;
     }
     deficitTriggered = deficit >= threshold;
+    if (deficitTriggered && !deficitCrossed)
+    {
+        deficitCrossedUs = micros();
+    }
+    deficitCrossed = deficitTriggered;
 
       bool deficitHoldSatisfied =
           aggregatedMode
-              ? aggregatedDeficitSatisfied(deficit, currentTime, threshold, holdMs)
+              ? aggregatedBacklog.deficitSatisfied(deficit, currentTime, threshold, holdMs)
               : flowTracker.deficitSatisfied(deficit, currentTime, threshold, holdMs);
+    shadowDetector.evaluate((uint32_t) currentTime);
 
     currentDeficitMm   = deficit;
     deficitThresholdMm = threshold;
@@ -785,11 +1223,11 @@ void ElegooCC::checkFilamentMovement(unsigned long currentTime)
     if (debugFlow && currentlyPrinting && (currentTime - lastFlowLogMs) >= EXPECTED_FILAMENT_SAMPLE_MS)
     {
         lastFlowLogMs = currentTime;
-        logger.logf(
-            "Flow debug: cycle tele=%d expected=%.2fmm actual=%.2fmm deficit=%.2fmm "
-            "threshold=%.2fmm ratio=%.2f pulses=%lu",
-            expectedTelemetryAvailable ? 1 : 0, expectedFilamentMM, actualFilamentMM,
-            currentDeficitMm, deficitThresholdMm, deficitRatio, movementPulseCount);
+        LOGD(LOG_CAT_FLOW,
+             "Flow debug: cycle tele=%d expected=%.2fmm actual=%.2fmm deficit=%.2fmm "
+             "threshold=%.2fmm ratio=%.2f pulses=%lu",
+             expectedTelemetryAvailable ? 1 : 0, expectedFilamentMM, actualFilamentMM,
+             currentDeficitMm, deficitThresholdMm, deficitRatio, movementPulseCount);
     }
 
     // Optional condensed logging mode: one summary line per second, even when full
@@ -797,16 +1235,21 @@ void ElegooCC::checkFilamentMovement(unsigned long currentTime)
     if (summaryFlow && currentlyPrinting && !debugFlow && (currentTime - lastSummaryLogMs) >= 1000)
     {
         lastSummaryLogMs = currentTime;
-        logger.logf("Flow summary: tele=%d expected=%.2fmm actual=%.2fmm deficit=%.2fmm "
-                    "threshold=%.2fmm ratio=%.2f pulses=%lu",
-                    expectedTelemetryAvailable ? 1 : 0, expectedFilamentMM, actualFilamentMM,
-                    currentDeficitMm, deficitThresholdMm, deficitRatio, movementPulseCount);
+        LOGI(LOG_CAT_FLOW_SUMMARY,
+             "Flow summary: tele=%d expected=%.2fmm actual=%.2fmm deficit=%.2fmm "
+             "threshold=%.2fmm ratio=%.2f pulses=%lu",
+             expectedTelemetryAvailable ? 1 : 0, expectedFilamentMM, actualFilamentMM,
+             currentDeficitMm, deficitThresholdMm, deficitRatio, movementPulseCount);
     }
 
     bool newFilamentStopped = deficitHoldSatisfied;
 
     if (newFilamentStopped && !filamentStopped)
     {
+        holdSatisfiedUs = micros();
+        event_t event            = {};
+        event.data.jam.deficitMm = deficit;
+        publishEvent(EVENT_JAM, event);
         if (deficitTriggered)
         {
             logger.logf(
@@ -855,14 +1298,9 @@ bool ElegooCC::shouldPausePrint(unsigned long currentTime)
 
     bool pauseCondition = filamentRunout || filamentStopped;
 
-    bool           sdcpLoss      = false;
-    unsigned long  lastSuccessMs = lastSuccessfulTelemetryMs;
-    int            lossBehavior  = settingsManager.getSdcpLossBehavior();
-    if (webSocket.isConnected() && isPrinting() && lastSuccessMs > 0 &&
-        (currentTime - lastSuccessMs) > SDCP_LOSS_TIMEOUT_MS)
-    {
-        sdcpLoss = true;
-    }
+    // Held across the reconnect below until status frames return
+    bool sdcpLoss     = sdcpLost && isPrinting();
+    int  lossBehavior = settingsManager.getSdcpLossBehavior();
 
     if (sdcpLoss)
     {
@@ -876,8 +1314,10 @@ bool ElegooCC::shouldPausePrint(unsigned long currentTime)
         }
     }
 
+    // While a pause is being verified, follow-up commands are the
+    // verifier's escalations rather than fresh pauses
     if (currentTime - startedAt < settingsManager.getStartPrintTimeout() ||
-        !webSocket.isConnected() || waitingForAck || !isPrinting() ||
+        !webSocket.isConnected() || waitingForAck || pauseVerifier.isActive() || !isPrinting() ||
         !pauseCondition ||
         (lastPauseRequestMs != 0 && (currentTime - lastPauseRequestMs) < PAUSE_REARM_DELAY_MS))
     {
@@ -892,13 +1332,11 @@ bool ElegooCC::shouldPausePrint(unsigned long currentTime)
     logger.logf("Time since print start %d", currentTime - startedAt);
     logger.logf("Is Machine status printing?: %d", hasMachineStatus(SDCP_MACHINE_STATUS_PRINTING));
     logger.logf("Print status: %d", printStatus);
-    if (settingsManager.getVerboseLogging())
-    {
-        logger.logf("Flow state: expected=%.2fmm actual=%.2fmm deficit=%.2fmm "
-                    "threshold=%.2fmm ratio=%.2f pulses=%lu",
-                    expectedFilamentMM, actualFilamentMM, currentDeficitMm,
-                    deficitThresholdMm, deficitRatio, movementPulseCount);
-    }
+    LOGD(LOG_CAT_FLOW,
+         "Flow state: expected=%.2fmm actual=%.2fmm deficit=%.2fmm threshold=%.2fmm ratio=%.2f "
+         "pulses=%lu",
+         expectedFilamentMM, actualFilamentMM, currentDeficitMm, deficitThresholdMm,
+         deficitRatio, movementPulseCount);
 
     return true;
 }
@@ -934,7 +1372,7 @@ printer_info_t ElegooCC::getCurrentInformation()
 
     info.filamentStopped      = filamentStopped;
     info.filamentRunout       = filamentRunout;
-    info.mainboardID          = mainboardID;
+    strlcpy(info.mainboardID, mainboardID.c_str(), sizeof(info.mainboardID));
     info.printStatus          = printStatus;
     info.isPrinting           = isPrinting();
     info.currentLayer         = currentLayer;
@@ -955,83 +1393,26 @@ printer_info_t ElegooCC::getCurrentInformation()
     info.deficitThresholdMm   = deficitThresholdMm;
     info.deficitRatio         = deficitRatio;
     info.movementPulseCount   = movementPulseCount;
+    info.frameAgeMs           = frameAgeMs;
+    info.jobNumber            = trackedJob;
 
     return info;
 }
 
-void ElegooCC::clearAggregatedBacklog()
-{
-    aggregatedOutstandingMm = 0.0f;
-    aggregatedDeficitActive = false;
-    aggregatedDeficitStartMs = 0;
-    aggregatedDeltaPositiveSum = 0.0f;
-    aggregatedDeltaNetSum      = 0.0f;
-    aggregatedTotalBaselineMm  = 0.0f;
-    aggregatedTotalBaselineValid = false;
-    aggregatedPulseDeductMm      = 0.0f;
-}
-
-void ElegooCC::resetTotalBacklog(float totalValue)
-{
-    aggregatedTotalBaselineMm    = totalValue;
-    aggregatedTotalBaselineValid = true;
-    aggregatedPulseDeductMm      = 0.0f;
-    aggregatedOutstandingMm      = 0.0f;
-    lastTotalExtrusionValue      = totalValue;
-}
-
-void ElegooCC::recalculateTotalBacklog()
+batch_mode_t ElegooCC::backlogMode()
 {
-    if (!aggregatedTotalBaselineValid)
+    if (settingsManager.getUseTotalExtrusionBacklog())
     {
-        return;
-    }
-    float requested = lastTotalExtrusionValue - aggregatedTotalBaselineMm;
-    if (requested < 0.0f)
-    {
-        requested = 0.0f;
-    }
-    if (aggregatedPulseDeductMm > requested)
-    {
-        aggregatedPulseDeductMm = requested;
-    }
-    aggregatedOutstandingMm = requested - aggregatedPulseDeductMm;
-    if (aggregatedOutstandingMm < 0.0f)
-    {
-        aggregatedOutstandingMm = 0.0f;
+        return BATCH_MODE_TOTAL;
     }
+    return settingsManager.getUseTotalExtrusionDeficit() ? BATCH_MODE_DELTA : BATCH_MODE_TRACKER;
 }
 
-bool ElegooCC::aggregatedDeficitSatisfied(float outstandingValue, unsigned long now,
-                                          float threshold, unsigned long holdWindowMs)
+void ElegooCC::clearAggregatedBacklog()
 {
-    if (threshold <= 0 || holdWindowMs == 0)
-    {
-        aggregatedDeficitActive = false;
-        aggregatedDeficitStartMs = 0;
-        return false;
-    }
-
-    if (outstandingValue >= threshold)
-    {
-        if (!aggregatedDeficitActive)
-        {
-            aggregatedDeficitActive  = true;
-            aggregatedDeficitStartMs = now;
-        }
-    }
-    else
-    {
-        aggregatedDeficitActive  = false;
-        aggregatedDeficitStartMs = 0;
-    }
-
-    if (!aggregatedDeficitActive)
-    {
-        return false;
-    }
-
-    return (now - aggregatedDeficitStartMs) >= holdWindowMs;
+    aggregatedBacklog.clear();
+    aggregatedDeltaPositiveSum = 0.0f;
+    aggregatedDeltaNetSum      = 0.0f;
 }
 
 bool ElegooCC::discoverPrinterIP(String &outIp, unsigned long timeoutMs)
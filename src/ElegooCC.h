@@ -2,10 +2,21 @@
 #define ELEGOOCC_H
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
 #include <WebSocketsClient.h>
 
+#include "AggregatedBacklog.h"
+#include "BatchDetector.h"
+#include "DetectionProfile.h"
+#include "EventBus.h"
 #include "FilamentFlowTracker.h"
+#include "JobIdentity.h"
+#include "LayerFlowStats.h"
+#include "LinkLiveness.h"
+#include "PauseTrace.h"
+#include "PauseVerifier.h"
+#include "PrinterClock.h"
+#include "SdcpCodec.h"
+#include "StatusJson.h"
 #include "UUID.h"
 
 #define CARBON_CENTAURI_PORT 3030
@@ -19,86 +30,23 @@
 #define MOVEMENT_SENSOR_PIN 13
 #endif
 
-// Status codes
-typedef enum
-{
-    SDCP_PRINT_STATUS_IDLE          = 0,   // Idle
-    SDCP_PRINT_STATUS_HOMING        = 1,   // Homing
-    SDCP_PRINT_STATUS_DROPPING      = 2,   // Descending
-    SDCP_PRINT_STATUS_EXPOSURING    = 3,   // Exposing
-    SDCP_PRINT_STATUS_LIFTING       = 4,   // Lifting
-    SDCP_PRINT_STATUS_PAUSING       = 5,   // Executing Pause Action
-    SDCP_PRINT_STATUS_PAUSED        = 6,   // Suspended
-    SDCP_PRINT_STATUS_STOPPING      = 7,   // Executing Stop Action
-    SDCP_PRINT_STATUS_STOPED        = 8,   // Stopped
-    SDCP_PRINT_STATUS_COMPLETE      = 9,   // Print Completed
-    SDCP_PRINT_STATUS_FILE_CHECKING = 10,  // File Checking in Progress
-    SDCP_PRINT_STATUS_PRINTING      = 13,  // Printing
-    SDCP_PRINT_STATUS_UNKNOWN_15    = 15,  // unknown
-    SDCP_PRINT_STATUS_HEATING       = 16,  // Heating
-    SDCP_PRINT_STATUS_UNKNOWN_18    = 18,  // Unknown
-    SDCP_PRINT_STATUS_UNKNOWN_19    = 19,  // Unknown
-    SDCP_PRINT_STATUS_BED_LEVELING  = 20,  // Bed Leveling
-    SDCP_PRINT_STATUS_UNKNOWN_21    = 21,  // Unknown
-} sdcp_print_status_t;
-
-// Extended Status Error Codes
-typedef enum
-{
-    SDCP_PRINT_ERROR_NONE               = 0,  // Normal
-    SDCP_PRINT_ERROR_CHECK              = 1,  // File MD5 Check Failed
-    SDCP_PRINT_ERROR_FILEIO             = 2,  // File Read Failed
-    SDCP_PRINT_ERROR_INVLAID_RESOLUTION = 3,  // Resolution Mismatch
-    SDCP_PRINT_ERROR_UNKNOWN_FORMAT     = 4,  // Format Mismatch
-    SDCP_PRINT_ERROR_UNKNOWN_MODEL      = 5   // Machine Model Mismatch
-} sdcp_print_error_t;
-
-typedef enum
-{
-    SDCP_MACHINE_STATUS_IDLE              = 0,  // Idle
-    SDCP_MACHINE_STATUS_PRINTING          = 1,  // Executing print task
-    SDCP_MACHINE_STATUS_FILE_TRANSFERRING = 2,  // File transfer in progress
-    SDCP_MACHINE_STATUS_EXPOSURE_TESTING  = 3,  // Exposure test in progress
-    SDCP_MACHINE_STATUS_DEVICES_TESTING   = 4,  // Device self-check in progress
-} sdcp_machine_status_t;
-
-typedef enum
+// One detection profile's shadow evaluation, as last published by the loop
+typedef struct
 {
-    SDCP_COMMAND_STATUS                = 0,
-    SDCP_COMMAND_ATTRIBUTES            = 1,
-    SDCP_COMMAND_START_PRINT           = 128,
-    SDCP_COMMAND_PAUSE_PRINT           = 129,
-    SDCP_COMMAND_STOP_PRINT            = 130,
-    SDCP_COMMAND_CONTINUE_PRINT        = 131,
-    SDCP_COMMAND_STOP_FEEDING_MATERIAL = 132,
-} sdcp_command_t;
-
-// Struct to hold current printer information
+    char     name[DETECTION_PROFILE_NAME_LEN];
+    float    thresholdMm;
+    uint32_t holdMs;
+    float    deficitMm;
+    bool     satisfied;
+    uint32_t firstSatisfiedMs;  // 0 if never
+} shadow_result_t;
+
 typedef struct
 {
-    String              mainboardID;
-    sdcp_print_status_t printStatus;
-    bool                filamentStopped;
-    bool                filamentRunout;
-    int                 currentLayer;
-    int                 totalLayer;
-    int                 progress;
-    int                 currentTicks;
-    int                 totalTicks;
-    int                 PrintSpeedPct;
-    bool                isWebsocketConnected;
-    bool                isPrinting;
-    float               currentZ;
-    bool                waitingForAck;
-    float               expectedFilamentMM;
-    float               actualFilamentMM;
-    float               lastExpectedDeltaMM;
-    bool                telemetryAvailable;
-    float               currentDeficitMm;
-    float               deficitThresholdMm;
-    float               deficitRatio;
-    unsigned long       movementPulseCount;
-} printer_info_t;
+    batch_mode_t    mode;
+    size_t          count;
+    shadow_result_t results[BatchDetector::MAX_CONFIGS];
+} shadow_snapshot_t;
 
 class ElegooCC
 {
@@ -133,29 +81,77 @@ class ElegooCC
     unsigned long       lastSuccessfulTelemetryMs;
     unsigned long       lastTelemetryReceiveMs;
     unsigned long       lastStatusReceiveMs;
+    bool                hasReceivedStatus;
+    bool                sdcpLost;  // no status frames; cleared when one arrives
     bool                telemetryAvailableLastStatus;
     float               currentDeficitMm;
     float               deficitThresholdMm;
     float               deficitRatio;
 
+    // Printer clock tracking: how long status frames took to reach us.
+    // frameStaleMs is the part of the last frame's age known to exceed
+    // timestamp quantization; freshness checks date the frame back by it.
+    PrinterClock  printerClock;
+    uint32_t      frameAgeMs;
+    uint32_t      frameStaleMs;
+    String        rttRequestId;
+    unsigned long rttSentMs;
+
+    // Learns the printer's frame spacing; probes and then declares the link
+    // lost when it stays silent for longer than usual.
+    LinkLiveness linkLiveness;
+
     unsigned long startedAt;
+    // Which job the tracking state below belongs to. trackedJob is the
+    // jobTracker number tracking was last reset for, 0 after a print ended.
+    JobTracker    jobTracker;
+    uint32_t      trackedJob;
     FilamentFlowTracker flowTracker;
+    LayerFlowStats      layerStats;
+    // Every detection profile run side by side on the live stream, to show
+    // which ones would have paused this print and when
+    BatchDetector       shadowDetector;
+    char                shadowNames[BatchDetector::MAX_CONFIGS][DETECTION_PROFILE_NAME_LEN];
+    // The loop's own copy of the active profile; settings may be replaced
+    // from the web server meanwhile
+    detection_profile_t detectionProfile;
     unsigned long       movementPulseCount;
     unsigned long       lastFlowLogMs;
     unsigned long       lastSummaryLogMs;
-    float               aggregatedOutstandingMm;
-    bool                aggregatedDeficitActive;
-    unsigned long       aggregatedDeficitStartMs;
+    // Deficit backlog for the delta and total modes; the sums are only logged
+    AggregatedBacklog   aggregatedBacklog;
     float               aggregatedDeltaPositiveSum;
     float               aggregatedDeltaNetSum;
-    float               aggregatedTotalBaselineMm;
-    float               aggregatedPulseDeductMm;
-    bool                aggregatedTotalBaselineValid;
-    float               lastTotalExtrusionValue;
     // Jam / pause tracking
     bool          jamPauseRequested;
     bool          trackingFrozen;
 
+    // Pause latency tracing. Times are micros() and only meaningful while
+    // the matching flag is set.
+    PauseTracer pauseTracer;
+    uint32_t    lastPulseUs;
+    float       expectedAtLastPulseMm;
+    bool        hasLastPulse;
+    uint32_t    deficitCrossedUs;
+    bool        deficitCrossed;
+    uint32_t    holdSatisfiedUs;
+
+    // Watches extrusion after a pause and escalates (re-pause, stop
+    // feeding, stop) when it did not take. Times are millis().
+    PauseVerifier pauseVerifier;
+
+    // Copies of the diagnostics above for the web server task (layerStats
+    // is copied on request instead, see copyLayerStats()). The loop
+    // refreshes them every DIAGNOSTICS_PUBLISH_MS under stateMux; readers
+    // copy them out under the same lock, so they never see one mid-update.
+    portMUX_TYPE      stateMux;
+    PauseTracer       pauseTracerSnapshot;
+    PauseVerifier     pauseVerifierSnapshot;
+    PrinterClock      printerClockSnapshot;
+    LinkLiveness      linkLivenessSnapshot;
+    shadow_snapshot_t shadowSnapshot;  // results and names of shadowDetector
+    unsigned long     lastDiagnosticsPublishMs;
+
     // Acknowledgment tracking
     bool          waitingForAck;
     int           pendingAckCommand;
@@ -171,17 +167,23 @@ class ElegooCC
 
     void webSocketEvent(WStype_t type, uint8_t *payload, size_t length);
     void connect();
-    void handleCommandResponse(JsonDocument &doc);
-    void handleStatus(JsonDocument &doc);
+    void handleCommandResponse(const sdcp_message_t &message);
+    void handleStatus(const sdcp_message_t &message);
+    // Feeds an SDCP TimeStamp (0 if absent) to the printer clock; returns
+    // the frame's stale age
+    uint32_t samplePrinterClock(double timestamp);
     void sendCommand(int command, bool waitForAck = false);
+    // Stamps type and time, then queues the event for the main loop
+    void publishEvent(event_type_t type, event_t &event);
     void pausePrint();
     void continuePrint();
 
     void resetFilamentTracking();
+    void beginJobTracking(const sdcp_print_info_t &printInfo);
+    void selectDetectionProfile(const char *filename);
+    void loadShadowProfiles();
     void updateExpectedFilament(unsigned long currentTime);
-    bool processFilamentTelemetry(JsonObject& printInfo, unsigned long currentTime);
-    bool tryReadExtrusionValue(JsonObject& printInfo, const char* key, const char* hexKey,
-                               float& output);
+    bool processFilamentTelemetry(const sdcp_print_info_t &printInfo, unsigned long currentTime);
 
     // Helper methods for machine status bitmask
     bool hasMachineStatus(sdcp_machine_status_t status);
@@ -189,12 +191,16 @@ class ElegooCC
     bool isPrinting();
     bool shouldPausePrint(unsigned long currentTime);
     void checkFilamentMovement(unsigned long currentTime);
+    void recordMovementPulse(int fromValue, int toValue);
     void checkFilamentRunout(unsigned long currentTime);
+    void checkLinkLiveness(unsigned long currentTime);
+    batch_mode_t backlogMode();
     void clearAggregatedBacklog();
-    void resetTotalBacklog(float totalValue);
-    void recalculateTotalBacklog();
-    bool aggregatedDeficitSatisfied(float outstandingValue, unsigned long now, float threshold,
-                                     unsigned long holdWindowMs);
+    void beginPauseTrace();
+    void logPauseTrace(const PauseTrace &trace);
+    void verifyPause(unsigned long currentTime);
+    void logPauseVerification(const PauseVerification &record);
+    void publishDiagnostics(unsigned long currentTime);
 
    public:
     // Singleton access method
@@ -206,6 +212,30 @@ class ElegooCC
     // Get current printer information
     printer_info_t getCurrentInformation();
 
+    // The getters below are safe from other tasks and may lag the loop by
+    // up to DIAGNOSTICS_PUBLISH_MS.
+
+    // Copy of the recent pause traces and the one in progress
+    PauseTracer getPauseTracer();
+
+    // Copy of the pause verifications: escalations and filament extruded
+    // after each pause decision
+    PauseVerifier getPauseVerifier();
+
+    // Copy of the printer clock estimate (frame age, skew, round trips)
+    PrinterClock getPrinterClock();
+
+    // Copy of the link liveness state and learned timeouts
+    LinkLiveness getLinkLiveness();
+
+    // Copies the flow broken down by layer for the current (or last) print.
+    // Taken under stateMux, which the loop holds while it updates the
+    // buckets, so a merge is never seen half done.
+    void copyLayerStats(LayerFlowStats &out);
+
+    // Copy of the shadow evaluation of every detection profile
+    shadow_snapshot_t getShadowSnapshot();
+
     bool discoverPrinterIP(String &outIp, unsigned long timeoutMs = 3000);
 };
 
@@ -0,0 +1,168 @@
+#include "EventBus.h"
+
+#include <string.h>
+
+EventBus &EventBus::getInstance()
+{
+    static EventBus instance;
+    return instance;
+}
+
+EventBus::EventBus()
+{
+    memset(ring, 0, sizeof(ring));
+    memset(subscribers, 0, sizeof(subscribers));
+    memset(&stats, 0, sizeof(stats));
+    head            = 0;
+    count           = 0;
+    subscriberCount = 0;
+    subscribedMask  = 0;
+#ifdef ARDUINO
+    mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+}
+
+void EventBus::lock() const
+{
+#ifdef ARDUINO
+    portENTER_CRITICAL(&mux);
+#endif
+}
+
+void EventBus::unlock() const
+{
+#ifdef ARDUINO
+    portEXIT_CRITICAL(&mux);
+#endif
+}
+
+bool EventBus::subscribe(uint32_t typeMask, event_handler_t handler, void *context)
+{
+    if (handler == nullptr)
+    {
+        return false;
+    }
+    lock();
+    bool added = subscriberCount < MAX_SUBSCRIBERS;
+    if (added)
+    {
+        subscribers[subscriberCount].mask    = typeMask;
+        subscribers[subscriberCount].handler = handler;
+        subscribers[subscriberCount].context = context;
+        subscriberCount++;
+        subscribedMask |= typeMask;
+    }
+    unlock();
+    return added;
+}
+
+bool EventBus::publish(const event_t &event)
+{
+    if (event.type >= EVENT_TYPE_COUNT)
+    {
+        return false;
+    }
+    lock();
+    if (!(subscribedMask & EVENT_BIT(event.type)))
+    {
+        stats.published[event.type]++;
+        stats.unheard++;
+        unlock();
+        return true;
+    }
+    bool queued = count < QUEUE_SIZE;
+    if (queued)
+    {
+        ring[(head + count) % QUEUE_SIZE] = event;
+        count++;
+        stats.published[event.type]++;
+        if (count > stats.highWater)
+        {
+            stats.highWater = count;
+        }
+    }
+    else
+    {
+        stats.dropped++;
+    }
+    unlock();
+    return queued;
+}
+
+bool EventBus::pop(event_t &event)
+{
+    lock();
+    bool available = count > 0;
+    if (available)
+    {
+        event = ring[head];
+        head  = (head + 1) % QUEUE_SIZE;
+        count--;
+    }
+    unlock();
+    return available;
+}
+
+size_t EventBus::dispatch(size_t maxEvents)
+{
+    size_t  delivered = 0;
+    event_t event;
+    // Subscribers are only added during setup, so the list is read unlocked.
+    while (delivered < maxEvents && pop(event))
+    {
+        uint32_t bit = EVENT_BIT(event.type);
+        for (size_t i = 0; i < subscriberCount; i++)
+        {
+            if (subscribers[i].mask & bit)
+            {
+                subscribers[i].handler(event, subscribers[i].context);
+            }
+        }
+        delivered++;
+    }
+    lock();
+    stats.dispatched += delivered;
+    unlock();
+    return delivered;
+}
+
+size_t EventBus::pending() const
+{
+    lock();
+    size_t waiting = count;
+    unlock();
+    return waiting;
+}
+
+event_bus_stats_t EventBus::getStats() const
+{
+    lock();
+    event_bus_stats_t copy = stats;
+    unlock();
+    return copy;
+}
+
+const char *EventBus::typeName(event_type_t type)
+{
+    switch (type)
+    {
+        case EVENT_PRINT_STATE:
+            return "print_state";
+        case EVENT_PULSE:
+            return "pulse";
+        case EVENT_FRAME:
+            return "frame";
+        case EVENT_JAM:
+            return "jam";
+        case EVENT_PAUSE_ACK:
+            return "pause_ack";
+        case EVENT_SETTINGS_CHANGED:
+            return "settings_changed";
+        case EVENT_LINK_UP:
+            return "link_up";
+        case EVENT_LINK_DOWN:
+            return "link_down";
+        default:
+            return "unknown";
+    }
+}
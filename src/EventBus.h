@@ -0,0 +1,150 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#endif
+
+typedef enum
+{
+    EVENT_PRINT_STATE      = 0,  // SDCP print status changed
+    EVENT_PULSE            = 1,  // reserved: not published until something consumes it
+    EVENT_FRAME            = 2,  // SDCP status frame parsed
+    EVENT_JAM              = 3,  // deficit/stall or runout condition raised
+    EVENT_PAUSE_ACK        = 4,  // reserved: not published until something consumes it
+    EVENT_SETTINGS_CHANGED = 5,  // settings saved
+    EVENT_LINK_UP          = 6,
+    EVENT_LINK_DOWN        = 7,
+    EVENT_TYPE_COUNT
+} event_type_t;
+
+#define EVENT_BIT(type) (1UL << (type))
+
+// settingsChanged.changed bits
+#define SETTINGS_CHANGED_WIFI (1UL << 0)
+#define SETTINGS_CHANGED_PRINTER_IP (1UL << 1)
+#define SETTINGS_CHANGED_SYSLOG (1UL << 2)
+#define SETTINGS_CHANGED_NOTIFY (1UL << 3)
+#define SETTINGS_CHANGED_SENSOR (1UL << 4)
+#define SETTINGS_CHANGED_FLASH_LOG (1UL << 5)
+#define SETTINGS_CHANGED_DETECTION (1UL << 6)
+
+typedef enum
+{
+    EVENT_LINK_WIFI    = 0,
+    EVENT_LINK_PRINTER = 1,  // SDCP websocket
+} event_link_t;
+
+// Fixed-size event record; copied into and out of the ring by value.
+typedef struct
+{
+    uint8_t  type;         // event_type_t
+    uint64_t timestampUs;  // TimeService monotonic microseconds
+    union
+    {
+        struct
+        {
+            int16_t from;
+            int16_t to;
+        } printState;
+        struct
+        {
+            uint32_t count;
+            uint32_t total;
+        } pulse;
+        struct
+        {
+            int16_t printStatus;
+            int16_t layer;
+            float   expectedMm;
+        } frame;
+        struct
+        {
+            float   deficitMm;
+            uint8_t runout;
+        } jam;
+        struct
+        {
+            int32_t command;
+        } pauseAck;
+        struct
+        {
+            uint32_t changed;  // SETTINGS_CHANGED_* bits
+        } settingsChanged;
+        struct
+        {
+            uint8_t link;  // event_link_t
+        } link;
+    } data;
+} event_t;
+
+typedef void (*event_handler_t)(const event_t &event, void *context);
+
+typedef struct
+{
+    uint32_t published[EVENT_TYPE_COUNT];
+    uint32_t dispatched;
+    uint32_t dropped;    // publish() found the ring full
+    uint32_t unheard;    // published with no subscriber for the type, never queued
+    uint32_t highWater;  // most events ever waiting at once
+} event_bus_stats_t;
+
+// Allocation-free publish/subscribe between subsystems.
+//
+// publish() copies the event into a fixed ring and never calls handlers, so
+// it is safe from any task (the ring is guarded by a spinlock on the
+// device). dispatch() runs on the main loop and delivers queued events to
+// every subscriber whose mask includes the type, in publish order. Handlers
+// may publish; those events are delivered later in the same dispatch().
+// Types nobody subscribed to are counted but not queued, so they cannot
+// crowd out the ones that are listened for.
+class EventBus
+{
+   public:
+    static const size_t QUEUE_SIZE      = 32;
+    static const size_t MAX_SUBSCRIBERS = 12;
+
+    EventBus();
+
+    static EventBus &getInstance();
+
+    bool subscribe(uint32_t typeMask, event_handler_t handler, void *context = nullptr);
+    bool publish(const event_t &event);
+    // Delivers up to maxEvents queued events; returns how many were delivered.
+    size_t dispatch(size_t maxEvents = QUEUE_SIZE);
+
+    size_t            pending() const;
+    event_bus_stats_t getStats() const;
+
+    static const char *typeName(event_type_t type);
+
+   private:
+    struct Subscriber
+    {
+        uint32_t        mask;
+        event_handler_t handler;
+        void           *context;
+    };
+
+    event_t           ring[QUEUE_SIZE];
+    size_t            head;
+    size_t            count;
+    Subscriber        subscribers[MAX_SUBSCRIBERS];
+    size_t            subscriberCount;
+    uint32_t          subscribedMask;  // union of the subscriber masks
+    event_bus_stats_t stats;
+#ifdef ARDUINO
+    mutable portMUX_TYPE mux;
+#endif
+
+    void lock() const;
+    void unlock() const;
+    bool pop(event_t &event);
+};
+
+#define eventBus EventBus::getInstance()
+
+#endif  // EVENT_BUS_H
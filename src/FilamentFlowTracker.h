@@ -7,6 +7,8 @@
 class FilamentFlowTracker
 {
    public:
+    static const size_t MAX_CHUNKS = 16;
+
     FilamentFlowTracker();
 
     void reset();
@@ -24,8 +26,6 @@ class FilamentFlowTracker
         float         remaining;
     };
 
-    static const size_t MAX_CHUNKS = 16;
-
     FlowChunk     chunks[MAX_CHUNKS];
     size_t        head;
     size_t        count;
@@ -0,0 +1,166 @@
+#include "FlowReplay.h"
+
+FlowReplay::FlowReplay(BatchDetector &target) : detector(target)
+{
+    records        = nullptr;
+    count          = 0;
+    next           = 0;
+    keyframeIndex         = nullptr;
+    maxKeyframes   = 0;
+    keyframes      = 0;
+    stateBuffer    = nullptr;
+    stateCapacity  = 0;
+    stateUsed      = 0;
+    seekReplayed   = 0;
+    startStateSize = 0;
+}
+
+void FlowReplay::attach(const trace_record_t *newRecords, size_t newCount)
+{
+    records   = newRecords;
+    count     = newCount;
+    next      = 0;
+    keyframes = 0;
+    stateUsed = 0;
+    // The state the trace starts from, for seeks before the first keyframe
+    startStateSize = detector.saveState(startState, sizeof(startState));
+}
+
+void FlowReplay::attachIndex(trace_keyframe_t *newKeyframes, size_t newMaxKeyframes,
+                             uint8_t *newStateBuffer, size_t newStateCapacity)
+{
+    keyframeIndex        = newKeyframes;
+    maxKeyframes  = newMaxKeyframes;
+    stateBuffer   = newStateBuffer;
+    stateCapacity = newStateCapacity;
+    keyframes     = 0;
+    stateUsed     = 0;
+}
+
+void FlowReplay::setIndex(size_t keyframeCount, size_t stateBytes)
+{
+    keyframes = keyframeCount <= maxKeyframes ? keyframeCount : maxKeyframes;
+    stateUsed = stateBytes <= stateCapacity ? stateBytes : stateCapacity;
+}
+
+void FlowReplay::apply(BatchDetector &target, const trace_record_t &record)
+{
+    switch (record.kind)
+    {
+        case TRACE_TELEMETRY:
+            target.onTelemetry((record.flags & TRACE_HAS_TOTAL) != 0, record.a,
+                                 (record.flags & TRACE_HAS_DELTA) != 0, record.b);
+            break;
+        case TRACE_PULSE:
+            target.onPulse();
+            break;
+        case TRACE_EVALUATE:
+            target.evaluate(record.timeMs);
+            break;
+        case TRACE_RESET:
+            target.reset();
+            break;
+        case TRACE_RESUME:
+            target.resume(record.a);
+            break;
+        default:
+            break;
+    }
+}
+
+void FlowReplay::rewind()
+{
+    detector.loadState(startState, startStateSize);
+    next = 0;
+}
+
+size_t FlowReplay::buildIndex(uint32_t intervalMs)
+{
+    rewind();
+    keyframes = 0;
+    stateUsed = 0;
+    if (count == 0 || intervalMs == 0)
+    {
+        return 0;
+    }
+
+    uint32_t nextKeyframeMs = records[0].timeMs + intervalMs;
+    bool     full           = false;
+    for (next = 0; next < count; next++)
+    {
+        const trace_record_t &record = records[next];
+        if (record.timeMs >= nextKeyframeMs && !full)
+        {
+            size_t size = keyframes < maxKeyframes
+                              ? detector.saveState(stateBuffer + stateUsed,
+                                                   stateCapacity - stateUsed)
+                              : 0;
+            if (size == 0)
+            {
+                // Out of index storage; later seeks replay from the last keyframe
+                full = true;
+            }
+            else
+            {
+                trace_keyframe_t &keyframe = keyframeIndex[keyframes++];
+                keyframe.timeMs            = record.timeMs;
+                keyframe.recordIndex       = (uint32_t) next;
+                keyframe.stateOffset       = (uint32_t) stateUsed;
+                keyframe.stateSize         = (uint32_t) size;
+                stateUsed += size;
+            }
+            while (nextKeyframeMs <= record.timeMs)
+            {
+                nextKeyframeMs += intervalMs;
+            }
+        }
+        apply(detector, record);
+    }
+    return keyframes;
+}
+
+bool FlowReplay::seek(uint32_t timeMs)
+{
+    // Last keyframe at or before the target
+    size_t low  = 0;
+    size_t high = keyframes;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (keyframeIndex[mid].timeMs <= timeMs)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    if (low == 0)
+    {
+        rewind();
+    }
+    else
+    {
+        const trace_keyframe_t &keyframe = keyframeIndex[low - 1];
+        if (!detector.loadState(stateBuffer + keyframe.stateOffset, keyframe.stateSize))
+        {
+            return false;
+        }
+        next = keyframe.recordIndex;
+    }
+    seekReplayed = runUntil(timeMs);
+    return true;
+}
+
+size_t FlowReplay::runUntil(uint32_t timeMs)
+{
+    size_t applied = 0;
+    while (next < count && records[next].timeMs <= timeMs)
+    {
+        apply(detector, records[next++]);
+        applied++;
+    }
+    return applied;
+}
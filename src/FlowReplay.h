@@ -0,0 +1,108 @@
+#ifndef FLOW_REPLAY_H
+#define FLOW_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "BatchDetector.h"
+
+// One detector input, in the order the firmware feeds them
+typedef enum
+{
+    TRACE_TELEMETRY = 0,  // a = TotalExtrusion, b = CurrentExtrusion
+    TRACE_PULSE     = 1,  // one movement sensor pulse
+    TRACE_EVALUATE  = 2,  // a detection loop pass
+    TRACE_RESET     = 3,  // new print
+    TRACE_RESUME    = 4,  // resume after a jam pause, a = expected mm
+} trace_kind_t;
+
+#define TRACE_HAS_TOTAL 0x01
+#define TRACE_HAS_DELTA 0x02
+
+typedef struct
+{
+    uint32_t timeMs;
+    uint8_t  kind;   // trace_kind_t
+    uint8_t  flags;  // TRACE_HAS_* for TRACE_TELEMETRY
+    uint16_t reserved;
+    float    a;
+    float    b;
+} trace_record_t;
+
+// Detector state before records[recordIndex], stored at stateOffset in the
+// state buffer
+typedef struct
+{
+    uint32_t timeMs;  // time of records[recordIndex]
+    uint32_t recordIndex;
+    uint32_t stateOffset;
+    uint32_t stateSize;
+} trace_keyframe_t;
+
+// Replays a recorded trace through a BatchDetector with random access.
+//
+// buildIndex() runs the whole trace once and snapshots the detector every
+// `intervalMs` of trace time. seek() then restores the last keyframe before
+// the target and replays only from there, so looking at hour five of a
+// six-hour print costs at most one interval of replay, and the result is
+// bit-identical to replaying from the start.
+//
+// Keyframes hold the configurations too. A sweep that only changes
+// parameters after some point can seek() there once per variant and
+// retune with BatchDetector::setConfig(), sharing the prefix. Changing
+// anything that affects earlier samples (mode, mm per pulse) needs a new
+// index.
+//
+// All storage is supplied by the caller.
+class FlowReplay
+{
+   public:
+    explicit FlowReplay(BatchDetector &target);
+
+    // Records must be in time order
+    void attach(const trace_record_t *records, size_t count);
+    void attachIndex(trace_keyframe_t *keyframes, size_t maxKeyframes, uint8_t *stateBuffer,
+                     size_t stateCapacity);
+    // Uses an index built earlier (e.g. loaded from a file). Keyframes must
+    // be in record order.
+    void setIndex(size_t keyframeCount, size_t stateBytes);
+
+    // Replays from the start with the detector's current configurations.
+    // Stops adding keyframes when the index storage is full. Returns the
+    // number of keyframes.
+    size_t buildIndex(uint32_t intervalMs);
+
+    // Positions the detector after every record at or before `timeMs`
+    bool seek(uint32_t timeMs);
+    // Applies records up to and including `timeMs`; returns how many
+    size_t runUntil(uint32_t timeMs);
+    void   rewind();
+
+    size_t position() const { return next; }
+    size_t recordCount() const { return count; }
+    size_t keyframeCount() const { return keyframes; }
+    size_t stateBytes() const { return stateUsed; }
+    // Records replayed by the last seek() to reach its target
+    size_t lastSeekReplayed() const { return seekReplayed; }
+
+    const trace_keyframe_t &keyframe(size_t index) const { return keyframeIndex[index]; }
+
+    static void apply(BatchDetector &target, const trace_record_t &record);
+
+   private:
+    BatchDetector        &detector;
+    const trace_record_t *records;
+    size_t                count;
+    size_t                next;
+    trace_keyframe_t     *keyframeIndex;
+    size_t                maxKeyframes;
+    size_t                keyframes;
+    uint8_t              *stateBuffer;
+    size_t                stateCapacity;
+    size_t                stateUsed;
+    size_t                seekReplayed;
+    uint8_t               startState[BatchDetector::MAX_STATE_SIZE];
+    size_t                startStateSize;
+};
+
+#endif  // FLOW_REPLAY_H
@@ -0,0 +1,271 @@
+#include "GzipStream.h"
+
+#include <string.h>
+
+static const uint16_t LENGTH_BASE[29]  = {3,  4,  5,  6,  7,  8,  9,   10,  11,  13,
+                                          15, 17, 19, 23, 27, 31, 35,  43,  51,  59,
+                                          67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t  LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                          2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DIST_BASE[30]    = {1,    2,    3,    4,    5,    7,     9,     13,
+                                          17,   25,   33,   49,   65,   97,    129,   193,
+                                          257,  385,  513,  769,  1025, 1537,  2049,  3073,
+                                          4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t  DIST_EXTRA[30]   = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                          6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Nibble-at-a-time CRC-32 (IEEE); 64 bytes of table instead of 1 KB.
+static const uint32_t CRC_NIBBLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+    0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static inline uint32_t hashAt(const uint8_t *p)
+{
+    uint32_t v = ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+    return ((v * 2654435761u) >> (32 - GzipStream::HASH_BITS)) & (GzipStream::HASH_ENTRIES - 1);
+}
+
+GzipStream::GzipStream()
+{
+    memset(head, 0, sizeof(head));
+    historyLength = 0;
+    windowBase    = 0;
+    crc           = 0;
+    totalIn       = 0;
+    totalOut      = 0;
+    bitBuffer     = 0;
+    bitCount      = 0;
+    started       = false;
+    finished      = false;
+    out           = nullptr;
+    outPos        = 0;
+    outCapacity   = 0;
+}
+
+size_t GzipStream::inputBudget(size_t outputCapacity)
+{
+    // Worst case is 9 bits per literal; matches are never longer than the
+    // literals they replace because distances stay under WINDOW_SIZE. Add
+    // the header, block headers and end codes, pending bits and the trailer.
+    const size_t overhead = HEADER_SIZE + TRAILER_SIZE + 6;
+    if (outputCapacity <= overhead)
+    {
+        return 0;
+    }
+    size_t budget = ((outputCapacity - overhead) * 8) / 9;
+    return budget > MAX_INPUT ? MAX_INPUT : budget;
+}
+
+uint8_t *GzipStream::inputBuffer()
+{
+    return window + historyLength;
+}
+
+void GzipStream::putByte(uint8_t value)
+{
+    if (outPos < outCapacity)
+    {
+        out[outPos] = value;
+    }
+    outPos++;
+}
+
+void GzipStream::putBits(uint32_t value, uint8_t count)
+{
+    bitBuffer |= value << bitCount;
+    bitCount += count;
+    while (bitCount >= 8)
+    {
+        putByte((uint8_t) bitBuffer);
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+}
+
+// Huffman codes are defined MSB-first but packed LSB-first.
+void GzipStream::putCode(uint32_t code, uint8_t length)
+{
+    uint32_t reversed = 0;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    putBits(reversed, length);
+}
+
+void GzipStream::putLiteral(uint8_t literal)
+{
+    if (literal < 144)
+    {
+        putCode(0x30 + literal, 8);
+    }
+    else
+    {
+        putCode(0x190 + (literal - 144), 9);
+    }
+}
+
+void GzipStream::putMatch(size_t length, size_t distance)
+{
+    int lengthCode = 28;
+    while (LENGTH_BASE[lengthCode] > length)
+    {
+        lengthCode--;
+    }
+    uint32_t symbol = 257 + lengthCode;
+    if (symbol < 280)
+    {
+        putCode(symbol - 256, 7);
+    }
+    else
+    {
+        putCode(0xC0 + (symbol - 280), 8);
+    }
+    putBits(length - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+
+    int distCode = 29;
+    while (DIST_BASE[distCode] > distance)
+    {
+        distCode--;
+    }
+    putCode(distCode, 5);
+    putBits(distance - DIST_BASE[distCode], DIST_EXTRA[distCode]);
+}
+
+void GzipStream::flushBits()
+{
+    if (bitCount > 0)
+    {
+        putByte((uint8_t) bitBuffer);
+    }
+    bitBuffer = 0;
+    bitCount  = 0;
+}
+
+size_t GzipStream::compress(size_t length, bool last, uint8_t *output, size_t outputCapacity)
+{
+    if (finished || output == nullptr || length > MAX_INPUT ||
+        (length > 0 && inputBudget(outputCapacity) < length))
+    {
+        return 0;
+    }
+    out         = output;
+    outPos      = 0;
+    outCapacity = outputCapacity;
+
+    if (!started)
+    {
+        // Magic, deflate, no flags, no mtime, no extra flags, OS unknown
+        static const uint8_t header[HEADER_SIZE] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+        for (size_t i = 0; i < HEADER_SIZE; i++)
+        {
+            putByte(header[i]);
+        }
+        started = true;
+    }
+
+    if (length > 0)
+    {
+        const uint8_t *input = window + historyLength;
+        crc                  = crc32Update(crc, input, length);
+        totalIn += length;
+
+        putBits(0, 1);  // BFINAL
+        putBits(1, 2);  // fixed Huffman
+
+        size_t end = historyLength + length;
+        size_t i   = historyLength;
+        while (i < end)
+        {
+            size_t bestLength = 0;
+            size_t distance   = 0;
+            if (i + MIN_MATCH <= end)
+            {
+                uint32_t hash      = hashAt(window + i);
+                uint32_t candidate = head[hash];
+                uint32_t position  = windowBase + (uint32_t) i;
+                head[hash]         = position + 1;
+                if (candidate > windowBase && candidate - 1 < position &&
+                    position - (candidate - 1) <= WINDOW_SIZE)
+                {
+                    size_t match = candidate - 1 - windowBase;
+                    size_t limit = end - i;
+                    if (limit > MAX_MATCH)
+                    {
+                        limit = MAX_MATCH;
+                    }
+                    while (bestLength < limit && window[match + bestLength] == window[i + bestLength])
+                    {
+                        bestLength++;
+                    }
+                    distance = i - match;
+                }
+            }
+            if (bestLength >= MIN_MATCH)
+            {
+                putMatch(bestLength, distance);
+                // Index the covered positions so later chunks can match into them.
+                for (size_t k = 1; k < bestLength && i + k + MIN_MATCH <= end; k++)
+                {
+                    head[hashAt(window + i + k)] = windowBase + (uint32_t) (i + k) + 1;
+                }
+                i += bestLength;
+            }
+            else
+            {
+                putLiteral(window[i]);
+                i++;
+            }
+        }
+        putCode(0, 7);  // end of block
+
+        // Keep the newest WINDOW_SIZE bytes as history for the next chunk.
+        if (end > WINDOW_SIZE)
+        {
+            size_t shift = end - WINDOW_SIZE;
+            memmove(window, window + shift, WINDOW_SIZE);
+            windowBase += (uint32_t) shift;
+            historyLength = WINDOW_SIZE;
+        }
+        else
+        {
+            historyLength = end;
+        }
+    }
+
+    if (last)
+    {
+        putBits(1, 1);  // BFINAL
+        putBits(1, 2);  // fixed Huffman
+        putCode(0, 7);  // end of block
+        flushBits();
+        uint32_t trailer[2] = {crc, totalIn};
+        for (int w = 0; w < 2; w++)
+        {
+            for (int b = 0; b < 4; b++)
+            {
+                putByte((uint8_t) (trailer[w] >> (8 * b)));
+            }
+        }
+        finished = true;
+    }
+
+    size_t written = outPos < outCapacity ? outPos : outCapacity;
+    totalOut += written;
+    out = nullptr;
+    return written;
+}
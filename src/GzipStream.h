@@ -0,0 +1,71 @@
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Streaming gzip (RFC 1952) encoder for chunked HTTP responses.
+//
+// Each compress() call turns one chunk of raw input into one deflate block
+// with the fixed Huffman code, so every chunk can go out on the wire as soon
+// as it is produced. Matches may reach back WINDOW_SIZE bytes into earlier
+// chunks, which keeps RAM to the object itself (about 4 KB) instead of the
+// 32 KB window zlib would use.
+class GzipStream
+{
+   public:
+    static const size_t WINDOW_SIZE  = 1024;
+    static const size_t MAX_INPUT    = 1024;  // raw bytes per compress() call
+    static const size_t HASH_BITS    = 9;
+    static const size_t HASH_ENTRIES = 1 << HASH_BITS;
+    static const size_t MIN_MATCH    = 3;
+    static const size_t MAX_MATCH    = 258;
+    static const size_t HEADER_SIZE  = 10;
+    static const size_t TRAILER_SIZE = 8;
+
+    GzipStream();
+
+    // Largest raw chunk whose output, including header and trailer, always
+    // fits in outputCapacity. 0 if the capacity is too small to be useful.
+    static size_t inputBudget(size_t outputCapacity);
+
+    // Raw input for the next compress() call is written here, up to
+    // MAX_INPUT bytes, so sources fill it without an extra copy.
+    uint8_t *inputBuffer();
+
+    // Compresses `length` bytes from inputBuffer() into output, emitting the
+    // header on the first call. When `last` is set the stream is closed with
+    // a final block and the CRC/length trailer. Returns the bytes written, or
+    // 0 if output is smaller than the inputBudget() contract allows.
+    size_t compress(size_t length, bool last, uint8_t *output, size_t outputCapacity);
+
+    bool     isFinished() const { return finished; }
+    uint32_t rawBytes() const { return totalIn; }
+    uint32_t compressedBytes() const { return totalOut; }
+
+   private:
+    uint8_t  window[WINDOW_SIZE + MAX_INPUT];
+    uint32_t head[HASH_ENTRIES];  // absolute position + 1 of the last 3-byte match; 0 = empty
+    size_t   historyLength;       // bytes of earlier input kept at the start of window
+    uint32_t windowBase;          // absolute stream position of window[0]
+    uint32_t crc;
+    uint32_t totalIn;
+    uint32_t totalOut;
+    uint32_t bitBuffer;
+    uint8_t  bitCount;
+    bool     started;
+    bool     finished;
+
+    uint8_t *out;
+    size_t   outPos;
+    size_t   outCapacity;
+
+    void putBits(uint32_t value, uint8_t count);
+    void putCode(uint32_t code, uint8_t length);
+    void putLiteral(uint8_t literal);
+    void putMatch(size_t length, size_t distance);
+    void putByte(uint8_t value);
+    void flushBits();
+};
+
+#endif  // GZIP_STREAM_H
@@ -0,0 +1,106 @@
+#include "JobIdentity.h"
+
+#include <string.h>
+
+namespace
+{
+bool textDiffers(const char *known, const char *seen)
+{
+    return known[0] != '\0' && seen[0] != '\0' && strcmp(known, seen) != 0;
+}
+
+bool countDiffers(int32_t known, int32_t seen)
+{
+    return known > 0 && seen > 0 && known != seen;
+}
+
+void copyText(char *dest, size_t size, const char *src)
+{
+    strncpy(dest, src, size - 1);
+    dest[size - 1] = '\0';
+}
+}  // namespace
+
+JobTracker::JobTracker()
+{
+    reset();
+}
+
+void JobTracker::reset()
+{
+    memset(&job, 0, sizeof(job));
+    number       = 0;
+    highestTicks = 0;
+}
+
+const char *JobTracker::changeName(job_change_t change)
+{
+    switch (change)
+    {
+        case JOB_CHANGE_NONE:
+            return "none";
+        case JOB_CHANGE_NEW:
+            return "new";
+        case JOB_CHANGE_RESTARTED:
+            return "restarted";
+    }
+    return "unknown";
+}
+
+bool JobTracker::sameJob(const sdcp_print_info_t &info) const
+{
+    // TotalTicks is left out: the printer re-estimates it mid-print.
+    return !textDiffers(job.taskId, info.taskId) && !textDiffers(job.filename, info.filename) &&
+           !countDiffers(job.totalLayer, info.totalLayer);
+}
+
+void JobTracker::adopt(const sdcp_print_info_t &info)
+{
+    if (info.taskId[0] != '\0')
+    {
+        copyText(job.taskId, sizeof(job.taskId), info.taskId);
+    }
+    if (info.filename[0] != '\0')
+    {
+        copyText(job.filename, sizeof(job.filename), info.filename);
+    }
+    if (info.totalLayer > 0)
+    {
+        job.totalLayer = info.totalLayer;
+    }
+    if (info.totalTicks > 0)
+    {
+        job.totalTicks = info.totalTicks;
+    }
+}
+
+job_change_t JobTracker::observe(const sdcp_print_info_t &info)
+{
+    if (info.taskId[0] == '\0' && info.filename[0] == '\0')
+    {
+        return JOB_CHANGE_NONE;
+    }
+
+    if (number == 0 || !sameJob(info))
+    {
+        memset(&job, 0, sizeof(job));
+        adopt(info);
+        number++;
+        highestTicks = info.currentTicks > 0 ? info.currentTicks : 0;
+        return JOB_CHANGE_NEW;
+    }
+
+    adopt(info);
+    if (info.currentTicks <= 0)
+    {
+        return JOB_CHANGE_NONE;
+    }
+    if (highestTicks > 0 && info.currentTicks < highestTicks)
+    {
+        number++;
+        highestTicks = info.currentTicks;
+        return JOB_CHANGE_RESTARTED;
+    }
+    highestTicks = info.currentTicks;
+    return JOB_CHANGE_NONE;
+}
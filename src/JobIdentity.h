@@ -0,0 +1,61 @@
+#ifndef JOB_IDENTITY_H
+#define JOB_IDENTITY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SdcpCodec.h"
+
+typedef enum
+{
+    JOB_CHANGE_NONE      = 0,  // same job, or the frame does not say which job
+    JOB_CHANGE_NEW       = 1,  // first job seen, or a different one
+    JOB_CHANGE_RESTARTED = 2,  // same file and task, but CurrentTicks went back
+} job_change_t;
+
+// What the printer reports about the job it is running. Empty strings and
+// zero counts are unknown.
+struct JobIdentity
+{
+    char    taskId[SDCP_ID_LENGTH];
+    char    filename[SDCP_FILENAME_LENGTH];
+    int32_t totalLayer;
+    int32_t totalTicks;
+};
+
+// Tells jobs apart from the PrintInfo block of status frames, so tracking
+// state can be kept per job instead of per print status transition.
+//
+// A frame belongs to a different job when TaskId, Filename or TotalLayer
+// differ from the current job. TotalTicks is recorded but not compared: the
+// printer revises the estimate mid-print. Fields unknown on either side
+// never differ: they are filled in as the printer starts reporting them.
+// The same job printed again is recognised by CurrentTicks going back,
+// since ticks only grow while a job runs. Frames without a TaskId or
+// Filename are ignored.
+class JobTracker
+{
+   public:
+    JobTracker();
+
+    void         reset();
+    job_change_t observe(const sdcp_print_info_t &info);
+
+    bool hasJob() const { return number != 0; }
+    // 1 for the first job seen, then counts up with every change; 0 before
+    // any job was seen.
+    uint32_t           jobNumber() const { return number; }
+    const JobIdentity &current() const { return job; }
+
+    static const char *changeName(job_change_t change);
+
+   private:
+    JobIdentity job;
+    uint32_t    number;
+    int32_t     highestTicks;
+
+    bool sameJob(const sdcp_print_info_t &info) const;
+    void adopt(const sdcp_print_info_t &info);
+};
+
+#endif  // JOB_IDENTITY_H
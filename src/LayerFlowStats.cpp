@@ -0,0 +1,215 @@
+#include "LayerFlowStats.h"
+
+#include <stdio.h>
+#include <string.h>
+
+LayerFlowStats::LayerFlowStats()
+{
+    begin(0);
+}
+
+void LayerFlowStats::clearBucket(layer_flow_bucket_t &bucket)
+{
+    memset(&bucket, 0, sizeof(bucket));
+    bucket.minFlowRatio = -1.0f;
+}
+
+void LayerFlowStats::begin(int layers)
+{
+    for (size_t i = 0; i < MAX_BUCKETS; i++)
+    {
+        clearBucket(buckets[i]);
+    }
+    usedBuckets     = 0;
+    totalLayers     = 0;
+    layersPerBucket = 1;
+    hasBaseline     = false;
+    lastExpectedMm  = 0.0f;
+    lastActualMm    = 0.0f;
+    lastPulses      = 0;
+    lastSampleMs    = 0;
+    setTotalLayers(layers);
+}
+
+void LayerFlowStats::setTotalLayers(int layers)
+{
+    if (layers <= 0)
+    {
+        return;
+    }
+    totalLayers = layers;
+    while ((size_t) ((layers + layersPerBucket - 1) / layersPerBucket) > MAX_BUCKETS)
+    {
+        coarsen();
+    }
+}
+
+void LayerFlowStats::coarsen()
+{
+    for (size_t i = 0; i < MAX_BUCKETS / 2; i++)
+    {
+        layer_flow_bucket_t &merged = buckets[i];
+        merged                      = buckets[2 * i];
+        const layer_flow_bucket_t &next = buckets[2 * i + 1];
+
+        merged.expectedMm += next.expectedMm;
+        merged.actualMm += next.actualMm;
+        merged.pulses += next.pulses;
+        merged.durationMs += next.durationMs;
+        if (next.peakDeficitMm > merged.peakDeficitMm)
+        {
+            merged.peakDeficitMm = next.peakDeficitMm;
+        }
+        if (next.minFlowRatio >= 0.0f &&
+            (merged.minFlowRatio < 0.0f || next.minFlowRatio < merged.minFlowRatio))
+        {
+            merged.minFlowRatio = next.minFlowRatio;
+        }
+    }
+    for (size_t i = MAX_BUCKETS / 2; i < MAX_BUCKETS; i++)
+    {
+        clearBucket(buckets[i]);
+    }
+    usedBuckets = (usedBuckets + 1) / 2;
+    layersPerBucket *= 2;
+}
+
+void LayerFlowStats::updateRatio(layer_flow_bucket_t &bucket)
+{
+    if (bucket.expectedMm < MIN_RATIO_EXPECTED_MM)
+    {
+        return;
+    }
+    float ratio = bucket.actualMm / bucket.expectedMm;
+    if (bucket.minFlowRatio < 0.0f || ratio < bucket.minFlowRatio)
+    {
+        bucket.minFlowRatio = ratio;
+    }
+}
+
+void LayerFlowStats::sample(int layer, float expectedTotalMm, float actualTotalMm,
+                            uint32_t pulseTotal, float deficitMm, unsigned long nowMs)
+{
+    // Totals going backwards means tracking was reset; start a new baseline
+    // instead of crediting a negative delta.
+    if (!hasBaseline || expectedTotalMm < lastExpectedMm || actualTotalMm < lastActualMm ||
+        pulseTotal < lastPulses)
+    {
+        hasBaseline    = true;
+        lastExpectedMm = expectedTotalMm;
+        lastActualMm   = actualTotalMm;
+        lastPulses     = pulseTotal;
+        lastSampleMs   = nowMs;
+        return;
+    }
+
+    if (layer < 0)
+    {
+        layer = 0;
+    }
+    while ((size_t) (layer / layersPerBucket) >= MAX_BUCKETS)
+    {
+        coarsen();
+    }
+    size_t               index  = (size_t) (layer / layersPerBucket);
+    layer_flow_bucket_t &bucket = buckets[index];
+    if (index + 1 > usedBuckets)
+    {
+        usedBuckets = index + 1;
+    }
+
+    bucket.expectedMm += expectedTotalMm - lastExpectedMm;
+    bucket.actualMm += actualTotalMm - lastActualMm;
+    bucket.pulses += pulseTotal - lastPulses;
+    bucket.durationMs += nowMs - lastSampleMs;
+    if (deficitMm > bucket.peakDeficitMm)
+    {
+        bucket.peakDeficitMm = deficitMm;
+    }
+    updateRatio(bucket);
+
+    lastExpectedMm = expectedTotalMm;
+    lastActualMm   = actualTotalMm;
+    lastPulses     = pulseTotal;
+    lastSampleMs   = nowMs;
+}
+
+LayerJsonCursor LayerFlowStats::beginJson() const
+{
+    LayerJsonCursor cursor;
+    cursor.nextBucket = 0;
+    cursor.state      = 0;
+    return cursor;
+}
+
+size_t LayerFlowStats::readJson(LayerJsonCursor &cursor, char *out, size_t maxLen) const
+{
+    size_t written = 0;
+    char   piece[224];
+
+    while (cursor.state < 3)
+    {
+        int length = 0;
+        if (cursor.state == 0)
+        {
+            length = snprintf(piece, sizeof(piece),
+                              "{\"totalLayers\":%d,\"layersPerBucket\":%d,\"layers\":[",
+                              totalLayers, layersPerBucket);
+        }
+        else if (cursor.state == 1 && cursor.nextBucket < usedBuckets)
+        {
+            const layer_flow_bucket_t &bucket = buckets[cursor.nextBucket];
+            int firstLayer = (int) cursor.nextBucket * layersPerBucket;
+            length         = snprintf(piece, sizeof(piece),
+                                      "%s{\"firstLayer\":%d,\"lastLayer\":%d,\"expectedMm\":%.2f,"
+                                      "\"actualMm\":%.2f,\"peakDeficitMm\":%.2f,\"minFlowRatio\":",
+                                      cursor.nextBucket == 0 ? "" : ",", firstLayer,
+                                      firstLayer + layersPerBucket - 1, bucket.expectedMm,
+                                      bucket.actualMm, bucket.peakDeficitMm);
+            if (length > 0 && (size_t) length < sizeof(piece))
+            {
+                int tail = bucket.minFlowRatio < 0.0f
+                               ? snprintf(piece + length, sizeof(piece) - length, "null")
+                               : snprintf(piece + length, sizeof(piece) - length, "%.3f",
+                                          bucket.minFlowRatio);
+                length += tail;
+            }
+            if (length > 0 && (size_t) length < sizeof(piece))
+            {
+                length += snprintf(piece + length, sizeof(piece) - length,
+                                   ",\"pulses\":%lu,\"durationMs\":%lu}",
+                                   (unsigned long) bucket.pulses,
+                                   (unsigned long) bucket.durationMs);
+            }
+        }
+        else if (cursor.state == 1)
+        {
+            cursor.state = 2;
+            continue;
+        }
+        else
+        {
+            length = snprintf(piece, sizeof(piece), "]}");
+        }
+
+        if (length < 0 || (size_t) length >= sizeof(piece))
+        {
+            length = 0;
+        }
+        if (written + (size_t) length > maxLen)
+        {
+            break;
+        }
+        memcpy(out + written, piece, (size_t) length);
+        written += (size_t) length;
+        if (cursor.state == 1)
+        {
+            cursor.nextBucket++;
+        }
+        else
+        {
+            cursor.state++;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,85 @@
+#ifndef LAYER_FLOW_STATS_H
+#define LAYER_FLOW_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Flow totals for one layer, or for a run of layers once coarsened.
+typedef struct
+{
+    float    expectedMm;
+    float    actualMm;
+    float    peakDeficitMm;
+    float    minFlowRatio;  // actual/expected within the bucket; < 0 until measurable
+    uint32_t pulses;
+    uint32_t durationMs;
+} layer_flow_bucket_t;
+
+// Position of an in-progress streaming read of the buckets as JSON.
+struct LayerJsonCursor
+{
+    size_t nextBucket;
+    int    state;  // 0 header, 1 buckets, 2 trailer, 3 done
+
+    bool done() const { return state == 3; }
+};
+
+// Per-layer breakdown of expected vs. actual filament for the current print.
+//
+// Memory is one fixed array of MAX_BUCKETS entries. A print with more layers
+// than that is stored with several layers per bucket; if the layer count is
+// unknown or grows past what was planned for, adjacent buckets are merged
+// pairwise and the layers-per-bucket doubles, so a bucket always covers a
+// contiguous run of layers.
+//
+// The detection loop feeds cumulative totals via sample(); the deltas since
+// the previous sample are credited to the layer being printed.
+class LayerFlowStats
+{
+   public:
+    static const size_t MAX_BUCKETS = 256;
+    // Expected filament a bucket needs before its flow ratio means anything;
+    // below this one sensor pulse swings the ratio wildly.
+    static constexpr float MIN_RATIO_EXPECTED_MM = 5.0f;
+
+    LayerFlowStats();
+
+    void begin(int totalLayers);
+    // Coarsens if needed so totalLayers fits; never refines.
+    void setTotalLayers(int totalLayers);
+    void sample(int layer, float expectedTotalMm, float actualTotalMm, uint32_t pulseTotal,
+                float deficitMm, unsigned long nowMs);
+    // Call while not sampling (paused, idle) so the gap is not credited to
+    // the next sample's layer.
+    void resync() { hasBaseline = false; }
+
+    int    getTotalLayers() const { return totalLayers; }
+    int    getLayersPerBucket() const { return layersPerBucket; }
+    // Buckets up to and including the highest one written.
+    size_t getBucketCount() const { return usedBuckets; }
+    const layer_flow_bucket_t &getBucket(size_t index) const { return buckets[index]; }
+
+    LayerJsonCursor beginJson() const;
+    // Streams {"totalLayers":..,"layersPerBucket":..,"layers":[..]} in pieces.
+    // Returns 0 when finished, or when maxLen cannot hold the next piece
+    // (cursor.done() tells which).
+    size_t readJson(LayerJsonCursor &cursor, char *out, size_t maxLen) const;
+
+   private:
+    layer_flow_bucket_t buckets[MAX_BUCKETS];
+    size_t              usedBuckets;
+    int                 totalLayers;
+    int                 layersPerBucket;
+
+    bool          hasBaseline;
+    float         lastExpectedMm;
+    float         lastActualMm;
+    uint32_t      lastPulses;
+    unsigned long lastSampleMs;
+
+    void        clearBucket(layer_flow_bucket_t &bucket);
+    void        coarsen();
+    static void updateRatio(layer_flow_bucket_t &bucket);
+};
+
+#endif  // LAYER_FLOW_STATS_H
@@ -0,0 +1,155 @@
+#include "LinkLiveness.h"
+
+#include <string.h>
+
+namespace
+{
+void sortAscending(uint16_t *values, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        uint16_t value = values[i];
+        size_t   j     = i;
+        while (j > 0 && values[j - 1] > value)
+        {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+}
+}  // namespace
+
+LinkLiveness::LinkLiveness()
+{
+    memset(gaps, 0, sizeof(gaps));
+    memset(&stats, 0, sizeof(stats));
+    gapCount       = 0;
+    gapNext        = 0;
+    probeRttEwmaMs = 0;
+    backoff        = 0;
+    reset(0);
+}
+
+void LinkLiveness::reset(uint32_t nowMs)
+{
+    lastFrameMs = nowMs;
+    probeSentMs = 0;
+    linkState   = LINK_STATE_ALIVE;
+}
+
+const char *LinkLiveness::stateName(link_state_t state)
+{
+    switch (state)
+    {
+        case LINK_STATE_ALIVE:
+            return "alive";
+        case LINK_STATE_PROBING:
+            return "probing";
+        case LINK_STATE_LOST:
+            return "lost";
+    }
+    return "unknown";
+}
+
+void LinkLiveness::recordGap(uint32_t gapMs)
+{
+    gaps[gapNext] = gapMs > 0xFFFF ? 0xFFFF : (uint16_t) gapMs;
+    gapNext       = (gapNext + 1) % GAP_HISTORY;
+    if (gapCount < GAP_HISTORY)
+    {
+        gapCount++;
+    }
+    if (gapCount < MIN_SAMPLES)
+    {
+        return;
+    }
+
+    // Once per frame over at most GAP_HISTORY values
+    uint16_t sorted[GAP_HISTORY];
+    memcpy(sorted, gaps, gapCount * sizeof(uint16_t));
+    sortAscending(sorted, gapCount);
+    size_t rank    = (99 * gapCount + 99) / 100;
+    stats.p99GapMs = sorted[rank - 1];
+}
+
+void LinkLiveness::onFrame(uint32_t nowMs)
+{
+    uint32_t gap = nowMs - lastFrameMs;
+    stats.frames++;
+    recordGap(gap);
+    if (linkState == LINK_STATE_PROBING)
+    {
+        uint32_t rtt         = nowMs - probeSentMs;
+        stats.lastProbeRttMs = rtt;
+        stats.probesAnswered++;
+        probeRttEwmaMs = probeRttEwmaMs == 0 ? rtt : probeRttEwmaMs - probeRttEwmaMs / 4 + rtt / 4;
+        if (backoff < MAX_BACKOFF)
+        {
+            backoff++;
+        }
+    }
+    else if (backoff > 0 && baseTimeoutMs() >= gap)
+    {
+        backoff = 0;
+    }
+    lastFrameMs = nowMs;
+    linkState   = LINK_STATE_ALIVE;
+}
+
+uint32_t LinkLiveness::baseTimeoutMs() const
+{
+    if (stats.p99GapMs == 0)
+    {
+        return DEFAULT_TIMEOUT_MS;
+    }
+    uint32_t timeout = stats.p99GapMs + stats.p99GapMs / 2;
+    return timeout < MIN_TIMEOUT_MS ? MIN_TIMEOUT_MS : timeout;
+}
+
+uint32_t LinkLiveness::silenceTimeoutMs() const
+{
+    uint32_t timeout = baseTimeoutMs() << backoff;
+    return timeout > MAX_TIMEOUT_MS ? MAX_TIMEOUT_MS : timeout;
+}
+
+uint32_t LinkLiveness::probeTimeoutMs() const
+{
+    if (probeRttEwmaMs == 0)
+    {
+        return DEFAULT_PROBE_TIMEOUT_MS;
+    }
+    uint32_t timeout = probeRttEwmaMs * 4;
+    if (timeout < MIN_PROBE_TIMEOUT_MS)
+    {
+        return MIN_PROBE_TIMEOUT_MS;
+    }
+    return timeout > MAX_PROBE_TIMEOUT_MS ? MAX_PROBE_TIMEOUT_MS : timeout;
+}
+
+link_action_t LinkLiveness::update(uint32_t nowMs)
+{
+    switch (linkState)
+    {
+        case LINK_STATE_ALIVE:
+            if (nowMs - lastFrameMs > silenceTimeoutMs())
+            {
+                linkState   = LINK_STATE_PROBING;
+                probeSentMs = nowMs;
+                stats.probes++;
+                return LINK_ACTION_PROBE;
+            }
+            break;
+        case LINK_STATE_PROBING:
+            if (nowMs - probeSentMs > probeTimeoutMs())
+            {
+                linkState = LINK_STATE_LOST;
+                stats.losses++;
+                return LINK_ACTION_LOST;
+            }
+            break;
+        case LINK_STATE_LOST:
+            break;
+    }
+    return LINK_ACTION_NONE;
+}
@@ -0,0 +1,92 @@
+#ifndef LINK_LIVENESS_H
+#define LINK_LIVENESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+    LINK_STATE_ALIVE   = 0,
+    LINK_STATE_PROBING = 1,  // silent too long; a status request is out
+    LINK_STATE_LOST    = 2,  // the probe went unanswered too
+} link_state_t;
+
+typedef enum
+{
+    LINK_ACTION_NONE  = 0,
+    LINK_ACTION_PROBE = 1,  // caller should send a status request now
+    LINK_ACTION_LOST  = 2,  // caller should treat the link as down
+} link_action_t;
+
+// Decides when a printer connection has gone quiet for longer than it
+// normally does.
+//
+// The gaps between received frames are kept in a ring, and silence beyond
+// the 99th percentile gap times 1.5 triggers a probe. Loss is only declared
+// if the probe also goes unanswered within a few probe round trips. A chatty
+// printer therefore fails over in about a second or two, while a quiet one
+// learns a long timeout instead of tripping false losses. Until enough gaps
+// have been seen the fixed DEFAULT_TIMEOUT_MS applies.
+//
+// A gap that ends with a probe answer is recorded too, but it only says the
+// real gap is longer. Each answered probe therefore also doubles the timeout
+// (up to 16x). The backoff is dropped once the quantile alone covers the
+// printer's natural gaps again, so a printer that slows down between prints
+// costs a couple of probes instead of a false loss.
+class LinkLiveness
+{
+   public:
+    static const size_t   GAP_HISTORY              = 128;
+    static const uint32_t MIN_SAMPLES              = 16;
+    static const uint32_t DEFAULT_TIMEOUT_MS       = 10000;
+    static const uint32_t MIN_TIMEOUT_MS           = 750;
+    static const uint32_t MAX_TIMEOUT_MS           = 30000;
+    static const uint32_t DEFAULT_PROBE_TIMEOUT_MS = 1000;
+    static const uint32_t MIN_PROBE_TIMEOUT_MS     = 300;
+    static const uint32_t MAX_PROBE_TIMEOUT_MS     = 3000;
+    static const uint8_t  MAX_BACKOFF              = 4;
+
+    struct Stats
+    {
+        uint32_t frames;
+        uint32_t probes;
+        uint32_t probesAnswered;
+        uint32_t losses;
+        uint32_t lastProbeRttMs;
+        uint32_t p99GapMs;  // 0 until MIN_SAMPLES gaps are known
+    };
+
+    LinkLiveness();
+
+    // Connection (re)established at `nowMs`; learned gaps are kept since
+    // they describe the printer, not the connection.
+    void reset(uint32_t nowMs);
+    // Every status frame. Pongs and acks don't show that the printer is
+    // still reporting, so they are not fed here.
+    void onFrame(uint32_t nowMs);
+    // Call every loop pass while connected
+    link_action_t update(uint32_t nowMs);
+
+    link_state_t state() const { return linkState; }
+    uint32_t     silenceTimeoutMs() const;
+    uint32_t     probeTimeoutMs() const;
+    Stats        getStats() const { return stats; }
+
+    static const char *stateName(link_state_t state);
+
+   private:
+    uint16_t     gaps[GAP_HISTORY];
+    size_t       gapCount;
+    size_t       gapNext;
+    uint32_t     lastFrameMs;
+    uint32_t     probeSentMs;
+    uint32_t     probeRttEwmaMs;  // 0 until a probe has been answered
+    uint8_t      backoff;         // timeout doubled this many times
+    link_state_t linkState;
+    Stats        stats;
+
+    void     recordGap(uint32_t gapMs);
+    uint32_t baseTimeoutMs() const;
+};
+
+#endif  // LINK_LIVENESS_H
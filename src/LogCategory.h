@@ -0,0 +1,90 @@
+#ifndef LOG_CATEGORY_H
+#define LOG_CATEGORY_H
+
+#include <stdint.h>
+
+#include "LogSink.h"
+
+// Leveled, categorized logging.
+//
+//   LOGD(LOG_CAT_FLOW, "Flow debug: pulses=%lu", pulses);
+//
+// Calls below LOG_LEVEL_FLOOR are removed by the preprocessor, format string
+// and argument evaluation included. Calls that survive test one bit of a
+// cached category mask before evaluating any argument, so a disabled line
+// costs a load and a branch. The mask is rebuilt from the settings whenever
+// they are loaded or saved (see SettingsManager).
+//
+// The macros expand to logger.logf(level, category, ...), so include
+// Logger.h (which includes this header) rather than this header on its own.
+// The category is stored with the line so log queries can filter on it.
+
+typedef enum
+{
+    LOG_CAT_GENERAL           = 0,  // always enabled
+    LOG_CAT_FLOW              = 1,  // per-pulse / per-cycle flow debug (verbose_logging)
+    LOG_CAT_FLOW_SUMMARY      = 2,  // one condensed flow line per second (flow_summary_logging)
+    LOG_CAT_PACKET            = 3,  // every SDCP extrusion packet (packet_flow_logging)
+    LOG_CAT_TELEMETRY_COMPARE = 4,  // TotalExtrusion vs delta sums (total_vs_delta_logging)
+    LOG_CAT_DEFICIT_RESET     = 5,  // deficit resets to zero (zero_deficit_logging)
+    LOG_CAT_COUNT
+} log_category_t;
+
+#define LOG_CATEGORY_BIT(category) (1UL << (category))
+
+// Build-time floor, e.g. -D LOG_LEVEL_FLOOR=2 keeps ERROR, WARN and INFO.
+// Must be a plain integer so it can be tested by #if.
+#ifndef LOG_LEVEL_FLOOR
+#define LOG_LEVEL_FLOOR 4
+#endif
+
+// Defined by Logger.cpp.
+extern volatile uint32_t logCategoryMask;
+
+#define LOG_CATEGORY_ENABLED(category) ((logCategoryMask & LOG_CATEGORY_BIT(category)) != 0)
+
+#define LOG_AT_(level, category, ...)                          \
+    do                                                         \
+    {                                                          \
+        if (LOG_CATEGORY_ENABLED(category))                    \
+        {                                                      \
+            logger.logf((level), (category), __VA_ARGS__);     \
+        }                                                      \
+    } while (0)
+
+#define LOG_DISCARD_(...) \
+    do                    \
+    {                     \
+    } while (0)
+
+#if LOG_LEVEL_FLOOR >= 0
+#define LOGE(category, ...) LOG_AT_(LOG_LEVEL_ERROR, category, __VA_ARGS__)
+#else
+#define LOGE(category, ...) LOG_DISCARD_()
+#endif
+
+#if LOG_LEVEL_FLOOR >= 1
+#define LOGW(category, ...) LOG_AT_(LOG_LEVEL_WARN, category, __VA_ARGS__)
+#else
+#define LOGW(category, ...) LOG_DISCARD_()
+#endif
+
+#if LOG_LEVEL_FLOOR >= 2
+#define LOGI(category, ...) LOG_AT_(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#else
+#define LOGI(category, ...) LOG_DISCARD_()
+#endif
+
+#if LOG_LEVEL_FLOOR >= 3
+#define LOGD(category, ...) LOG_AT_(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#else
+#define LOGD(category, ...) LOG_DISCARD_()
+#endif
+
+#if LOG_LEVEL_FLOOR >= 4
+#define LOGV(category, ...) LOG_AT_(LOG_LEVEL_VERBOSE, category, __VA_ARGS__)
+#else
+#define LOGV(category, ...) LOG_DISCARD_()
+#endif
+
+#endif  // LOG_CATEGORY_H
@@ -0,0 +1,179 @@
+#include "LogCodec.h"
+
+#include <string.h>
+
+static const size_t MAX_LITERAL_RUN = 32;
+
+static inline uint32_t hashAt(const uint8_t *p)
+{
+    uint32_t v = ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+    return ((v * 2654435761u) >> (32 - LogCodec::HASH_BITS)) & (LogCodec::HASH_ENTRIES - 1);
+}
+
+// Emits input[start, end) as literal runs. Returns false if out of space.
+static bool emitLiterals(const uint8_t *input, size_t start, size_t end, uint8_t *output,
+                         size_t outputCapacity, size_t &op)
+{
+    while (start < end)
+    {
+        size_t run = end - start;
+        if (run > MAX_LITERAL_RUN)
+        {
+            run = MAX_LITERAL_RUN;
+        }
+        if (op + 1 + run > outputCapacity)
+        {
+            return false;
+        }
+        output[op++] = (uint8_t) (run - 1);
+        memcpy(output + op, input + start, run);
+        op += run;
+        start += run;
+    }
+    return true;
+}
+
+size_t LogCodec::compress(const uint8_t *input, size_t inputLength, uint8_t *output,
+                          size_t outputCapacity, uint16_t *hashTable)
+{
+    if (input == nullptr || output == nullptr || hashTable == nullptr || inputLength == 0 ||
+        inputLength > 0xFFFF)
+    {
+        return 0;
+    }
+
+    // Positions are stored +1 so that 0 means "empty".
+    memset(hashTable, 0, HASH_ENTRIES * sizeof(uint16_t));
+
+    size_t op         = 0;
+    size_t ip         = 0;
+    size_t literalPos = 0;
+
+    while (ip + MIN_MATCH <= inputLength)
+    {
+        uint32_t h         = hashAt(input + ip);
+        size_t   candidate = hashTable[h];
+        hashTable[h]       = (uint16_t) (ip + 1);
+
+        if (candidate != 0)
+        {
+            size_t ref      = candidate - 1;
+            size_t distance = ip - ref;
+            if (distance >= 1 && distance <= MAX_OFFSET && input[ref] == input[ip] &&
+                input[ref + 1] == input[ip + 1] && input[ref + 2] == input[ip + 2])
+            {
+                size_t maxLength = inputLength - ip;
+                if (maxLength > MAX_MATCH)
+                {
+                    maxLength = MAX_MATCH;
+                }
+                size_t length = MIN_MATCH;
+                while (length < maxLength && input[ref + length] == input[ip + length])
+                {
+                    length++;
+                }
+
+                if (!emitLiterals(input, literalPos, ip, output, outputCapacity, op))
+                {
+                    return 0;
+                }
+
+                size_t encodedLength = length - 2;
+                size_t encodedOffset = distance - 1;
+                if (encodedLength < 7)
+                {
+                    if (op + 2 > outputCapacity)
+                    {
+                        return 0;
+                    }
+                    output[op++] = (uint8_t) ((encodedLength << 5) | (encodedOffset >> 8));
+                }
+                else
+                {
+                    if (op + 3 > outputCapacity)
+                    {
+                        return 0;
+                    }
+                    output[op++] = (uint8_t) ((7 << 5) | (encodedOffset >> 8));
+                    output[op++] = (uint8_t) (encodedLength - 7);
+                }
+                output[op++] = (uint8_t) (encodedOffset & 0xFF);
+
+                // Seed the hash with the tail of the match so the next line
+                // can find it; hashing every byte costs more than it gains.
+                size_t end = ip + length;
+                if (end + MIN_MATCH <= inputLength && length > 4)
+                {
+                    hashTable[hashAt(input + end - 1)] = (uint16_t) (end - 1 + 1);
+                }
+                ip         = end;
+                literalPos = ip;
+                continue;
+            }
+        }
+        ip++;
+    }
+
+    if (!emitLiterals(input, literalPos, inputLength, output, outputCapacity, op))
+    {
+        return 0;
+    }
+    return op;
+}
+
+size_t LogCodec::decompress(const uint8_t *input, size_t inputLength, uint8_t *output,
+                            size_t outputCapacity)
+{
+    if (input == nullptr || output == nullptr)
+    {
+        return 0;
+    }
+
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < inputLength)
+    {
+        uint8_t control = input[ip++];
+        if (control < 32)
+        {
+            size_t run = (size_t) control + 1;
+            if (ip + run > inputLength || op + run > outputCapacity)
+            {
+                return 0;
+            }
+            memcpy(output + op, input + ip, run);
+            ip += run;
+            op += run;
+            continue;
+        }
+
+        size_t length = control >> 5;
+        if (length == 7)
+        {
+            if (ip >= inputLength)
+            {
+                return 0;
+            }
+            length += input[ip++];
+        }
+        length += 2;
+        if (ip >= inputLength)
+        {
+            return 0;
+        }
+        size_t distance = (((size_t) (control & 0x1F) << 8) | input[ip++]) + 1;
+        if (distance > op || op + length > outputCapacity)
+        {
+            return 0;
+        }
+
+        // Byte-wise copy: matches may overlap their own output.
+        const uint8_t *ref = output + op - distance;
+        for (size_t i = 0; i < length; i++)
+        {
+            output[op + i] = ref[i];
+        }
+        op += length;
+    }
+    return op;
+}
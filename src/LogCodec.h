@@ -0,0 +1,30 @@
+#ifndef LOG_CODEC_H
+#define LOG_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Small LZ77 codec (LZF-compatible stream format) used to compress sealed log
+// blocks. It needs no heap and only a caller-provided hash table, and the
+// decoder is a simple byte loop, which suits repetitive text on an MCU.
+class LogCodec
+{
+   public:
+    static const size_t HASH_BITS    = 10;
+    static const size_t HASH_ENTRIES = 1 << HASH_BITS;
+    static const size_t MAX_OFFSET   = 8192;
+    static const size_t MIN_MATCH    = 3;
+    static const size_t MAX_MATCH    = 264;
+
+    // Returns the compressed size, or 0 if the output would not fit in
+    // outputCapacity. hashTable must hold HASH_ENTRIES entries.
+    static size_t compress(const uint8_t *input, size_t inputLength, uint8_t *output,
+                           size_t outputCapacity, uint16_t *hashTable);
+
+    // Returns the decompressed size, or 0 if the input is malformed or the
+    // output would not fit in outputCapacity.
+    static size_t decompress(const uint8_t *input, size_t inputLength, uint8_t *output,
+                             size_t outputCapacity);
+};
+
+#endif  // LOG_CODEC_H
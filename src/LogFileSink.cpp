@@ -0,0 +1,392 @@
+#include "LogFileSink.h"
+
+#include <LittleFS.h>
+#include <esp_system.h>
+
+#include "Logger.h"
+#include "TimeService.h"
+
+#define LOG_DIR "/logs"
+#define CURRENT_BASE "cur"
+#define PREVIOUS_BASE "prev"
+
+static File currentFile;
+static uint8_t *chunkBuffer = nullptr;
+
+static String logPath(const char *base, int index)
+{
+    String path = String(LOG_DIR "/") + base;
+    if (index > 0)
+    {
+        path += ".";
+        path += index;
+    }
+    path += ".log";
+    return path;
+}
+
+LogFileSink &LogFileSink::getInstance()
+{
+    static LogFileSink instance;
+    return instance;
+}
+
+LogFileSink::LogFileSink()
+{
+    staging              = nullptr;
+    stagedHead           = 0;
+    stagedCount          = 0;
+    stagingMutex         = nullptr;
+    writerTask           = nullptr;
+    started              = false;
+    failed               = false;
+    preserved            = false;
+    enabled              = false;
+    lastFlushMs          = 0;
+    currentFileBytes     = 0;
+    droppedBytes         = 0;
+    reportedDroppedBytes = 0;
+    bytesWritten         = 0;
+    chunksWritten        = 0;
+    rotations            = 0;
+}
+
+bool LogFileSink::begin(bool enable)
+{
+    if (!enable || started || failed)
+    {
+        return enabled;
+    }
+
+    if (!LittleFS.exists(LOG_DIR))
+    {
+        LittleFS.mkdir(LOG_DIR);
+    }
+    // Once per boot: after that cur.log is this boot's own log
+    if (!preserved)
+    {
+        preservePreviousBoot();
+        preserved = true;
+    }
+
+    staging      = (uint8_t *) malloc(STAGING_BYTES);
+    chunkBuffer  = (uint8_t *) malloc(SECTOR_BYTES);
+    stagingMutex = xSemaphoreCreateMutex();
+    currentFile  = LittleFS.open(logPath(CURRENT_BASE, 0), "w");
+    if (staging == nullptr || chunkBuffer == nullptr || stagingMutex == nullptr || !currentFile)
+    {
+        release();
+        failed = true;
+        logger.log("Flash log: failed to initialize, persistent logging disabled until reboot");
+        return false;
+    }
+
+    lastFlushMs = millis();
+    // Lowest priority above idle; flash writes only happen when nothing
+    // else needs the CPU.
+    if (xTaskCreate(writerTaskEntry, "log_file_sink", 4096, this, tskIDLE_PRIORITY + 1,
+                    &writerTask) != pdPASS)
+    {
+        writerTask = nullptr;
+        release();
+        failed = true;
+        logger.log("Flash log: failed to start writer task, disabled until reboot");
+        return false;
+    }
+
+    started = true;
+    enabled = true;
+    logger.addSink(this);
+
+    logger.logf("Flash log started, previous boot ended with reset reason %d",
+                (int) esp_reset_reason());
+    return true;
+}
+
+void LogFileSink::release()
+{
+    free(staging);
+    free(chunkBuffer);
+    staging     = nullptr;
+    chunkBuffer = nullptr;
+    if (stagingMutex != nullptr)
+    {
+        vSemaphoreDelete(stagingMutex);
+        stagingMutex = nullptr;
+    }
+    if (currentFile)
+    {
+        currentFile.close();
+    }
+}
+
+void LogFileSink::setEnabled(bool enable)
+{
+    if (!started)
+    {
+        begin(enable);
+        return;
+    }
+    if (enable == enabled)
+    {
+        return;
+    }
+    if (enable)
+    {
+        enabled = true;
+        logger.log("Flash log resumed");
+    }
+    else
+    {
+        // Logged first so the file says why it stops here
+        logger.log("Flash log paused");
+        enabled = false;
+    }
+}
+
+void LogFileSink::preservePreviousBoot()
+{
+    if (!LittleFS.exists(logPath(CURRENT_BASE, 0)))
+    {
+        return;
+    }
+
+    for (int i = 0; i <= MAX_ROTATED_FILES; i++)
+    {
+        if (LittleFS.exists(logPath(PREVIOUS_BASE, i)))
+        {
+            LittleFS.remove(logPath(PREVIOUS_BASE, i));
+        }
+        if (LittleFS.exists(logPath(CURRENT_BASE, i)))
+        {
+            LittleFS.rename(logPath(CURRENT_BASE, i), logPath(PREVIOUS_BASE, i));
+        }
+    }
+
+    // Chunks are cut on sector boundaries, not line boundaries, so a reset
+    // between two chunks leaves the last line unfinished. Close it off so the
+    // recovered file still reads line by line.
+    File previous = LittleFS.open(logPath(PREVIOUS_BASE, 0), "r");
+    bool torn     = false;
+    if (previous && previous.size() > 0)
+    {
+        previous.seek(previous.size() - 1);
+        torn = previous.read() != '\n';
+    }
+    previous.close();
+    if (torn)
+    {
+        File recovered = LittleFS.open(logPath(PREVIOUS_BASE, 0), "a");
+        recovered.print(" [truncated by reset]\n");
+        recovered.close();
+    }
+}
+
+bool LogFileSink::enqueue(log_level_t level, uint64_t timestamp, const char *message,
+                          size_t length)
+{
+    (void) level;
+    if (!enabled)
+    {
+        return true;
+    }
+
+    // The file is an export, so it carries wall-clock seconds (0 before NTP)
+    char header[16];
+    int  headerLength = snprintf(header, sizeof(header), "%lu ",
+                                 (unsigned long) timeService.toEpochSeconds(timestamp));
+    if (headerLength < 0)
+    {
+        return false;
+    }
+    size_t total = (size_t) headerLength + length + 1;
+
+    bool queued = false;
+    xSemaphoreTake(stagingMutex, portMAX_DELAY);
+    if (stagedCount + total > STAGING_BYTES)
+    {
+        droppedBytes += total;
+    }
+    else
+    {
+        stage(header, (size_t) headerLength);
+        stage(message, length);
+        stage("\n", 1);
+        queued = true;
+    }
+    xSemaphoreGive(stagingMutex);
+    return queued;
+}
+
+void LogFileSink::stage(const char *data, size_t length)
+{
+    // Caller holds stagingMutex and has checked there is room.
+    size_t tail  = (stagedHead + stagedCount) % STAGING_BYTES;
+    size_t first = STAGING_BYTES - tail;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(staging + tail, data, first);
+    memcpy(staging, data + first, length - first);
+    stagedCount += length;
+}
+
+void LogFileSink::writerTaskEntry(void *arg)
+{
+    static_cast<LogFileSink *>(arg)->writerLoop();
+}
+
+void LogFileSink::writerLoop()
+{
+    while (true)
+    {
+        vTaskDelay(pdMS_TO_TICKS(WRITER_POLL_MS));
+
+        if (droppedBytes != reportedDroppedBytes)
+        {
+            uint32_t dropped     = droppedBytes - reportedDroppedBytes;
+            reportedDroppedBytes = droppedBytes;
+            logger.logf("Flash log: staging buffer full, dropped %lu bytes",
+                        (unsigned long) dropped);
+        }
+
+        while (writeChunk(false))
+        {
+        }
+        if (millis() - lastFlushMs >= FLUSH_INTERVAL_MS)
+        {
+            writeChunk(true);
+            lastFlushMs = millis();
+        }
+    }
+}
+
+bool LogFileSink::writeChunk(bool force)
+{
+    if (currentFileBytes >= MAX_FILE_BYTES)
+    {
+        rotate();
+    }
+
+    // Size the chunk so the file ends on a sector boundary afterwards; a
+    // forced partial flush is followed by one that fills the rest.
+    size_t room = SECTOR_BYTES - (currentFileBytes % SECTOR_BYTES);
+
+    xSemaphoreTake(stagingMutex, portMAX_DELAY);
+    size_t length = stagedCount >= room ? room : (force ? stagedCount : 0);
+    size_t first  = STAGING_BYTES - stagedHead;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(chunkBuffer, staging + stagedHead, first);
+    memcpy(chunkBuffer + first, staging, length - first);
+    stagedHead = (stagedHead + length) % STAGING_BYTES;
+    stagedCount -= length;
+    xSemaphoreGive(stagingMutex);
+
+    if (length == 0)
+    {
+        return false;
+    }
+
+    size_t written = currentFile.write(chunkBuffer, length);
+    currentFile.flush();
+    currentFileBytes += written;
+    bytesWritten += written;
+    chunksWritten++;
+    lastFlushMs = millis();
+    return written == length;
+}
+
+void LogFileSink::rotate()
+{
+    currentFile.close();
+    if (LittleFS.exists(logPath(CURRENT_BASE, MAX_ROTATED_FILES)))
+    {
+        LittleFS.remove(logPath(CURRENT_BASE, MAX_ROTATED_FILES));
+    }
+    for (int i = MAX_ROTATED_FILES - 1; i >= 0; i--)
+    {
+        if (LittleFS.exists(logPath(CURRENT_BASE, i)))
+        {
+            LittleFS.rename(logPath(CURRENT_BASE, i), logPath(CURRENT_BASE, i + 1));
+        }
+    }
+    currentFile      = LittleFS.open(logPath(CURRENT_BASE, 0), "w");
+    currentFileBytes = 0;
+    rotations++;
+}
+
+log_file_sink_stats_t LogFileSink::getStats()
+{
+    log_file_sink_stats_t stats;
+    stats.enabled          = enabled;
+    stats.stagedBytes      = stagedCount;
+    stats.bytesWritten     = bytesWritten;
+    stats.chunksWritten    = chunksWritten;
+    stats.droppedBytes     = droppedBytes;
+    stats.rotations        = rotations;
+    stats.currentFileBytes = currentFileBytes;
+    return stats;
+}
+
+bool LogFileSink::hasPreviousLog()
+{
+    return LittleFS.exists(logPath(PREVIOUS_BASE, 0));
+}
+
+size_t LogFileSink::previousLogSize()
+{
+    size_t total = 0;
+    for (int i = 0; i <= MAX_ROTATED_FILES; i++)
+    {
+        String path = logPath(PREVIOUS_BASE, i);
+        if (LittleFS.exists(path))
+        {
+            File file = LittleFS.open(path, "r");
+            total += file.size();
+            file.close();
+        }
+    }
+    return total;
+}
+
+PreviousLogCursor LogFileSink::beginPreviousRead()
+{
+    PreviousLogCursor cursor;
+    cursor.fileIndex = MAX_ROTATED_FILES;
+    cursor.offset    = 0;
+    return cursor;
+}
+
+size_t LogFileSink::readPrevious(PreviousLogCursor &cursor, uint8_t *out, size_t maxLen)
+{
+    if (maxLen == 0)
+    {
+        // A zero-length read would look like the end of the file
+        return 0;
+    }
+    // Oldest rotated file first, so the output reads in chronological order.
+    while (cursor.fileIndex >= 0)
+    {
+        String path = logPath(PREVIOUS_BASE, cursor.fileIndex);
+        File   file = LittleFS.exists(path) ? LittleFS.open(path, "r") : File();
+        if (file && cursor.offset < file.size())
+        {
+            file.seek(cursor.offset);
+            size_t n = file.read(out, maxLen);
+            file.close();
+            if (n > 0)
+            {
+                cursor.offset += n;
+                return n;
+            }
+        }
+        file.close();
+        cursor.fileIndex--;
+        cursor.offset = 0;
+    }
+    return 0;
+}
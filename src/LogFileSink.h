@@ -0,0 +1,109 @@
+#ifndef LOG_FILE_SINK_H
+#define LOG_FILE_SINK_H
+
+#include <Arduino.h>
+
+#include "LogSink.h"
+
+typedef struct
+{
+    bool     enabled;
+    uint32_t stagedBytes;    // waiting in RAM for the writer task
+    uint32_t bytesWritten;   // written to flash this boot
+    uint32_t chunksWritten;  // write calls issued this boot
+    uint32_t droppedBytes;   // lost because the staging buffer was full
+    uint32_t rotations;
+    uint32_t currentFileBytes;
+} log_file_sink_stats_t;
+
+// Position of an in-progress read of the previous boot's log files.
+struct PreviousLogCursor
+{
+    int    fileIndex;  // counts down from the oldest rotated file to 0
+    size_t offset;
+
+    bool done() const { return fileIndex < 0; }
+};
+
+// Optional persistent copy of the log on LittleFS.
+//
+// Logger offers every line to the sink, which only copies it into a RAM
+// staging buffer. A low-priority task moves staged bytes to flash in
+// sector-sized chunks, so flash I/O never runs on the detection path and
+// every sector is written at most once per fill. A partial chunk is only
+// written after FLUSH_INTERVAL_MS, and later chunks are sized to realign the
+// file to a sector boundary.
+//
+// Files from the current boot are /logs/cur.log (newest) and
+// /logs/cur.N.log (older). On begin() they are renamed to /logs/prev*.log so
+// the log that led up to a watchdog reset or brownout survives the reboot.
+class LogFileSink : public LogSink
+{
+   private:
+    static const size_t        STAGING_BYTES      = 16 * 1024;
+    static const size_t        SECTOR_BYTES       = 4096;
+    static const size_t        MAX_FILE_BYTES     = 64 * 1024;
+    static const int           MAX_ROTATED_FILES  = 2;
+    static const unsigned long FLUSH_INTERVAL_MS  = 15000;
+    static const unsigned long WRITER_POLL_MS     = 250;
+
+    uint8_t          *staging;
+    size_t            stagedHead;  // next byte to write to flash
+    size_t            stagedCount;
+    SemaphoreHandle_t stagingMutex;
+    TaskHandle_t      writerTask;
+    bool              started;  // buffers, file and writer task are set up
+    bool              failed;   // begin() gave up; not retried until reboot
+    bool              preserved;  // previous boot's files moved aside already
+    bool              enabled;
+    unsigned long     lastFlushMs;
+    size_t            currentFileBytes;
+    uint32_t          droppedBytes;
+    uint32_t          reportedDroppedBytes;
+    uint32_t          bytesWritten;
+    uint32_t          chunksWritten;
+    uint32_t          rotations;
+
+    LogFileSink();
+
+    LogFileSink(const LogFileSink &)            = delete;
+    LogFileSink &operator=(const LogFileSink &) = delete;
+
+    static void writerTaskEntry(void *arg);
+    void        writerLoop();
+    bool        writeChunk(bool force);
+    void        rotate();
+    void        preservePreviousBoot();
+    void        release();
+    void        stage(const char *data, size_t length);
+
+   protected:
+    // Only copies the line into the staging buffer; never touches flash.
+    bool enqueue(log_level_t level, uint64_t timestamp, const char *message,
+                 size_t length) override;
+
+   public:
+    static LogFileSink &getInstance();
+
+    // Moves the previous boot's files aside and starts the writer task.
+    // Does nothing (and keeps any existing files) when disabled. A failure
+    // frees what was set up and is not retried until the next boot.
+    bool begin(bool enable);
+    // Applies the setting at runtime. Starts the sink if it was never
+    // started; otherwise pauses or resumes staging lines, and the writer
+    // task still flushes what was staged before a pause.
+    void setEnabled(bool enable);
+
+    const char *name() const override { return "flash"; }
+
+    log_file_sink_stats_t getStats();
+
+    PreviousLogCursor beginPreviousRead();
+    size_t            readPrevious(PreviousLogCursor &cursor, uint8_t *out, size_t maxLen);
+    bool              hasPreviousLog();
+    size_t            previousLogSize();
+};
+
+#define logFileSink LogFileSink::getInstance()
+
+#endif  // LOG_FILE_SINK_H
@@ -0,0 +1,120 @@
+#include "LogQueue.h"
+
+#include <string.h>
+
+LogQueue::LogQueue()
+{
+    ring     = nullptr;
+    ringSize = 0;
+    head     = 0;
+    used     = 0;
+    entries  = 0;
+}
+
+void LogQueue::attach(uint8_t *buffer, size_t size)
+{
+    ring     = buffer;
+    ringSize = buffer ? size : 0;
+    head     = 0;
+    used     = 0;
+    entries  = 0;
+}
+
+bool LogQueue::push(uint8_t level, uint64_t timestamp, uint32_t nowMs, const char *message,
+                    size_t length)
+{
+    if (length > MAX_MESSAGE_LENGTH)
+    {
+        length = MAX_MESSAGE_LENGTH;
+    }
+    size_t need = ENTRY_HEADER_SIZE + length;
+    if (ring == nullptr || used + need > ringSize)
+    {
+        return false;
+    }
+
+    uint8_t header[ENTRY_HEADER_SIZE];
+    uint16_t storedLength = (uint16_t) length;
+    memcpy(header, &storedLength, 2);
+    header[2] = level;
+    memcpy(header + 3, &timestamp, 8);
+    memcpy(header + 11, &nowMs, 4);
+
+    size_t tail = (head + used) % ringSize;
+    writeBytes(tail, header, ENTRY_HEADER_SIZE);
+    writeBytes((tail + ENTRY_HEADER_SIZE) % ringSize, message, length);
+    used += need;
+    entries++;
+    return true;
+}
+
+bool LogQueue::peek(Entry &entry, char *message, size_t capacity) const
+{
+    if (entries == 0)
+    {
+        return false;
+    }
+
+    uint8_t header[ENTRY_HEADER_SIZE];
+    readBytes(head, header, ENTRY_HEADER_SIZE);
+    uint16_t storedLength;
+    memcpy(&storedLength, header, 2);
+    entry.level = header[2];
+    memcpy(&entry.timestamp, header + 3, 8);
+    memcpy(&entry.enqueuedMs, header + 11, 4);
+
+    entry.length = storedLength < capacity ? storedLength : capacity;
+    readBytes((head + ENTRY_HEADER_SIZE) % ringSize, message, entry.length);
+    return true;
+}
+
+void LogQueue::pop()
+{
+    if (entries == 0)
+    {
+        return;
+    }
+    uint16_t storedLength;
+    readBytes(head, &storedLength, 2);
+    size_t size = ENTRY_HEADER_SIZE + storedLength;
+    head        = (head + size) % ringSize;
+    used -= size;
+    entries--;
+}
+
+uint32_t LogQueue::count() const
+{
+    return entries;
+}
+
+size_t LogQueue::usedBytes() const
+{
+    return used;
+}
+
+size_t LogQueue::capacity() const
+{
+    return ringSize;
+}
+
+void LogQueue::writeBytes(size_t offset, const void *data, size_t length)
+{
+    size_t first = ringSize - offset;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(ring + offset, data, first);
+    memcpy(ring, static_cast<const uint8_t *>(data) + first, length - first);
+}
+
+void LogQueue::readBytes(size_t offset, void *data, size_t length) const
+{
+    size_t first = ringSize - offset;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(data, ring + offset, first);
+    memcpy(static_cast<uint8_t *>(data) + first, ring, length - first);
+}
@@ -0,0 +1,53 @@
+#ifndef LOG_QUEUE_H
+#define LOG_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded FIFO of log lines packed into a caller-provided byte ring. Used by
+// sinks as their private queue between the logging task and the sink task.
+// Not synchronized; the owner guards it.
+class LogQueue
+{
+   public:
+    struct Entry
+    {
+        uint8_t  level;
+        uint64_t timestamp;   // Logger timestamp (monotonic microseconds)
+        uint32_t enqueuedMs;  // caller's clock when queued, for flush-by-age
+        size_t   length;
+    };
+
+    static const size_t MAX_MESSAGE_LENGTH = 512;
+
+    LogQueue();
+
+    void attach(uint8_t *buffer, size_t capacity);
+
+    // Returns false, leaving the queue unchanged, if there is no room.
+    bool push(uint8_t level, uint64_t timestamp, uint32_t nowMs, const char *message,
+              size_t length);
+
+    // Copies the oldest entry without removing it. The message is truncated
+    // to `capacity` bytes (not NUL-terminated); entry.length is the copied size.
+    bool peek(Entry &entry, char *message, size_t capacity) const;
+    void pop();
+
+    uint32_t count() const;
+    size_t   usedBytes() const;
+    size_t   capacity() const;
+
+   private:
+    static const size_t ENTRY_HEADER_SIZE = 15;  // u16 length, u8 level, u64 ts, u32 ms
+
+    uint8_t *ring;
+    size_t   ringSize;
+    size_t   head;
+    size_t   used;
+    uint32_t entries;
+
+    void writeBytes(size_t offset, const void *data, size_t length);
+    void readBytes(size_t offset, void *data, size_t length) const;
+};
+
+#endif  // LOG_QUEUE_H
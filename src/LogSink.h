@@ -0,0 +1,59 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Severity of a log line, most severe first. A sink accepts a line when its
+// level is at or above (numerically at or below) the sink's minimum level.
+typedef enum
+{
+    LOG_LEVEL_ERROR   = 0,
+    LOG_LEVEL_WARN    = 1,
+    LOG_LEVEL_INFO    = 2,
+    LOG_LEVEL_DEBUG   = 3,
+    LOG_LEVEL_VERBOSE = 4,
+} log_level_t;
+
+// Destination for log lines besides serial and the in-RAM history.
+//
+// Logger calls offer() for every line from whatever task is logging, so
+// implementations must only copy the line into their own bounded queue and
+// return; anything slow (flash, network) happens later on the sink's own
+// task under its own flush policy. A full queue drops the line and counts
+// it, it never blocks the caller.
+class LogSink
+{
+   public:
+    LogSink() : minLevel(LOG_LEVEL_INFO), dropped(0) {}
+    virtual ~LogSink() {}
+
+    void offer(log_level_t level, uint64_t timestamp, const char *message, size_t length)
+    {
+        if (level > minLevel)
+        {
+            return;
+        }
+        if (!enqueue(level, timestamp, message, length))
+        {
+            dropped++;
+        }
+    }
+
+    void        setMinLevel(log_level_t level) { minLevel = level; }
+    log_level_t getMinLevel() const { return minLevel; }
+    uint32_t    getDropped() const { return dropped; }
+
+    virtual const char *name() const = 0;
+
+   protected:
+    // Returns false if the line could not be queued.
+    virtual bool enqueue(log_level_t level, uint64_t timestamp, const char *message,
+                         size_t length) = 0;
+
+   private:
+    volatile log_level_t minLevel;
+    volatile uint32_t    dropped;
+};
+
+#endif  // LOG_SINK_H
@@ -0,0 +1,491 @@
+#include "LogStore.h"
+
+#include <string.h>
+
+LogStore::LogStore()
+{
+    activeBlock   = nullptr;
+    scratch       = nullptr;
+    ring          = nullptr;
+    totalCapacity = 0;
+    ringSize      = 0;
+    clock         = nullptr;
+    oldestSeq     = 0;
+    sealedRecords = 0;
+    activeRecords = 0;
+    clear();
+}
+
+void LogStore::attach(uint8_t *buffer, size_t size)
+{
+    if (buffer == nullptr || size < MIN_CAPACITY)
+    {
+        activeBlock   = nullptr;
+        scratch       = nullptr;
+        ring          = nullptr;
+        totalCapacity = 0;
+        ringSize      = 0;
+    }
+    else
+    {
+        activeBlock   = buffer;
+        scratch       = buffer + BLOCK_SIZE;
+        ring          = buffer + 2 * BLOCK_SIZE;
+        totalCapacity = size;
+        ringSize      = size - 2 * BLOCK_SIZE;
+    }
+    clear();
+}
+
+bool LogStore::isAttached() const
+{
+    return activeBlock != nullptr;
+}
+
+size_t LogStore::capacity() const
+{
+    return totalCapacity;
+}
+
+void LogStore::setClock(MicrosClock microsClock)
+{
+    clock = microsClock;
+}
+
+void LogStore::clear()
+{
+    // Keep sequence numbers monotonic across clears so readers holding a
+    // cursor never see an older sequence reused for a newer record.
+    oldestSeq     = nextSeq();
+    activeUsed    = 0;
+    activeRecords = 0;
+    activeSummary = {};
+    head          = 0;
+    tail          = 0;
+    blocks        = 0;
+    sealedRecords = 0;
+    scratchValid  = false;
+    scratchSeq    = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void LogStore::append(uint64_t timestamp, const char *message, size_t length, uint8_t level,
+                      uint8_t category)
+{
+    if (!isAttached())
+    {
+        return;
+    }
+
+    if (length > MAX_MESSAGE_LENGTH)
+    {
+        length = MAX_MESSAGE_LENGTH;
+    }
+    size_t need = RECORD_HEADER_SIZE + length;
+
+    if (activeUsed + need > BLOCK_SIZE)
+    {
+        seal();
+    }
+
+    level &= TAG_LEVEL_MASK;
+    category %= 32;
+    if (activeRecords == 0)
+    {
+        activeSummary.minLevel   = level;
+        activeSummary.categories = 0;
+        activeSummary.minUs      = timestamp;
+        activeSummary.maxUs      = timestamp;
+    }
+    activeSummary.minLevel = level < activeSummary.minLevel ? level : activeSummary.minLevel;
+    activeSummary.categories |= LOG_CATEGORY_BIT(category);
+    activeSummary.minUs = timestamp < activeSummary.minUs ? timestamp : activeSummary.minUs;
+    activeSummary.maxUs = timestamp > activeSummary.maxUs ? timestamp : activeSummary.maxUs;
+
+    uint16_t storedLength = (uint16_t) length;
+    uint8_t  tag          = (uint8_t) (level | (category << TAG_CATEGORY_SHIFT));
+    memcpy(activeBlock + activeUsed, &storedLength, sizeof(storedLength));
+    activeBlock[activeUsed + sizeof(uint16_t)] = tag;
+    memcpy(activeBlock + activeUsed + RECORD_TIME_OFFSET, &timestamp, sizeof(timestamp));
+    memcpy(activeBlock + activeUsed + RECORD_HEADER_SIZE, message, length);
+    activeUsed += need;
+    activeRecords++;
+}
+
+uint32_t LogStore::count() const
+{
+    return sealedRecords + activeRecords;
+}
+
+uint32_t LogStore::firstSeq() const
+{
+    return oldestSeq;
+}
+
+uint32_t LogStore::nextSeq() const
+{
+    return oldestSeq + sealedRecords + activeRecords;
+}
+
+size_t LogStore::usedBytes() const
+{
+    return stats.liveStoredBytes + blocks * sizeof(BlockHeader) + activeUsed;
+}
+
+size_t LogStore::rawBytes() const
+{
+    return stats.liveRawBytes + activeUsed;
+}
+
+LogStore::Stats LogStore::getStats() const
+{
+    return stats;
+}
+
+void LogStore::seal()
+{
+    if (activeRecords == 0)
+    {
+        return;
+    }
+
+    uint32_t start = clock ? clock() : 0;
+
+    // The scratch area doubles as the compression output buffer.
+    scratchValid           = false;
+    size_t         stored  = LogCodec::compress(activeBlock, activeUsed, scratch, BLOCK_SIZE,
+                                                hashTable);
+    const uint8_t *source  = scratch;
+    uint8_t        flags   = 0;
+    if (stored == 0 || stored >= activeUsed)
+    {
+        // Incompressible; keep the raw bytes rather than grow the block.
+        stored = activeUsed;
+        source = activeBlock;
+        flags  = BLOCK_FLAG_RAW;
+    }
+
+    uint32_t elapsed = clock ? clock() - start : 0;
+
+    BlockHeader header;
+    header.storedLength = (uint16_t) stored;
+    header.rawLength    = (uint16_t) activeUsed;
+    header.firstSeq     = nextSeq() - activeRecords;
+    header.records      = (uint16_t) activeRecords;
+    header.flags        = flags;
+    header.minLevel     = activeSummary.minLevel;
+    header.categories   = activeSummary.categories;
+    header.minUs        = activeSummary.minUs;
+    header.maxUs        = activeSummary.maxUs;
+
+    size_t need = sizeof(BlockHeader) + stored;
+    if (reserveRing(need))
+    {
+        memcpy(ring + tail, &header, sizeof(header));
+        memcpy(ring + tail + sizeof(header), source, stored);
+        tail += need;
+        blocks++;
+        sealedRecords += activeRecords;
+        stats.liveBlocks++;
+        stats.liveRawBytes += header.rawLength;
+        stats.liveStoredBytes += header.storedLength;
+    }
+    else
+    {
+        // Cannot happen with MIN_CAPACITY, but never leave a gap in the
+        // sequence: drop everything older along with this block.
+        while (blocks > 0)
+        {
+            evictOldestBlock();
+        }
+        oldestSeq += activeRecords;
+    }
+
+    stats.sealedBlocks++;
+    stats.lastCompressUs = elapsed;
+    stats.totalCompressUs += elapsed;
+    if (elapsed > stats.maxCompressUs)
+    {
+        stats.maxCompressUs = elapsed;
+    }
+
+    activeUsed    = 0;
+    activeRecords = 0;
+}
+
+bool LogStore::reserveRing(size_t need)
+{
+    if (need > ringSize)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        if (blocks == 0)
+        {
+            head = 0;
+            tail = 0;
+        }
+
+        bool wrapped = tail < head || (tail == head && blocks > 0);
+        if (!wrapped)
+        {
+            if (tail + need <= ringSize)
+            {
+                return true;
+            }
+            if (need <= head)
+            {
+                // Not enough room before the end of the ring; leave a wrap
+                // marker (if there is room for one) and continue at offset 0.
+                if (tail + sizeof(uint16_t) <= ringSize)
+                {
+                    uint16_t marker = WRAP_MARKER;
+                    memcpy(ring + tail, &marker, sizeof(marker));
+                }
+                tail = 0;
+                return true;
+            }
+        }
+        else if (tail + need <= head)
+        {
+            return true;
+        }
+
+        evictOldestBlock();
+    }
+}
+
+void LogStore::evictOldestBlock()
+{
+    if (blocks == 0)
+    {
+        return;
+    }
+
+    head               = normalize(head);
+    BlockHeader header = readBlockHeader(head);
+    head += sizeof(BlockHeader) + header.storedLength;
+    blocks--;
+    sealedRecords -= header.records;
+    oldestSeq += header.records;
+    stats.liveBlocks--;
+    stats.liveRawBytes -= header.rawLength;
+    stats.liveStoredBytes -= header.storedLength;
+
+    if (scratchValid && scratchSeq == header.firstSeq)
+    {
+        scratchValid = false;
+    }
+    if (blocks > 0)
+    {
+        head = normalize(head);
+    }
+}
+
+size_t LogStore::normalize(size_t offset) const
+{
+    if (offset + sizeof(uint16_t) > ringSize)
+    {
+        return 0;
+    }
+    uint16_t storedLength;
+    memcpy(&storedLength, ring + offset, sizeof(storedLength));
+    return storedLength == WRAP_MARKER ? 0 : offset;
+}
+
+LogStore::BlockHeader LogStore::readBlockHeader(size_t offset) const
+{
+    BlockHeader header;
+    memcpy(&header, ring + offset, sizeof(header));
+    return header;
+}
+
+static char lowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char) (c - 'A' + 'a') : c;
+}
+
+static bool containsText(const char *message, size_t length, const char *text)
+{
+    size_t textLength = strlen(text);
+    if (textLength > length)
+    {
+        return false;
+    }
+    for (size_t i = 0; i + textLength <= length; i++)
+    {
+        size_t j = 0;
+        while (j < textLength && lowerAscii(message[i + j]) == lowerAscii(text[j]))
+        {
+            j++;
+        }
+        if (j == textLength)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LogStore::matches(const Filter &filter, const Record &record)
+{
+    return (filter.categoryMask & LOG_CATEGORY_BIT(record.category)) != 0 &&
+           record.level <= filter.maxLevel && record.timestamp >= filter.fromUs &&
+           record.timestamp <= filter.toUs &&
+           (filter.text == nullptr || containsText(record.message, record.length, filter.text));
+}
+
+bool LogStore::summaryMatches(const Filter &filter, const Summary &summary)
+{
+    return (filter.categoryMask & summary.categories) != 0 &&
+           summary.minLevel <= filter.maxLevel && summary.maxUs >= filter.fromUs &&
+           summary.minUs <= filter.toUs;
+}
+
+bool LogStore::visitRecords(const uint8_t *data, size_t length, uint32_t blockFirstSeq,
+                            uint32_t &seq, const Filter *filter, RecordVisitor visitor,
+                            void *context)
+{
+    size_t   offset    = 0;
+    uint32_t recordSeq = blockFirstSeq;
+    while (offset + RECORD_HEADER_SIZE <= length)
+    {
+        uint16_t messageLength;
+        memcpy(&messageLength, data + offset, sizeof(messageLength));
+
+        if (recordSeq >= seq)
+        {
+            uint8_t tag = data[offset + sizeof(uint16_t)];
+            Record  record;
+            record.seq      = recordSeq;
+            record.length   = messageLength;
+            record.level    = tag & TAG_LEVEL_MASK;
+            record.category = tag >> TAG_CATEGORY_SHIFT;
+            memcpy(&record.timestamp, data + offset + RECORD_TIME_OFFSET, sizeof(uint64_t));
+            record.message = reinterpret_cast<const char *>(data + offset + RECORD_HEADER_SIZE);
+
+            seq = recordSeq;
+            if ((filter == nullptr || matches(*filter, record)) && !visitor(record, context))
+            {
+                return false;
+            }
+            seq = recordSeq + 1;
+        }
+
+        offset += RECORD_HEADER_SIZE + messageLength;
+        recordSeq++;
+    }
+    return true;
+}
+
+uint32_t LogStore::visitFrom(uint32_t seq, RecordVisitor visitor, void *context)
+{
+    return walk(seq, nullptr, visitor, context, nullptr);
+}
+
+uint32_t LogStore::visitFrom(uint32_t seq, const Filter &filter, RecordVisitor visitor,
+                             void *context, Scan *scan)
+{
+    return walk(seq, &filter, visitor, context, scan);
+}
+
+uint32_t LogStore::walk(uint32_t seq, const Filter *filter, RecordVisitor visitor, void *context,
+                        Scan *scan)
+{
+    if (!isAttached() || visitor == nullptr)
+    {
+        return seq;
+    }
+
+    if (seq < oldestSeq)
+    {
+        seq = oldestSeq;
+    }
+
+    uint32_t read   = 0;
+    size_t   offset = head;
+    for (uint32_t i = 0; i < blocks; i++)
+    {
+        offset             = normalize(offset);
+        BlockHeader header = readBlockHeader(offset);
+        const uint8_t *payload = ring + offset + sizeof(BlockHeader);
+        offset += sizeof(BlockHeader) + header.storedLength;
+
+        uint32_t blockEnd = header.firstSeq + header.records;
+        if (seq >= blockEnd)
+        {
+            // Entirely before the cursor; skip without decompressing.
+            continue;
+        }
+
+        if (filter != nullptr)
+        {
+            Summary summary = {header.minLevel, header.categories, header.minUs, header.maxUs};
+            if (!summaryMatches(*filter, summary))
+            {
+                seq = blockEnd;
+                if (scan != nullptr)
+                {
+                    scan->blocksSkipped++;
+                }
+                continue;
+            }
+            if (scan != nullptr)
+            {
+                if (scan->blockBudget != 0 && read >= scan->blockBudget)
+                {
+                    return seq;
+                }
+                // Resuming inside a block is not a new read
+                if (seq <= header.firstSeq)
+                {
+                    read++;
+                    scan->blocksRead++;
+                }
+            }
+        }
+
+        const uint8_t *data = payload;
+        if ((header.flags & BLOCK_FLAG_RAW) == 0)
+        {
+            if (!scratchValid || scratchSeq != header.firstSeq)
+            {
+                size_t decoded =
+                    LogCodec::decompress(payload, header.storedLength, scratch, BLOCK_SIZE);
+                if (decoded != header.rawLength)
+                {
+                    scratchValid = false;
+                    seq          = blockEnd;
+                    continue;
+                }
+                scratchValid = true;
+                scratchSeq   = header.firstSeq;
+            }
+            data = scratch;
+        }
+
+        if (!visitRecords(data, header.rawLength, header.firstSeq, seq, filter, visitor, context))
+        {
+            return seq;
+        }
+    }
+
+    uint32_t activeFirst = nextSeq() - activeRecords;
+    if (filter != nullptr && activeRecords > 0 && !summaryMatches(*filter, activeSummary))
+    {
+        if (seq < nextSeq())
+        {
+            seq = nextSeq();
+        }
+        return seq;
+    }
+    visitRecords(activeBlock, activeUsed, activeFirst, seq, filter, visitor, context);
+    return seq;
+}
+
+void LogStore::forEach(RecordVisitor visitor, void *context)
+{
+    visitFrom(firstSeq(), visitor, context);
+}
@@ -0,0 +1,173 @@
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LogCategory.h"
+#include "LogCodec.h"
+
+// Circular log storage built from fixed-size blocks. New records are packed
+// into an uncompressed active block; when it fills up the block is sealed,
+// compressed with LogCodec and moved into a ring of sealed blocks inside the
+// caller-provided buffer. The oldest sealed blocks are evicted when space
+// runs out. Readers decompress one block at a time into a scratch area, so no
+// per-entry objects are ever constructed.
+//
+// Every sealed block carries a summary of its records (categories present,
+// most severe level, time span), so filtered walks skip blocks that cannot
+// match without decompressing them.
+class LogStore
+{
+   public:
+    struct Record
+    {
+        uint32_t    seq;
+        uint64_t    timestamp;  // monotonic microseconds (TimeService)
+        const char *message;
+        size_t      length;
+        uint8_t     level;     // log_level_t
+        uint8_t     category;  // log_category_t
+    };
+
+    // Records a filtered walk visits. The defaults match everything.
+    struct Filter
+    {
+        uint32_t    categoryMask = 0xFFFFFFFF;  // LOG_CATEGORY_BIT() of the wanted categories
+        uint8_t     maxLevel     = LOG_LEVEL_VERBOSE;  // least severe level wanted
+        uint64_t    fromUs       = 0;           // inclusive, monotonic
+        uint64_t    toUs         = UINT64_MAX;  // inclusive, monotonic
+        const char *text         = nullptr;     // ASCII case-insensitive substring
+    };
+
+    // Work done by filtered walks; visitFrom() adds to it. With a non-zero
+    // blockBudget a walk returns early once it has read that many blocks, so
+    // a long scan can release whatever lock guards the store in between.
+    struct Scan
+    {
+        uint32_t blockBudget   = 0;
+        uint32_t blocksRead    = 0;  // blocks whose records were examined
+        uint32_t blocksSkipped = 0;  // blocks ruled out by their summary
+    };
+
+    struct Stats
+    {
+        uint32_t sealedBlocks;      // blocks sealed since attach/clear
+        uint32_t liveBlocks;        // sealed blocks still held
+        uint32_t liveRawBytes;      // uncompressed size of the live sealed blocks
+        uint32_t liveStoredBytes;   // stored size of the live sealed blocks
+        uint32_t lastCompressUs;    // cost of the most recent seal
+        uint32_t maxCompressUs;     // worst seal cost
+        uint32_t totalCompressUs;   // sum of seal costs
+    };
+
+    // Return false to stop the walk.
+    typedef bool (*RecordVisitor)(const Record &record, void *context);
+    typedef uint32_t (*MicrosClock)();
+
+    static const size_t BLOCK_SIZE         = 4096;
+    static const size_t MAX_MESSAGE_LENGTH = 1024;
+    // Active block, scratch block and at least one sealed block.
+    static const size_t MIN_CAPACITY = 3 * BLOCK_SIZE + 64;
+
+    LogStore();
+
+    void attach(uint8_t *buffer, size_t capacity);
+    bool isAttached() const;
+    size_t capacity() const;
+
+    // Optional microsecond clock used to measure per-block compression cost.
+    void setClock(MicrosClock clock);
+
+    void append(uint64_t timestamp, const char *message, size_t length,
+                uint8_t level = LOG_LEVEL_INFO, uint8_t category = LOG_CAT_GENERAL);
+    void clear();
+
+    uint32_t count() const;
+    uint32_t firstSeq() const;
+    uint32_t nextSeq() const;
+    size_t   usedBytes() const;
+    // Uncompressed size of everything held, record headers included
+    size_t   rawBytes() const;
+    Stats    getStats() const;
+
+    // Visits records from `seq` (clamped to the oldest held) to the newest.
+    // Returns the sequence number of the first record not visited.
+    uint32_t visitFrom(uint32_t seq, RecordVisitor visitor, void *context);
+    // Same, visiting only records that match `filter`. The returned
+    // sequence number also moves past records that did not match.
+    uint32_t visitFrom(uint32_t seq, const Filter &filter, RecordVisitor visitor, void *context,
+                       Scan *scan = nullptr);
+    void     forEach(RecordVisitor visitor, void *context);
+
+    static bool matches(const Filter &filter, const Record &record);
+
+   private:
+    struct BlockHeader
+    {
+        uint16_t storedLength;  // WRAP_MARKER marks the end of the used ring
+        uint16_t rawLength;
+        uint32_t firstSeq;
+        uint16_t records;
+        uint8_t  flags;
+        uint8_t  minLevel;    // most severe level in the block
+        uint32_t categories;  // LOG_CATEGORY_BIT() of every category present
+        uint64_t minUs;       // time span; tasks may append slightly out of order
+        uint64_t maxUs;
+    };
+
+    // Block summary kept while the block is active, copied into its header
+    // when it is sealed
+    struct Summary
+    {
+        uint8_t  minLevel;
+        uint32_t categories;
+        uint64_t minUs;
+        uint64_t maxUs;
+    };
+
+    // u16 length + u8 tag (level | category << TAG_CATEGORY_SHIFT) + u64 timestamp
+    static const size_t   RECORD_HEADER_SIZE = 11;
+    static const size_t   RECORD_TIME_OFFSET = 3;
+    static const uint8_t  TAG_LEVEL_MASK     = 0x07;
+    static const uint8_t  TAG_CATEGORY_SHIFT = 3;
+    static const uint16_t WRAP_MARKER        = 0xFFFF;
+    static const uint8_t  BLOCK_FLAG_RAW     = 0x01;
+
+    uint8_t *activeBlock;
+    uint8_t *scratch;
+    uint8_t *ring;
+    size_t   totalCapacity;
+    size_t   ringSize;
+
+    size_t   activeUsed;
+    uint32_t activeRecords;
+    Summary  activeSummary;
+
+    size_t   head;  // offset of the oldest sealed block
+    size_t   tail;  // offset where the next sealed block is written
+    uint32_t blocks;
+    uint32_t sealedRecords;
+    uint32_t oldestSeq;
+
+    bool     scratchValid;  // scratch holds the decoded block starting at scratchSeq
+    uint32_t scratchSeq;
+
+    MicrosClock clock;
+    Stats       stats;
+    uint16_t    hashTable[LogCodec::HASH_ENTRIES];
+
+    void   seal();
+    bool   reserveRing(size_t need);
+    void   evictOldestBlock();
+    size_t normalize(size_t offset) const;
+    BlockHeader readBlockHeader(size_t offset) const;
+    bool   visitRecords(const uint8_t *data, size_t length, uint32_t blockFirstSeq,
+                        uint32_t &seq, const Filter *filter, RecordVisitor visitor,
+                        void *context);
+    uint32_t walk(uint32_t seq, const Filter *filter, RecordVisitor visitor, void *context,
+                  Scan *scan);
+    static bool summaryMatches(const Filter &filter, const Summary &summary);
+};
+
+#endif  // LOG_STORE_H
@@ -1,8 +1,14 @@
 #include "Logger.h"
-#include "time.h"
+#include "TimeService.h"
 
-// External function to get current time (from main.cpp)
-extern unsigned long getTime();
+// Categories enabled at runtime; rebuilt by SettingsManager from the
+// logging flags whenever settings are loaded or saved.
+volatile uint32_t logCategoryMask = LOG_CATEGORY_BIT(LOG_CAT_GENERAL);
+
+static uint32_t microsClock()
+{
+  return (uint32_t)micros();
+}
 
 Logger &Logger::getInstance()
 {
@@ -12,60 +18,101 @@ Logger &Logger::getInstance()
 
 Logger::Logger()
 {
-  currentIndex = 0;
-  totalEntries = 0;
-  logCapacity = MAX_LOG_ENTRIES;
-  uuidGenerator.generate();
-  logBuffer = new (std::nothrow) LogEntry[logCapacity];
+  logBuffer = nullptr;
+  storageAttempted = false;
+  storeMutex = xSemaphoreCreateMutex();
+  sinkCount = 0;
+}
+
+Logger::~Logger()
+{
+  free(logBuffer);
+}
+
+void Logger::ensureStorage()
+{
+  if (storageAttempted)
+  {
+    return;
+  }
+  storageAttempted = true;
+
+  size_t capacity = 0;
+  if (psramFound())
+  {
+    capacity = PSRAM_LOG_BUFFER_BYTES;
+    logBuffer = (uint8_t *)ps_malloc(capacity);
+  }
   if (!logBuffer)
   {
-    logCapacity = FALLBACK_LOG_ENTRIES;
-    logBuffer  = new (std::nothrow) LogEntry[logCapacity];
-    if (!logBuffer)
-    {
-      logCapacity = 0;
-    }
+    capacity = LOG_BUFFER_BYTES;
+    logBuffer = (uint8_t *)malloc(capacity);
+  }
+  if (!logBuffer)
+  {
+    capacity = FALLBACK_LOG_BUFFER_BYTES;
+    logBuffer = (uint8_t *)malloc(capacity);
   }
+  if (!logBuffer)
+  {
+    capacity = 0;
+  }
+  store.attach(logBuffer, capacity);
+  store.setClock(microsClock);
 }
 
-Logger::~Logger()
+void Logger::lockStore()
 {
-  delete[] logBuffer;
+  if (storeMutex)
+  {
+    xSemaphoreTake(storeMutex, portMAX_DELAY);
+  }
 }
 
-void Logger::log(const String &message)
+void Logger::unlockStore()
+{
+  if (storeMutex)
+  {
+    xSemaphoreGive(storeMutex);
+  }
+}
+
+void Logger::log(const char *message)
+{
+  log(LOG_LEVEL_INFO, message);
+}
+
+void Logger::log(log_level_t level, const char *message)
+{
+  log(level, LOG_CAT_GENERAL, message);
+}
+
+void Logger::log(log_level_t level, log_category_t category, const char *message)
 {
   // Print to serial first
   Serial.println(message);
 
-  // Generate UUID for this log entry
-  uuidGenerator.generate();
-  String uuid = String(uuidGenerator.toCharArray());
-
-  // Get current timestamp
-  unsigned long timestamp = getTime();
+  ensureStorage();
 
-  if (logCapacity == 0 || logBuffer == nullptr)
-  {
-    return;
-  }
+  // Monotonic, so lines logged before NTP sync can still be dated on export
+  uint64_t timestamp = timeService.nowUs();
 
-  // Store in circular buffer
-  logBuffer[currentIndex].uuid = uuid;
-  logBuffer[currentIndex].timestamp = timestamp;
-  logBuffer[currentIndex].message = message;
+  size_t length = strlen(message);
+  lockStore();
+  store.append(timestamp, message, length, level, category);
+  unlockStore();
 
-  // Update indices
-  currentIndex = (currentIndex + 1) % logCapacity;
-  if (totalEntries < logCapacity)
+  // Sinks only queue here; any slow I/O happens on their own tasks.
+  int count = sinkCount;
+  for (int i = 0; i < count; i++)
   {
-    totalEntries++;
+    sinks[i]->offer(level, timestamp, message, length);
   }
 }
 
-void Logger::log(const char *message)
+void Logger::log(const String &message)
 {
-  log(String(message));
+  log(message.c_str());
 }
 
 void Logger::logf(const char *format, ...)
@@ -75,86 +122,313 @@ void Logger::logf(const char *format, ...)
   va_start(args, format);
   vsnprintf(buffer, sizeof(buffer), format, args);
   va_end(args);
-  log(String(buffer));
+  log(buffer);
+}
+
+void Logger::logf(log_level_t level, const char *format, ...)
+{
+  char buffer[512];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  log(level, buffer);
+}
+
+void Logger::logf(log_level_t level, log_category_t category, const char *format, ...)
+{
+  char buffer[512];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  log(level, category, buffer);
 }
 
-String Logger::getLogsAsJson()
+static const char JSON_PREFIX[] = "{\"logs\":[";
+// Blocks read per lock hold while filtering, so a query that matches
+// little doesn't hold off logging for a whole scan of the store
+static const uint32_t QUERY_BLOCK_BUDGET = 4;
+
+struct ChunkWriter
 {
-  DynamicJsonDocument jsonDoc(32768); // Allocate space for expanded log buffer
-  JsonArray logsArray = jsonDoc.createNestedArray("logs");
+  char *out;
+  size_t capacity;
+  size_t used;
+  LogReadCursor *cursor;
+};
 
-  if (logCapacity == 0 || logBuffer == nullptr)
+static bool putText(ChunkWriter &w, size_t &pos, const char *text, size_t length)
+{
+  if (pos + length > w.capacity)
   {
-    String jsonResponse;
-    serializeJson(jsonDoc, jsonResponse);
-    return jsonResponse;
+    return false;
   }
+  memcpy(w.out + pos, text, length);
+  pos += length;
+  return true;
+}
+
+// Copies as much of the message as fits, JSON-escaped when requested.
+// Returns false if not all of it fit.
+static bool putMessage(ChunkWriter &w, size_t &pos, const char *message, size_t length,
+                       size_t reserve, bool escape)
+{
+  size_t limit = w.capacity > reserve ? w.capacity - reserve : 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    char c = message[i];
+    char escaped[7];
+    size_t n = 1;
+    escaped[0] = c;
+    if (escape)
+    {
+      if (c == '"' || c == '\\')
+      {
+        escaped[0] = '\\';
+        escaped[1] = c;
+        n = 2;
+      }
+      else if (c == '\n')
+      {
+        memcpy(escaped, "\\n", 2);
+        n = 2;
+      }
+      else if ((uint8_t)c < 0x20)
+      {
+        snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)(uint8_t)c);
+        n = 6;
+      }
+    }
+    if (pos + n > limit)
+    {
+      return false;
+    }
+    memcpy(w.out + pos, escaped, n);
+    pos += n;
+  }
+  return true;
+}
 
-  // If we have less than MAX_LOG_ENTRIES, start from 0
-  // Otherwise, start from currentIndex (oldest entry)
-  int startIndex = (totalEntries < logCapacity) ? 0 : currentIndex;
-  int count = totalEntries;
+static bool writeRecord(const LogStore::Record &record, void *context)
+{
+  ChunkWriter &w = *static_cast<ChunkWriter *>(context);
+  LogReadCursor &cursor = *w.cursor;
+  if (record.seq >= cursor.endSeq)
+  {
+    return false;
+  }
 
-  for (int i = 0; i < count; i++)
+  // A record that does not fit an otherwise empty chunk is truncated rather
+  // than stalling the stream.
+  bool mayTruncate = w.used == 0;
+  size_t pos = w.used;
+  // Stored times are monotonic; wall-clock time comes from the current NTP
+  // offset, so lines from before the first sync are dated too.
+  unsigned long epochSeconds = timeService.toEpochSeconds(record.timestamp);
+  char head[112];
+  int headLength;
+  if (cursor.json)
+  {
+    // Entries are identified by their sequence number; it is unique for the
+    // lifetime of the device and much cheaper than generating a UUID per line.
+    headLength = snprintf(head, sizeof(head),
+                          "%s{\"uuid\":%lu,\"timestamp\":%lu,\"uptimeUs\":%llu,\"message\":\"",
+                          cursor.wroteRecord ? "," : "", (unsigned long)record.seq, epochSeconds,
+                          (unsigned long long)record.timestamp);
+  }
+  else
   {
-    int bufferIndex = (startIndex + i) % MAX_LOG_ENTRIES;
+    headLength = snprintf(head, sizeof(head), "%lu ", epochSeconds);
+  }
+  const char *tail = cursor.json ? "\"}" : "\n";
+  size_t tailLength = strlen(tail);
 
-    JsonObject logEntry = logsArray.createNestedObject();
-    logEntry["uuid"] = logBuffer[bufferIndex].uuid;
-    logEntry["timestamp"] = logBuffer[bufferIndex].timestamp;
-    logEntry["message"] = logBuffer[bufferIndex].message;
+  if (!putText(w, pos, head, (size_t)headLength))
+  {
+    return false;
+  }
+  if (!putMessage(w, pos, record.message, record.length, tailLength, cursor.json) &&
+      !mayTruncate)
+  {
+    return false;
   }
+  if (!putText(w, pos, tail, tailLength))
+  {
+    return false;
+  }
+
+  w.used = pos;
+  cursor.matched++;
+  cursor.wroteRecord = true;
+  cursor.nextSeq = record.seq + 1;
+  return true;
+}
 
-  String jsonResponse;
-  serializeJson(jsonDoc, jsonResponse);
-  return jsonResponse;
+LogReadCursor Logger::beginRead(bool json)
+{
+  return beginRead(json, LogStore::Filter());
 }
 
-String Logger::getLogsAsText()
+LogReadCursor Logger::beginRead(bool json, const LogStore::Filter &filter)
 {
-  String result;
+  ensureStorage();
 
-  if (logCapacity == 0 || logBuffer == nullptr)
+  LogReadCursor cursor;
+  lockStore();
+  cursor.nextSeq = store.firstSeq();
+  cursor.endSeq = store.nextSeq();
+  unlockStore();
+  cursor.json = json;
+  cursor.wroteRecord = false;
+  cursor.state = json ? READ_STATE_PREFIX : READ_STATE_RECORDS;
+  cursor.filter = filter;
+  cursor.text[0] = '\0';
+  if (filter.text != nullptr)
   {
-    return result;
+    strlcpy(cursor.text, filter.text, sizeof(cursor.text));
   }
+  cursor.matched = 0;
+  cursor.scan = LogStore::Scan();
+  cursor.scan.blockBudget = QUERY_BLOCK_BUDGET;
+  return cursor;
+}
 
-  // If we have less than MAX_LOG_ENTRIES, start from 0
-  // Otherwise, start from currentIndex (oldest entry)
-  int startIndex = (totalEntries < logCapacity) ? 0 : currentIndex;
-  int count      = totalEntries;
+size_t Logger::readLogChunk(LogReadCursor &cursor, uint8_t *out, size_t maxLen)
+{
+  ChunkWriter w;
+  w.out = reinterpret_cast<char *>(out);
+  w.capacity = maxLen;
+  w.used = 0;
+  w.cursor = &cursor;
 
-  for (int i = 0; i < count; i++)
+  if (cursor.state == READ_STATE_PREFIX)
+  {
+    if (!putText(w, w.used, JSON_PREFIX, sizeof(JSON_PREFIX) - 1))
+    {
+      return 0;
+    }
+    cursor.state = READ_STATE_RECORDS;
+  }
+
+  cursor.filter.text = cursor.text[0] != '\0' ? cursor.text : nullptr;
+  // A filtered scan gives the lock up every few blocks, and keeps going
+  // until something fits in this chunk: returning 0 would end the stream.
+  while (cursor.state == READ_STATE_RECORDS)
+  {
+    uint32_t startedAt = cursor.nextSeq;
+    lockStore();
+    // Records evicted since the last chunk are skipped by the clamp in
+    // visitFrom; the cursor simply moves on to the oldest one still held.
+    uint32_t stoppedAt =
+        store.visitFrom(cursor.nextSeq, cursor.filter, writeRecord, &w, &cursor.scan);
+    unlockStore();
+    // Also moves past records that did not match
+    if (stoppedAt > cursor.nextSeq)
+    {
+      cursor.nextSeq = stoppedAt;
+    }
+
+    if (stoppedAt >= cursor.endSeq)
+    {
+      cursor.state = cursor.json ? READ_STATE_SUFFIX : READ_STATE_DONE;
+    }
+    else if (w.used > 0 || stoppedAt == startedAt)
+    {
+      break;
+    }
+  }
+
+  if (cursor.state == READ_STATE_SUFFIX)
   {
-    int bufferIndex = (startIndex + i) % MAX_LOG_ENTRIES;
+    char suffix[96];
+    int length = snprintf(suffix, sizeof(suffix),
+                          "],\"matched\":%lu,\"blocksRead\":%lu,\"blocksSkipped\":%lu}",
+                          (unsigned long)cursor.matched, (unsigned long)cursor.scan.blocksRead,
+                          (unsigned long)cursor.scan.blocksSkipped);
+    if (putText(w, w.used, suffix, (size_t)length))
+    {
+      cursor.state = READ_STATE_DONE;
+    }
+  }
+
+  return w.used;
+}
 
-    result += String(logBuffer[bufferIndex].timestamp);
-    result += " ";
-    result += logBuffer[bufferIndex].message;
-    result += "\n";
+bool Logger::addSink(LogSink *sink)
+{
+  lockStore();
+  bool added = sinkCount < MAX_SINKS;
+  if (added)
+  {
+    sinks[sinkCount] = sink;
+    sinkCount = sinkCount + 1;
   }
+  unlockStore();
+  return added;
+}
+
+LogStore::Stats Logger::getStats()
+{
+  ensureStorage();
+  lockStore();
+  LogStore::Stats stats = store.getStats();
+  unlockStore();
+  return stats;
+}
+
+size_t Logger::getRawBytes()
+{
+  ensureStorage();
+  lockStore();
+  size_t bytes = store.rawBytes();
+  unlockStore();
+  return bytes;
+}
 
-  return result;
+size_t Logger::getCapacity()
+{
+  ensureStorage();
+  return store.capacity();
 }
 
 void Logger::clearLogs()
 {
-  currentIndex = 0;
-  totalEntries = 0;
-  if (logCapacity == 0 || logBuffer == nullptr)
+  lockStore();
+  store.clear();
+  unlockStore();
+}
+
+size_t Logger::shedHistory()
+{
+  ensureStorage();
+  lockStore();
+  size_t capacity = store.capacity();
+  size_t released = 0;
+  // A PSRAM buffer doesn't compete with the internal heap, so it stays.
+  if (logBuffer && capacity > FALLBACK_LOG_BUFFER_BYTES && capacity != PSRAM_LOG_BUFFER_BYTES)
   {
-    return;
+    // The block ring is laid out for the old capacity, so the history goes.
+    uint8_t *smaller = (uint8_t *)realloc(logBuffer, FALLBACK_LOG_BUFFER_BYTES);
+    if (smaller)
+    {
+      logBuffer = smaller;
+      released = capacity - FALLBACK_LOG_BUFFER_BYTES;
+      store.attach(logBuffer, FALLBACK_LOG_BUFFER_BYTES);
+    }
   }
-  // Clear the buffer
-  for (int i = 0; i < logCapacity; i++)
+  unlockStore();
+  if (released > 0)
   {
-    logBuffer[i].uuid = "";
-    logBuffer[i].timestamp = 0;
-    logBuffer[i].message = "";
+    logf(LOG_LEVEL_WARN, "Log history dropped to free %u bytes of heap", (unsigned)released);
   }
+  return released;
 }
 
 int Logger::getLogCount()
 {
-  return totalEntries;
+  lockStore();
+  int count = (int)store.count();
+  unlockStore();
+  return count;
 }
@@ -3,26 +3,59 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <UUID.h>
-#include <new>
 
-struct LogEntry
+#include "LogCategory.h"
+#include "LogSink.h"
+#include "LogStore.h"
+
+// Longest substring a log query may search for
+static const size_t LOG_QUERY_TEXT_MAX = 64;
+
+enum
+{
+  READ_STATE_PREFIX = 0,
+  READ_STATE_RECORDS,
+  READ_STATE_SUFFIX,
+  READ_STATE_DONE
+};
+
+// Position of an in-progress streaming read of the log history. Records
+// appended after beginRead() are not included, so a stream always ends.
+struct LogReadCursor
 {
-  String uuid;
-  unsigned long timestamp;
-  String message;
+  uint32_t nextSeq;
+  uint32_t endSeq;
+  bool json;
+  bool wroteRecord;
+  uint8_t state;
+  // Only matching records are sent; filter.text is pointed at `text` on
+  // every read because the cursor is copied around by value
+  LogStore::Filter filter;
+  char text[LOG_QUERY_TEXT_MAX];
+  uint32_t matched;
+  LogStore::Scan scan;
+
+  bool done() const { return state == READ_STATE_DONE; }
 };
 
 class Logger
 {
 private:
-  static const int MAX_LOG_ENTRIES = 20000;
-  static const int FALLBACK_LOG_ENTRIES = 4096;
-  LogEntry *logBuffer;
-  int logCapacity;
-  int currentIndex;
-  int totalEntries;
-  UUID uuidGenerator;
+  // Log history is kept as packed records in one byte buffer. PSRAM is used
+  // when the board has it; otherwise a smaller internal-RAM buffer is used.
+  static const size_t PSRAM_LOG_BUFFER_BYTES = 512 * 1024;
+  static const size_t LOG_BUFFER_BYTES = 64 * 1024;
+  static const size_t FALLBACK_LOG_BUFFER_BYTES = 16 * 1024;
+  uint8_t *logBuffer;
+  bool storageAttempted;
+  LogStore store;
+  // Records are appended from the loop task and streamed out from the
+  // async web server task.
+  SemaphoreHandle_t storeMutex;
+
+  static const int MAX_SINKS = 4;
+  LogSink *sinks[MAX_SINKS];
+  volatile int sinkCount;
 
   Logger();
 
@@ -30,6 +63,11 @@ private:
   Logger(const Logger &) = delete;
   Logger &operator=(const Logger &) = delete;
 
+  // Allocates the log buffer on first use rather than at static-init time
+  void ensureStorage();
+  void lockStore();
+  void unlockStore();
+
 public:
   // Singleton access method
   static Logger &getInstance();
@@ -38,10 +76,35 @@ public:
 
   void log(const String &message);
   void log(const char *message);
+  void log(log_level_t level, const char *message);
+  void log(log_level_t level, log_category_t category, const char *message);
   void logf(const char *format, ...);
-  String getLogsAsJson();
-  String getLogsAsText();
+  void logf(log_level_t level, const char *format, ...);
+  void logf(log_level_t level, log_category_t category, const char *format, ...);
+
+  // Streams the history in pieces so a response never needs the whole log
+  // decompressed in RAM. readLogChunk() returns 0 once the cursor is done,
+  // and also when maxLen cannot hold the next piece; cursor.done() tells
+  // the two apart.
+  // With a filter only matching records are read; blocks that cannot match
+  // are skipped without being decompressed. The JSON form ends with the
+  // number of matches and of blocks read and skipped.
+  LogReadCursor beginRead(bool json);
+  LogReadCursor beginRead(bool json, const LogStore::Filter &filter);
+  size_t readLogChunk(LogReadCursor &cursor, uint8_t *out, size_t maxLen);
+
+  // Registers an additional destination. Sinks are never removed; a sink
+  // that is switched off simply stops queueing.
+  bool addSink(LogSink *sink);
+
+  LogStore::Stats getStats();
+  size_t getCapacity();
+  // Approximate size of the history as text, for sizing responses
+  size_t getRawBytes();
   void clearLogs();
+  // Shrinks an internal-RAM log buffer to the fallback size when memory runs
+  // low, dropping the history. Returns the bytes released.
+  size_t shedHistory();
   int getLogCount();
 };
 
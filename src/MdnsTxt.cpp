@@ -0,0 +1,81 @@
+#include "MdnsTxt.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void mdnsHostnameFromMac(const uint8_t mac[6], char *out, size_t outSize)
+{
+    snprintf(out, outSize, "%s-%02x%02x", MDNS_HOSTNAME_PREFIX, mac[4], mac[5]);
+}
+
+MdnsTxtRecords::MdnsTxtRecords()
+{
+    memset(records, 0, sizeof(records));
+    recordCount = 0;
+    lastPushMs  = 0;
+    hasPushed   = false;
+}
+
+bool MdnsTxtRecords::set(const char *key, const char *value)
+{
+    Record *record = nullptr;
+    for (size_t i = 0; i < recordCount; i++)
+    {
+        if (strncmp(records[i].key, key, KEY_SIZE) == 0)
+        {
+            record = &records[i];
+            break;
+        }
+    }
+    if (record == nullptr)
+    {
+        if (recordCount >= MAX_RECORDS)
+        {
+            return false;
+        }
+        record = &records[recordCount++];
+        snprintf(record->key, KEY_SIZE, "%s", key);
+        record->value[0] = '\0';
+        record->dirty    = true;
+    }
+    else if (strncmp(record->value, value, VALUE_SIZE - 1) == 0)
+    {
+        return false;
+    }
+    snprintf(record->value, VALUE_SIZE, "%s", value);
+    record->dirty = true;
+    return true;
+}
+
+bool MdnsTxtRecords::due(uint32_t nowMs) const
+{
+    bool anyDirty = false;
+    for (size_t i = 0; i < recordCount && !anyDirty; i++)
+    {
+        anyDirty = records[i].dirty;
+    }
+    if (!anyDirty)
+    {
+        return false;
+    }
+    return !hasPushed || (nowMs - lastPushMs) >= MIN_PUSH_INTERVAL_MS;
+}
+
+void MdnsTxtRecords::markPushed(uint32_t nowMs)
+{
+    for (size_t i = 0; i < recordCount; i++)
+    {
+        records[i].dirty = false;
+    }
+    lastPushMs = nowMs;
+    hasPushed  = true;
+}
+
+void MdnsTxtRecords::markAllDirty()
+{
+    for (size_t i = 0; i < recordCount; i++)
+    {
+        records[i].dirty = true;
+    }
+    hasPushed = false;
+}
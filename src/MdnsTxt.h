@@ -0,0 +1,58 @@
+#ifndef MDNS_TXT_H
+#define MDNS_TXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MDNS_HOSTNAME_PREFIX "ccxsfs20"
+#define MDNS_SERVICE_NAME "ccsfs"
+#define MDNS_SERVICE_PROTO "tcp"
+
+// Writes "ccxsfs20-xxxx", where xxxx is the last two bytes of the MAC in
+// hex, so several units on one network get distinct names.
+void mdnsHostnameFromMac(const uint8_t mac[6], char *out, size_t outSize);
+
+// TXT records for the _ccsfs._tcp service. Values are stored here and only
+// changed records are pushed to the responder, at most once per
+// MIN_PUSH_INTERVAL_MS, so a flapping jam flag or print state doesn't flood
+// the network with announcements.
+class MdnsTxtRecords
+{
+   public:
+    static const size_t   MAX_RECORDS          = 8;
+    static const size_t   KEY_SIZE             = 10;
+    static const size_t   VALUE_SIZE           = 40;
+    static const uint32_t MIN_PUSH_INTERVAL_MS = 2000;
+
+    MdnsTxtRecords();
+
+    // Adds the key on first use. Returns true when the stored value changed.
+    bool set(const char *key, const char *value);
+
+    // True when a record changed and the rate limit allows a push now
+    bool due(uint32_t nowMs) const;
+    // Marks every record as pushed; call after sending the dirty ones.
+    void markPushed(uint32_t nowMs);
+    // Forces all records to be sent again (e.g. after the responder restarts)
+    void markAllDirty();
+
+    size_t      count() const { return recordCount; }
+    const char *key(size_t index) const { return records[index].key; }
+    const char *value(size_t index) const { return records[index].value; }
+    bool        isDirty(size_t index) const { return records[index].dirty; }
+
+   private:
+    struct Record
+    {
+        char key[KEY_SIZE];
+        char value[VALUE_SIZE];
+        bool dirty;
+    };
+
+    Record   records[MAX_RECORDS];
+    size_t   recordCount;
+    uint32_t lastPushMs;
+    bool     hasPushed;
+};
+
+#endif  // MDNS_TXT_H
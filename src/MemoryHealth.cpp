@@ -0,0 +1,121 @@
+#include "MemoryHealth.h"
+
+#include <string.h>
+
+MemoryHealth::MemoryHealth()
+{
+    // Defaults sized for an ESP32 without PSRAM: the websocket client and
+    // AsyncTCP need a few KB contiguous, a gzip response about 4 KB.
+    limits.lowFreeBytes         = 40 * 1024;
+    limits.criticalFreeBytes    = 20 * 1024;
+    limits.lowLargestBlock      = 16 * 1024;
+    limits.criticalLargestBlock = 8 * 1024;
+    limits.hysteresisBytes      = 4 * 1024;
+    current                     = MEMORY_OK;
+    memset(&last, 0, sizeof(last));
+    memset(shedders, 0, sizeof(shedders));
+    memset(&stats, 0, sizeof(stats));
+    count = 0;
+}
+
+void MemoryHealth::setThresholds(const memory_thresholds_t &thresholds)
+{
+    limits = thresholds;
+}
+
+bool MemoryHealth::addShedder(const char *name, memory_level_t level, shed_fn shed,
+                              void *context)
+{
+    if (count >= MAX_SHEDDERS || shed == nullptr || level == MEMORY_OK)
+    {
+        return false;
+    }
+    shedders[count].name    = name;
+    shedders[count].level   = level;
+    shedders[count].shed    = shed;
+    shedders[count].context = context;
+    shedders[count].fired   = false;
+    count++;
+    return true;
+}
+
+memory_level_t MemoryHealth::classify(const memory_sample_t &sample, uint32_t headroom) const
+{
+    if (sample.freeBytes < limits.criticalFreeBytes + headroom ||
+        sample.largestBlock < limits.criticalLargestBlock + headroom)
+    {
+        return MEMORY_CRITICAL;
+    }
+    if (sample.freeBytes < limits.lowFreeBytes + headroom ||
+        sample.largestBlock < limits.lowLargestBlock + headroom)
+    {
+        return MEMORY_LOW;
+    }
+    return MEMORY_OK;
+}
+
+memory_level_t MemoryHealth::update(const memory_sample_t &sample)
+{
+    last = sample;
+    stats.samples++;
+
+    memory_level_t next = classify(sample, 0);
+    if (next < current)
+    {
+        // Only step down once the heap clears the thresholds with headroom
+        memory_level_t withHeadroom = classify(sample, limits.hysteresisBytes);
+        next                        = withHeadroom < current ? withHeadroom : current;
+    }
+    if (next != current)
+    {
+        stats.levelChanges++;
+        current = next;
+    }
+    if (current > stats.worstLevel)
+    {
+        stats.worstLevel = current;
+    }
+
+    if (current == MEMORY_OK)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            shedders[i].fired = false;
+        }
+        return current;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!shedders[i].fired && shedders[i].level <= current)
+        {
+            shedders[i].fired = true;
+            stats.shedRuns++;
+            stats.bytesShed += (uint32_t) shedders[i].shed(shedders[i].context);
+        }
+    }
+    return current;
+}
+
+uint8_t MemoryHealth::fragmentationPct(const memory_sample_t &sample)
+{
+    if (sample.freeBytes == 0 || sample.largestBlock >= sample.freeBytes)
+    {
+        return 0;
+    }
+    return (uint8_t) (100 - (uint64_t) sample.largestBlock * 100 / sample.freeBytes);
+}
+
+const char *MemoryHealth::levelName(memory_level_t level)
+{
+    switch (level)
+    {
+        case MEMORY_OK:
+            return "ok";
+        case MEMORY_LOW:
+            return "low";
+        case MEMORY_CRITICAL:
+            return "critical";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef MEMORY_HEALTH_H
+#define MEMORY_HEALTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+    MEMORY_OK       = 0,
+    MEMORY_LOW      = 1,  // optional caches are shed
+    MEMORY_CRITICAL = 2,  // optional work is refused
+} memory_level_t;
+
+// One reading of a heap (one capability set)
+typedef struct
+{
+    uint32_t freeBytes;
+    uint32_t minFreeBytes;  // lowest free since boot
+    uint32_t largestBlock;  // largest single allocation that would succeed
+} memory_sample_t;
+
+typedef struct
+{
+    uint32_t lowFreeBytes;
+    uint32_t criticalFreeBytes;
+    uint32_t lowLargestBlock;
+    uint32_t criticalLargestBlock;
+    // Extra headroom needed before a level is left again, so a heap hovering
+    // at a threshold doesn't flap
+    uint32_t hysteresisBytes;
+} memory_thresholds_t;
+
+// Classifies heap samples into OK/LOW/CRITICAL and runs registered shedders
+// when the level rises. Both total free memory and the largest free block are
+// checked: a fragmented heap can have plenty free and still fail a 4 KB
+// allocation. Each shedder runs once per episode and is re-armed when the
+// heap recovers to OK.
+class MemoryHealth
+{
+   public:
+    // Returns the bytes it released (best effort, for reporting)
+    typedef size_t (*shed_fn)(void *context);
+
+    static const size_t MAX_SHEDDERS = 6;
+
+    struct Stats
+    {
+        uint32_t samples;
+        uint32_t levelChanges;
+        uint32_t shedRuns;
+        uint32_t bytesShed;
+        uint8_t  worstLevel;  // memory_level_t
+    };
+
+    MemoryHealth();
+
+    void setThresholds(const memory_thresholds_t &thresholds);
+    bool addShedder(const char *name, memory_level_t level, shed_fn shed, void *context);
+
+    // Feeds a sample and returns the (possibly new) level
+    memory_level_t update(const memory_sample_t &sample);
+
+    memory_level_t        level() const { return current; }
+    const memory_sample_t &lastSample() const { return last; }
+    Stats                 getStats() const { return stats; }
+
+    size_t      shedderCount() const { return count; }
+    const char *shedderName(size_t index) const { return shedders[index].name; }
+    bool        shedderFired(size_t index) const { return shedders[index].fired; }
+
+    // 0 when all free memory is one block, approaching 100 as it splinters
+    static uint8_t     fragmentationPct(const memory_sample_t &sample);
+    static const char *levelName(memory_level_t level);
+
+   private:
+    struct Shedder
+    {
+        const char    *name;
+        memory_level_t level;
+        shed_fn        shed;
+        void          *context;
+        bool           fired;
+    };
+
+    memory_thresholds_t limits;
+    memory_level_t      current;
+    memory_sample_t     last;
+    Shedder             shedders[MAX_SHEDDERS];
+    size_t              count;
+    Stats               stats;
+
+    memory_level_t classify(const memory_sample_t &sample, uint32_t headroom) const;
+};
+
+#endif  // MEMORY_HEALTH_H
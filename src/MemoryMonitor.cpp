@@ -0,0 +1,102 @@
+#include "MemoryMonitor.h"
+
+#include <esp_heap_caps.h>
+
+#include "Logger.h"
+
+// Tasks worth watching: ours, the Arduino loop, and the network stack.
+static const char *const WATCHED_TASKS[MemoryMonitor::MAX_TASKS] = {
+    "loopTask",  "async_tcp",   "tiT",         "wifi",          "sys_evt",
+    "esp_timer", "syslog_sink", "log_file_sink", "arduino_events", "IDLE"};
+
+static size_t shedLogHistory(void *)
+{
+    return logger.shedHistory();
+}
+
+MemoryMonitor &MemoryMonitor::getInstance()
+{
+    static MemoryMonitor instance;
+    return instance;
+}
+
+MemoryMonitor::MemoryMonitor()
+{
+    memset(&psram, 0, sizeof(psram));
+    psramPresent = false;
+    for (size_t i = 0; i < MAX_TASKS; i++)
+    {
+        tasks[i].name         = WATCHED_TASKS[i];
+        tasks[i].found        = false;
+        tasks[i].stackFreeMin = 0;
+        stackWarned[i]        = false;
+    }
+    lastSampleMs = 0;
+    sampled      = false;
+}
+
+void MemoryMonitor::begin()
+{
+    psramPresent = psramFound();
+    // The log buffer is the one large optional allocation on internal RAM
+    // (it moves to PSRAM when fitted, where shedding it wouldn't help).
+    health.addShedder("log_history", MEMORY_LOW, shedLogHistory, nullptr);
+}
+
+memory_sample_t MemoryMonitor::sampleHeap(uint32_t caps)
+{
+    memory_sample_t sample;
+    sample.freeBytes    = heap_caps_get_free_size(caps);
+    sample.minFreeBytes = heap_caps_get_minimum_free_size(caps);
+    sample.largestBlock = heap_caps_get_largest_free_block(caps);
+    return sample;
+}
+
+void MemoryMonitor::sampleTasks()
+{
+    for (size_t i = 0; i < MAX_TASKS; i++)
+    {
+        TaskHandle_t handle = xTaskGetHandle(tasks[i].name);
+        tasks[i].found      = handle != nullptr;
+        if (!tasks[i].found)
+        {
+            continue;
+        }
+        // ESP-IDF reports stack in bytes
+        tasks[i].stackFreeMin = uxTaskGetStackHighWaterMark(handle);
+        if (tasks[i].stackFreeMin < STACK_WARN_BYTES && !stackWarned[i])
+        {
+            stackWarned[i] = true;
+            LOGW(LOG_CAT_GENERAL, "Task %s stack nearly exhausted: %lu bytes never used",
+                 tasks[i].name, (unsigned long) tasks[i].stackFreeMin);
+        }
+    }
+}
+
+void MemoryMonitor::loop(unsigned long currentTime)
+{
+    if (sampled && currentTime - lastSampleMs < SAMPLE_INTERVAL_MS)
+    {
+        return;
+    }
+    sampled      = true;
+    lastSampleMs = currentTime;
+
+    memory_level_t  before   = health.level();
+    memory_sample_t internal = sampleHeap(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    memory_level_t  after    = health.update(internal);
+    if (psramPresent)
+    {
+        psram = sampleHeap(MALLOC_CAP_SPIRAM);
+    }
+    sampleTasks();
+
+    if (after != before)
+    {
+        logger.logf(after > before ? LOG_LEVEL_WARN : LOG_LEVEL_INFO,
+                    "Memory %s: free=%lu min=%lu largest=%lu fragmentation=%u%%",
+                    MemoryHealth::levelName(after), (unsigned long) internal.freeBytes,
+                    (unsigned long) internal.minFreeBytes, (unsigned long) internal.largestBlock,
+                    (unsigned) MemoryHealth::fragmentationPct(internal));
+    }
+}
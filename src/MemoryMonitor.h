@@ -0,0 +1,60 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <Arduino.h>
+
+#include "MemoryHealth.h"
+
+typedef struct
+{
+    const char *name;
+    bool        found;
+    uint32_t    stackFreeMin;  // high-water mark: least free stack ever, bytes
+} task_stack_t;
+
+// Samples the heaps and task stacks from the main loop and drives
+// MemoryHealth with the internal 8-bit heap, the one the websocket client,
+// AsyncTCP and ArduinoJson allocate from. PSRAM (if fitted) is reported but
+// doesn't raise alarms.
+class MemoryMonitor
+{
+   public:
+    static const unsigned long SAMPLE_INTERVAL_MS = 5000;
+    static const size_t        MAX_TASKS          = 10;
+    // Warn once per task when its free stack drops below this
+    static const uint32_t      STACK_WARN_BYTES   = 512;
+
+    static MemoryMonitor &getInstance();
+
+    // Call once from setup(); registers the optional caches to shed
+    void begin();
+    void loop(unsigned long currentTime);
+
+    memory_level_t      level() const { return health.level(); }
+    const MemoryHealth &getHealth() const { return health; }
+    memory_sample_t     getPsramSample() const { return psram; }
+    bool                hasPsram() const { return psramPresent; }
+    size_t              taskCount() const { return MAX_TASKS; }
+    const task_stack_t &task(size_t index) const { return tasks[index]; }
+
+   private:
+    MemoryHealth    health;
+    memory_sample_t psram;
+    bool            psramPresent;
+    task_stack_t    tasks[MAX_TASKS];
+    bool            stackWarned[MAX_TASKS];
+    unsigned long   lastSampleMs;
+    bool            sampled;
+
+    MemoryMonitor();
+
+    MemoryMonitor(const MemoryMonitor &)            = delete;
+    MemoryMonitor &operator=(const MemoryMonitor &) = delete;
+
+    static memory_sample_t sampleHeap(uint32_t caps);
+    void                   sampleTasks();
+};
+
+#define memoryMonitor MemoryMonitor::getInstance()
+
+#endif  // MEMORY_MONITOR_H
@@ -0,0 +1,299 @@
+#include "Notifier.h"
+
+#include <HTTPClient.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+
+#include "Logger.h"
+#include "SdcpCodec.h"
+#include "TimeService.h"
+
+#define NOTIFY_NAMESPACE "notify"
+#define NOTIFY_QUEUE_KEY "queue"
+
+Notifier &Notifier::getInstance()
+{
+    static Notifier instance;
+    return instance;
+}
+
+Notifier::Notifier()
+{
+    queueMux        = portMUX_INITIALIZER_UNLOCKED;
+    senderTask      = nullptr;
+    url[0]          = '\0';
+    bodyTemplate[0] = '\0';
+    eventMask       = 0;
+    strlcpy(hostname, "ccxsfs20", sizeof(hostname));
+    printStatus   = -1;
+    layer         = 0;
+    printerLinkUp = false;
+    lastStatus    = 0;
+}
+
+void Notifier::begin()
+{
+    static uint8_t state[NotifyQueue::MAX_STATE_SIZE];
+    Preferences    prefs;
+    if (prefs.begin(NOTIFY_NAMESPACE, true))
+    {
+        size_t length = prefs.getBytes(NOTIFY_QUEUE_KEY, state, sizeof(state));
+        prefs.end();
+        portENTER_CRITICAL(&queueMux);
+        bool restored = length > 0 && queue.loadState(state, length);
+        size_t pending = queue.count();
+        portEXIT_CRITICAL(&queueMux);
+        if (restored && pending > 0)
+        {
+            logger.logf("Notify: %u notifications pending from before reboot", (unsigned) pending);
+        }
+    }
+
+    eventBus.subscribe(EVENT_BIT(EVENT_JAM) | EVENT_BIT(EVENT_PRINT_STATE) |
+                           EVENT_BIT(EVENT_FRAME) | EVENT_BIT(EVENT_LINK_UP) |
+                           EVENT_BIT(EVENT_LINK_DOWN),
+                       handleEvent, this);
+
+    if (xTaskCreate(senderTaskEntry, "notifier", 6144, this, tskIDLE_PRIORITY + 1,
+                    &senderTask) != pdPASS)
+    {
+        senderTask = nullptr;
+        logger.log("Notify: failed to start sender task");
+    }
+}
+
+void Notifier::configure(const String &webhookUrl, const String &webhookTemplate, uint32_t mask)
+{
+    portENTER_CRITICAL(&queueMux);
+    strlcpy(url, webhookUrl.c_str(), sizeof(url));
+    strlcpy(bodyTemplate, webhookTemplate.c_str(), sizeof(bodyTemplate));
+    eventMask = mask;
+    portEXIT_CRITICAL(&queueMux);
+
+    if (webhookUrl.length() >= URL_LENGTH || webhookTemplate.length() >= TEMPLATE_LENGTH)
+    {
+        logger.log("Notify: webhook URL or template too long, truncated");
+    }
+    if (webhookUrl.length() > 0)
+    {
+        logger.logf("Notify: posting events to %s", url);
+    }
+}
+
+void Notifier::setHostname(const char *deviceHostname)
+{
+    portENTER_CRITICAL(&queueMux);
+    strlcpy(hostname, deviceHostname, sizeof(hostname));
+    portEXIT_CRITICAL(&queueMux);
+}
+
+void Notifier::handleEvent(const event_t &event, void *context)
+{
+    static_cast<Notifier *>(context)->onEvent(event);
+}
+
+void Notifier::onEvent(const event_t &event)
+{
+    switch (event.type)
+    {
+        case EVENT_JAM:
+            enqueue(event.data.jam.runout ? NOTIFY_RUNOUT : NOTIFY_JAM, event.timestampUs,
+                    event.data.jam.deficitMm);
+            break;
+        case EVENT_FRAME:
+            layer = event.data.frame.layer;
+            break;
+        case EVENT_PRINT_STATE:
+            printStatus = event.data.printState.to;
+            if (event.data.printState.to == SDCP_PRINT_STATUS_COMPLETE)
+            {
+                enqueue(NOTIFY_PRINT_COMPLETE, event.timestampUs, 0.0f);
+            }
+            break;
+        case EVENT_LINK_UP:
+            if (event.data.link.link == EVENT_LINK_PRINTER)
+            {
+                printerLinkUp = true;
+            }
+            break;
+        case EVENT_LINK_DOWN:
+        {
+            if (event.data.link.link != EVENT_LINK_PRINTER || !printerLinkUp)
+            {
+                // Reconnect attempts report down again; only the drop counts
+                break;
+            }
+            printerLinkUp = false;
+            // Detection is blind without printer telemetry; that only
+            // matters while a print is running.
+            bool printing = printStatus > SDCP_PRINT_STATUS_IDLE &&
+                            printStatus != SDCP_PRINT_STATUS_STOPED &&
+                            printStatus != SDCP_PRINT_STATUS_COMPLETE;
+            if (printing)
+            {
+                enqueue(NOTIFY_LINK_LOST, event.timestampUs, 0.0f);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void Notifier::enqueue(notify_kind_t kind, uint64_t timestampUs, float deficitMm)
+{
+    portENTER_CRITICAL(&queueMux);
+    if (kind == NOTIFY_TEST || (eventMask & NOTIFY_BIT(kind)))
+    {
+        queue.push(kind, timestampUs, timeService.toEpochSeconds(timestampUs), deficitMm, layer,
+                   millis());
+    }
+    portEXIT_CRITICAL(&queueMux);
+}
+
+bool Notifier::enqueueTest()
+{
+    portENTER_CRITICAL(&queueMux);
+    uint64_t nowUs  = timeService.nowUs();
+    bool     queued = queue.push(NOTIFY_TEST, nowUs, timeService.toEpochSeconds(nowUs), 0.0f, layer,
+                                 millis());
+    portEXIT_CRITICAL(&queueMux);
+    return queued;
+}
+
+void Notifier::senderTaskEntry(void *arg)
+{
+    static_cast<Notifier *>(arg)->senderLoop();
+}
+
+void Notifier::senderLoop()
+{
+    while (true)
+    {
+        vTaskDelay(pdMS_TO_TICKS(POLL_MS));
+
+        notify_record_t record;
+        portENTER_CRITICAL(&queueMux);
+        bool hasUrl = url[0] != '\0';
+        bool isDue  = hasUrl && queue.due(millis(), record);
+        portEXIT_CRITICAL(&queueMux);
+
+        if (isDue && WiFi.status() == WL_CONNECTED)
+        {
+            bool sent = deliver(record);
+            // Only this task removes entries, so the head is still `record`
+            // unless a full queue evicted it meanwhile.
+            portENTER_CRITICAL(&queueMux);
+            notify_record_t head;
+            if (queue.due(millis(), head) && head.id == record.id)
+            {
+                if (sent)
+                {
+                    queue.markSent();
+                }
+                else
+                {
+                    queue.markFailed(millis());
+                }
+            }
+            portEXIT_CRITICAL(&queueMux);
+            if (!sent && record.attempts + 1 >= NotifyQueue::MAX_ATTEMPTS)
+            {
+                logger.logf("Notify: giving up on %s notification %lu",
+                            NotifyQueue::kindName((notify_kind_t) record.kind),
+                            (unsigned long) record.id);
+            }
+        }
+        saveQueue();
+    }
+}
+
+bool Notifier::deliver(const notify_record_t &record)
+{
+    static char body[NotifyQueue::MAX_BODY_LENGTH];
+    static char tmpl[TEMPLATE_LENGTH];
+
+    // configure() may run on the web server task while this one sends.
+    char target[URL_LENGTH];
+    char device[sizeof(hostname)];
+    portENTER_CRITICAL(&queueMux);
+    memcpy(target, url, sizeof(target));
+    memcpy(tmpl, bodyTemplate, sizeof(tmpl));
+    memcpy(device, hostname, sizeof(device));
+    portEXIT_CRITICAL(&queueMux);
+
+    // Events queued before NTP get their date at send time; restored ones
+    // without a date have lost their clock and go out without a time.
+    uint32_t epochSeconds = record.epochSeconds;
+    if (epochSeconds == 0 && record.timestampUs != 0)
+    {
+        epochSeconds = timeService.toEpochSeconds(record.timestampUs);
+    }
+    notify_context_t context = {device, epochSeconds};
+    size_t length = NotifyQueue::render(tmpl, record, context, body, sizeof(body));
+    if (length == 0)
+    {
+        // A template that cannot fit will never fit; fall back to the default
+        length = NotifyQueue::render(nullptr, record, context, body, sizeof(body));
+    }
+
+    char idempotencyKey[48];
+    snprintf(idempotencyKey, sizeof(idempotencyKey), "%s-%lu", device, (unsigned long) record.id);
+
+    HTTPClient       http;
+    WiFiClient       plainClient;
+    WiFiClientSecure secureClient;
+    bool             secure = strncmp(target, "https://", 8) == 0;
+    if (secure)
+    {
+        // No CA bundle on the device; the body carries nothing secret
+        secureClient.setInsecure();
+    }
+    http.setTimeout(HTTP_TIMEOUT_MS);
+    http.setConnectTimeout(HTTP_TIMEOUT_MS);
+    if (!(secure ? http.begin(secureClient, target) : http.begin(plainClient, target)))
+    {
+        lastStatus = HTTPC_ERROR_CONNECTION_REFUSED;
+        return false;
+    }
+    http.addHeader("Content-Type", "application/json");
+    http.addHeader("X-SFS-Event", NotifyQueue::kindName((notify_kind_t) record.kind));
+    http.addHeader("Idempotency-Key", idempotencyKey);
+    int status = http.POST((uint8_t *) body, length);
+    http.end();
+
+    lastStatus = status;
+    return status >= 200 && status < 300;
+}
+
+void Notifier::saveQueue()
+{
+    static uint8_t state[NotifyQueue::MAX_STATE_SIZE];
+    portENTER_CRITICAL(&queueMux);
+    bool   dirty  = queue.takeDirty();
+    size_t length = dirty ? queue.saveState(state, sizeof(state)) : 0;
+    portEXIT_CRITICAL(&queueMux);
+    if (!dirty)
+    {
+        return;
+    }
+
+    Preferences prefs;
+    if (prefs.begin(NOTIFY_NAMESPACE, false))
+    {
+        prefs.putBytes(NOTIFY_QUEUE_KEY, state, length);
+        prefs.end();
+    }
+}
+
+notifier_stats_t Notifier::getStats()
+{
+    notifier_stats_t stats;
+    portENTER_CRITICAL(&queueMux);
+    stats.enabled = senderTask != nullptr && url[0] != '\0';
+    stats.queue   = queue.getStats();
+    portEXIT_CRITICAL(&queueMux);
+    stats.lastStatus = lastStatus;
+    return stats;
+}
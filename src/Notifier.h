@@ -0,0 +1,75 @@
+#ifndef NOTIFIER_H
+#define NOTIFIER_H
+
+#include <Arduino.h>
+
+#include "EventBus.h"
+#include "NotifyQueue.h"
+
+typedef struct
+{
+    bool           enabled;
+    notify_stats_t queue;
+    int            lastStatus;  // HTTP status (or negative HTTPClient error) of the last attempt
+} notifier_stats_t;
+
+// Sends jam, runout, printer link loss and print complete events to a
+// webhook as HTTP POSTs with a templated JSON body.
+//
+// Event handlers only push into a NotifyQueue under a spinlock; a
+// low-priority task does the HTTP work, so a slow or unreachable endpoint
+// delays notifications but never the detection loop. The queue is saved to
+// NVS whenever it changes so pending notifications survive a reboot.
+class Notifier
+{
+   private:
+    static const unsigned long POLL_MS         = 500;
+    static const uint16_t      HTTP_TIMEOUT_MS = 5000;
+    static const size_t        URL_LENGTH      = 160;
+    static const size_t        TEMPLATE_LENGTH = 512;
+
+    NotifyQueue  queue;
+    portMUX_TYPE queueMux;
+    TaskHandle_t senderTask;
+
+    char     url[URL_LENGTH];
+    char     bodyTemplate[TEMPLATE_LENGTH];
+    uint32_t eventMask;  // NOTIFY_BIT() of the kinds to send
+    char     hostname[32];
+    int16_t  printStatus;
+    int32_t  layer;
+    bool     printerLinkUp;
+    int      lastStatus;
+
+    Notifier();
+
+    Notifier(const Notifier &)            = delete;
+    Notifier &operator=(const Notifier &) = delete;
+
+    static void handleEvent(const event_t &event, void *context);
+    void        onEvent(const event_t &event);
+    void        enqueue(notify_kind_t kind, uint64_t timestampUs, float deficitMm);
+
+    static void senderTaskEntry(void *arg);
+    void        senderLoop();
+    bool        deliver(const notify_record_t &record);
+    void        saveQueue();
+
+   public:
+    static Notifier &getInstance();
+
+    // Restores the saved queue, subscribes to events and starts the sender
+    void begin();
+    // An empty URL disables sending; events still queue so a URL set later
+    // receives what happened meanwhile. An empty template uses the default.
+    void configure(const String &webhookUrl, const String &webhookTemplate, uint32_t mask);
+    void setHostname(const char *deviceHostname);
+
+    // Queues a NOTIFY_TEST notification regardless of the event mask
+    bool             enqueueTest();
+    notifier_stats_t getStats();
+};
+
+#define notifier Notifier::getInstance()
+
+#endif  // NOTIFIER_H
@@ -0,0 +1,357 @@
+#include "NotifyQueue.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const char *NotifyQueue::DEFAULT_TEMPLATE =
+    "{\"event\":\"{{event}}\",\"message\":\"{{message}}\",\"device\":\"{{device}}\","
+    "\"time\":{{time}},\"deficitMm\":{{deficit}},\"layer\":{{layer}},\"id\":{{id}}}";
+
+NotifyQueue::NotifyQueue()
+{
+    nextId = 1;
+    clear();
+}
+
+void NotifyQueue::clear()
+{
+    head    = 0;
+    entries = 0;
+    dirty   = true;
+    memset(&stats, 0, sizeof(stats));
+    memset(lastAcceptedMs, 0, sizeof(lastAcceptedMs));
+    memset(hasAccepted, 0, sizeof(hasAccepted));
+}
+
+bool NotifyQueue::push(notify_kind_t kind, uint64_t timestampUs, uint32_t epochSeconds,
+                       float deficitMm, int32_t layer, uint32_t nowMs)
+{
+    if (kind >= NOTIFY_KIND_COUNT)
+    {
+        return false;
+    }
+
+    if (hasAccepted[kind] && nowMs - lastAcceptedMs[kind] < DEDUPE_MS)
+    {
+        stats.suppressed++;
+        return false;
+    }
+
+    if (entries == CAPACITY)
+    {
+        popHead();
+        stats.dropped++;
+    }
+
+    notify_record_t &record = records[(head + entries) % CAPACITY];
+    memset(&record, 0, sizeof(record));
+    record.id            = nextId++;
+    record.kind          = (uint8_t) kind;
+    record.nextAttemptMs = nowMs;
+    record.epochSeconds  = epochSeconds;
+    record.timestampUs   = timestampUs;
+    record.deficitMm     = deficitMm;
+    record.layer         = layer;
+    entries++;
+
+    lastAcceptedMs[kind] = nowMs;
+    hasAccepted[kind]    = true;
+    stats.accepted++;
+    dirty = true;
+    return true;
+}
+
+bool NotifyQueue::due(uint32_t nowMs, notify_record_t &record) const
+{
+    if (entries == 0)
+    {
+        return false;
+    }
+    const notify_record_t &oldest = at(0);
+    // Wrap-safe: due once nextAttemptMs is not in the future
+    if ((int32_t) (nowMs - oldest.nextAttemptMs) < 0)
+    {
+        return false;
+    }
+    record = oldest;
+    return true;
+}
+
+void NotifyQueue::popHead()
+{
+    head = (head + 1) % CAPACITY;
+    entries--;
+    dirty = true;
+}
+
+void NotifyQueue::markSent()
+{
+    if (entries == 0)
+    {
+        return;
+    }
+    popHead();
+    stats.sent++;
+}
+
+void NotifyQueue::markFailed(uint32_t nowMs)
+{
+    if (entries == 0)
+    {
+        return;
+    }
+    notify_record_t &oldest = at(0);
+    oldest.attempts++;
+    if (oldest.attempts >= MAX_ATTEMPTS)
+    {
+        popHead();
+        stats.failed++;
+        return;
+    }
+    oldest.nextAttemptMs = nowMs + backoffMs(oldest.attempts);
+    stats.retries++;
+    dirty = true;
+}
+
+uint32_t NotifyQueue::backoffMs(uint8_t attempts)
+{
+    if (attempts == 0)
+    {
+        return 0;
+    }
+    uint32_t delay = RETRY_BASE_MS;
+    for (uint8_t i = 1; i < attempts && delay < RETRY_MAX_MS; i++)
+    {
+        delay *= 2;
+    }
+    return delay < RETRY_MAX_MS ? delay : RETRY_MAX_MS;
+}
+
+notify_stats_t NotifyQueue::getStats() const
+{
+    notify_stats_t result = stats;
+    result.queued         = (uint32_t) entries;
+    return result;
+}
+
+bool NotifyQueue::takeDirty()
+{
+    bool wasDirty = dirty;
+    dirty         = false;
+    return wasDirty;
+}
+
+size_t NotifyQueue::saveState(uint8_t *out, size_t capacity) const
+{
+    size_t size = STATE_HEADER + entries * sizeof(notify_record_t);
+    if (out == nullptr || capacity < size)
+    {
+        return 0;
+    }
+    uint32_t header[3] = {STATE_MAGIC, nextId, (uint32_t) entries};
+    memcpy(out, header, sizeof(header));
+    for (size_t i = 0; i < entries; i++)
+    {
+        memcpy(out + STATE_HEADER + i * sizeof(notify_record_t), &at(i), sizeof(notify_record_t));
+    }
+    return size;
+}
+
+bool NotifyQueue::loadState(const uint8_t *data, size_t length)
+{
+    uint32_t header[3];
+    if (data == nullptr || length < STATE_HEADER)
+    {
+        return false;
+    }
+    memcpy(header, data, sizeof(header));
+    if (header[0] != STATE_MAGIC || header[2] > CAPACITY ||
+        length != STATE_HEADER + header[2] * sizeof(notify_record_t))
+    {
+        return false;
+    }
+
+    clear();
+    nextId  = header[1];
+    entries = header[2];
+    for (size_t i = 0; i < entries; i++)
+    {
+        memcpy(&records[i], data + STATE_HEADER + i * sizeof(notify_record_t),
+               sizeof(notify_record_t));
+        // The saved millis() and monotonic time belonged to the previous boot
+        records[i].nextAttemptMs = 0;
+        records[i].timestampUs   = 0;
+        if (records[i].kind >= NOTIFY_KIND_COUNT)
+        {
+            records[i].kind = NOTIFY_TEST;
+        }
+    }
+    dirty = false;
+    return true;
+}
+
+const char *NotifyQueue::kindName(notify_kind_t kind)
+{
+    switch (kind)
+    {
+        case NOTIFY_JAM:
+            return "jam";
+        case NOTIFY_RUNOUT:
+            return "runout";
+        case NOTIFY_LINK_LOST:
+            return "link_lost";
+        case NOTIFY_PRINT_COMPLETE:
+            return "print_complete";
+        case NOTIFY_TEST:
+            return "test";
+        default:
+            return "unknown";
+    }
+}
+
+const char *NotifyQueue::kindMessage(notify_kind_t kind)
+{
+    switch (kind)
+    {
+        case NOTIFY_JAM:
+            return "Filament jam detected";
+        case NOTIFY_RUNOUT:
+            return "Filament ran out";
+        case NOTIFY_LINK_LOST:
+            return "Lost connection to the printer, jam detection is inactive";
+        case NOTIFY_PRINT_COMPLETE:
+            return "Print complete";
+        case NOTIFY_TEST:
+            return "Test notification";
+        default:
+            return "";
+    }
+}
+
+namespace
+{
+struct BodyWriter
+{
+    char  *out;
+    size_t capacity;
+    size_t used;
+    bool   overflow;
+
+    void put(const char *text, size_t length)
+    {
+        if (used + length >= capacity)
+        {
+            overflow = true;
+            return;
+        }
+        memcpy(out + used, text, length);
+        used += length;
+    }
+
+    void putEscaped(const char *text)
+    {
+        for (; *text != '\0'; text++)
+        {
+            char c = *text;
+            if (c == '"' || c == '\\')
+            {
+                char escaped[2] = {'\\', c};
+                put(escaped, 2);
+            }
+            else if ((uint8_t) c < 0x20)
+            {
+                char escaped[7];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned) (uint8_t) c);
+                put(escaped, 6);
+            }
+            else
+            {
+                put(&c, 1);
+            }
+        }
+    }
+};
+}  // namespace
+
+size_t NotifyQueue::render(const char *tmpl, const notify_record_t &record,
+                           const notify_context_t &context, char *out, size_t capacity)
+{
+    if (out == nullptr || capacity == 0)
+    {
+        return 0;
+    }
+    if (tmpl == nullptr || tmpl[0] == '\0')
+    {
+        tmpl = DEFAULT_TEMPLATE;
+    }
+
+    BodyWriter    w    = {out, capacity, 0, false};
+    notify_kind_t kind = (notify_kind_t) record.kind;
+    const char   *p    = tmpl;
+    while (*p != '\0' && !w.overflow)
+    {
+        const char *open  = strstr(p, "{{");
+        const char *close = open != nullptr ? strstr(open + 2, "}}") : nullptr;
+        if (close == nullptr)
+        {
+            w.put(p, strlen(p));
+            break;
+        }
+        w.put(p, (size_t) (open - p));
+
+        const char *name   = open + 2;
+        size_t      length = (size_t) (close - name);
+        char        number[24];
+        if (length == 5 && strncmp(name, "event", 5) == 0)
+        {
+            w.putEscaped(kindName(kind));
+        }
+        else if (length == 7 && strncmp(name, "message", 7) == 0)
+        {
+            w.putEscaped(kindMessage(kind));
+        }
+        else if (length == 6 && strncmp(name, "device", 6) == 0)
+        {
+            w.putEscaped(context.device != nullptr ? context.device : "");
+        }
+        else if (length == 4 && strncmp(name, "time", 4) == 0)
+        {
+            if (context.epochSeconds == 0)
+            {
+                w.put("null", 4);
+            }
+            else
+            {
+                w.put(number, (size_t) snprintf(number, sizeof(number), "%lu",
+                                                (unsigned long) context.epochSeconds));
+            }
+        }
+        else if (length == 7 && strncmp(name, "deficit", 7) == 0)
+        {
+            w.put(number, (size_t) snprintf(number, sizeof(number), "%.2f",
+                                            (double) record.deficitMm));
+        }
+        else if (length == 5 && strncmp(name, "layer", 5) == 0)
+        {
+            w.put(number, (size_t) snprintf(number, sizeof(number), "%ld", (long) record.layer));
+        }
+        else if (length == 2 && strncmp(name, "id", 2) == 0)
+        {
+            w.put(number, (size_t) snprintf(number, sizeof(number), "%lu",
+                                            (unsigned long) record.id));
+        }
+        else
+        {
+            w.put(open, (size_t) (close + 2 - open));
+        }
+        p = close + 2;
+    }
+
+    if (w.overflow)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    out[w.used] = '\0';
+    return w.used;
+}
@@ -0,0 +1,134 @@
+#ifndef NOTIFY_QUEUE_H
+#define NOTIFY_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+    NOTIFY_JAM            = 0,  // deficit/stall detected
+    NOTIFY_RUNOUT         = 1,  // runout switch opened
+    NOTIFY_LINK_LOST      = 2,  // printer connection lost; detection is blind
+    NOTIFY_PRINT_COMPLETE = 3,
+    NOTIFY_TEST           = 4,  // requested from the settings page
+    NOTIFY_KIND_COUNT
+} notify_kind_t;
+
+#define NOTIFY_BIT(kind) (1UL << (kind))
+#define NOTIFY_DEFAULT_EVENTS                                                      \
+    (NOTIFY_BIT(NOTIFY_JAM) | NOTIFY_BIT(NOTIFY_RUNOUT) | NOTIFY_BIT(NOTIFY_LINK_LOST) | \
+     NOTIFY_BIT(NOTIFY_PRINT_COMPLETE))
+
+// One pending notification; copied into and out of the queue by value.
+typedef struct
+{
+    uint32_t id;             // increasing per device, sent for receiver-side dedupe
+    uint8_t  kind;           // notify_kind_t
+    uint8_t  attempts;       // failed deliveries so far
+    uint16_t reserved;
+    uint32_t nextAttemptMs;  // caller's clock; not meaningful across reboots
+    uint32_t epochSeconds;   // event time if known when queued, else 0
+    uint64_t timestampUs;    // TimeService monotonic time of the event; 0 once restored
+    float    deficitMm;
+    int32_t  layer;
+} notify_record_t;
+
+typedef struct
+{
+    uint32_t queued;      // waiting now
+    uint32_t accepted;
+    uint32_t sent;
+    uint32_t retries;     // failed attempts that will be retried
+    uint32_t failed;      // given up after MAX_ATTEMPTS
+    uint32_t dropped;     // oldest evicted because the queue was full
+    uint32_t suppressed;  // same kind as one accepted within DEDUPE_MS
+} notify_stats_t;
+
+// Values substituted into a body template besides the record's own
+typedef struct
+{
+    const char *device;        // hostname
+    uint32_t    epochSeconds;  // event time, 0 if unknown
+} notify_context_t;
+
+// Bounded FIFO of outgoing notifications with retry backoff and dedupe.
+//
+// Delivery is strictly in order: the oldest notification is retried with
+// exponential backoff (RETRY_BASE_MS doubling up to RETRY_MAX_MS) until it
+// is sent or has failed MAX_ATTEMPTS times, and only then does the next one
+// go out. A notification of a kind accepted less than DEDUPE_MS ago is
+// suppressed. When the queue is full the oldest entry is dropped so the
+// newest events are the ones delivered.
+//
+// Not synchronized; the owner guards it. saveState()/loadState() let the
+// owner keep the queue across reboots; takeDirty() says when to save.
+class NotifyQueue
+{
+   public:
+    static const size_t   CAPACITY      = 16;
+    static const uint8_t  MAX_ATTEMPTS  = 10;
+    static const uint32_t RETRY_BASE_MS = 5000;
+    static const uint32_t RETRY_MAX_MS  = 300000;
+    static const uint32_t DEDUPE_MS     = 60000;
+
+    static const uint32_t STATE_MAGIC     = 0x3151464E;  // "NFQ1"
+    static const size_t   STATE_HEADER    = 12;          // magic, next id, count
+    static const size_t   MAX_STATE_SIZE  = STATE_HEADER + CAPACITY * sizeof(notify_record_t);
+    static const size_t   MAX_BODY_LENGTH = 1024;
+
+    NotifyQueue();
+
+    // Returns false if suppressed as a duplicate. `epochSeconds` is 0 when
+    // wall-clock time is not known yet; the caller can still convert
+    // `timestampUs` later in the same boot.
+    bool push(notify_kind_t kind, uint64_t timestampUs, uint32_t epochSeconds, float deficitMm,
+              int32_t layer, uint32_t nowMs);
+
+    // The oldest notification, if its next attempt is due
+    bool due(uint32_t nowMs, notify_record_t &record) const;
+    void markSent();
+    void markFailed(uint32_t nowMs);
+    void clear();
+
+    size_t         count() const { return entries; }
+    notify_stats_t getStats() const;
+
+    // True once after any change to the queued records
+    bool takeDirty();
+
+    // Queued records, oldest first, in host byte order. Returns 0 if
+    // `capacity` is too small. Loaded records are due immediately, and their
+    // timestampUs is cleared since it counted from the previous boot.
+    size_t saveState(uint8_t *out, size_t capacity) const;
+    bool   loadState(const uint8_t *data, size_t length);
+
+    static uint32_t    backoffMs(uint8_t attempts);
+    static const char *kindName(notify_kind_t kind);
+    static const char *kindMessage(notify_kind_t kind);
+
+    // Expands {{event}}, {{message}}, {{device}}, {{time}}, {{deficit}},
+    // {{layer}} and {{id}} in `tmpl`. Strings are JSON-escaped so the
+    // template can place them inside quotes; unknown placeholders are kept.
+    // {{time}} is null when the context has no time.
+    // Returns the length written (NUL-terminated), 0 if it did not fit.
+    static size_t render(const char *tmpl, const notify_record_t &record,
+                         const notify_context_t &context, char *out, size_t capacity);
+
+    static const char *DEFAULT_TEMPLATE;
+
+   private:
+    notify_record_t records[CAPACITY];
+    size_t          head;
+    size_t          entries;
+    uint32_t        nextId;
+    bool            dirty;
+    notify_stats_t  stats;
+    uint32_t        lastAcceptedMs[NOTIFY_KIND_COUNT];
+    bool            hasAccepted[NOTIFY_KIND_COUNT];
+
+    notify_record_t &at(size_t index) { return records[(head + index) % CAPACITY]; }
+    const notify_record_t &at(size_t index) const { return records[(head + index) % CAPACITY]; }
+    void             popHead();
+};
+
+#endif  // NOTIFY_QUEUE_H
@@ -0,0 +1,236 @@
+#include "PauseTrace.h"
+
+#include <string.h>
+
+namespace
+{
+template <typename T>
+void sortAscending(T *values, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        T      value = values[i];
+        size_t j     = i;
+        while (j > 0 && values[j - 1] > value)
+        {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+}
+
+// Nearest-rank percentile of a sorted, non-empty array.
+template <typename T>
+T percentile(const T *sorted, size_t n, unsigned pct)
+{
+    size_t rank = (pct * n + 99) / 100;
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+}  // namespace
+
+bool PauseTrace::hasStage(pause_stage_t stage) const
+{
+    return stage >= 0 && stage < PAUSE_STAGE_COUNT && (seenMask & (1u << stage)) != 0;
+}
+
+uint32_t PauseTrace::offsetUs(pause_stage_t stage) const
+{
+    if (!hasStage(stage))
+    {
+        return 0;
+    }
+    uint32_t origin = stageUs[stage];
+    for (int i = 0; i < PAUSE_STAGE_COUNT; i++)
+    {
+        pause_stage_t other = static_cast<pause_stage_t>(i);
+        if (hasStage(other) && (int32_t) (stageUs[i] - origin) < 0)
+        {
+            origin = stageUs[i];
+        }
+    }
+    return stageUs[stage] - origin;
+}
+
+float PauseTrace::overrunMm() const
+{
+    if (!hasStage(PAUSE_STAGE_JAM_ONSET) ||
+        !(hasStage(PAUSE_STAGE_PAUSING) || hasStage(PAUSE_STAGE_PAUSED)))
+    {
+        return 0.0f;
+    }
+    float overrun = expectedAtStopMm - expectedAtOnsetMm;
+    return overrun > 0.0f ? overrun : 0.0f;
+}
+
+PauseTracer::PauseTracer()
+{
+    nextId = 1;
+    reset();
+}
+
+void PauseTracer::reset()
+{
+    memset(traces, 0, sizeof(traces));
+    memset(&activeTrace, 0, sizeof(activeTrace));
+    head    = 0;
+    count   = 0;
+    active  = false;
+    beganUs = 0;
+}
+
+uint32_t PauseTracer::begin(bool runout, uint32_t nowUs)
+{
+    if (active)
+    {
+        retire(false);
+    }
+    memset(&activeTrace, 0, sizeof(activeTrace));
+    activeTrace.id     = nextId++;
+    activeTrace.runout = runout;
+    active             = true;
+    beganUs            = nowUs;
+    return activeTrace.id;
+}
+
+void PauseTracer::mark(pause_stage_t stage, uint32_t atUs)
+{
+    if (!active || stage < 0 || stage >= PAUSE_STAGE_COUNT || activeTrace.hasStage(stage))
+    {
+        return;
+    }
+    activeTrace.stageUs[stage] = atUs;
+    activeTrace.seenMask |= (uint16_t) (1u << stage);
+}
+
+void PauseTracer::setExpectedAtOnset(float expectedMm)
+{
+    if (active)
+    {
+        activeTrace.expectedAtOnsetMm = expectedMm;
+    }
+}
+
+void PauseTracer::markStopped(pause_stage_t stage, uint32_t atUs, float expectedMm)
+{
+    if (!active || activeTrace.hasStage(stage))
+    {
+        return;
+    }
+    // The printer stops feeding once it starts pausing; keep the first value.
+    if (!activeTrace.hasStage(PAUSE_STAGE_PAUSING) && !activeTrace.hasStage(PAUSE_STAGE_PAUSED))
+    {
+        activeTrace.expectedAtStopMm = expectedMm;
+    }
+    mark(stage, atUs);
+    if (stage == PAUSE_STAGE_PAUSED)
+    {
+        retire(true);
+    }
+}
+
+void PauseTracer::expire(uint32_t nowUs)
+{
+    if (active && nowUs - beganUs > TIMEOUT_US)
+    {
+        retire(false);
+    }
+}
+
+void PauseTracer::retire(bool complete)
+{
+    activeTrace.complete = complete;
+    traces[head]         = activeTrace;
+    head                 = (head + 1) % HISTORY_SIZE;
+    if (count < HISTORY_SIZE)
+    {
+        count++;
+    }
+    active = false;
+}
+
+const PauseTrace &PauseTracer::history(size_t index) const
+{
+    if (index >= count)
+    {
+        index = 0;
+    }
+    return traces[(head + HISTORY_SIZE - 1 - index) % HISTORY_SIZE];
+}
+
+PauseLatencySummary PauseTracer::stageSummary(pause_stage_t stage) const
+{
+    uint32_t values[HISTORY_SIZE];
+    size_t   n = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const PauseTrace &trace = history(i);
+        if (trace.complete && trace.hasStage(stage))
+        {
+            values[n++] = trace.offsetUs(stage);
+        }
+    }
+
+    PauseLatencySummary summary = {0, 0, 0, 0};
+    if (n == 0)
+    {
+        return summary;
+    }
+    sortAscending(values, n);
+    summary.samples = n;
+    summary.p50Us   = percentile(values, n, 50);
+    summary.p90Us   = percentile(values, n, 90);
+    summary.maxUs   = values[n - 1];
+    return summary;
+}
+
+PauseOverrunSummary PauseTracer::overrunSummary() const
+{
+    float  values[HISTORY_SIZE];
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const PauseTrace &trace = history(i);
+        if (trace.complete && trace.hasStage(PAUSE_STAGE_JAM_ONSET))
+        {
+            values[n++] = trace.overrunMm();
+        }
+    }
+
+    PauseOverrunSummary summary = {0, 0.0f, 0.0f, 0.0f};
+    if (n == 0)
+    {
+        return summary;
+    }
+    sortAscending(values, n);
+    summary.samples = n;
+    summary.p50Mm   = percentile(values, n, 50);
+    summary.p90Mm   = percentile(values, n, 90);
+    summary.maxMm   = values[n - 1];
+    return summary;
+}
+
+const char *PauseTracer::stageName(pause_stage_t stage)
+{
+    switch (stage)
+    {
+        case PAUSE_STAGE_JAM_ONSET:
+            return "jam_onset";
+        case PAUSE_STAGE_THRESHOLD_CROSSED:
+            return "threshold_crossed";
+        case PAUSE_STAGE_HOLD_SATISFIED:
+            return "hold_satisfied";
+        case PAUSE_STAGE_COMMAND_BUILT:
+            return "command_built";
+        case PAUSE_STAGE_SOCKET_WRITTEN:
+            return "socket_written";
+        case PAUSE_STAGE_ACK_RECEIVED:
+            return "ack_received";
+        case PAUSE_STAGE_PAUSING:
+            return "pausing";
+        case PAUSE_STAGE_PAUSED:
+            return "paused";
+        default:
+            return "unknown";
+    }
+}
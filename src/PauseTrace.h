@@ -0,0 +1,107 @@
+#ifndef PAUSE_TRACE_H
+#define PAUSE_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Points on the way from a jam to a stopped printer, in the order they
+// normally happen. Not every pause passes through every stage: a runout pause
+// has no deficit threshold, and a printer may go straight to PAUSED.
+typedef enum
+{
+    PAUSE_STAGE_JAM_ONSET         = 0,  // last movement pulse before the jam
+    PAUSE_STAGE_THRESHOLD_CROSSED = 1,  // deficit first reached the threshold
+    PAUSE_STAGE_HOLD_SATISFIED    = 2,  // deficit held for the flow window
+    PAUSE_STAGE_COMMAND_BUILT     = 3,  // pause command serialized
+    PAUSE_STAGE_SOCKET_WRITTEN    = 4,  // handed to the websocket
+    PAUSE_STAGE_ACK_RECEIVED      = 5,  // printer acknowledged the command
+    PAUSE_STAGE_PAUSING           = 6,  // first PAUSING status frame
+    PAUSE_STAGE_PAUSED            = 7,  // first PAUSED status frame
+    PAUSE_STAGE_COUNT
+} pause_stage_t;
+
+struct PauseTrace
+{
+    uint32_t id;
+    uint32_t stageUs[PAUSE_STAGE_COUNT];  // micros() when each stage was reached
+    uint16_t seenMask;
+    bool     runout;    // triggered by the runout switch rather than a deficit
+    bool     complete;  // reached PAUSED; false if the trace timed out
+    float    expectedAtOnsetMm;
+    float    expectedAtStopMm;
+
+    bool hasStage(pause_stage_t stage) const;
+    // Time from the earliest recorded stage (normally the jam onset).
+    uint32_t offsetUs(pause_stage_t stage) const;
+    // Filament the printer was asked to extrude between the jam onset and
+    // the printer stopping, i.e. what was printed into air. 0 if unknown.
+    float overrunMm() const;
+};
+
+struct PauseLatencySummary
+{
+    uint32_t samples;
+    uint32_t p50Us;
+    uint32_t p90Us;
+    uint32_t maxUs;
+};
+
+struct PauseOverrunSummary
+{
+    uint32_t samples;
+    float    p50Mm;
+    float    p90Mm;
+    float    maxMm;
+};
+
+// Records one trace per pause decision and keeps the most recent ones.
+//
+// The detection loop calls begin() when it decides to pause, then mark() as
+// each later stage happens. Stages that precede the decision (onset,
+// threshold, hold) are marked right after begin() with their original
+// timestamps. A trace is retired into the history when PAUSED is seen, or as
+// incomplete when it expires or a new pause begins.
+class PauseTracer
+{
+   public:
+    static const size_t   HISTORY_SIZE = 16;
+    static const uint32_t TIMEOUT_US   = 60UL * 1000 * 1000;
+
+    PauseTracer();
+
+    void     reset();
+    uint32_t begin(bool runout, uint32_t nowUs);
+    // Records the first time a stage is reached; later calls are ignored.
+    void mark(pause_stage_t stage, uint32_t atUs);
+    void setExpectedAtOnset(float expectedMm);
+    // PAUSING/PAUSED frame. PAUSED completes the trace.
+    void markStopped(pause_stage_t stage, uint32_t atUs, float expectedMm);
+    // Retires the active trace as incomplete once it is older than TIMEOUT_US.
+    void expire(uint32_t nowUs);
+
+    bool              isActive() const { return active; }
+    const PauseTrace &current() const { return activeTrace; }
+
+    size_t historyCount() const { return count; }
+    // 0 is the most recent.
+    const PauseTrace &history(size_t index) const;
+
+    // Offsets of a stage from the onset, over completed traces that have it.
+    PauseLatencySummary stageSummary(pause_stage_t stage) const;
+    PauseOverrunSummary overrunSummary() const;
+
+    static const char *stageName(pause_stage_t stage);
+
+   private:
+    PauseTrace traces[HISTORY_SIZE];
+    size_t     head;  // next slot to write
+    size_t     count;
+    PauseTrace activeTrace;
+    bool       active;
+    uint32_t   nextId;
+    uint32_t   beganUs;
+
+    void retire(bool complete);
+};
+
+#endif  // PAUSE_TRACE_H
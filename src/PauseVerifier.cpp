@@ -0,0 +1,298 @@
+#include "PauseVerifier.h"
+
+#include <string.h>
+
+namespace
+{
+void sortAscending(float *values, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        float  value = values[i];
+        size_t j     = i;
+        while (j > 0 && values[j - 1] > value)
+        {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+}
+
+// Nearest-rank percentile of a sorted, non-empty array.
+float percentile(const float *sorted, size_t n, unsigned pct)
+{
+    size_t rank = (pct * n + 99) / 100;
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+float larger(float a, float b)
+{
+    return a > b ? a : b;
+}
+}  // namespace
+
+float PauseVerification::totalMm() const
+{
+    float total = 0.0f;
+    for (uint8_t i = 0; i < steps && i < PAUSE_STEP_COUNT; i++)
+    {
+        total += stepMm[i];
+    }
+    return total;
+}
+
+PauseVerifier::PauseVerifier()
+{
+    maxStep      = PAUSE_STEP_REPAUSE;
+    hasLastTotal = false;
+    lastTotalMm  = 0.0f;
+    extruding    = false;
+    reset();
+}
+
+void PauseVerifier::reset()
+{
+    memset(records, 0, sizeof(records));
+    memset(&activeRecord, 0, sizeof(activeRecord));
+    memset(&stats, 0, sizeof(stats));
+    head             = 0;
+    count            = 0;
+    active           = false;
+    beganMs          = 0;
+    stepMs           = 0;
+    reportedMm       = 0.0f;
+    sensedMm         = 0.0f;
+    windowReportedMm = 0.0f;
+    windowSensedMm   = 0.0f;
+    windowFrames     = 0;
+}
+
+const char *PauseVerifier::stepName(pause_step_t step)
+{
+    switch (step)
+    {
+        case PAUSE_STEP_PAUSE:
+            return "pause";
+        case PAUSE_STEP_REPAUSE:
+            return "repause";
+        case PAUSE_STEP_STOP_FEEDING:
+            return "stop_feeding";
+        case PAUSE_STEP_STOP:
+            return "stop";
+        default:
+            return "unknown";
+    }
+}
+
+const char *PauseVerifier::outcomeName(pause_outcome_t outcome)
+{
+    switch (outcome)
+    {
+        case PAUSE_OUTCOME_STOPPED:
+            return "stopped";
+        case PAUSE_OUTCOME_STILL_EXTRUDING:
+            return "still_extruding";
+        case PAUSE_OUTCOME_NO_TELEMETRY:
+            return "no_telemetry";
+        case PAUSE_OUTCOME_CANCELLED:
+            return "cancelled";
+    }
+    return "unknown";
+}
+
+void PauseVerifier::begin(uint32_t id, uint32_t nowMs)
+{
+    if (active)
+    {
+        retire(PAUSE_OUTCOME_CANCELLED, nowMs);
+    }
+    memset(&activeRecord, 0, sizeof(activeRecord));
+    activeRecord.id = id;
+    active          = true;
+    beganMs         = nowMs;
+    stats.verifications++;
+    startStep(PAUSE_STEP_PAUSE, nowMs);
+}
+
+void PauseVerifier::cancel(uint32_t nowMs)
+{
+    if (active)
+    {
+        retire(PAUSE_OUTCOME_CANCELLED, nowMs);
+    }
+}
+
+void PauseVerifier::startStep(pause_step_t step, uint32_t nowMs)
+{
+    activeRecord.stepOffsetMs[step] = nowMs - beganMs;
+    activeRecord.steps              = (uint8_t) (step + 1);
+    stepMs                          = nowMs;
+    reportedMm                      = 0.0f;
+    sensedMm                        = 0.0f;
+    windowReportedMm                = 0.0f;
+    windowSensedMm                  = 0.0f;
+    windowFrames                    = 0;
+}
+
+void PauseVerifier::closeStep()
+{
+    activeRecord.stepMm[activeRecord.steps - 1] = larger(reportedMm, sensedMm);
+}
+
+void PauseVerifier::onTelemetry(uint32_t nowMs, bool printing, bool hasTotal, float totalMm,
+                                bool hasDelta, float deltaMm)
+{
+    // A falling total is a retraction or a new print; neither is feed.
+    float advance = 0.0f;
+    if (hasTotal)
+    {
+        if (hasLastTotal && totalMm > lastTotalMm)
+        {
+            advance = totalMm - lastTotalMm;
+        }
+        lastTotalMm  = totalMm;
+        hasLastTotal = true;
+    }
+    else if (hasDelta && deltaMm > 0.0f)
+    {
+        advance = deltaMm;
+    }
+    extruding = printing || advance > 0.0f;
+
+    if (!active || !(hasTotal || hasDelta))
+    {
+        return;
+    }
+    reportedMm += advance;
+    if (nowMs - stepMs >= SETTLE_MS)
+    {
+        windowReportedMm += advance;
+        windowFrames++;
+    }
+}
+
+void PauseVerifier::onMovement(uint32_t nowMs, float mm)
+{
+    if (!active || !extruding)
+    {
+        return;
+    }
+    sensedMm += mm;
+    if (nowMs - stepMs >= SETTLE_MS)
+    {
+        windowSensedMm += mm;
+    }
+}
+
+pause_action_t PauseVerifier::update(uint32_t nowMs)
+{
+    if (!active)
+    {
+        return PAUSE_ACTION_NONE;
+    }
+    uint32_t sinceStep = nowMs - stepMs;
+    if (sinceStep < SETTLE_MS)
+    {
+        return PAUSE_ACTION_NONE;
+    }
+
+    if (larger(windowReportedMm, windowSensedMm) > TOLERANCE_MM)
+    {
+        closeStep();
+        pause_step_t next = (pause_step_t) activeRecord.steps;
+        if (next > maxStep || next >= PAUSE_STEP_COUNT)
+        {
+            retire(PAUSE_OUTCOME_STILL_EXTRUDING, nowMs);
+            return PAUSE_ACTION_FINISHED;
+        }
+        stats.escalations[next]++;
+        startStep(next, nowMs);
+        switch (next)
+        {
+            case PAUSE_STEP_REPAUSE:
+                return PAUSE_ACTION_REPAUSE;
+            case PAUSE_STEP_STOP_FEEDING:
+                return PAUSE_ACTION_STOP_FEEDING;
+            default:
+                return PAUSE_ACTION_STOP;
+        }
+    }
+
+    if (sinceStep - SETTLE_MS >= WINDOW_MS && windowFrames > 0)
+    {
+        retire(PAUSE_OUTCOME_STOPPED, nowMs);
+        return PAUSE_ACTION_FINISHED;
+    }
+    if (sinceStep - SETTLE_MS >= NO_TELEMETRY_MS)
+    {
+        retire(PAUSE_OUTCOME_NO_TELEMETRY, nowMs);
+        return PAUSE_ACTION_FINISHED;
+    }
+    return PAUSE_ACTION_NONE;
+}
+
+void PauseVerifier::retire(pause_outcome_t outcome, uint32_t nowMs)
+{
+    closeStep();
+    activeRecord.outcome    = (uint8_t) outcome;
+    activeRecord.durationMs = nowMs - beganMs;
+    records[head]           = activeRecord;
+    head                    = (head + 1) % HISTORY_SIZE;
+    if (count < HISTORY_SIZE)
+    {
+        count++;
+    }
+    active = false;
+
+    switch (outcome)
+    {
+        case PAUSE_OUTCOME_STOPPED:
+            stats.stopped++;
+            break;
+        case PAUSE_OUTCOME_STILL_EXTRUDING:
+            stats.stillExtruding++;
+            break;
+        case PAUSE_OUTCOME_NO_TELEMETRY:
+            stats.noTelemetry++;
+            break;
+        case PAUSE_OUTCOME_CANCELLED:
+            stats.cancelled++;
+            break;
+    }
+}
+
+const PauseVerification &PauseVerifier::history(size_t index) const
+{
+    if (index >= count)
+    {
+        index = 0;
+    }
+    return records[(head + HISTORY_SIZE - 1 - index) % HISTORY_SIZE];
+}
+
+PauseEffectSummary PauseVerifier::summary() const
+{
+    float  values[HISTORY_SIZE];
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const PauseVerification &record = history(i);
+        if (record.outcome == PAUSE_OUTCOME_STOPPED)
+        {
+            values[n++] = record.totalMm();
+        }
+    }
+
+    PauseEffectSummary result = {0, 0.0f, 0.0f, 0.0f};
+    if (n == 0)
+    {
+        return result;
+    }
+    sortAscending(values, n);
+    result.samples = n;
+    result.p50Mm   = percentile(values, n, 50);
+    result.p90Mm   = percentile(values, n, 90);
+    result.maxMm   = values[n - 1];
+    return result;
+}
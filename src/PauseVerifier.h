@@ -0,0 +1,153 @@
+#ifndef PAUSE_VERIFIER_H
+#define PAUSE_VERIFIER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Decisions taken for one pause, in escalation order
+typedef enum
+{
+    PAUSE_STEP_PAUSE        = 0,  // the pause command that started verification
+    PAUSE_STEP_REPAUSE      = 1,  // pause sent again
+    PAUSE_STEP_STOP_FEEDING = 2,  // SDCP stop feeding material
+    PAUSE_STEP_STOP         = 3,  // print stopped
+    PAUSE_STEP_COUNT
+} pause_step_t;
+
+typedef enum
+{
+    PAUSE_ACTION_NONE         = 0,
+    PAUSE_ACTION_REPAUSE      = 1,  // caller should send the pause command again
+    PAUSE_ACTION_STOP_FEEDING = 2,  // caller should send stop feeding material
+    PAUSE_ACTION_STOP         = 3,  // caller should stop the print
+    PAUSE_ACTION_FINISHED     = 4,  // verification retired; see history(0)
+} pause_action_t;
+
+typedef enum
+{
+    PAUSE_OUTCOME_STOPPED         = 0,  // extrusion stayed within tolerance
+    PAUSE_OUTCOME_STILL_EXTRUDING = 1,  // out of steps (escalation limit reached)
+    PAUSE_OUTCOME_NO_TELEMETRY    = 2,  // no frame arrived to confirm either way
+    PAUSE_OUTCOME_CANCELLED       = 3,  // print resumed or restarted meanwhile
+} pause_outcome_t;
+
+struct PauseVerification
+{
+    uint32_t id;     // the pause trace this verification belongs to
+    uint8_t  steps;  // decisions taken, 1..PAUSE_STEP_COUNT
+    uint8_t  outcome;
+    uint32_t durationMs;
+    uint32_t stepOffsetMs[PAUSE_STEP_COUNT];  // from the first decision
+    // Filament extruded after each decision, until the next one or the end
+    // of verification: the larger of what the printer reported extruding
+    // and what the movement sensor saw.
+    float stepMm[PAUSE_STEP_COUNT];
+
+    float totalMm() const;
+};
+
+struct PauseEffectSummary
+{
+    uint32_t samples;  // verifications that ended in PAUSE_OUTCOME_STOPPED
+    float    p50Mm;    // of totalMm()
+    float    p90Mm;
+    float    maxMm;
+};
+
+// Confirms that a pause actually stopped extrusion, and escalates when it
+// did not.
+//
+// After each decision the printer gets SETTLE_MS to finish its move and act
+// on the command; SDCP status is allowed to lag that long. Extrusion is then
+// watched: more than TOLERANCE_MM reported by TotalExtrusion (or
+// CurrentExtrusion when there is no total) or seen by the movement sensor
+// escalates right away, to re-pause, then stop feeding, then stop, as far
+// as setEscalation() allows. A quiet WINDOW_MS with at least one telemetry
+// frame in it confirms the pause. The filament extruded after each decision
+// is kept per verification.
+//
+// The sensor counts edges in either direction, so pulling filament by hand
+// or an unload would look like extrusion. Sensor movement only counts while
+// the latest frame shows the printer extruding: TotalExtrusion (or
+// CurrentExtrusion) going up, or the print status back at PRINTING.
+class PauseVerifier
+{
+   public:
+    static const size_t   HISTORY_SIZE    = 16;
+    static const uint32_t SETTLE_MS       = 4000;
+    static const uint32_t WINDOW_MS       = 3000;
+    static const uint32_t NO_TELEMETRY_MS = 30000;  // after SETTLE_MS
+    static constexpr float TOLERANCE_MM   = 2.0f;
+
+    struct Stats
+    {
+        uint32_t verifications;
+        uint32_t stopped;
+        uint32_t escalations[PAUSE_STEP_COUNT];  // index 0 unused
+        uint32_t stillExtruding;
+        uint32_t noTelemetry;
+        uint32_t cancelled;
+    };
+
+    PauseVerifier();
+
+    void reset();
+    // The furthest step escalation may take; PAUSE_STEP_PAUSE turns it off
+    // and a pause that does not take is only recorded.
+    void setEscalation(pause_step_t lastStep) { maxStep = lastStep; }
+
+    // The pause command for trace `id` went out at `nowMs`. A verification
+    // still running is retired as cancelled.
+    void begin(uint32_t id, uint32_t nowMs);
+    // Ends the running verification without a verdict (resume, new print).
+    void cancel(uint32_t nowMs);
+
+    // Every PrintInfo frame, also while idle, so the TotalExtrusion baseline
+    // is known when a pause begins. `printing` is the frame's status being
+    // PRINTING.
+    void onTelemetry(uint32_t nowMs, bool printing, bool hasTotal, float totalMm, bool hasDelta,
+                     float deltaMm);
+    // Filament the movement sensor saw pass, in mm. Ignored unless the latest
+    // frame shows the printer extruding.
+    void onMovement(uint32_t nowMs, float mm);
+    // Call every loop pass
+    pause_action_t update(uint32_t nowMs);
+
+    bool                     isActive() const { return active; }
+    const PauseVerification &current() const { return activeRecord; }
+    Stats                    getStats() const { return stats; }
+
+    size_t historyCount() const { return count; }
+    // 0 is the most recent.
+    const PauseVerification &history(size_t index) const;
+    PauseEffectSummary       summary() const;
+
+    static const char *stepName(pause_step_t step);
+    static const char *outcomeName(pause_outcome_t outcome);
+
+   private:
+    PauseVerification records[HISTORY_SIZE];
+    size_t            head;  // next slot to write
+    size_t            count;
+    PauseVerification activeRecord;
+    bool              active;
+    pause_step_t      maxStep;
+    Stats             stats;
+
+    bool     hasLastTotal;
+    float    lastTotalMm;
+    bool     extruding;  // per the latest frame
+    uint32_t beganMs;      // first decision
+    uint32_t stepMs;       // current decision
+    float    reportedMm;   // since the current decision, from telemetry
+    float    sensedMm;     // since the current decision, from the sensor
+    float    windowReportedMm;  // the same, after SETTLE_MS
+    float    windowSensedMm;
+    uint32_t windowFrames;
+
+    void startStep(pause_step_t step, uint32_t nowMs);
+    void closeStep();
+    void retire(pause_outcome_t outcome, uint32_t nowMs);
+};
+
+#endif  // PAUSE_VERIFIER_H
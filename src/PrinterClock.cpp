@@ -0,0 +1,210 @@
+#include "PrinterClock.h"
+
+#include <string.h>
+
+PrinterClock::PrinterClock()
+{
+    memset(&stats, 0, sizeof(stats));
+    reset();
+}
+
+void PrinterClock::reset()
+{
+    bucketCount       = 0;
+    newest            = 0;
+    stepSamples       = 0;
+    stats.samples     = 0;
+    stats.lastAgeMs   = 0;
+    stats.meanAgeMs   = 0;
+    stats.maxAgeMs    = 0;
+    stats.skewPpm     = 0;
+    stats.locked      = false;
+}
+
+int64_t PrinterClock::timestampToMs(uint64_t raw, uint16_t &quantumMs)
+{
+    // 1e11 s is year 5138; 1e11 ms is 1973
+    if (raw >= 100000000000ULL)
+    {
+        quantumMs = 1;
+        return (int64_t) raw;
+    }
+    quantumMs = 1000;
+    return (int64_t) raw * 1000;
+}
+
+void PrinterClock::startBucket(int64_t localMs, int64_t offsetMs)
+{
+    if (bucketCount > 0)
+    {
+        newest = (newest + 1) % BUCKET_COUNT;
+    }
+    if (bucketCount < BUCKET_COUNT)
+    {
+        bucketCount++;
+    }
+    buckets[newest].startMs     = localMs;
+    buckets[newest].minOffsetMs = offsetMs;
+    buckets[newest].minAtMs     = localMs;
+}
+
+// Least-squares slope through the minima of the completed buckets; the one
+// still filling may so far hold only a queued frame. Runs once per bucket
+// over at most BUCKET_COUNT points, relative to the newest so doubles keep
+// their precision.
+void PrinterClock::updateSkew()
+{
+    size_t completed = bucketCount - 1;
+    if (bucketCount == 0 || completed < 3)
+    {
+        stats.skewPpm = 0;
+        return;
+    }
+
+    size_t        first = (newest + BUCKET_COUNT - completed) % BUCKET_COUNT;
+    const Bucket &ref   = buckets[(newest + BUCKET_COUNT - 1) % BUCKET_COUNT];
+    double        sumX = 0, sumY = 0;
+    for (size_t n = 0; n < completed; n++)
+    {
+        const Bucket &b = buckets[(first + n) % BUCKET_COUNT];
+        sumX += (double) (b.minAtMs - ref.minAtMs);
+        sumY += (double) (b.minOffsetMs - ref.minOffsetMs);
+    }
+    double meanX = sumX / completed;
+    double meanY = sumY / completed;
+    double sxx = 0, sxy = 0;
+    for (size_t n = 0; n < completed; n++)
+    {
+        const Bucket &b  = buckets[(first + n) % BUCKET_COUNT];
+        double        dx = (double) (b.minAtMs - ref.minAtMs) - meanX;
+        double        dy = (double) (b.minOffsetMs - ref.minOffsetMs) - meanY;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+    if (sxx <= 0)
+    {
+        return;
+    }
+
+    // d = local - printer grows when the printer clock runs slow
+    double ppm = -sxy / sxx * 1e6;
+    if (ppm > MAX_SKEW_PPM)
+    {
+        ppm = MAX_SKEW_PPM;
+    }
+    else if (ppm < -MAX_SKEW_PPM)
+    {
+        ppm = -MAX_SKEW_PPM;
+    }
+    stats.skewPpm = (int32_t) ppm;
+}
+
+int64_t PrinterClock::offsetAt(int64_t localMs) const
+{
+    int64_t best = 0;
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        int64_t projected = buckets[i].minOffsetMs -
+                            (localMs - buckets[i].minAtMs) * stats.skewPpm / 1000000;
+        if (i == 0 || projected < best)
+        {
+            best = projected;
+        }
+    }
+    return best;
+}
+
+int64_t PrinterClock::printerTimeAt(int64_t localMs) const
+{
+    return localMs - offsetAt(localMs) + stats.minRttMs / 2;
+}
+
+uint32_t PrinterClock::addSample(int64_t localMs, int64_t printerMs, uint16_t quantumMs)
+{
+    int64_t offset  = localMs - printerMs;
+    stats.quantumMs = quantumMs;
+
+    if (bucketCount == 0 || localMs - buckets[newest].startMs >= (int64_t) BUCKET_MS)
+    {
+        startBucket(localMs, offset);
+        updateSkew();
+    }
+
+    int64_t age = offset - offsetAt(localMs);
+    if (stats.locked &&
+        (age > (int64_t) STEP_THRESHOLD_MS || age < -(int64_t) STEP_THRESHOLD_MS))
+    {
+        // A backwards step looks like frames that are suddenly very old; a
+        // forward step like frames from the future. Either way the history
+        // no longer describes the printer's clock.
+        if (age < 0 || ++stepSamples >= STEP_CONFIRM_SAMPLES)
+        {
+            stats.resets++;
+            reset();
+            startBucket(localMs, offset);
+            age = 0;
+        }
+        else
+        {
+            // Don't let a suspected step into the floor or the averages
+            return 0;
+        }
+    }
+    else
+    {
+        stepSamples = 0;
+    }
+
+    Bucket &bucket = buckets[newest];
+    if (offset < bucket.minOffsetMs)
+    {
+        bucket.minOffsetMs = offset;
+        bucket.minAtMs     = localMs;
+    }
+    if (age < 0)
+    {
+        age = 0;  // this frame is the new floor
+    }
+
+    stats.samples++;
+    if (!stats.locked)
+    {
+        stats.locked = stats.samples >= MIN_SAMPLES;
+        if (!stats.locked)
+        {
+            return 0;
+        }
+    }
+
+    uint32_t ageMs  = (uint32_t) age;
+    stats.lastAgeMs = ageMs;
+    stats.meanAgeMs = stats.meanAgeMs - stats.meanAgeMs / 8 + ageMs / 8;
+    if (ageMs > stats.maxAgeMs)
+    {
+        stats.maxAgeMs = ageMs;
+    }
+    return ageMs;
+}
+
+void PrinterClock::addRoundTrip(uint32_t rttMs)
+{
+    stats.lastRttMs = rttMs;
+    if (stats.minRttMs == 0 || rttMs < stats.minRttMs)
+    {
+        stats.minRttMs = rttMs;
+    }
+}
+
+bool PrinterClock::isLocked() const
+{
+    return stats.locked;
+}
+
+uint32_t PrinterClock::staleAgeMs(uint32_t ageMs) const
+{
+    if (!stats.locked || ageMs <= stats.quantumMs)
+    {
+        return 0;
+    }
+    return ageMs - stats.quantumMs;
+}
@@ -0,0 +1,89 @@
+#ifndef PRINTER_CLOCK_H
+#define PRINTER_CLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Estimates how old an SDCP frame is when it arrives, from the printer's
+// TimeStamp and our local receive time.
+//
+// Every frame gives d = local receive time - printer send time, which is the
+// offset between the two clocks plus that frame's one-way delay. The frames
+// that got through fastest bound the offset, so d is min-filtered: the
+// minimum is kept per 30 s bucket, a line fitted through the minima of the
+// completed buckets gives the relative skew, and the offset at any moment is the lowest bucket
+// minimum projected to that moment. A frame's age is how far its d sits
+// above that floor, i.e. how long it spent queued beyond the fastest path.
+//
+// The printer stamps whole seconds, so individual ages carry up to one
+// quantum of noise; staleAgeMs() returns only the part that is certain.
+// A printer clock step is detected as a run of implausible ages and
+// restarts the estimate.
+class PrinterClock
+{
+   public:
+    static const size_t   BUCKET_COUNT         = 8;
+    static const uint32_t BUCKET_MS            = 30000;
+    static const uint32_t MIN_SAMPLES          = 4;      // before ages are trusted
+    static const uint32_t STEP_THRESHOLD_MS    = 10000;  // age that can't be queueing
+    static const uint32_t STEP_CONFIRM_SAMPLES = 5;
+    static const int32_t  MAX_SKEW_PPM         = 500;
+
+    struct Stats
+    {
+        uint32_t samples;     // since the last reset
+        uint32_t resets;      // printer clock steps detected
+        uint32_t lastAgeMs;
+        uint32_t meanAgeMs;   // EWMA, 1/8 weight
+        uint32_t maxAgeMs;    // since the last reset
+        uint32_t lastRttMs;   // command -> ack round trip
+        uint32_t minRttMs;    // 0 until a round trip is seen
+        int32_t  skewPpm;     // printer clock rate relative to ours
+        uint16_t quantumMs;   // resolution of the printer's timestamps
+        bool     locked;
+    };
+
+    PrinterClock();
+
+    void reset();
+
+    // Records a frame received at `localMs` (monotonic) that the printer
+    // stamped `printerMs`. Returns the frame's estimated age, 0 until locked.
+    uint32_t addSample(int64_t localMs, int64_t printerMs, uint16_t quantumMs);
+    // Round trip of a command and its ack; bounds the one-way delay.
+    void addRoundTrip(uint32_t rttMs);
+
+    bool isLocked() const;
+    // Part of an age that exceeds timestamp quantization; 0 until locked
+    uint32_t staleAgeMs(uint32_t ageMs) const;
+    // Floor of local - printer time at `localMs`, skew applied
+    int64_t offsetAt(int64_t localMs) const;
+    // Printer clock reading at local time `localMs`, assuming the fastest
+    // path takes half the best round trip
+    int64_t printerTimeAt(int64_t localMs) const;
+
+    Stats getStats() const { return stats; }
+
+    // SDCP TimeStamp is epoch seconds on current firmware; values too large
+    // for that are taken as milliseconds.
+    static int64_t timestampToMs(uint64_t raw, uint16_t &quantumMs);
+
+   private:
+    struct Bucket
+    {
+        int64_t startMs;
+        int64_t minOffsetMs;
+        int64_t minAtMs;
+    };
+
+    Bucket   buckets[BUCKET_COUNT];
+    size_t   bucketCount;
+    size_t   newest;
+    uint32_t stepSamples;
+    Stats    stats;
+
+    void startBucket(int64_t localMs, int64_t offsetMs);
+    void updateSkew();
+};
+
+#endif  // PRINTER_CLOCK_H
@@ -0,0 +1,368 @@
+#include "PulseCapture.h"
+
+#include <LittleFS.h>
+#include <driver/gpio.h>
+#include <driver/timer.h>
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+
+#include "ElegooCC.h"
+#include "Logger.h"
+
+#define STRESS_TIMER_GROUP TIMER_GROUP_1
+#define STRESS_TIMER_INDEX TIMER_0
+#define STRESS_FILE_PATH "/capture_stress.bin"
+#define STRESS_CHUNK_BYTES 4096
+#define STRESS_CHUNKS_PER_FILE 4
+#define EDGE_RING_SIZE 128  // must be a power of two
+
+// Everything the interrupt handlers touch is placed in DRAM explicitly so it
+// stays reachable while the flash cache is disabled.
+static DRAM_ATTR portMUX_TYPE captureMux = portMUX_INITIALIZER_UNLOCKED;
+static DRAM_ATTR pulse_edge_t edgeRing[EDGE_RING_SIZE];
+static DRAM_ATTR volatile uint32_t ringHead          = 0;  // next slot to write
+static DRAM_ATTR volatile uint32_t ringTail          = 0;  // next slot to read
+static DRAM_ATTR volatile uint32_t movementEdges     = 0;
+static DRAM_ATTR volatile uint32_t movementOverflows = 0;
+static DRAM_ATTR volatile int64_t  lastMovementUs    = 0;
+static DRAM_ATTR volatile uint8_t  movementLevel     = 0xFF;  // last accepted, 0xFF until one is
+static DRAM_ATTR volatile uint32_t minEdgeUs         = PulseCapture::DEFAULT_MIN_EDGE_US;
+static DRAM_ATTR volatile uint32_t rejectedEdges     = 0;
+static DRAM_ATTR volatile uint32_t runoutEdges       = 0;
+static DRAM_ATTR volatile uint8_t  runoutLevel       = 1;
+
+static DRAM_ATTR volatile bool     stressActive        = false;
+static DRAM_ATTR volatile uint8_t  stressLevel         = 0;
+static DRAM_ATTR volatile uint32_t stressInjected      = 0;
+static DRAM_ATTR volatile uint32_t stressDelivered     = 0;
+static DRAM_ATTR volatile uint32_t stressOverflowed    = 0;
+static DRAM_ATTR volatile uint32_t stressMaxGapUs      = 0;
+static DRAM_ATTR volatile int64_t  stressLastInjectUs  = 0;
+
+static capture_stress_result_t stressResult;
+
+static inline IRAM_ATTR uint8_t readPinLevel(int pin)
+{
+    if (pin < 32)
+    {
+        return (REG_READ(GPIO_IN_REG) >> pin) & 0x1;
+    }
+    return (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 0x1;
+}
+
+PulseCapture &PulseCapture::getInstance()
+{
+    static PulseCapture instance;
+    return instance;
+}
+
+PulseCapture::PulseCapture()
+{
+    memset(&stressResult, 0, sizeof(stressResult));
+}
+
+bool PulseCapture::begin()
+{
+    // Install the shared GPIO ISR dispatcher in IRAM. Arduino's
+    // attachInterrupt() installs it without ESP_INTR_FLAG_IRAM, which masks
+    // our handlers for the whole duration of every flash write.
+    esp_err_t err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE)
+    {
+        logger.logf("Pulse capture: failed to install GPIO ISR service (%d)", err);
+        return false;
+    }
+    if (err == ESP_ERR_INVALID_STATE)
+    {
+        logger.log("Pulse capture: GPIO ISR service already installed, may not be IRAM-safe");
+    }
+
+    runoutLevel   = readPinLevel(FILAMENT_RUNOUT_PIN);
+    movementLevel = readPinLevel(MOVEMENT_SENSOR_PIN);
+
+    gpio_set_intr_type((gpio_num_t) MOVEMENT_SENSOR_PIN, GPIO_INTR_ANYEDGE);
+    gpio_set_intr_type((gpio_num_t) FILAMENT_RUNOUT_PIN, GPIO_INTR_ANYEDGE);
+    if (gpio_isr_handler_add((gpio_num_t) MOVEMENT_SENSOR_PIN, onMovementEdge, nullptr) != ESP_OK ||
+        gpio_isr_handler_add((gpio_num_t) FILAMENT_RUNOUT_PIN, onRunoutEdge, nullptr) != ESP_OK)
+    {
+        logger.log("Pulse capture: failed to attach sensor interrupts");
+        return false;
+    }
+    gpio_intr_enable((gpio_num_t) MOVEMENT_SENSOR_PIN);
+    gpio_intr_enable((gpio_num_t) FILAMENT_RUNOUT_PIN);
+
+    logger.log("Pulse capture: sensor interrupts attached (IRAM)");
+    return true;
+}
+
+void IRAM_ATTR PulseCapture::recordMovementEdge(uint8_t level, bool synthetic)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&captureMux);
+    if (!synthetic)
+    {
+        // Bounce: too soon after the last real edge, or no net level change
+        if (level == movementLevel ||
+            (movementLevel != 0xFF && (uint64_t) (now - lastMovementUs) < minEdgeUs))
+        {
+            rejectedEdges++;
+            portEXIT_CRITICAL_ISR(&captureMux);
+            return;
+        }
+        movementEdges++;
+        lastMovementUs = now;
+        movementLevel  = level;
+    }
+
+    if (ringHead - ringTail < EDGE_RING_SIZE)
+    {
+        pulse_edge_t &slot = edgeRing[ringHead & (EDGE_RING_SIZE - 1)];
+        slot.timestampUs   = now;
+        slot.level         = level;
+        slot.synthetic     = synthetic ? 1 : 0;
+        ringHead++;
+    }
+    else if (synthetic)
+    {
+        stressOverflowed++;
+    }
+    else
+    {
+        movementOverflows++;
+    }
+    portEXIT_CRITICAL_ISR(&captureMux);
+}
+
+void IRAM_ATTR PulseCapture::onMovementEdge(void *arg)
+{
+    (void) arg;
+    recordMovementEdge(readPinLevel(MOVEMENT_SENSOR_PIN), false);
+}
+
+void IRAM_ATTR PulseCapture::onRunoutEdge(void *arg)
+{
+    (void) arg;
+    uint8_t level = readPinLevel(FILAMENT_RUNOUT_PIN);
+    portENTER_CRITICAL_ISR(&captureMux);
+    runoutLevel = level;
+    runoutEdges++;
+    portEXIT_CRITICAL_ISR(&captureMux);
+}
+
+bool IRAM_ATTR PulseCapture::onStressTimer(void *arg)
+{
+    (void) arg;
+    if (!stressActive)
+    {
+        return false;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (stressLastInjectUs != 0)
+    {
+        uint32_t gap = (uint32_t) (now - stressLastInjectUs);
+        if (gap > stressMaxGapUs)
+        {
+            stressMaxGapUs = gap;
+        }
+    }
+    stressLastInjectUs = now;
+
+    stressLevel = stressLevel ? 0 : 1;
+    stressInjected++;
+    recordMovementEdge(stressLevel, true);
+    return false;
+}
+
+bool PulseCapture::popMovementEdge(pulse_edge_t &edge)
+{
+    while (true)
+    {
+        portENTER_CRITICAL(&captureMux);
+        if (ringTail == ringHead)
+        {
+            portEXIT_CRITICAL(&captureMux);
+            return false;
+        }
+        edge = edgeRing[ringTail & (EDGE_RING_SIZE - 1)];
+        ringTail++;
+        if (edge.synthetic)
+        {
+            stressDelivered++;
+        }
+        portEXIT_CRITICAL(&captureMux);
+
+        if (!edge.synthetic)
+        {
+            return true;
+        }
+    }
+}
+
+uint32_t PulseCapture::takeMovementOverflows()
+{
+    portENTER_CRITICAL(&captureMux);
+    uint32_t overflows = movementOverflows;
+    movementOverflows  = 0;
+    portEXIT_CRITICAL(&captureMux);
+    return overflows;
+}
+
+bool PulseCapture::getRunoutLevel() const
+{
+    return runoutLevel != 0;
+}
+
+uint32_t PulseCapture::getMovementEdgeCount() const
+{
+    return movementEdges;
+}
+
+uint32_t PulseCapture::getRunoutEdgeCount() const
+{
+    return runoutEdges;
+}
+
+uint32_t PulseCapture::getRejectedEdgeCount() const
+{
+    return rejectedEdges;
+}
+
+void PulseCapture::setMinEdgeIntervalUs(uint32_t intervalUs)
+{
+    minEdgeUs = intervalUs;
+}
+
+uint32_t PulseCapture::getMinEdgeIntervalUs() const
+{
+    return minEdgeUs;
+}
+
+int64_t PulseCapture::getLastMovementEdgeUs() const
+{
+    portENTER_CRITICAL(&captureMux);
+    int64_t last = lastMovementUs;
+    portEXIT_CRITICAL(&captureMux);
+    return last;
+}
+
+bool PulseCapture::startStressTest(uint32_t durationMs, uint32_t intervalUs)
+{
+    if (stressResult.running)
+    {
+        return false;
+    }
+
+    memset(&stressResult, 0, sizeof(stressResult));
+    stressResult.running    = true;
+    stressResult.durationMs = durationMs;
+    stressResult.intervalUs = intervalUs;
+
+    // Low priority: the point is to contend for flash, not for the CPU.
+    if (xTaskCreate(stressTask, "capture_stress", 4096, this, 1, nullptr) != pdPASS)
+    {
+        stressResult.running = false;
+        logger.log("Pulse capture: failed to start stress task");
+        return false;
+    }
+    return true;
+}
+
+capture_stress_result_t PulseCapture::getStressResult()
+{
+    capture_stress_result_t result = stressResult;
+    if (result.running)
+    {
+        result.injected       = stressInjected;
+        result.delivered      = stressDelivered;
+        result.overflowed     = stressOverflowed;
+        result.maxInjectGapUs = stressMaxGapUs;
+    }
+    return result;
+}
+
+void PulseCapture::stressTask(void *arg)
+{
+    static_cast<PulseCapture *>(arg)->runStress();
+    vTaskDelete(nullptr);
+}
+
+void PulseCapture::runStress()
+{
+    logger.logf("Pulse capture stress: injecting every %luus for %lums during flash writes",
+                (unsigned long) stressResult.intervalUs, (unsigned long) stressResult.durationMs);
+
+    portENTER_CRITICAL(&captureMux);
+    stressInjected     = 0;
+    stressDelivered    = 0;
+    stressOverflowed   = 0;
+    stressMaxGapUs     = 0;
+    stressLastInjectUs = 0;
+    portEXIT_CRITICAL(&captureMux);
+
+    timer_config_t config = {};
+    config.alarm_en       = TIMER_ALARM_EN;
+    config.counter_en     = TIMER_PAUSE;
+    config.intr_type      = TIMER_INTR_LEVEL;
+    config.counter_dir    = TIMER_COUNT_UP;
+    config.auto_reload    = TIMER_AUTORELOAD_EN;
+    config.divider        = 80;  // 1 MHz tick
+    timer_init(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX, &config);
+    timer_set_counter_value(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX, 0);
+    timer_set_alarm_value(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX, stressResult.intervalUs);
+    timer_enable_intr(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX);
+    timer_isr_callback_add(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX, onStressTimer, nullptr,
+                           ESP_INTR_FLAG_IRAM);
+
+    uint8_t *chunk = (uint8_t *) malloc(STRESS_CHUNK_BYTES);
+    if (chunk != nullptr)
+    {
+        memset(chunk, 0xA5, STRESS_CHUNK_BYTES);
+    }
+
+    stressActive = true;
+    timer_start(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX);
+
+    unsigned long start = millis();
+    while (chunk != nullptr && (millis() - start) < stressResult.durationMs)
+    {
+        File file = LittleFS.open(STRESS_FILE_PATH, "w");
+        if (!file)
+        {
+            break;
+        }
+        for (int i = 0; i < STRESS_CHUNKS_PER_FILE; i++)
+        {
+            stressResult.flashBytesWritten += file.write(chunk, STRESS_CHUNK_BYTES);
+            stressResult.flashWrites++;
+        }
+        file.close();
+    }
+
+    timer_pause(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX);
+    stressActive = false;
+    timer_isr_callback_remove(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX);
+    timer_deinit(STRESS_TIMER_GROUP, STRESS_TIMER_INDEX);
+
+    free(chunk);
+    LittleFS.remove(STRESS_FILE_PATH);
+
+    // Give the loop task time to drain what is still queued.
+    vTaskDelay(pdMS_TO_TICKS(250));
+
+    stressResult.injected       = stressInjected;
+    stressResult.delivered      = stressDelivered;
+    stressResult.overflowed     = stressOverflowed;
+    stressResult.maxInjectGapUs = stressMaxGapUs;
+    stressResult.completed      = true;
+    stressResult.running        = false;
+
+    logger.logf("Pulse capture stress: injected=%lu delivered=%lu overflowed=%lu "
+                "max_gap=%luus flash_writes=%lu flash_bytes=%lu",
+                (unsigned long) stressResult.injected, (unsigned long) stressResult.delivered,
+                (unsigned long) stressResult.overflowed,
+                (unsigned long) stressResult.maxInjectGapUs,
+                (unsigned long) stressResult.flashWrites,
+                (unsigned long) stressResult.flashBytesWritten);
+}
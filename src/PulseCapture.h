@@ -0,0 +1,85 @@
+#ifndef PULSE_CAPTURE_H
+#define PULSE_CAPTURE_H
+
+#include <Arduino.h>
+
+// A single captured level change on the movement sensor pin.
+typedef struct
+{
+    int64_t timestampUs;  // esp_timer time of the edge (same base as micros()/millis())
+    uint8_t level;        // pin level after the edge
+    uint8_t synthetic;    // injected by the capture stress test, not a real pulse
+} pulse_edge_t;
+
+typedef struct
+{
+    bool     running;
+    bool     completed;
+    uint32_t durationMs;
+    uint32_t intervalUs;
+    uint32_t injected;           // synthetic edges raised by the stress timer ISR
+    uint32_t delivered;          // synthetic edges that reached the consumer
+    uint32_t overflowed;         // synthetic edges dropped because the ring was full
+    uint32_t maxInjectGapUs;     // worst observed gap between stress timer interrupts
+    uint32_t flashWrites;        // LittleFS write calls issued while injecting
+    uint32_t flashBytesWritten;  // bytes written to flash while injecting
+} capture_stress_result_t;
+
+// Interrupt-driven capture of the movement and runout sensor pins.
+//
+// The GPIO handlers, the stress timer handler and everything they touch live
+// in IRAM/DRAM and are registered with ESP_INTR_FLAG_IRAM, so they keep
+// running while the flash cache is disabled by LittleFS writes. The loop task
+// drains the edge ring; anything that could not be queued is still counted so
+// the pulse total stays exact even if timestamps are lost.
+//
+// Movement edges closer than the minimum edge interval to the last accepted
+// one, or that leave the pin at the level it already had, are contact bounce
+// and are dropped (counted separately) before anything else sees them.
+class PulseCapture
+{
+   private:
+    PulseCapture();
+
+    PulseCapture(const PulseCapture &)            = delete;
+    PulseCapture &operator=(const PulseCapture &) = delete;
+
+    static void IRAM_ATTR onMovementEdge(void *arg);
+    static void IRAM_ATTR onRunoutEdge(void *arg);
+    static bool IRAM_ATTR onStressTimer(void *arg);
+    static void IRAM_ATTR recordMovementEdge(uint8_t level, bool synthetic);
+    static void           stressTask(void *arg);
+
+    void runStress();
+
+   public:
+    static PulseCapture &getInstance();
+
+    static const uint32_t DEFAULT_MIN_EDGE_US = 2000;
+
+    bool begin();
+    // 0 accepts every edge
+    void     setMinEdgeIntervalUs(uint32_t intervalUs);
+    uint32_t getMinEdgeIntervalUs() const;
+
+    // Loop-side consumer. Returns real movement edges oldest first.
+    bool popMovementEdge(pulse_edge_t &edge);
+    // Real edges that were counted but could not be queued since the last call.
+    uint32_t takeMovementOverflows();
+
+    bool     getRunoutLevel() const;
+    uint32_t getMovementEdgeCount() const;
+    uint32_t getRunoutEdgeCount() const;
+    // Movement edges dropped as bounce
+    uint32_t getRejectedEdgeCount() const;
+    int64_t  getLastMovementEdgeUs() const;
+
+    // Injects synthetic edges from an IRAM timer interrupt while a background
+    // task hammers LittleFS with writes, then reports whether any were lost.
+    bool                    startStressTest(uint32_t durationMs, uint32_t intervalUs);
+    capture_stress_result_t getStressResult();
+};
+
+#define pulseCapture PulseCapture::getInstance()
+
+#endif  // PULSE_CAPTURE_H
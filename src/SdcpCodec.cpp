@@ -0,0 +1,1239 @@
+#include "SdcpCodec.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *SdcpCodec::TOTAL_EXTRUSION_HEX_KEY = "54 6F 74 61 6C 45 78 74 72 75 73 69 6F 6E 00";
+const char *SdcpCodec::CURRENT_EXTRUSION_HEX_KEY =
+    "43 75 72 72 65 6E 74 45 78 74 72 75 73 69 6F 6E 00";
+
+namespace
+{
+// Decoded string bytes; stops at the first sequence that does not fit.
+struct TextSink
+{
+    char  *out;
+    size_t capacity;
+    size_t used;
+    bool   truncated;
+
+    void put(const char *bytes, size_t length)
+    {
+        if (out == nullptr || truncated)
+        {
+            return;
+        }
+        if (used + length >= capacity)
+        {
+            truncated = true;
+            return;
+        }
+        memcpy(out + used, bytes, length);
+        used += length;
+    }
+
+    void putCodePoint(uint32_t cp)
+    {
+        char utf8[4];
+        if (cp < 0x80)
+        {
+            utf8[0] = (char) cp;
+            put(utf8, 1);
+        }
+        else if (cp < 0x800)
+        {
+            utf8[0] = (char) (0xC0 | (cp >> 6));
+            utf8[1] = (char) (0x80 | (cp & 0x3F));
+            put(utf8, 2);
+        }
+        else if (cp < 0x10000)
+        {
+            utf8[0] = (char) (0xE0 | (cp >> 12));
+            utf8[1] = (char) (0x80 | ((cp >> 6) & 0x3F));
+            utf8[2] = (char) (0x80 | (cp & 0x3F));
+            put(utf8, 3);
+        }
+        else
+        {
+            utf8[0] = (char) (0xF0 | (cp >> 18));
+            utf8[1] = (char) (0x80 | ((cp >> 12) & 0x3F));
+            utf8[2] = (char) (0x80 | ((cp >> 6) & 0x3F));
+            utf8[3] = (char) (0x80 | (cp & 0x3F));
+            put(utf8, 4);
+        }
+    }
+};
+
+struct Reader
+{
+    const char *p;
+    const char *end;
+    int         depth;
+
+    void skipSpace()
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        {
+            p++;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (p < end && *p == c)
+        {
+            p++;
+            return true;
+        }
+        return false;
+    }
+
+    bool at(char c)
+    {
+        skipSpace();
+        return p < end && *p == c;
+    }
+
+    bool atNumber()
+    {
+        skipSpace();
+        return p < end && (*p == '-' || (*p >= '0' && *p <= '9'));
+    }
+
+    bool literal(const char *word)
+    {
+        size_t length = strlen(word);
+        if ((size_t) (end - p) < length || memcmp(p, word, length) != 0)
+        {
+            return false;
+        }
+        p += length;
+        return true;
+    }
+
+    bool readHex4(uint32_t &value)
+    {
+        if (end - p < 4)
+        {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; i++, p++)
+        {
+            char c = *p;
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+            {
+                value |= (uint32_t) (c - '0');
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                value |= (uint32_t) (c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                value |= (uint32_t) (c - 'A' + 10);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Reads a string into `out` (NUL-terminated) or skips it if `out` is
+    // null. Text that does not fit is cut before the first UTF-8 sequence
+    // that would overflow.
+    bool readString(char *out, size_t capacity, bool *truncated = nullptr)
+    {
+        if (!consume('"'))
+        {
+            return false;
+        }
+        TextSink sink = {out, capacity, 0, out == nullptr || capacity == 0};
+        while (p < end)
+        {
+            uint8_t c = (uint8_t) *p;
+            if (c == '"')
+            {
+                p++;
+                if (out != nullptr && capacity > 0)
+                {
+                    out[sink.used] = '\0';
+                }
+                if (truncated != nullptr)
+                {
+                    *truncated = sink.truncated && out != nullptr;
+                }
+                return true;
+            }
+            if (c == '\\')
+            {
+                if (++p >= end)
+                {
+                    return false;
+                }
+                char escaped = *p++;
+                switch (escaped)
+                {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        sink.put(&escaped, 1);
+                        break;
+                    case 'b':
+                        sink.put("\b", 1);
+                        break;
+                    case 'f':
+                        sink.put("\f", 1);
+                        break;
+                    case 'n':
+                        sink.put("\n", 1);
+                        break;
+                    case 'r':
+                        sink.put("\r", 1);
+                        break;
+                    case 't':
+                        sink.put("\t", 1);
+                        break;
+                    case 'u':
+                    {
+                        uint32_t cp;
+                        if (!readHex4(cp))
+                        {
+                            return false;
+                        }
+                        if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' &&
+                            p[1] == 'u')
+                        {
+                            const char *mark = p;
+                            uint32_t    low;
+                            p += 2;
+                            if (readHex4(low) && low >= 0xDC00 && low <= 0xDFFF)
+                            {
+                                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            }
+                            else
+                            {
+                                p = mark;
+                            }
+                        }
+                        if (cp == 0 || (cp >= 0xD800 && cp <= 0xDFFF))
+                        {
+                            cp = 0xFFFD;  // NUL would end the C string; unpaired surrogate
+                        }
+                        sink.putCodePoint(cp);
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+                continue;
+            }
+
+            // Raw bytes, a whole UTF-8 sequence at a time
+            size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+            size_t n      = 1;
+            while (n < length && p + n < end && ((uint8_t) p[n] & 0xC0) == 0x80)
+            {
+                n++;
+            }
+            sink.put(p, n);
+            p += n;
+        }
+        return false;
+    }
+
+    bool readNumber(double &value)
+    {
+        skipSpace();
+        const char *start = p;
+        if (p < end && *p == '-')
+        {
+            p++;
+        }
+        if (p >= end || *p < '0' || *p > '9')
+        {
+            return false;
+        }
+        if (*p == '0')
+        {
+            p++;
+        }
+        else
+        {
+            skipDigits();
+        }
+        if (p < end && *p == '.')
+        {
+            p++;
+            if (!skipDigits())
+            {
+                return false;
+            }
+        }
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            p++;
+            if (p < end && (*p == '+' || *p == '-'))
+            {
+                p++;
+            }
+            if (!skipDigits())
+            {
+                return false;
+            }
+        }
+
+        char   text[64];
+        size_t length = (size_t) (p - start);
+        if (length >= sizeof(text))
+        {
+            value = 0.0;  // well-formed but longer than any value SDCP sends
+            return true;
+        }
+        memcpy(text, start, length);
+        text[length] = '\0';
+        value        = strtod(text, nullptr);
+        return true;
+    }
+
+    bool skipDigits()
+    {
+        const char *start = p;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            p++;
+        }
+        return p > start;
+    }
+
+    bool skipValue();
+};
+
+// Calls handler(key, reader) for each member; the handler consumes the value.
+template <typename Handler>
+bool readObject(Reader &r, Handler handler)
+{
+    if (!r.consume('{') || ++r.depth > SdcpCodec::MAX_DEPTH)
+    {
+        return false;
+    }
+    if (!r.consume('}'))
+    {
+        while (true)
+        {
+            char key[64];
+            bool truncated = false;
+            if (!r.readString(key, sizeof(key), &truncated) || !r.consume(':'))
+            {
+                return false;
+            }
+            if (truncated)
+            {
+                key[0] = '\0';  // longer than any key we look for
+            }
+            if (!handler((const char *) key, r))
+            {
+                return false;
+            }
+            if (r.consume(','))
+            {
+                continue;
+            }
+            if (!r.consume('}'))
+            {
+                return false;
+            }
+            break;
+        }
+    }
+    r.depth--;
+    return true;
+}
+
+// Calls handler(index, reader) for each element; the handler consumes it.
+template <typename Handler>
+bool readArray(Reader &r, Handler handler)
+{
+    if (!r.consume('[') || ++r.depth > SdcpCodec::MAX_DEPTH)
+    {
+        return false;
+    }
+    if (!r.consume(']'))
+    {
+        for (size_t index = 0;; index++)
+        {
+            if (!handler(index, r))
+            {
+                return false;
+            }
+            if (r.consume(','))
+            {
+                continue;
+            }
+            if (!r.consume(']'))
+            {
+                return false;
+            }
+            break;
+        }
+    }
+    r.depth--;
+    return true;
+}
+
+bool Reader::skipValue()
+{
+    skipSpace();
+    if (p >= end)
+    {
+        return false;
+    }
+    switch (*p)
+    {
+        case '"':
+            return readString(nullptr, 0);
+        case '{':
+            return readObject(*this, [](const char *, Reader &r) { return r.skipValue(); });
+        case '[':
+            return readArray(*this, [](size_t, Reader &r) { return r.skipValue(); });
+        case 't':
+            return literal("true");
+        case 'f':
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default:
+        {
+            double unused;
+            return readNumber(unused);
+        }
+    }
+}
+
+// Values of another type than expected are skipped and leave the field
+// alone, the way a missing key would.
+bool readDouble(Reader &r, double &value, bool *present = nullptr)
+{
+    if (!r.atNumber())
+    {
+        return r.skipValue();
+    }
+    double number = 0.0;
+    if (!r.readNumber(number))
+    {
+        return false;
+    }
+    if (!isfinite(number))
+    {
+        return true;  // 1e999: well-formed but unrepresentable, so absent
+    }
+    value = number;
+    if (present != nullptr)
+    {
+        *present = true;
+    }
+    return true;
+}
+
+int32_t clampInt(double value, double low, double high)
+{
+    if (!(value == value))
+    {
+        return 0;
+    }
+    return (int32_t) (value < low ? low : value > high ? high : value);
+}
+
+bool readInt32(Reader &r, int32_t &value)
+{
+    double number  = 0.0;
+    bool   present = false;
+    if (!readDouble(r, number, &present))
+    {
+        return false;
+    }
+    if (present)
+    {
+        value = clampInt(number, -2147483648.0, 2147483647.0);
+    }
+    return true;
+}
+
+bool readInt16(Reader &r, int16_t &value)
+{
+    int32_t wide = value;
+    if (!readInt32(r, wide))
+    {
+        return false;
+    }
+    value = (int16_t) (wide < -32768 ? -32768 : wide > 32767 ? 32767 : wide);
+    return true;
+}
+
+bool readFloat(Reader &r, float &value, bool &present)
+{
+    double number = 0.0;
+    bool   found  = false;
+    if (!readDouble(r, number, &found))
+    {
+        return false;
+    }
+    if (found && number >= -FLT_MAX && number <= FLT_MAX)
+    {
+        value   = (float) number;
+        present = true;
+    }
+    return true;
+}
+
+bool readText(Reader &r, char *out, size_t capacity)
+{
+    return r.at('"') ? r.readString(out, capacity) : r.skipValue();
+}
+
+bool readMachineStatuses(Reader &r, int16_t *statuses, uint8_t &count)
+{
+    count = 0;
+    if (!r.at('['))
+    {
+        return r.skipValue();  // treated as an empty list
+    }
+    return readArray(r,
+                     [&](size_t index, Reader &r)
+                     {
+                         int16_t value = 0;
+                         if (!readInt16(r, value))
+                         {
+                             return false;
+                         }
+                         if (index < SDCP_MAX_MACHINE_STATUSES)
+                         {
+                             statuses[count++] = value;
+                         }
+                         return true;
+                     });
+}
+
+bool readPrintInfo(Reader &r, sdcp_print_info_t &info)
+{
+    bool plainTotal   = false;
+    bool plainCurrent = false;
+    return readObject(
+        r,
+        [&](const char *key, Reader &r)
+        {
+            if (strcmp(key, "Status") == 0)
+            {
+                return readInt16(r, info.status);
+            }
+            if (strcmp(key, "CurrentLayer") == 0)
+            {
+                return readInt32(r, info.currentLayer);
+            }
+            if (strcmp(key, "TotalLayer") == 0)
+            {
+                return readInt32(r, info.totalLayer);
+            }
+            if (strcmp(key, "CurrentTicks") == 0)
+            {
+                return readInt32(r, info.currentTicks);
+            }
+            if (strcmp(key, "TotalTicks") == 0)
+            {
+                return readInt32(r, info.totalTicks);
+            }
+            if (strcmp(key, "Progress") == 0)
+            {
+                return readInt32(r, info.progress);
+            }
+            if (strcmp(key, "PrintSpeedPct") == 0)
+            {
+                return readInt32(r, info.printSpeedPct);
+            }
+            if (strcmp(key, "Filename") == 0)
+            {
+                return readText(r, info.filename, sizeof(info.filename));
+            }
+            if (strcmp(key, "TaskId") == 0)
+            {
+                return readText(r, info.taskId, sizeof(info.taskId));
+            }
+            if (strcmp(key, "TotalExtrusion") == 0)
+            {
+                bool present = false;
+                if (!readFloat(r, info.totalExtrusion, present))
+                {
+                    return false;
+                }
+                plainTotal = plainTotal || present;
+                info.hasTotalExtrusion = info.hasTotalExtrusion || present;
+                return true;
+            }
+            if (strcmp(key, "CurrentExtrusion") == 0)
+            {
+                bool present = false;
+                if (!readFloat(r, info.currentExtrusion, present))
+                {
+                    return false;
+                }
+                plainCurrent = plainCurrent || present;
+                info.hasCurrentExtrusion = info.hasCurrentExtrusion || present;
+                return true;
+            }
+            if (!plainTotal && strcmp(key, SdcpCodec::TOTAL_EXTRUSION_HEX_KEY) == 0)
+            {
+                return readFloat(r, info.totalExtrusion, info.hasTotalExtrusion);
+            }
+            if (!plainCurrent && strcmp(key, SdcpCodec::CURRENT_EXTRUSION_HEX_KEY) == 0)
+            {
+                return readFloat(r, info.currentExtrusion, info.hasCurrentExtrusion);
+            }
+            return r.skipValue();
+        });
+}
+
+bool readCoord(Reader &r, sdcp_status_t &status)
+{
+    char text[SDCP_TEXT_LENGTH] = "";
+    if (!readText(r, text, sizeof(text)))
+    {
+        return false;
+    }
+    char *firstComma  = strchr(text, ',');
+    char *secondComma = firstComma != nullptr ? strchr(firstComma + 1, ',') : nullptr;
+    if (secondComma != nullptr)
+    {
+        status.coord[0] = strtof(text, nullptr);
+        status.coord[1] = strtof(firstComma + 1, nullptr);
+        status.coord[2] = strtof(secondComma + 1, nullptr);
+        status.hasCoord = true;
+    }
+    return true;
+}
+
+bool readStatus(Reader &r, sdcp_status_t &status)
+{
+    return readObject(r,
+                      [&](const char *key, Reader &r)
+                      {
+                          if (strcmp(key, "CurrentStatus") == 0)
+                          {
+                              status.hasMachineStatuses = true;
+                              return readMachineStatuses(r, status.machineStatuses,
+                                                         status.machineStatusCount);
+                          }
+                          if (strcmp(key, "CurrenCoord") == 0)
+                          {
+                              return readCoord(r, status);
+                          }
+                          if (strcmp(key, "PrintInfo") == 0 && r.at('{'))
+                          {
+                              status.hasPrintInfo = true;
+                              return readPrintInfo(r, status.printInfo);
+                          }
+                          return r.skipValue();
+                      });
+}
+
+bool readAttributes(Reader &r, sdcp_attributes_t &attributes, char *mainboardId)
+{
+    return readObject(r,
+                      [&](const char *key, Reader &r)
+                      {
+                          if (strcmp(key, "Name") == 0)
+                          {
+                              return readText(r, attributes.name, sizeof(attributes.name));
+                          }
+                          if (strcmp(key, "MachineName") == 0)
+                          {
+                              return readText(r, attributes.machineName,
+                                              sizeof(attributes.machineName));
+                          }
+                          if (strcmp(key, "BrandName") == 0)
+                          {
+                              return readText(r, attributes.brandName,
+                                              sizeof(attributes.brandName));
+                          }
+                          if (strcmp(key, "ProtocolVersion") == 0)
+                          {
+                              return readText(r, attributes.protocolVersion,
+                                              sizeof(attributes.protocolVersion));
+                          }
+                          if (strcmp(key, "FirmwareVersion") == 0)
+                          {
+                              return readText(r, attributes.firmwareVersion,
+                                              sizeof(attributes.firmwareVersion));
+                          }
+                          if (strcmp(key, "MainboardIP") == 0)
+                          {
+                              return readText(r, attributes.mainboardIp,
+                                              sizeof(attributes.mainboardIp));
+                          }
+                          if (strcmp(key, "MainboardID") == 0)
+                          {
+                              return readText(r, mainboardId, SDCP_ID_LENGTH);
+                          }
+                          return r.skipValue();
+                      });
+}
+
+// The "Data" member of a request or ack, before we know which it is
+struct CommandFields
+{
+    bool    present;
+    bool    hasCmd;
+    bool    hasRequestId;
+    bool    hasFrom;
+    bool    hasTimeStamp;
+    int32_t cmd;
+    int32_t ack;
+    int32_t from;
+    int16_t printStatus;
+    uint8_t machineStatusCount;
+    int16_t machineStatuses[SDCP_MAX_MACHINE_STATUSES];
+    double  timeStamp;
+    char    requestId[SDCP_ID_LENGTH];
+    char    mainboardId[SDCP_ID_LENGTH];
+};
+
+bool readCommand(Reader &r, CommandFields &data)
+{
+    data.present = true;
+    return readObject(
+        r,
+        [&](const char *key, Reader &r)
+        {
+            if (strcmp(key, "Cmd") == 0)
+            {
+                data.hasCmd = r.atNumber();
+                return readInt32(r, data.cmd);
+            }
+            if (strcmp(key, "RequestID") == 0)
+            {
+                data.hasRequestId = true;
+                return readText(r, data.requestId, sizeof(data.requestId));
+            }
+            if (strcmp(key, "MainboardID") == 0)
+            {
+                return readText(r, data.mainboardId, sizeof(data.mainboardId));
+            }
+            if (strcmp(key, "TimeStamp") == 0)
+            {
+                return readDouble(r, data.timeStamp, &data.hasTimeStamp);
+            }
+            if (strcmp(key, "From") == 0)
+            {
+                data.hasFrom = true;
+                return readInt32(r, data.from);
+            }
+            if (strcmp(key, "PrintStatus") == 0)
+            {
+                return readInt16(r, data.printStatus);
+            }
+            if (strcmp(key, "CurrentStatus") == 0)
+            {
+                return readMachineStatuses(r, data.machineStatuses, data.machineStatusCount);
+            }
+            if (strcmp(key, "Data") == 0 && r.at('{'))
+            {
+                return readObject(r,
+                                  [&](const char *key, Reader &r)
+                                  {
+                                      return strcmp(key, "Ack") == 0 ? readInt32(r, data.ack)
+                                                                     : r.skipValue();
+                                  });
+            }
+            return r.skipValue();
+        });
+}
+
+// ---- encoding
+
+struct Writer
+{
+    char  *out;
+    size_t capacity;
+    size_t used;
+    bool   overflow;
+
+    void put(const char *text, size_t length)
+    {
+        if (used + length >= capacity)
+        {
+            overflow = true;
+            return;
+        }
+        memcpy(out + used, text, length);
+        used += length;
+    }
+
+    void put(const char *text) { put(text, strlen(text)); }
+
+    // `first` tracks whether the enclosing object needs a comma
+    void member(bool &first, const char *name)
+    {
+        if (!first)
+        {
+            put(",", 1);
+        }
+        first = false;
+        put("\"", 1);
+        put(name);
+        put("\":", 2);
+    }
+
+    void putString(const char *text)
+    {
+        put("\"", 1);
+        for (; *text != '\0'; text++)
+        {
+            char c = *text;
+            if (c == '"' || c == '\\')
+            {
+                char escaped[2] = {'\\', c};
+                put(escaped, 2);
+            }
+            else if ((uint8_t) c < 0x20)
+            {
+                char escaped[7];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned) (uint8_t) c);
+                put(escaped, 6);
+            }
+            else
+            {
+                put(&c, 1);
+            }
+        }
+        put("\"", 1);
+    }
+
+    void putInt(long value)
+    {
+        char text[16];
+        put(text, (size_t) snprintf(text, sizeof(text), "%ld", value));
+    }
+
+    // Shortest of the usual precisions that reads back as the same float
+    static size_t formatFloat(float value, char *text, size_t capacity)
+    {
+        int length = snprintf(text, capacity, "%.7g", (double) value);
+        if (strtof(text, nullptr) != value)
+        {
+            length = snprintf(text, capacity, "%.9g", (double) value);
+        }
+        return (size_t) length;
+    }
+
+    void putFloat(float value)
+    {
+        if (!isfinite(value))
+        {
+            put("null", 4);
+            return;
+        }
+        char text[24];
+        put(text, formatFloat(value, text, sizeof(text)));
+    }
+
+    void putDouble(double value)
+    {
+        if (!isfinite(value))
+        {
+            put("null", 4);
+            return;
+        }
+        char text[32];
+        int  length = snprintf(text, sizeof(text), "%.15g", value);
+        if (strtod(text, nullptr) != value)
+        {
+            length = snprintf(text, sizeof(text), "%.17g", value);
+        }
+        put(text, (size_t) length);
+    }
+
+    void putMachineStatuses(const int16_t *statuses, uint8_t count)
+    {
+        put("[", 1);
+        for (uint8_t i = 0; i < count && i < SDCP_MAX_MACHINE_STATUSES; i++)
+        {
+            if (i > 0)
+            {
+                put(",", 1);
+            }
+            putInt(statuses[i]);
+        }
+        put("]", 1);
+    }
+
+    // MainboardID, TimeStamp and Topic, as the printer sends them
+    void putHeader(bool &first, const sdcp_message_t &message, const char *topicPrefix)
+    {
+        member(first, "MainboardID");
+        putString(message.mainboardId);
+        if (message.hasTimeStamp)
+        {
+            member(first, "TimeStamp");
+            putDouble(message.timeStamp);
+        }
+        putTopic(first, message, topicPrefix);
+    }
+
+    void putTopic(bool &first, const sdcp_message_t &message, const char *topicPrefix)
+    {
+        if (message.mainboardId[0] != '\0')
+        {
+            char topic[SDCP_TEXT_LENGTH + SDCP_ID_LENGTH];
+            snprintf(topic, sizeof(topic), "%s/%s", topicPrefix, message.mainboardId);
+            member(first, "Topic");
+            putString(topic);
+        }
+    }
+};
+
+void encodePrintInfo(Writer &w, const sdcp_print_info_t &info)
+{
+    bool first = true;
+    w.put("{", 1);
+    w.member(first, "Status");
+    w.putInt(info.status);
+    w.member(first, "CurrentLayer");
+    w.putInt(info.currentLayer);
+    w.member(first, "TotalLayer");
+    w.putInt(info.totalLayer);
+    w.member(first, "CurrentTicks");
+    w.putInt(info.currentTicks);
+    w.member(first, "TotalTicks");
+    w.putInt(info.totalTicks);
+    w.member(first, "Filename");
+    w.putString(info.filename);
+    w.member(first, "TaskId");
+    w.putString(info.taskId);
+    w.member(first, "PrintSpeedPct");
+    w.putInt(info.printSpeedPct);
+    w.member(first, "Progress");
+    w.putInt(info.progress);
+    if (info.hasTotalExtrusion)
+    {
+        w.member(first, "TotalExtrusion");
+        w.putFloat(info.totalExtrusion);
+    }
+    if (info.hasCurrentExtrusion)
+    {
+        w.member(first, "CurrentExtrusion");
+        w.putFloat(info.currentExtrusion);
+    }
+    w.put("}", 1);
+}
+
+void encodeStatus(Writer &w, const sdcp_message_t &message)
+{
+    const sdcp_status_t &status = message.status;
+    bool                 first  = true;
+    bool                 inner  = true;
+    w.put("{", 1);
+    w.member(first, "Status");
+    w.put("{", 1);
+    if (status.hasMachineStatuses)
+    {
+        w.member(inner, "CurrentStatus");
+        w.putMachineStatuses(status.machineStatuses, status.machineStatusCount);
+    }
+    if (status.hasCoord)
+    {
+        char   coord[80];
+        size_t length = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            if (i > 0)
+            {
+                coord[length++] = ',';
+            }
+            length += Writer::formatFloat(status.coord[i], coord + length, sizeof(coord) - length);
+        }
+        coord[length] = '\0';
+        w.member(inner, "CurrenCoord");
+        w.putString(coord);
+    }
+    if (status.hasPrintInfo)
+    {
+        w.member(inner, "PrintInfo");
+        encodePrintInfo(w, status.printInfo);
+    }
+    w.put("}", 1);
+    w.putHeader(first, message, "sdcp/status");
+    w.put("}", 1);
+}
+
+void encodeAttributes(Writer &w, const sdcp_message_t &message)
+{
+    const sdcp_attributes_t &attributes = message.attributes;
+    bool                     first      = true;
+    bool                     inner      = true;
+    w.put("{", 1);
+    w.member(first, "Attributes");
+    w.put("{", 1);
+    w.member(inner, "Name");
+    w.putString(attributes.name);
+    w.member(inner, "MachineName");
+    w.putString(attributes.machineName);
+    w.member(inner, "BrandName");
+    w.putString(attributes.brandName);
+    w.member(inner, "ProtocolVersion");
+    w.putString(attributes.protocolVersion);
+    w.member(inner, "FirmwareVersion");
+    w.putString(attributes.firmwareVersion);
+    w.member(inner, "MainboardIP");
+    w.putString(attributes.mainboardIp);
+    w.member(inner, "MainboardID");
+    w.putString(message.mainboardId);
+    w.put("}", 1);
+    w.putHeader(first, message, "sdcp/attributes");
+    w.put("}", 1);
+}
+
+// Field order matches what the Elegoo Home Assistant integration sends.
+void encodeRequest(Writer &w, const sdcp_message_t &message)
+{
+    const sdcp_request_t &request = message.request;
+    bool                  first   = true;
+    bool                  inner   = true;
+    w.put("{", 1);
+    w.member(first, "Id");
+    w.putString(request.requestId);
+    w.member(first, "Data");
+    w.put("{", 1);
+    w.member(inner, "Cmd");
+    w.putInt(request.cmd);
+    w.member(inner, "RequestID");
+    w.putString(request.requestId);
+    w.member(inner, "MainboardID");
+    w.putString(message.mainboardId);
+    if (message.hasTimeStamp)
+    {
+        w.member(inner, "TimeStamp");
+        w.putDouble(message.timeStamp);
+    }
+    w.member(inner, "From");
+    w.putInt(request.from);
+    w.member(inner, "Data");
+    w.put("{}", 2);
+    w.member(inner, "PrintStatus");
+    w.putInt(request.printStatus);
+    w.member(inner, "CurrentStatus");
+    w.putMachineStatuses(request.machineStatuses, request.machineStatusCount);
+    w.put("}", 1);
+    w.putTopic(first, message, "sdcp/request");
+    w.put("}", 1);
+}
+
+void encodeAck(Writer &w, const sdcp_message_t &message)
+{
+    const sdcp_ack_t &ack   = message.ack;
+    bool              first = true;
+    bool              inner = true;
+    w.put("{", 1);
+    w.member(first, "Id");
+    w.putString(ack.requestId);
+    w.member(first, "Data");
+    w.put("{", 1);
+    w.member(inner, "Cmd");
+    w.putInt(ack.cmd);
+    w.member(inner, "Data");
+    w.put("{\"Ack\":", 7);
+    w.putInt(ack.ack);
+    w.put("}", 1);
+    w.member(inner, "RequestID");
+    w.putString(ack.requestId);
+    w.member(inner, "MainboardID");
+    w.putString(message.mainboardId);
+    if (message.hasTimeStamp)
+    {
+        w.member(inner, "TimeStamp");
+        w.putDouble(message.timeStamp);
+    }
+    w.put("}", 1);
+    w.putTopic(first, message, "sdcp/response");
+    w.put("}", 1);
+}
+}  // namespace
+
+bool SdcpCodec::decode(const char *json, size_t length, sdcp_message_t &message)
+{
+    memset(&message, 0, sizeof(message));
+    if (json == nullptr)
+    {
+        return false;
+    }
+
+    static const char REQUEST_TOPIC[] = "sdcp/request/";
+    Reader            r               = {json, json + length, 0};
+    CommandFields     data;
+    char              topic[SDCP_TEXT_LENGTH] = "";
+    char              attributesMainboardId[SDCP_ID_LENGTH] = "";
+    bool              hasId         = false;
+    bool              hasStatus     = false;
+    bool              hasAttributes = false;
+    memset(&data, 0, sizeof(data));
+
+    bool ok = readObject(
+        r,
+        [&](const char *key, Reader &r)
+        {
+            if (strcmp(key, "Id") == 0)
+            {
+                hasId = true;
+                return r.skipValue();
+            }
+            if (strcmp(key, "Data") == 0 && r.at('{'))
+            {
+                return readCommand(r, data);
+            }
+            if (strcmp(key, "Status") == 0 && r.at('{'))
+            {
+                hasStatus = true;
+                return readStatus(r, message.status);
+            }
+            if (strcmp(key, "Attributes") == 0 && r.at('{'))
+            {
+                hasAttributes = true;
+                return readAttributes(r, message.attributes, attributesMainboardId);
+            }
+            if (strcmp(key, "MainboardID") == 0)
+            {
+                return readText(r, message.mainboardId, sizeof(message.mainboardId));
+            }
+            if (strcmp(key, "TimeStamp") == 0)
+            {
+                return readDouble(r, message.timeStamp, &message.hasTimeStamp);
+            }
+            if (strcmp(key, "Topic") == 0)
+            {
+                return readText(r, topic, sizeof(topic));
+            }
+            return r.skipValue();
+        });
+    if (!ok)
+    {
+        memset(&message, 0, sizeof(message));
+        return false;
+    }
+
+    if (hasId && data.present)
+    {
+        if (!data.hasCmd || !data.hasRequestId)
+        {
+            return true;  // SDCP_MESSAGE_UNKNOWN
+        }
+        if (message.mainboardId[0] == '\0')
+        {
+            memcpy(message.mainboardId, data.mainboardId, sizeof(message.mainboardId));
+        }
+        if (data.hasTimeStamp)
+        {
+            message.timeStamp    = data.timeStamp;
+            message.hasTimeStamp = true;
+        }
+
+        if (data.hasFrom || strncmp(topic, REQUEST_TOPIC, sizeof(REQUEST_TOPIC) - 1) == 0)
+        {
+            sdcp_request_t &request = message.request;
+            message.kind            = SDCP_MESSAGE_REQUEST;
+            request.cmd             = data.cmd;
+            request.from            = data.from;
+            request.printStatus     = data.printStatus;
+            request.machineStatusCount = data.machineStatusCount;
+            memcpy(request.machineStatuses, data.machineStatuses, sizeof(request.machineStatuses));
+            memcpy(request.requestId, data.requestId, sizeof(request.requestId));
+        }
+        else
+        {
+            message.kind    = SDCP_MESSAGE_ACK;
+            message.ack.cmd = data.cmd;
+            message.ack.ack = data.ack;
+            memcpy(message.ack.requestId, data.requestId, sizeof(message.ack.requestId));
+        }
+    }
+    else if (hasStatus)
+    {
+        message.kind = SDCP_MESSAGE_STATUS;
+    }
+    else if (hasAttributes)
+    {
+        message.kind = SDCP_MESSAGE_ATTRIBUTES;
+        if (message.mainboardId[0] == '\0')
+        {
+            memcpy(message.mainboardId, attributesMainboardId, sizeof(message.mainboardId));
+        }
+    }
+
+    // Only the member named by `kind` may carry data
+    if (message.kind != SDCP_MESSAGE_STATUS)
+    {
+        memset(&message.status, 0, sizeof(message.status));
+    }
+    if (message.kind != SDCP_MESSAGE_ATTRIBUTES)
+    {
+        memset(&message.attributes, 0, sizeof(message.attributes));
+    }
+    return true;
+}
+
+size_t SdcpCodec::encode(const sdcp_message_t &message, char *out, size_t capacity)
+{
+    if (out == nullptr || capacity == 0)
+    {
+        return 0;
+    }
+
+    Writer w = {out, capacity, 0, false};
+    switch (message.kind)
+    {
+        case SDCP_MESSAGE_STATUS:
+            encodeStatus(w, message);
+            break;
+        case SDCP_MESSAGE_ATTRIBUTES:
+            encodeAttributes(w, message);
+            break;
+        case SDCP_MESSAGE_REQUEST:
+            encodeRequest(w, message);
+            break;
+        case SDCP_MESSAGE_ACK:
+            encodeAck(w, message);
+            break;
+        default:
+            w.overflow = true;
+            break;
+    }
+
+    if (w.overflow)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    out[w.used] = '\0';
+    return w.used;
+}
+
+const char *SdcpCodec::kindName(sdcp_message_kind_t kind)
+{
+    switch (kind)
+    {
+        case SDCP_MESSAGE_STATUS:
+            return "status";
+        case SDCP_MESSAGE_ATTRIBUTES:
+            return "attributes";
+        case SDCP_MESSAGE_REQUEST:
+            return "request";
+        case SDCP_MESSAGE_ACK:
+            return "ack";
+        default:
+            return "unknown";
+    }
+}
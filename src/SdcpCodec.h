@@ -0,0 +1,175 @@
+#ifndef SDCP_CODEC_H
+#define SDCP_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Status codes
+typedef enum
+{
+    SDCP_PRINT_STATUS_IDLE          = 0,   // Idle
+    SDCP_PRINT_STATUS_HOMING        = 1,   // Homing
+    SDCP_PRINT_STATUS_DROPPING      = 2,   // Descending
+    SDCP_PRINT_STATUS_EXPOSURING    = 3,   // Exposing
+    SDCP_PRINT_STATUS_LIFTING       = 4,   // Lifting
+    SDCP_PRINT_STATUS_PAUSING       = 5,   // Executing Pause Action
+    SDCP_PRINT_STATUS_PAUSED        = 6,   // Suspended
+    SDCP_PRINT_STATUS_STOPPING      = 7,   // Executing Stop Action
+    SDCP_PRINT_STATUS_STOPED        = 8,   // Stopped
+    SDCP_PRINT_STATUS_COMPLETE      = 9,   // Print Completed
+    SDCP_PRINT_STATUS_FILE_CHECKING = 10,  // File Checking in Progress
+    SDCP_PRINT_STATUS_PRINTING      = 13,  // Printing
+    SDCP_PRINT_STATUS_UNKNOWN_15    = 15,  // unknown
+    SDCP_PRINT_STATUS_HEATING       = 16,  // Heating
+    SDCP_PRINT_STATUS_UNKNOWN_18    = 18,  // Unknown
+    SDCP_PRINT_STATUS_UNKNOWN_19    = 19,  // Unknown
+    SDCP_PRINT_STATUS_BED_LEVELING  = 20,  // Bed Leveling
+    SDCP_PRINT_STATUS_UNKNOWN_21    = 21,  // Unknown
+} sdcp_print_status_t;
+
+// Extended Status Error Codes
+typedef enum
+{
+    SDCP_PRINT_ERROR_NONE               = 0,  // Normal
+    SDCP_PRINT_ERROR_CHECK              = 1,  // File MD5 Check Failed
+    SDCP_PRINT_ERROR_FILEIO             = 2,  // File Read Failed
+    SDCP_PRINT_ERROR_INVLAID_RESOLUTION = 3,  // Resolution Mismatch
+    SDCP_PRINT_ERROR_UNKNOWN_FORMAT     = 4,  // Format Mismatch
+    SDCP_PRINT_ERROR_UNKNOWN_MODEL      = 5   // Machine Model Mismatch
+} sdcp_print_error_t;
+
+typedef enum
+{
+    SDCP_MACHINE_STATUS_IDLE              = 0,  // Idle
+    SDCP_MACHINE_STATUS_PRINTING          = 1,  // Executing print task
+    SDCP_MACHINE_STATUS_FILE_TRANSFERRING = 2,  // File transfer in progress
+    SDCP_MACHINE_STATUS_EXPOSURE_TESTING  = 3,  // Exposure test in progress
+    SDCP_MACHINE_STATUS_DEVICES_TESTING   = 4,  // Device self-check in progress
+} sdcp_machine_status_t;
+
+typedef enum
+{
+    SDCP_COMMAND_STATUS                = 0,
+    SDCP_COMMAND_ATTRIBUTES            = 1,
+    SDCP_COMMAND_START_PRINT           = 128,
+    SDCP_COMMAND_PAUSE_PRINT           = 129,
+    SDCP_COMMAND_STOP_PRINT            = 130,
+    SDCP_COMMAND_CONTINUE_PRINT        = 131,
+    SDCP_COMMAND_STOP_FEEDING_MATERIAL = 132,
+} sdcp_command_t;
+
+typedef enum
+{
+    SDCP_MESSAGE_UNKNOWN    = 0,  // well-formed JSON of no known shape
+    SDCP_MESSAGE_STATUS     = 1,  // printer -> client, "Status"
+    SDCP_MESSAGE_ATTRIBUTES = 2,  // printer -> client, "Attributes"
+    SDCP_MESSAGE_REQUEST    = 3,  // client -> printer command
+    SDCP_MESSAGE_ACK        = 4,  // printer's response to a command
+} sdcp_message_kind_t;
+
+#define SDCP_ID_LENGTH 48  // MainboardID, RequestID, TaskId
+#define SDCP_TEXT_LENGTH 64
+#define SDCP_FILENAME_LENGTH 128
+#define SDCP_MAX_MACHINE_STATUSES 5
+
+typedef struct
+{
+    int16_t status;  // sdcp_print_status_t
+    int32_t currentLayer;
+    int32_t totalLayer;
+    int32_t currentTicks;
+    int32_t totalTicks;
+    int32_t progress;
+    int32_t printSpeedPct;
+    bool    hasTotalExtrusion;  // TotalExtrusion, or its hex-named alias
+    bool    hasCurrentExtrusion;
+    float   totalExtrusion;
+    float   currentExtrusion;
+    char    filename[SDCP_FILENAME_LENGTH];
+    char    taskId[SDCP_ID_LENGTH];
+} sdcp_print_info_t;
+
+typedef struct
+{
+    bool              hasMachineStatuses;
+    bool              hasCoord;
+    bool              hasPrintInfo;
+    uint8_t           machineStatusCount;
+    int16_t           machineStatuses[SDCP_MAX_MACHINE_STATUSES];  // sdcp_machine_status_t
+    float             coord[3];  // CurrenCoord x, y, z
+    sdcp_print_info_t printInfo;
+} sdcp_status_t;
+
+typedef struct
+{
+    char name[SDCP_TEXT_LENGTH];
+    char machineName[SDCP_TEXT_LENGTH];
+    char brandName[SDCP_TEXT_LENGTH];
+    char protocolVersion[SDCP_TEXT_LENGTH];
+    char firmwareVersion[SDCP_TEXT_LENGTH];
+    char mainboardIp[SDCP_TEXT_LENGTH];
+} sdcp_attributes_t;
+
+typedef struct
+{
+    int32_t cmd;  // sdcp_command_t
+    char    requestId[SDCP_ID_LENGTH];
+    int32_t from;
+    int16_t printStatus;  // the sender's view, echoed like the status frame
+    uint8_t machineStatusCount;
+    int16_t machineStatuses[SDCP_MAX_MACHINE_STATUSES];
+} sdcp_request_t;
+
+typedef struct
+{
+    int32_t cmd;
+    int32_t ack;  // 0 is success
+    char    requestId[SDCP_ID_LENGTH];
+} sdcp_ack_t;
+
+// One SDCP websocket message. Only the member named by `kind` is meaningful;
+// the others are left zeroed. mainboardId and timeStamp are lifted from
+// wherever the message kind carries them (top level or inside "Data").
+typedef struct
+{
+    uint8_t           kind;  // sdcp_message_kind_t
+    bool              hasTimeStamp;
+    double            timeStamp;  // printer epoch seconds
+    char              mainboardId[SDCP_ID_LENGTH];
+    sdcp_status_t     status;
+    sdcp_attributes_t attributes;
+    sdcp_request_t    request;
+    sdcp_ack_t        ack;
+} sdcp_message_t;
+
+// JSON encoder and decoder for the SDCP messages the firmware exchanges with
+// the printer, shared with the host replay tool and tests.
+//
+// Neither direction allocates: decode() scans the text once into the fixed
+// structs above (strings are truncated to their buffers on a UTF-8
+// boundary, unknown keys are skipped) and encode() writes into the
+// caller's buffer.
+class SdcpCodec
+{
+   public:
+    static const int MAX_DEPTH = 16;  // nesting allowed in skipped values
+
+    // False if the text is not well-formed JSON (or nests deeper than
+    // MAX_DEPTH); a well-formed message of no known shape decodes as
+    // SDCP_MESSAGE_UNKNOWN.
+    static bool decode(const char *json, size_t length, sdcp_message_t &message);
+
+    // Returns the length written (NUL-terminated), 0 if it did not fit or
+    // the kind is SDCP_MESSAGE_UNKNOWN. Non-finite numbers are written as
+    // null, which decodes as absent.
+    static size_t encode(const sdcp_message_t &message, char *out, size_t capacity);
+
+    static const char *kindName(sdcp_message_kind_t kind);
+
+    // Some firmware versions send these keys spelled as the hex bytes of
+    // the name; a plain key wins when both are present.
+    static const char *TOTAL_EXTRUSION_HEX_KEY;
+    static const char *CURRENT_EXTRUSION_HEX_KEY;
+};
+
+#endif  // SDCP_CODEC_H
@@ -0,0 +1,205 @@
+#include "SettingsJson.h"
+
+#include "NotifyQueue.h"
+
+void settingsDefaults(user_settings &settings)
+{
+    settings.ap_mode             = false;
+    settings.ssid                = "";
+    settings.passwd              = "";
+    settings.wifi_static_ip      = "";
+    settings.wifi_gateway        = "";
+    settings.wifi_subnet         = "";
+    settings.wifi_dns            = "";
+    settings.elegooip            = "";
+    settings.pause_on_runout     = true;
+    settings.pause_escalation    = true;
+    settings.pause_escalation_stop = false;
+    settings.start_print_timeout = 10000;
+    settings.enabled             = true;
+    settings.has_connected       = false;
+    settings.expected_deficit_mm      = 8.4f;
+    settings.expected_flow_window_ms  = 1500;
+    settings.sdcp_loss_behavior       = 2;
+    settings.flow_telemetry_stale_ms  = 1000;
+    settings.ui_refresh_interval_ms   = 1000;
+    settings.zero_deficit_logging           = false;
+    settings.use_total_extrusion_deficit    = false;
+    settings.total_vs_delta_logging         = false;
+    settings.packet_flow_logging            = false;
+    settings.use_total_extrusion_backlog    = false;
+    settings.dev_mode                       = false;
+    settings.verbose_logging          = false;
+    settings.flow_summary_logging     = false;
+    settings.movement_mm_per_pulse    = DETECTION_PROFILE_DEFAULT_MM_PER_PULSE;
+    settings.movement_min_edge_us     = 2000;
+    settings.flash_logging            = false;
+    settings.syslog_host              = "";
+    settings.syslog_port              = 514;
+    settings.syslog_level             = 2;
+    settings.detection_profile        = "";
+    settings.notify_url               = "";
+    settings.notify_template          = "";
+    settings.notify_events            = NOTIFY_DEFAULT_EVENTS;
+}
+
+void settingsFromJson(const JsonDocument &doc, user_settings &settings)
+{
+    settings.ap_mode             = doc["ap_mode"] | false;
+    settings.ssid                = doc["ssid"] | "";
+    settings.passwd              = doc["passwd"] | "";
+    settings.wifi_static_ip      = doc["wifi_static_ip"] | "";
+    settings.wifi_gateway        = doc["wifi_gateway"] | "";
+    settings.wifi_subnet         = doc["wifi_subnet"] | "";
+    settings.wifi_dns            = doc["wifi_dns"] | "";
+    settings.elegooip            = doc["elegooip"] | "";
+    settings.pause_on_runout     = doc["pause_on_runout"] | true;
+    settings.pause_escalation    = doc["pause_escalation"] | true;
+    settings.pause_escalation_stop = doc["pause_escalation_stop"] | false;
+    settings.enabled             = doc["enabled"] | true;
+    settings.start_print_timeout = doc["start_print_timeout"] | 10000;
+    settings.has_connected       = doc["has_connected"] | false;
+    settings.expected_deficit_mm =
+        doc.containsKey("expected_deficit_mm") ? doc["expected_deficit_mm"].as<float>() : 8.4f;
+    settings.expected_flow_window_ms =
+        doc.containsKey("expected_flow_window_ms") ? doc["expected_flow_window_ms"].as<int>()
+                                                   : 1500;
+    settings.sdcp_loss_behavior =
+        doc.containsKey("sdcp_loss_behavior") ? doc["sdcp_loss_behavior"].as<int>() : 2;
+    settings.flow_telemetry_stale_ms =
+        doc.containsKey("flow_telemetry_stale_ms")
+            ? doc["flow_telemetry_stale_ms"].as<int>()
+            : 1000;
+    settings.ui_refresh_interval_ms =
+        doc.containsKey("ui_refresh_interval_ms")
+            ? doc["ui_refresh_interval_ms"].as<int>()
+            : 1000;
+    settings.zero_deficit_logging =
+        doc.containsKey("zero_deficit_logging")
+            ? doc["zero_deficit_logging"].as<bool>()
+            : false;
+    settings.use_total_extrusion_deficit =
+        doc.containsKey("use_total_extrusion_deficit")
+            ? doc["use_total_extrusion_deficit"].as<bool>()
+            : false;
+    settings.total_vs_delta_logging =
+        doc.containsKey("total_vs_delta_logging")
+            ? doc["total_vs_delta_logging"].as<bool>()
+            : false;
+    settings.packet_flow_logging =
+        doc.containsKey("packet_flow_logging")
+            ? doc["packet_flow_logging"].as<bool>()
+            : false;
+    settings.use_total_extrusion_backlog =
+        doc.containsKey("use_total_extrusion_backlog")
+            ? doc["use_total_extrusion_backlog"].as<bool>()
+            : false;
+    settings.dev_mode =
+        doc.containsKey("dev_mode") ? doc["dev_mode"].as<bool>() : false;
+    settings.verbose_logging = doc.containsKey("verbose_logging")
+                                   ? doc["verbose_logging"].as<bool>()
+                                   : false;
+    settings.flow_summary_logging = doc.containsKey("flow_summary_logging")
+                                        ? doc["flow_summary_logging"].as<bool>()
+                                        : false;
+    settings.movement_mm_per_pulse = doc.containsKey("movement_mm_per_pulse")
+                                         ? doc["movement_mm_per_pulse"].as<float>()
+                                         : DETECTION_PROFILE_DEFAULT_MM_PER_PULSE;
+    settings.movement_min_edge_us = doc.containsKey("movement_min_edge_us")
+                                        ? doc["movement_min_edge_us"].as<int>()
+                                        : 2000;
+    settings.flash_logging = doc.containsKey("flash_logging")
+                                 ? doc["flash_logging"].as<bool>()
+                                 : false;
+    settings.syslog_host  = doc["syslog_host"] | "";
+    settings.syslog_port  = doc.containsKey("syslog_port") ? doc["syslog_port"].as<int>() : 514;
+    settings.syslog_level = doc.containsKey("syslog_level") ? doc["syslog_level"].as<int>() : 2;
+    settings.detection_profile = doc["detection_profile"] | "";
+    settings.notify_url        = doc["notify_url"] | "";
+    settings.notify_template   = doc["notify_template"] | "";
+    settings.notify_events     = doc.containsKey("notify_events")
+                                     ? doc["notify_events"].as<int>()
+                                     : NOTIFY_DEFAULT_EVENTS;
+}
+
+void settingsToJson(const user_settings &settings, const DetectionProfiles &profiles,
+                    JsonDocument &doc, bool includePassword)
+{
+    doc["ap_mode"]             = settings.ap_mode;
+    doc["ssid"]                = settings.ssid;
+    doc["wifi_static_ip"]      = settings.wifi_static_ip;
+    doc["wifi_gateway"]        = settings.wifi_gateway;
+    doc["wifi_subnet"]         = settings.wifi_subnet;
+    doc["wifi_dns"]            = settings.wifi_dns;
+    doc["elegooip"]            = settings.elegooip;
+    doc["pause_on_runout"]     = settings.pause_on_runout;
+    doc["pause_escalation"]    = settings.pause_escalation;
+    doc["pause_escalation_stop"] = settings.pause_escalation_stop;
+    doc["start_print_timeout"] = settings.start_print_timeout;
+    doc["enabled"]             = settings.enabled;
+    doc["has_connected"]       = settings.has_connected;
+    doc["expected_deficit_mm"] = settings.expected_deficit_mm;
+    doc["expected_flow_window_ms"] = settings.expected_flow_window_ms;
+    doc["sdcp_loss_behavior"]  = settings.sdcp_loss_behavior;
+    doc["flow_telemetry_stale_ms"] = settings.flow_telemetry_stale_ms;
+    doc["ui_refresh_interval_ms"]  = settings.ui_refresh_interval_ms;
+    doc["zero_deficit_logging"]    = settings.zero_deficit_logging;
+    doc["use_total_extrusion_deficit"] = settings.use_total_extrusion_deficit;
+    doc["total_vs_delta_logging"] = settings.total_vs_delta_logging;
+    doc["packet_flow_logging"] = settings.packet_flow_logging;
+    doc["use_total_extrusion_backlog"] = settings.use_total_extrusion_backlog;
+    doc["dev_mode"]              = settings.dev_mode;
+    doc["verbose_logging"]       = settings.verbose_logging;
+    doc["flow_summary_logging"]  = settings.flow_summary_logging;
+    doc["movement_mm_per_pulse"] = settings.movement_mm_per_pulse;
+    doc["movement_min_edge_us"]  = settings.movement_min_edge_us;
+    doc["flash_logging"]         = settings.flash_logging;
+    doc["syslog_host"]           = settings.syslog_host;
+    doc["syslog_port"]           = settings.syslog_port;
+    doc["syslog_level"]          = settings.syslog_level;
+    doc["detection_profile"]     = settings.detection_profile;
+    doc["notify_url"]            = settings.notify_url;
+    doc["notify_template"]       = settings.notify_template;
+    doc["notify_events"]         = settings.notify_events;
+
+    JsonArray entries = doc.createNestedArray("detection_profiles");
+    for (size_t i = 0; i < profiles.count(); i++)
+    {
+        const detection_profile_t &profile = profiles.get(i);
+        JsonObject                 entry   = entries.createNestedObject();
+        entry["name"]                    = profile.name;
+        entry["match"]                   = profile.match;
+        entry["expected_deficit_mm"]     = profile.expectedDeficitMm;
+        entry["expected_flow_window_ms"] = profile.flowWindowMs;
+        entry["movement_mm_per_pulse"]   = profile.mmPerPulse;
+    }
+
+    if (includePassword)
+    {
+        doc["passwd"] = settings.passwd;
+    }
+}
+
+size_t detectionProfilesFromJson(JsonArrayConst entries, const user_settings &settings,
+                                 DetectionProfiles &profiles)
+{
+    size_t skipped = 0;
+    profiles.clear();
+    for (JsonObjectConst profile : entries)
+    {
+        const char *name = profile["name"] | "";
+        if (name[0] == '\0')
+        {
+            continue;
+        }
+        if (!profiles.add(name, profile["match"] | "",
+                          profile["expected_deficit_mm"] | settings.expected_deficit_mm,
+                          profile["expected_flow_window_ms"] |
+                              (uint32_t) settings.expected_flow_window_ms,
+                          profile["movement_mm_per_pulse"] | settings.movement_mm_per_pulse))
+        {
+            skipped++;
+        }
+    }
+    return skipped;
+}
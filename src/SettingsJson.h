@@ -0,0 +1,70 @@
+#ifndef SETTINGS_JSON_H
+#define SETTINGS_JSON_H
+
+#include <ArduinoJson.h>
+
+#include "DetectionProfile.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+typedef String settings_string_t;
+#else
+#include <string>
+typedef std::string settings_string_t;
+#endif
+
+struct user_settings
+{
+    settings_string_t ssid;
+    settings_string_t passwd;
+    bool              ap_mode;
+    settings_string_t wifi_static_ip;  // empty uses DHCP
+    settings_string_t wifi_gateway;
+    settings_string_t wifi_subnet;
+    settings_string_t wifi_dns;  // empty uses the gateway
+    settings_string_t elegooip;
+    bool              pause_on_runout;
+    bool              pause_escalation;       // re-pause if a pause doesn't take
+    bool              pause_escalation_stop;  // then stop feeding and stop the print
+    int               start_print_timeout;
+    bool              enabled;
+    bool              has_connected;
+    float             expected_deficit_mm;
+    int               expected_flow_window_ms;
+    int               sdcp_loss_behavior;
+    int               flow_telemetry_stale_ms;
+    int               ui_refresh_interval_ms;
+    bool              zero_deficit_logging;
+    bool              use_total_extrusion_deficit;
+    bool              total_vs_delta_logging;
+    bool              packet_flow_logging;
+    bool              use_total_extrusion_backlog;
+    bool              dev_mode;
+    bool              verbose_logging;
+    bool              flow_summary_logging;
+    float             movement_mm_per_pulse;
+    int               movement_min_edge_us;  // sensor edges closer than this are bounce
+    bool              flash_logging;
+    settings_string_t syslog_host;
+    int               syslog_port;
+    int               syslog_level;
+    settings_string_t detection_profile;  // forced profile name; empty picks one per job
+    settings_string_t notify_url;         // webhook; empty disables notifications
+    settings_string_t notify_template;    // webhook body; empty uses NotifyQueue::DEFAULT_TEMPLATE
+    int               notify_events;      // NOTIFY_BIT() mask of the events to send
+};
+
+// The /user_settings.json mapping, kept free of the filesystem and logger so
+// the host benches time the same code the device runs.
+void settingsDefaults(user_settings &settings);
+// Missing keys take their defaults.
+void settingsFromJson(const JsonDocument &doc, user_settings &settings);
+void settingsToJson(const user_settings &settings, const DetectionProfiles &profiles,
+                    JsonDocument &doc, bool includePassword);
+// Replaces the named profiles. Entries without a name are ignored; fields
+// missing from an entry come from the global detection settings. Returns
+// how many named entries were skipped as duplicates or over the limit.
+size_t detectionProfilesFromJson(JsonArrayConst entries, const user_settings &settings,
+                                 DetectionProfiles &profiles);
+
+#endif  // SETTINGS_JSON_H
@@ -5,7 +5,9 @@
 #include <LittleFS.h>
 #include <stdlib.h>
 
+#include "EventBus.h"
 #include "Logger.h"
+#include "TimeService.h"
 
 SettingsManager &SettingsManager::getInstance()
 {
@@ -16,30 +18,9 @@ SettingsManager &SettingsManager::getInstance()
 SettingsManager::SettingsManager()
 {
     isLoaded                     = false;
-    requestWifiReconnect         = false;
-    wifiChanged                  = false;
-    settings.ap_mode             = false;
-    settings.ssid                = "";
-    settings.passwd              = "";
-    settings.elegooip            = "";
-    settings.pause_on_runout     = true;
-    settings.start_print_timeout = 10000;
-    settings.enabled             = true;
-    settings.has_connected       = false;
-    settings.expected_deficit_mm      = 8.4f;
-    settings.expected_flow_window_ms  = 1500;
-    settings.sdcp_loss_behavior       = 2;
-    settings.flow_telemetry_stale_ms  = 1000;
-    settings.ui_refresh_interval_ms   = 1000;
-    settings.zero_deficit_logging           = false;
-    settings.use_total_extrusion_deficit    = false;
-    settings.total_vs_delta_logging         = false;
-    settings.packet_flow_logging            = false;
-    settings.use_total_extrusion_backlog    = false;
-    settings.dev_mode                       = false;
-    settings.verbose_logging          = false;
-    settings.flow_summary_logging     = false;
-    settings.movement_mm_per_pulse    = 1.5f;
+    pendingChanges               = 0;
+    profilesMux                  = portMUX_INITIALIZER_UNLOCKED;
+    settingsDefaults(settings);
 }
 
 bool SettingsManager::load()
@@ -49,81 +30,73 @@ bool SettingsManager::load()
     {
         logger.log("Settings file not found, using defaults");
         isLoaded = true;
+        applyLogCategories();
+        applyDetectionProfiles();
         return false;
     }
 
-    StaticJsonDocument<1024> doc;
-    DeserializationError     error = deserializeJson(doc, file);
+    // On the heap: the webhook template alone can take 512 bytes
+    DynamicJsonDocument  doc(4096);
+    DeserializationError error = deserializeJson(doc, file);
     file.close();
 
     if (error)
     {
         logger.log("Settings JSON parsing error, using defaults");
         isLoaded = true;
+        applyLogCategories();
+        applyDetectionProfiles();
         return false;
     }
 
-    settings.ap_mode             = doc["ap_mode"] | false;
-    settings.ssid                = doc["ssid"] | "";
-    settings.passwd              = doc["passwd"] | "";
-    settings.elegooip            = doc["elegooip"] | "";
-    settings.pause_on_runout     = doc["pause_on_runout"] | true;
-    settings.enabled             = doc["enabled"] | true;
-    settings.start_print_timeout = doc["start_print_timeout"] | 10000;
-    settings.has_connected       = doc["has_connected"] | false;
-    settings.expected_deficit_mm =
-        doc.containsKey("expected_deficit_mm") ? doc["expected_deficit_mm"].as<float>() : 8.4f;
-    settings.expected_flow_window_ms =
-        doc.containsKey("expected_flow_window_ms") ? doc["expected_flow_window_ms"].as<int>()
-                                                   : 1500;
-    settings.sdcp_loss_behavior =
-        doc.containsKey("sdcp_loss_behavior") ? doc["sdcp_loss_behavior"].as<int>() : 2;
-    settings.flow_telemetry_stale_ms =
-        doc.containsKey("flow_telemetry_stale_ms")
-            ? doc["flow_telemetry_stale_ms"].as<int>()
-            : 1000;
-    settings.ui_refresh_interval_ms =
-        doc.containsKey("ui_refresh_interval_ms")
-            ? doc["ui_refresh_interval_ms"].as<int>()
-            : 1000;
-    settings.zero_deficit_logging =
-        doc.containsKey("zero_deficit_logging")
-            ? doc["zero_deficit_logging"].as<bool>()
-            : false;
-    settings.use_total_extrusion_deficit =
-        doc.containsKey("use_total_extrusion_deficit")
-            ? doc["use_total_extrusion_deficit"].as<bool>()
-            : false;
-    settings.total_vs_delta_logging =
-        doc.containsKey("total_vs_delta_logging")
-            ? doc["total_vs_delta_logging"].as<bool>()
-            : false;
-    settings.packet_flow_logging =
-        doc.containsKey("packet_flow_logging")
-            ? doc["packet_flow_logging"].as<bool>()
-            : false;
-    settings.use_total_extrusion_backlog =
-        doc.containsKey("use_total_extrusion_backlog")
-            ? doc["use_total_extrusion_backlog"].as<bool>()
-            : false;
-    settings.dev_mode =
-        doc.containsKey("dev_mode") ? doc["dev_mode"].as<bool>() : false;
-    settings.verbose_logging = doc.containsKey("verbose_logging")
-                                   ? doc["verbose_logging"].as<bool>()
-                                   : false;
-    settings.flow_summary_logging = doc.containsKey("flow_summary_logging")
-                                        ? doc["flow_summary_logging"].as<bool>()
-                                        : false;
-    settings.movement_mm_per_pulse = doc.containsKey("movement_mm_per_pulse")
-                                         ? doc["movement_mm_per_pulse"].as<float>()
-                                         : 1.5f;
+    settingsFromJson(doc, settings);
+    setDetectionProfiles(doc["detection_profiles"].as<JsonArrayConst>());
 
     isLoaded = true;
+    applyLogCategories();
+    applyDetectionProfiles();
     return true;
 }
 
+void SettingsManager::applyLogCategories()
+{
+    uint32_t mask = LOG_CATEGORY_BIT(LOG_CAT_GENERAL);
+    if (settings.verbose_logging)
+        mask |= LOG_CATEGORY_BIT(LOG_CAT_FLOW);
+    if (settings.flow_summary_logging)
+        mask |= LOG_CATEGORY_BIT(LOG_CAT_FLOW_SUMMARY);
+    if (settings.packet_flow_logging)
+        mask |= LOG_CATEGORY_BIT(LOG_CAT_PACKET);
+    if (settings.total_vs_delta_logging)
+        mask |= LOG_CATEGORY_BIT(LOG_CAT_TELEMETRY_COMPARE);
+    if (settings.zero_deficit_logging)
+        mask |= LOG_CATEGORY_BIT(LOG_CAT_DEFICIT_RESET);
+    logCategoryMask = mask;
+}
+
+void SettingsManager::applyDetectionProfiles()
+{
+    DetectionProfiles next = getDetectionProfiles();
+    next.setDefault(settings.expected_deficit_mm, (uint32_t) settings.expected_flow_window_ms,
+                    settings.movement_mm_per_pulse);
+    if (settings.detection_profile.length() > 0 &&
+        !next.selectByName(settings.detection_profile.c_str()))
+    {
+        logger.logf("Detection profile %s not found, keeping %s",
+                    settings.detection_profile.c_str(), next.active().name);
+    }
+    portENTER_CRITICAL(&profilesMux);
+    detectionProfiles = next;
+    portEXIT_CRITICAL(&profilesMux);
+}
+
 bool SettingsManager::save(bool skipWifiCheck)
 {
+    // Setters only touch the struct; logging and detection follow once
+    // changes are saved.
+    applyLogCategories();
+    applyDetectionProfiles();
+
     String output = toJson(true);
 
     File file = LittleFS.open("/user_settings.json", "w");
@@ -142,11 +115,22 @@ bool SettingsManager::save(bool skipWifiCheck)
 
     file.close();
     logger.log("Settings saved successfully");
-    if (!skipWifiCheck && wifiChanged)
+    if (skipWifiCheck)
     {
-        logger.log("WiFi changed, requesting reconnection");
-        requestWifiReconnect = true;
-        wifiChanged          = false;
+        pendingChanges &= ~SETTINGS_CHANGED_WIFI;
+    }
+    if (pendingChanges != 0)
+    {
+        if (pendingChanges & SETTINGS_CHANGED_WIFI)
+        {
+            logger.log("WiFi changed, requesting reconnection");
+        }
+        event_t event                      = {};
+        event.type                         = EVENT_SETTINGS_CHANGED;
+        event.timestampUs                  = timeService.nowUs();
+        event.data.settingsChanged.changed = pendingChanges;
+        eventBus.publish(event);
+        pendingChanges = 0;
     }
     return true;
 }
@@ -175,6 +159,26 @@ bool SettingsManager::isAPMode()
     return getSettings().ap_mode;
 }
 
+String SettingsManager::getWifiStaticIp()
+{
+    return getSettings().wifi_static_ip;
+}
+
+String SettingsManager::getWifiGateway()
+{
+    return getSettings().wifi_gateway;
+}
+
+String SettingsManager::getWifiSubnet()
+{
+    return getSettings().wifi_subnet;
+}
+
+String SettingsManager::getWifiDns()
+{
+    return getSettings().wifi_dns;
+}
+
 String SettingsManager::getElegooIP()
 {
     return getSettings().elegooip;
@@ -185,6 +189,16 @@ bool SettingsManager::getPauseOnRunout()
     return getSettings().pause_on_runout;
 }
 
+bool SettingsManager::getPauseEscalation()
+{
+    return getSettings().pause_escalation;
+}
+
+bool SettingsManager::getPauseEscalationStop()
+{
+    return getSettings().pause_escalation_stop;
+}
+
 int SettingsManager::getStartPrintTimeout()
 {
     return getSettings().start_print_timeout;
@@ -268,6 +282,76 @@ float SettingsManager::getMovementMmPerPulse()
     return getSettings().movement_mm_per_pulse;
 }
 
+int SettingsManager::getMovementMinEdgeUs()
+{
+    return getSettings().movement_min_edge_us;
+}
+
+bool SettingsManager::getFlashLogging()
+{
+    return getSettings().flash_logging;
+}
+
+String SettingsManager::getSyslogHost()
+{
+    return getSettings().syslog_host;
+}
+
+int SettingsManager::getSyslogPort()
+{
+    return getSettings().syslog_port;
+}
+
+int SettingsManager::getSyslogLevel()
+{
+    return getSettings().syslog_level;
+}
+
+String SettingsManager::getDetectionProfile()
+{
+    return getSettings().detection_profile;
+}
+
+String SettingsManager::getNotifyUrl()
+{
+    return getSettings().notify_url;
+}
+
+String SettingsManager::getNotifyTemplate()
+{
+    return getSettings().notify_template;
+}
+
+int SettingsManager::getNotifyEvents()
+{
+    return getSettings().notify_events;
+}
+
+detection_profile_t SettingsManager::getActiveProfile()
+{
+    portENTER_CRITICAL(&profilesMux);
+    detection_profile_t profile = detectionProfiles.active();
+    portEXIT_CRITICAL(&profilesMux);
+    return profile;
+}
+
+DetectionProfiles SettingsManager::getDetectionProfiles()
+{
+    portENTER_CRITICAL(&profilesMux);
+    DetectionProfiles profiles = detectionProfiles;
+    portEXIT_CRITICAL(&profilesMux);
+    return profiles;
+}
+
+detection_profile_t SettingsManager::selectProfileForJob(const char *filename)
+{
+    String forcedName = getSettings().detection_profile;
+    portENTER_CRITICAL(&profilesMux);
+    detection_profile_t profile = detectionProfiles.selectForJob(forcedName.c_str(), filename);
+    portEXIT_CRITICAL(&profilesMux);
+    return profile;
+}
+
 void SettingsManager::setSSID(const String &ssid)
 {
     if (!isLoaded)
@@ -275,7 +359,7 @@ void SettingsManager::setSSID(const String &ssid)
     if (settings.ssid != ssid)
     {
         settings.ssid = ssid;
-        wifiChanged   = true;
+        pendingChanges |= SETTINGS_CHANGED_WIFI;
     }
 }
 
@@ -286,7 +370,7 @@ void SettingsManager::setPassword(const String &password)
     if (settings.passwd != password)
     {
         settings.passwd = password;
-        wifiChanged     = true;
+        pendingChanges |= SETTINGS_CHANGED_WIFI;
     }
 }
 
@@ -297,7 +381,51 @@ void SettingsManager::setAPMode(bool apMode)
     if (settings.ap_mode != apMode)
     {
         settings.ap_mode = apMode;
-        wifiChanged      = true;
+        pendingChanges |= SETTINGS_CHANGED_WIFI;
+    }
+}
+
+void SettingsManager::setWifiStaticIp(const String &ip)
+{
+    if (!isLoaded)
+        load();
+    if (settings.wifi_static_ip != ip)
+    {
+        settings.wifi_static_ip = ip;
+        pendingChanges |= SETTINGS_CHANGED_WIFI;
+    }
+}
+
+void SettingsManager::setWifiGateway(const String &gateway)
+{
+    if (!isLoaded)
+        load();
+    if (settings.wifi_gateway != gateway)
+    {
+        settings.wifi_gateway = gateway;
+        pendingChanges |= SETTINGS_CHANGED_WIFI;
+    }
+}
+
+void SettingsManager::setWifiSubnet(const String &subnet)
+{
+    if (!isLoaded)
+        load();
+    if (settings.wifi_subnet != subnet)
+    {
+        settings.wifi_subnet = subnet;
+        pendingChanges |= SETTINGS_CHANGED_WIFI;
+    }
+}
+
+void SettingsManager::setWifiDns(const String &dns)
+{
+    if (!isLoaded)
+        load();
+    if (settings.wifi_dns != dns)
+    {
+        settings.wifi_dns = dns;
+        pendingChanges |= SETTINGS_CHANGED_WIFI;
     }
 }
 
@@ -305,7 +433,11 @@ void SettingsManager::setElegooIP(const String &ip)
 {
     if (!isLoaded)
         load();
-    settings.elegooip = ip;
+    if (settings.elegooip != ip)
+    {
+        settings.elegooip = ip;
+        pendingChanges |= SETTINGS_CHANGED_PRINTER_IP;
+    }
 }
 
 void SettingsManager::setPauseOnRunout(bool pauseOnRunout)
@@ -315,6 +447,20 @@ void SettingsManager::setPauseOnRunout(bool pauseOnRunout)
     settings.pause_on_runout = pauseOnRunout;
 }
 
+void SettingsManager::setPauseEscalation(bool pauseEscalation)
+{
+    if (!isLoaded)
+        load();
+    settings.pause_escalation = pauseEscalation;
+}
+
+void SettingsManager::setPauseEscalationStop(bool pauseEscalationStop)
+{
+    if (!isLoaded)
+        load();
+    settings.pause_escalation_stop = pauseEscalationStop;
+}
+
 void SettingsManager::setStartPrintTimeout(int timeoutMs)
 {
     if (!isLoaded)
@@ -340,14 +486,22 @@ void SettingsManager::setExpectedDeficitMM(float value)
 {
     if (!isLoaded)
         load();
-    settings.expected_deficit_mm = value;
+    if (settings.expected_deficit_mm != value)
+    {
+        settings.expected_deficit_mm = value;
+        pendingChanges |= SETTINGS_CHANGED_DETECTION;
+    }
 }
 
 void SettingsManager::setExpectedFlowWindowMs(int windowMs)
 {
     if (!isLoaded)
         load();
-    settings.expected_flow_window_ms = windowMs;
+    if (settings.expected_flow_window_ms != windowMs)
+    {
+        settings.expected_flow_window_ms = windowMs;
+        pendingChanges |= SETTINGS_CHANGED_DETECTION;
+    }
 }
 
 void SettingsManager::setSdcpLossBehavior(int behavior)
@@ -430,41 +584,136 @@ void SettingsManager::setMovementMmPerPulse(float mmPerPulse)
 {
     if (!isLoaded)
         load();
-    settings.movement_mm_per_pulse = mmPerPulse;
+    if (settings.movement_mm_per_pulse != mmPerPulse)
+    {
+        settings.movement_mm_per_pulse = mmPerPulse;
+        pendingChanges |= SETTINGS_CHANGED_DETECTION;
+    }
 }
 
-String SettingsManager::toJson(bool includePassword)
+void SettingsManager::setMovementMinEdgeUs(int intervalUs)
 {
-    String                   output;
-    StaticJsonDocument<1024> doc;
-
-    doc["ap_mode"]             = settings.ap_mode;
-    doc["ssid"]                = settings.ssid;
-    doc["elegooip"]            = settings.elegooip;
-    doc["pause_on_runout"]     = settings.pause_on_runout;
-    doc["start_print_timeout"] = settings.start_print_timeout;
-    doc["enabled"]             = settings.enabled;
-    doc["has_connected"]       = settings.has_connected;
-    doc["expected_deficit_mm"] = settings.expected_deficit_mm;
-    doc["expected_flow_window_ms"] = settings.expected_flow_window_ms;
-    doc["sdcp_loss_behavior"]  = settings.sdcp_loss_behavior;
-    doc["flow_telemetry_stale_ms"] = settings.flow_telemetry_stale_ms;
-    doc["ui_refresh_interval_ms"]  = settings.ui_refresh_interval_ms;
-    doc["zero_deficit_logging"]    = settings.zero_deficit_logging;
-    doc["use_total_extrusion_deficit"] = settings.use_total_extrusion_deficit;
-    doc["total_vs_delta_logging"] = settings.total_vs_delta_logging;
-    doc["packet_flow_logging"] = settings.packet_flow_logging;
-    doc["use_total_extrusion_backlog"] = settings.use_total_extrusion_backlog;
-    doc["dev_mode"]              = settings.dev_mode;
-    doc["verbose_logging"]       = settings.verbose_logging;
-    doc["flow_summary_logging"]  = settings.flow_summary_logging;
-    doc["movement_mm_per_pulse"] = settings.movement_mm_per_pulse;
-
-    if (includePassword)
+    if (!isLoaded)
+        load();
+    if (settings.movement_min_edge_us != intervalUs)
+    {
+        settings.movement_min_edge_us = intervalUs;
+        pendingChanges |= SETTINGS_CHANGED_SENSOR;
+    }
+}
+
+void SettingsManager::setFlashLogging(bool enabled)
+{
+    if (!isLoaded)
+        load();
+    if (settings.flash_logging != enabled)
+    {
+        settings.flash_logging = enabled;
+        pendingChanges |= SETTINGS_CHANGED_FLASH_LOG;
+    }
+}
+
+void SettingsManager::setSyslogHost(const String &host)
+{
+    if (!isLoaded)
+        load();
+    if (settings.syslog_host != host)
+    {
+        settings.syslog_host = host;
+        pendingChanges |= SETTINGS_CHANGED_SYSLOG;
+    }
+}
+
+void SettingsManager::setSyslogPort(int port)
+{
+    if (!isLoaded)
+        load();
+    if (settings.syslog_port != port)
     {
-        doc["passwd"] = settings.passwd;
+        settings.syslog_port = port;
+        pendingChanges |= SETTINGS_CHANGED_SYSLOG;
     }
+}
+
+void SettingsManager::setSyslogLevel(int level)
+{
+    if (!isLoaded)
+        load();
+    if (settings.syslog_level != level)
+    {
+        settings.syslog_level = level;
+        pendingChanges |= SETTINGS_CHANGED_SYSLOG;
+    }
+}
+
+void SettingsManager::setNotifyUrl(const String &url)
+{
+    if (!isLoaded)
+        load();
+    if (settings.notify_url != url)
+    {
+        settings.notify_url = url;
+        pendingChanges |= SETTINGS_CHANGED_NOTIFY;
+    }
+}
+
+void SettingsManager::setNotifyTemplate(const String &bodyTemplate)
+{
+    if (!isLoaded)
+        load();
+    if (settings.notify_template != bodyTemplate)
+    {
+        settings.notify_template = bodyTemplate;
+        pendingChanges |= SETTINGS_CHANGED_NOTIFY;
+    }
+}
+
+void SettingsManager::setNotifyEvents(int mask)
+{
+    if (!isLoaded)
+        load();
+    if (settings.notify_events != mask)
+    {
+        settings.notify_events = mask;
+        pendingChanges |= SETTINGS_CHANGED_NOTIFY;
+    }
+}
+
+void SettingsManager::setDetectionProfile(const String &name)
+{
+    if (!isLoaded)
+        load();
+    String forcedName = name == DetectionProfiles::DEFAULT_NAME ? String("") : name;
+    if (settings.detection_profile != forcedName)
+    {
+        settings.detection_profile = forcedName;
+        pendingChanges |= SETTINGS_CHANGED_DETECTION;
+    }
+}
+
+void SettingsManager::setDetectionProfiles(JsonArrayConst profiles)
+{
+    DetectionProfiles next    = getDetectionProfiles();
+    size_t            skipped = detectionProfilesFromJson(profiles, settings, next);
+    portENTER_CRITICAL(&profilesMux);
+    detectionProfiles = next;
+    portEXIT_CRITICAL(&profilesMux);
+    pendingChanges |= SETTINGS_CHANGED_DETECTION;
+    if (skipped > 0)
+    {
+        logger.logf("%u detection profiles skipped (duplicate or limit of %u reached)",
+                    (unsigned) skipped, (unsigned) DetectionProfiles::MAX_PROFILES);
+    }
+}
+
+String SettingsManager::toJson(bool includePassword)
+{
+    String              output;
+    DynamicJsonDocument doc(4096);
+    // Outlives doc: profile names are stored by pointer
+    DetectionProfiles profiles = getDetectionProfiles();
 
+    settingsToJson(settings, profiles, doc, includePassword);
     serializeJson(doc, output);
     return output;
 }
@@ -1,54 +1,43 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include "DetectionProfile.h"
+#include "NotifyQueue.h"
+#include "SettingsJson.h"
+
 #ifndef SETTINGS_DATA_H
 #define SETTINGS_DATA_H
 
-struct user_settings
-{
-    String ssid;
-    String passwd;
-    bool   ap_mode;
-    String elegooip;
-    bool   pause_on_runout;
-    int    start_print_timeout;
-    bool   enabled;
-    bool   has_connected;
-    float  expected_deficit_mm;
-    int    expected_flow_window_ms;
-    int    sdcp_loss_behavior;
-    int    flow_telemetry_stale_ms;
-    int    ui_refresh_interval_ms;
-    bool   zero_deficit_logging;
-    bool   use_total_extrusion_deficit;
-    bool   total_vs_delta_logging;
-    bool   packet_flow_logging;
-    bool   use_total_extrusion_backlog;
-    bool   dev_mode;
-    bool   verbose_logging;
-    bool   flow_summary_logging;
-    float  movement_mm_per_pulse;
-};
-
 class SettingsManager
 {
    private:
     user_settings settings;
     bool          isLoaded;
-    bool          wifiChanged;
+    uint32_t      pendingChanges;  // SETTINGS_CHANGED_* bits published on save()
 
     SettingsManager();
 
     SettingsManager(const SettingsManager &)            = delete;
     SettingsManager &operator=(const SettingsManager &) = delete;
 
+    // Rebuilds the cached log category mask from the logging flags
+    void applyLogCategories();
+    // Refreshes the default profile from the global detection settings and
+    // re-applies a forced profile selection
+    void applyDetectionProfiles();
+
+    // Read by the loop while the web server edits settings; only ever
+    // replaced whole, under profilesMux
+    DetectionProfiles detectionProfiles;
+    portMUX_TYPE      profilesMux;
+
    public:
     static SettingsManager &getInstance();
 
-    // Flag to request WiFi reconnection with new credentials
-    bool requestWifiReconnect;
-
     bool load();
+    // Publishes EVENT_SETTINGS_CHANGED for WiFi, printer IP, syslog,
+    // notification, sensor filter, flash log and detection profile changes;
+    // skipWifiCheck leaves WiFi changes to the caller.
     bool save(bool skipWifiCheck = false);
 
     //  (loads if not already loaded)
@@ -57,8 +46,14 @@ class SettingsManager
     String getSSID();
     String getPassword();
     bool   isAPMode();
+    String getWifiStaticIp();
+    String getWifiGateway();
+    String getWifiSubnet();
+    String getWifiDns();
     String getElegooIP();
     bool   getPauseOnRunout();
+    bool   getPauseEscalation();
+    bool   getPauseEscalationStop();
     int    getStartPrintTimeout();
     bool   getEnabled();
     bool   getHasConnected();
@@ -76,12 +71,33 @@ class SettingsManager
     bool   getVerboseLogging();
     bool   getFlowSummaryLogging();
     float  getMovementMmPerPulse();
+    int    getMovementMinEdgeUs();
+    bool   getFlashLogging();
+    String getSyslogHost();
+    int    getSyslogPort();
+    int    getSyslogLevel();
+    String getDetectionProfile();
+    String getNotifyUrl();
+    String getNotifyTemplate();
+    int    getNotifyEvents();
+    // Copies, safe to take from any task
+    detection_profile_t getActiveProfile();
+    DetectionProfiles   getDetectionProfiles();
+    // Chooses the profile for a job, makes it the active one and returns a
+    // copy
+    detection_profile_t selectProfileForJob(const char *filename);
 
     void setSSID(const String &ssid);
     void setPassword(const String &password);
     void setAPMode(bool apMode);
+    void setWifiStaticIp(const String &ip);
+    void setWifiGateway(const String &gateway);
+    void setWifiSubnet(const String &subnet);
+    void setWifiDns(const String &dns);
     void setElegooIP(const String &ip);
     void setPauseOnRunout(bool pauseOnRunout);
+    void setPauseEscalation(bool pauseEscalation);
+    void setPauseEscalationStop(bool pauseEscalationStop);
     void setStartPrintTimeout(int timeoutMs);
     void setEnabled(bool enabled);
     void setHasConnected(bool hasConnected);
@@ -99,6 +115,17 @@ class SettingsManager
     void setVerboseLogging(bool verbose);
     void setFlowSummaryLogging(bool enabled);
     void setMovementMmPerPulse(float mmPerPulse);
+    void setMovementMinEdgeUs(int intervalUs);
+    void setFlashLogging(bool enabled);
+    void setSyslogHost(const String &host);
+    void setSyslogPort(int port);
+    void setSyslogLevel(int level);
+    void setDetectionProfile(const String &name);
+    void setNotifyUrl(const String &url);
+    void setNotifyTemplate(const String &bodyTemplate);
+    void setNotifyEvents(int mask);
+    // Replaces the named profiles; entries without a name are skipped
+    void setDetectionProfiles(JsonArrayConst profiles);
 
     String toJson(bool includePassword = true);
 };
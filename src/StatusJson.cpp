@@ -0,0 +1,34 @@
+#include "StatusJson.h"
+
+void sensorStatusToJson(const printer_info_t &info, int uiRefreshIntervalMs,
+                        int flowTelemetryStaleMs, const char *detectionProfile,
+                        JsonDocument &doc)
+{
+    doc["stopped"]        = info.filamentStopped;
+    doc["filamentRunout"] = info.filamentRunout;
+
+    doc["elegoo"]["mainboardID"]          = info.mainboardID;
+    doc["elegoo"]["printStatus"]          = (int) info.printStatus;
+    doc["elegoo"]["isPrinting"]           = info.isPrinting;
+    doc["elegoo"]["currentLayer"]         = info.currentLayer;
+    doc["elegoo"]["totalLayer"]           = info.totalLayer;
+    doc["elegoo"]["progress"]             = info.progress;
+    doc["elegoo"]["currentTicks"]         = info.currentTicks;
+    doc["elegoo"]["totalTicks"]           = info.totalTicks;
+    doc["elegoo"]["PrintSpeedPct"]        = info.PrintSpeedPct;
+    doc["elegoo"]["isWebsocketConnected"] = info.isWebsocketConnected;
+    doc["elegoo"]["currentZ"]             = info.currentZ;
+    doc["elegoo"]["expectedFilament"]     = info.expectedFilamentMM;
+    doc["elegoo"]["actualFilament"]       = info.actualFilamentMM;
+    doc["elegoo"]["expectedDelta"]        = info.lastExpectedDeltaMM;
+    doc["elegoo"]["telemetryAvailable"]   = info.telemetryAvailable;
+    doc["elegoo"]["currentDeficitMm"]     = info.currentDeficitMm;
+    doc["elegoo"]["deficitThresholdMm"]   = info.deficitThresholdMm;
+    doc["elegoo"]["deficitRatio"]         = info.deficitRatio;
+    doc["elegoo"]["movementPulses"]       = (uint32_t) info.movementPulseCount;
+    doc["elegoo"]["frameAgeMs"]           = info.frameAgeMs;
+    doc["elegoo"]["jobNumber"]            = info.jobNumber;
+    doc["elegoo"]["uiRefreshIntervalMs"]  = uiRefreshIntervalMs;
+    doc["elegoo"]["flowTelemetryStaleMs"] = flowTelemetryStaleMs;
+    doc["elegoo"]["detectionProfile"]     = detectionProfile;
+}
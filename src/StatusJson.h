@@ -0,0 +1,44 @@
+#ifndef STATUS_JSON_H
+#define STATUS_JSON_H
+
+#include <ArduinoJson.h>
+#include <stdint.h>
+
+#include "SdcpCodec.h"
+
+// Struct to hold current printer information
+typedef struct
+{
+    char                mainboardID[SDCP_ID_LENGTH];
+    sdcp_print_status_t printStatus;
+    bool                filamentStopped;
+    bool                filamentRunout;
+    int                 currentLayer;
+    int                 totalLayer;
+    int                 progress;
+    int                 currentTicks;
+    int                 totalTicks;
+    int                 PrintSpeedPct;
+    bool                isWebsocketConnected;
+    bool                isPrinting;
+    float               currentZ;
+    bool                waitingForAck;
+    float               expectedFilamentMM;
+    float               actualFilamentMM;
+    float               lastExpectedDeltaMM;
+    bool                telemetryAvailable;
+    float               currentDeficitMm;
+    float               deficitThresholdMm;
+    float               deficitRatio;
+    unsigned long       movementPulseCount;
+    uint32_t            frameAgeMs;  // estimated age of the last status frame
+    uint32_t            jobNumber;   // counts up per job seen since boot, 0 if none
+} printer_info_t;
+
+// Fills the /sensor_status document. The last three fields come from the
+// settings rather than the printer.
+void sensorStatusToJson(const printer_info_t &info, int uiRefreshIntervalMs,
+                        int flowTelemetryStaleMs, const char *detectionProfile,
+                        JsonDocument &doc);
+
+#endif  // STATUS_JSON_H
@@ -0,0 +1,84 @@
+#include "SyslogFormatter.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+uint8_t SyslogFormatter::severityFor(log_level_t level)
+{
+    switch (level)
+    {
+        case LOG_LEVEL_ERROR:
+            return 3;  // err
+        case LOG_LEVEL_WARN:
+            return 4;  // warning
+        case LOG_LEVEL_INFO:
+            return 6;  // informational
+        default:
+            return 7;  // debug
+    }
+}
+
+size_t SyslogFormatter::formatLine(char *out, size_t capacity, log_level_t level,
+                                   uint32_t epochSeconds, const char *hostname,
+                                   const char *appName, const char *message, size_t length)
+{
+    if (capacity == 0)
+    {
+        return 0;
+    }
+
+    char timestamp[24] = "-";
+    if (epochSeconds >= MIN_VALID_EPOCH)
+    {
+        time_t    seconds = (time_t) epochSeconds;
+        struct tm utc;
+        gmtime_r(&seconds, &utc);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    }
+
+    unsigned priority = FACILITY_LOCAL0 * 8 + severityFor(level);
+    int      header   = snprintf(out, capacity, "<%u>1 %s %s %s - - - ", priority, timestamp,
+                                 hostname, appName);
+    if (header < 0)
+    {
+        return 0;
+    }
+    size_t used = (size_t) header < capacity ? (size_t) header : capacity - 1;
+
+    size_t room = capacity - used;
+    if (length > room)
+    {
+        length = room;
+    }
+    // Embedded newlines would split the message at the collector.
+    for (size_t i = 0; i < length; i++)
+    {
+        char c        = message[i];
+        out[used + i] = (c == '\n' || c == '\r') ? ' ' : c;
+    }
+    return used + length;
+}
+
+bool SyslogDatagram::append(const char *line, size_t lineLength)
+{
+    size_t separator = length > 0 ? 1 : 0;
+    if (length + separator + lineLength > sizeof(buffer))
+    {
+        return false;
+    }
+    if (separator)
+    {
+        buffer[length++] = '\n';
+    }
+    memcpy(buffer + length, line, lineLength);
+    length += lineLength;
+    lines++;
+    return true;
+}
+
+void SyslogDatagram::clear()
+{
+    length = 0;
+    lines  = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef SYSLOG_FORMATTER_H
+#define SYSLOG_FORMATTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LogSink.h"
+
+// RFC 5424 message formatting and datagram packing for the UDP syslog sink.
+class SyslogFormatter
+{
+   public:
+    static const uint8_t FACILITY_LOCAL0 = 16;
+    // Stays under a 1500 byte Ethernet MTU after IP/UDP headers.
+    static const size_t MAX_DATAGRAM = 1400;
+    // Timestamps below this are uptime-based, not wall-clock.
+    static const uint32_t MIN_VALID_EPOCH = 1600000000UL;
+
+    static uint8_t severityFor(log_level_t level);
+
+    // Formats one message:
+    //   <PRI>1 TIMESTAMP HOSTNAME APP-NAME - - - MSG
+    // TIMESTAMP is the NILVALUE "-" until the clock has been set. Returns the
+    // number of bytes written (truncating the message to fit), not counting
+    // a terminator; none is written.
+    static size_t formatLine(char *out, size_t capacity, log_level_t level, uint32_t epochSeconds,
+                             const char *hostname, const char *appName, const char *message,
+                             size_t length);
+};
+
+// Packs several formatted lines into one datagram, newline separated.
+class SyslogDatagram
+{
+   public:
+    SyslogDatagram() : length(0), lines(0) {}
+
+    // Returns false, leaving the datagram unchanged, if the line does not fit.
+    bool append(const char *line, size_t lineLength);
+    void clear();
+
+    const char *data() const { return buffer; }
+    size_t      size() const { return length; }
+    uint32_t    lineCount() const { return lines; }
+
+   private:
+    char     buffer[SyslogFormatter::MAX_DATAGRAM];
+    size_t   length;
+    uint32_t lines;
+};
+
+#endif  // SYSLOG_FORMATTER_H
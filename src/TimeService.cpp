@@ -0,0 +1,99 @@
+#include "TimeService.h"
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+uint64_t TimeService::defaultClock()
+{
+#ifdef ARDUINO
+    return (uint64_t) esp_timer_get_time();
+#else
+    return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+TimeService &TimeService::getInstance()
+{
+    static TimeService instance;
+    return instance;
+}
+
+TimeService::TimeService(MonotonicClock monotonicClock)
+{
+    clock      = monotonicClock != nullptr ? monotonicClock : defaultClock;
+    offsetUs   = 0;
+    epochKnown = false;
+    syncCount  = 0;
+    lastStepUs = 0;
+#ifdef ARDUINO
+    mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+}
+
+// The 64-bit offset is written by the loop task and read by whichever task
+// exports a timestamp; a 32-bit CPU can't load it atomically.
+void TimeService::lock() const
+{
+#ifdef ARDUINO
+    portENTER_CRITICAL(&mux);
+#endif
+}
+
+void TimeService::unlock() const
+{
+#ifdef ARDUINO
+    portEXIT_CRITICAL(&mux);
+#endif
+}
+
+void TimeService::setEpoch(uint64_t epochUs, uint64_t atUs)
+{
+    int64_t offset = (int64_t) (epochUs - atUs);
+    lock();
+    lastStepUs = epochKnown ? offset - offsetUs : 0;
+    offsetUs   = offset;
+    epochKnown = true;
+    syncCount++;
+    unlock();
+}
+
+bool TimeService::hasEpoch() const
+{
+    lock();
+    bool known = epochKnown;
+    unlock();
+    return known;
+}
+
+uint64_t TimeService::toEpochUs(uint64_t monotonicUs) const
+{
+    lock();
+    bool    known  = epochKnown;
+    int64_t offset = offsetUs;
+    unlock();
+    return known ? monotonicUs + (uint64_t) offset : 0;
+}
+
+uint32_t TimeService::toEpochSeconds(uint64_t monotonicUs) const
+{
+    return (uint32_t) (toEpochUs(monotonicUs) / 1000000ULL);
+}
+
+bool TimeService::toMonotonicUs(uint64_t epochUs, uint64_t &monotonicUs) const
+{
+    lock();
+    bool    known  = epochKnown;
+    int64_t offset = offsetUs;
+    unlock();
+    if (!known)
+    {
+        return false;
+    }
+    monotonicUs = (int64_t) epochUs > offset ? epochUs - (uint64_t) offset : 0;
+    return true;
+}
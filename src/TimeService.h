@@ -0,0 +1,63 @@
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#endif
+
+// One time base for event and log timestamps: a 64-bit monotonic
+// microsecond clock that starts at boot and never jumps or wraps, plus an
+// offset to wall-clock time that is learned from NTP.
+//
+// Timestamps are stored as monotonic microseconds and converted with
+// toEpochUs()/toEpochSeconds() when they are exported, so an NTP sync (or
+// correction) changes how history is presented without rewriting it, and
+// lines logged before the first sync get real dates once it happens.
+class TimeService
+{
+   public:
+    typedef uint64_t (*MonotonicClock)();
+
+    explicit TimeService(MonotonicClock clock = defaultClock);
+
+    static TimeService &getInstance();
+
+    // esp_timer on the device: one register read, cheap enough per pulse
+    uint64_t nowUs() const { return clock(); }
+
+    // Records that wall-clock time was `epochUs` at monotonic time `atUs`
+    void setEpoch(uint64_t epochUs, uint64_t atUs);
+    bool hasEpoch() const;
+
+    // 0 when no epoch is known yet
+    uint64_t toEpochUs(uint64_t monotonicUs) const;
+    uint32_t toEpochSeconds(uint64_t monotonicUs) const;
+    // Inverse of toEpochUs(), for queries over stored timestamps; false when
+    // no epoch is known yet. Times before boot map to 0.
+    bool     toMonotonicUs(uint64_t epochUs, uint64_t &monotonicUs) const;
+
+    uint32_t getSyncCount() const { return syncCount; }
+    // How far the last sync moved the offset (positive: clock was behind)
+    int64_t  getLastStepUs() const { return lastStepUs; }
+
+    static uint64_t defaultClock();
+
+   private:
+    MonotonicClock clock;
+    int64_t        offsetUs;  // epoch minus monotonic
+    bool           epochKnown;
+    uint32_t       syncCount;
+    int64_t        lastStepUs;
+#ifdef ARDUINO
+    mutable portMUX_TYPE mux;
+#endif
+
+    void lock() const;
+    void unlock() const;
+};
+
+#define timeService TimeService::getInstance()
+
+#endif  // TIME_SERVICE_H
@@ -0,0 +1,191 @@
+#include "UdpSyslogSink.h"
+
+#include <WiFi.h>
+
+#include "Logger.h"
+#include "TimeService.h"
+
+#define SYSLOG_APP_NAME "sfs"
+
+UdpSyslogSink &UdpSyslogSink::getInstance()
+{
+    static UdpSyslogSink instance;
+    return instance;
+}
+
+UdpSyslogSink::UdpSyslogSink()
+{
+    queueBuffer   = nullptr;
+    queueMux      = portMUX_INITIALIZER_UNLOCKED;
+    senderTask    = nullptr;
+    host[0]       = '\0';
+    port          = 514;
+    strlcpy(hostname, "ccxsfs20", sizeof(hostname));
+    datagramsSent = 0;
+    linesSent     = 0;
+    sendErrors    = 0;
+}
+
+void UdpSyslogSink::setHostname(const char *deviceHostname)
+{
+    portENTER_CRITICAL(&queueMux);
+    strlcpy(hostname, deviceHostname, sizeof(hostname));
+    portEXIT_CRITICAL(&queueMux);
+}
+
+void UdpSyslogSink::configure(const String &collectorHost, uint16_t collectorPort,
+                              log_level_t level)
+{
+    portENTER_CRITICAL(&queueMux);
+    strlcpy(host, collectorHost.c_str(), sizeof(host));
+    port = collectorPort;
+    portEXIT_CRITICAL(&queueMux);
+    setMinLevel(level);
+
+    if (collectorHost.length() == 0 || senderTask != nullptr)
+    {
+        return;
+    }
+
+    queueBuffer = (uint8_t *) malloc(QUEUE_BYTES);
+    if (queueBuffer == nullptr)
+    {
+        logger.log("Syslog: failed to allocate queue");
+        return;
+    }
+    portENTER_CRITICAL(&queueMux);
+    queue.attach(queueBuffer, QUEUE_BYTES);
+    portEXIT_CRITICAL(&queueMux);
+
+    if (xTaskCreate(senderTaskEntry, "syslog_sink", 4096, this, tskIDLE_PRIORITY + 1,
+                    &senderTask) != pdPASS)
+    {
+        senderTask = nullptr;
+        logger.log("Syslog: failed to start sender task");
+        return;
+    }
+    logger.addSink(this);
+    logger.logf("Syslog: shipping logs to %s:%u", host, (unsigned) port);
+}
+
+bool UdpSyslogSink::enqueue(log_level_t level, uint64_t timestamp, const char *message,
+                            size_t length)
+{
+    portENTER_CRITICAL(&queueMux);
+    // With no collector configured lines are discarded, not counted as dropped.
+    bool queued = host[0] == '\0' ||
+                  queue.push((uint8_t) level, timestamp, millis(), message, length);
+    portEXIT_CRITICAL(&queueMux);
+    return queued;
+}
+
+void UdpSyslogSink::senderTaskEntry(void *arg)
+{
+    static_cast<UdpSyslogSink *>(arg)->senderLoop();
+}
+
+void UdpSyslogSink::senderLoop()
+{
+    while (true)
+    {
+        vTaskDelay(pdMS_TO_TICKS(POLL_MS));
+        if (WiFi.status() == WL_CONNECTED && flushDue())
+        {
+            flushQueue();
+        }
+    }
+}
+
+bool UdpSyslogSink::flushDue()
+{
+    LogQueue::Entry entry;
+    char            unused;
+    portENTER_CRITICAL(&queueMux);
+    bool   hasEntry = queue.peek(entry, &unused, 0);
+    size_t queued   = queue.usedBytes();
+    portEXIT_CRITICAL(&queueMux);
+
+    return hasEntry && (queued >= FLUSH_BYTES || millis() - entry.enqueuedMs >= MAX_DELAY_MS);
+}
+
+void UdpSyslogSink::flushQueue()
+{
+    static char message[LogQueue::MAX_MESSAGE_LENGTH];
+    static char line[SyslogFormatter::MAX_DATAGRAM];
+
+    // configure() may run on the web server task while this one sends.
+    char     target[HOST_LENGTH];
+    char     source[sizeof(hostname)];
+    uint16_t targetPort;
+    portENTER_CRITICAL(&queueMux);
+    memcpy(target, host, sizeof(target));
+    memcpy(source, hostname, sizeof(source));
+    targetPort = port;
+    portEXIT_CRITICAL(&queueMux);
+
+    datagram.clear();
+    while (true)
+    {
+        LogQueue::Entry entry;
+        portENTER_CRITICAL(&queueMux);
+        bool hasEntry = queue.peek(entry, message, sizeof(message));
+        portEXIT_CRITICAL(&queueMux);
+        if (!hasEntry)
+        {
+            break;
+        }
+
+        // Converted at send time so lines queued before NTP still get a date
+        size_t lineLength = SyslogFormatter::formatLine(
+            line, sizeof(line), (log_level_t) entry.level,
+            timeService.toEpochSeconds(entry.timestamp), source, SYSLOG_APP_NAME, message,
+            entry.length);
+        if (!datagram.append(line, lineLength))
+        {
+            sendDatagram(target, targetPort);
+            datagram.append(line, lineLength);
+        }
+
+        // Only this task removes entries, so the one peeked is still oldest.
+        portENTER_CRITICAL(&queueMux);
+        queue.pop();
+        portEXIT_CRITICAL(&queueMux);
+    }
+    sendDatagram(target, targetPort);
+}
+
+void UdpSyslogSink::sendDatagram(const char *target, uint16_t targetPort)
+{
+    if (datagram.size() == 0 || target[0] == '\0')
+    {
+        datagram.clear();
+        return;
+    }
+    if (udp.beginPacket(target, targetPort) && udp.write((const uint8_t *) datagram.data(),
+                                                 datagram.size()) == datagram.size() &&
+        udp.endPacket())
+    {
+        datagramsSent++;
+        linesSent += datagram.lineCount();
+    }
+    else
+    {
+        sendErrors++;
+    }
+    datagram.clear();
+}
+
+udp_syslog_stats_t UdpSyslogSink::getStats()
+{
+    udp_syslog_stats_t stats;
+    portENTER_CRITICAL(&queueMux);
+    stats.enabled     = senderTask != nullptr && host[0] != '\0';
+    stats.queuedBytes = queue.usedBytes();
+    stats.queuedLines = queue.count();
+    portEXIT_CRITICAL(&queueMux);
+    stats.datagramsSent = datagramsSent;
+    stats.linesSent     = linesSent;
+    stats.sendErrors    = sendErrors;
+    stats.dropped       = getDropped();
+    return stats;
+}
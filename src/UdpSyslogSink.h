@@ -0,0 +1,82 @@
+#ifndef UDP_SYSLOG_SINK_H
+#define UDP_SYSLOG_SINK_H
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+#include "LogQueue.h"
+#include "LogSink.h"
+#include "SyslogFormatter.h"
+
+typedef struct
+{
+    bool     enabled;
+    uint32_t queuedBytes;
+    uint32_t queuedLines;
+    uint32_t datagramsSent;
+    uint32_t linesSent;
+    uint32_t sendErrors;
+    uint32_t dropped;
+} udp_syslog_stats_t;
+
+// Ships log lines to a remote syslog collector as RFC 5424 messages over
+// UDP, several lines per datagram.
+//
+// Lines wait in a private LogQueue until either a datagram's worth has built
+// up or the oldest line is MAX_DELAY_MS old; a low-priority task then packs
+// and sends them. While WiFi is down or no collector is configured lines
+// stay queued, and once the queue is full new ones are dropped and counted.
+class UdpSyslogSink : public LogSink
+{
+   private:
+    static const size_t        QUEUE_BYTES  = 8 * 1024;
+    static const size_t        FLUSH_BYTES  = 1024;
+    static const unsigned long MAX_DELAY_MS = 2000;
+    static const unsigned long POLL_MS      = 100;
+    static const size_t        HOST_LENGTH  = 64;
+
+    LogQueue       queue;
+    uint8_t       *queueBuffer;
+    portMUX_TYPE   queueMux;
+    TaskHandle_t   senderTask;
+    WiFiUDP        udp;
+    SyslogDatagram datagram;
+
+    char     host[HOST_LENGTH];
+    uint16_t port;
+    char     hostname[32];
+    uint32_t datagramsSent;
+    uint32_t linesSent;
+    uint32_t sendErrors;
+
+    UdpSyslogSink();
+
+    UdpSyslogSink(const UdpSyslogSink &)            = delete;
+    UdpSyslogSink &operator=(const UdpSyslogSink &) = delete;
+
+    static void senderTaskEntry(void *arg);
+    void        senderLoop();
+    bool        flushDue();
+    void        flushQueue();
+    void        sendDatagram(const char *target, uint16_t targetPort);
+
+   protected:
+    bool enqueue(log_level_t level, uint64_t timestamp, const char *message,
+                 size_t length) override;
+
+   public:
+    static UdpSyslogSink &getInstance();
+
+    // Applies the collector settings; an empty host disables shipping. The
+    // queue and sender task are created the first time a host is set.
+    void configure(const String &collectorHost, uint16_t collectorPort, log_level_t level);
+    // HOSTNAME field of outgoing messages.
+    void setHostname(const char *deviceHostname);
+
+    const char        *name() const override { return "syslog"; }
+    udp_syslog_stats_t getStats();
+};
+
+#define udpSyslogSink UdpSyslogSink::getInstance()
+
+#endif  // UDP_SYSLOG_SINK_H
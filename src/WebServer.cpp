@@ -2,14 +2,236 @@
 
 #include <AsyncJson.h>
 
+#include <functional>
+#include <memory>
+
+#include "BootTimeline.h"
 #include "ElegooCC.h"
+#include "EventBus.h"
+#include "GzipStream.h"
+#include "LogFileSink.h"
 #include "Logger.h"
+#include "MemoryMonitor.h"
+#include "Notifier.h"
+#include "PulseCapture.h"
+#include "TimeService.h"
+#include "UdpSyslogSink.h"
+#include "WifiConnect.h"
 
 #define SPIFFS LittleFS
 
 // External reference to firmware version from main.cpp
 extern const char *firmwareVersion;
 extern const char *chipFamily;
+extern char        deviceHostname[];
+
+// Streamed responses expected to be smaller than this go out uncompressed;
+// gzip wouldn't save a packet and costs ~4 KB of heap per response.
+#define GZIP_MIN_BYTES 1024
+
+// Raw chunk source for a streamed response. Returns the bytes written and
+// sets `done` once nothing is left; 0 without `done` means no room yet.
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, bool &done)> ChunkSource;
+
+struct GzipResponse
+{
+    GzipStream  gzip;
+    ChunkSource source;
+};
+
+// Updated from the async_tcp task only, like the handlers that read it
+static struct
+{
+    uint32_t gzipResponses;
+    uint32_t plainResponses;
+    uint32_t rawBytes;
+    uint32_t sentBytes;
+    uint32_t gzipRawBytes;  // rawBytes of gzip responses only
+    uint32_t compressUs;
+} responseStats;
+
+static bool acceptsGzip(AsyncWebServerRequest *request)
+{
+    return request->hasHeader("Accept-Encoding") &&
+           request->header("Accept-Encoding").indexOf("gzip") >= 0;
+}
+
+// Sends a chunked response, gzip-encoded chunk by chunk when the client
+// accepts it and the body is expected to reach GZIP_MIN_BYTES. Skipped while
+// the heap is low; the encoder's 4 KB is optional.
+static void sendStream(AsyncWebServerRequest *request, const char *contentType,
+                       size_t estimatedBytes, ChunkSource source,
+                       const char *attachmentName = nullptr)
+{
+    AsyncWebServerResponse *response;
+    if (estimatedBytes >= GZIP_MIN_BYTES && memoryMonitor.level() == MEMORY_OK &&
+        acceptsGzip(request))
+    {
+        std::shared_ptr<GzipResponse> state = std::make_shared<GzipResponse>();
+        state->source                       = source;
+        responseStats.gzipResponses++;
+        response = request->beginChunkedResponse(
+            contentType,
+            [state](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+            {
+                if (state->gzip.isFinished())
+                {
+                    return 0;
+                }
+                size_t budget = GzipStream::inputBudget(maxLen);
+                if (budget == 0)
+                {
+                    return RESPONSE_TRY_AGAIN;
+                }
+                bool   done   = false;
+                size_t length = state->source(state->gzip.inputBuffer(), budget, done);
+                if (length == 0 && !done)
+                {
+                    // The budget can be smaller than the source's next
+                    // piece; closing the stream here would truncate it
+                    return RESPONSE_TRY_AGAIN;
+                }
+                uint32_t start   = micros();
+                size_t   written = state->gzip.compress(length, done, buffer, maxLen);
+                responseStats.compressUs += micros() - start;
+                responseStats.rawBytes += length;
+                responseStats.gzipRawBytes += length;
+                responseStats.sentBytes += written;
+                return written;
+            });
+        response->addHeader("Content-Encoding", "gzip");
+        response->addHeader("Vary", "Accept-Encoding");
+    }
+    else
+    {
+        responseStats.plainResponses++;
+        response = request->beginChunkedResponse(
+            contentType,
+            [source](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+            {
+                bool   done   = false;
+                size_t length = source(buffer, maxLen, done);
+                if (length == 0 && !done)
+                {
+                    // Returning 0 would end the body
+                    return RESPONSE_TRY_AGAIN;
+                }
+                responseStats.rawBytes += length;
+                responseStats.sentBytes += length;
+                return length;
+            });
+    }
+    if (attachmentName != nullptr)
+    {
+        response->addHeader("Content-Disposition",
+                            String("attachment; filename=\"") + attachmentName + "\"");
+    }
+    request->send(response);
+}
+
+// Query names for log_category_t and log_level_t, in enum order
+static const char *const LOG_CATEGORY_NAMES[LOG_CAT_COUNT] = {
+    "general", "flow", "flow_summary", "packet", "telemetry_compare", "deficit_reset"};
+static const char *const LOG_LEVEL_NAMES[] = {"error", "warn", "info", "debug", "verbose"};
+
+// Builds a log filter from the query string:
+//   category=flow,general  level=warn (and more severe)  q=substring
+//   from=/to= epoch seconds, inclusive
+// `text` keeps the substring alive until beginRead() has copied it.
+static bool parseLogFilter(AsyncWebServerRequest *request, LogStore::Filter &filter,
+                           String &text, String &error)
+{
+    if (request->hasParam("category"))
+    {
+        String list = request->getParam("category")->value();
+        filter.categoryMask = 0;
+        int start           = 0;
+        while (start <= (int) list.length())
+        {
+            int end = list.indexOf(',', start);
+            if (end < 0)
+            {
+                end = list.length();
+            }
+            String name = list.substring(start, end);
+            name.trim();
+            int category = -1;
+            for (int i = 0; i < LOG_CAT_COUNT; i++)
+            {
+                if (name.equalsIgnoreCase(LOG_CATEGORY_NAMES[i]))
+                {
+                    category = i;
+                }
+            }
+            if (category < 0)
+            {
+                error = "Unknown category: " + name;
+                return false;
+            }
+            filter.categoryMask |= LOG_CATEGORY_BIT(category);
+            start = end + 1;
+        }
+    }
+
+    if (request->hasParam("level"))
+    {
+        String name  = request->getParam("level")->value();
+        int    level = -1;
+        for (int i = 0; i <= LOG_LEVEL_VERBOSE; i++)
+        {
+            if (name.equalsIgnoreCase(LOG_LEVEL_NAMES[i]))
+            {
+                level = i;
+            }
+        }
+        if (level < 0)
+        {
+            error = "Unknown level: " + name;
+            return false;
+        }
+        filter.maxLevel = (uint8_t) level;
+    }
+
+    if (request->hasParam("from") || request->hasParam("to"))
+    {
+        // Stored times are monotonic; needs the NTP offset to translate
+        uint64_t fromUs = 0;
+        uint64_t toUs   = 0;
+        if (request->hasParam("from") &&
+            !timeService.toMonotonicUs(
+                (uint64_t) strtoull(request->getParam("from")->value().c_str(), nullptr, 10) *
+                    1000000ULL,
+                fromUs))
+        {
+            error = "Time filters need NTP time";
+            return false;
+        }
+        if (request->hasParam("to") &&
+            !timeService.toMonotonicUs(
+                ((uint64_t) strtoull(request->getParam("to")->value().c_str(), nullptr, 10) + 1) *
+                        1000000ULL -
+                    1,
+                toUs))
+        {
+            error = "Time filters need NTP time";
+            return false;
+        }
+        filter.fromUs = fromUs;
+        filter.toUs   = request->hasParam("to") ? toUs : UINT64_MAX;
+    }
+
+    if (request->hasParam("q"))
+    {
+        text = request->getParam("q")->value();
+        if (text.length() >= LOG_QUERY_TEXT_MAX)
+        {
+            error = "Search text too long";
+            return false;
+        }
+        filter.text = text.length() > 0 ? text.c_str() : nullptr;
+    }
+    return true;
+}
 
 WebServer::WebServer(int port) : server(port) {}
 
@@ -40,6 +262,15 @@ void WebServer::begin()
             }
             settingsManager.setAPMode(jsonObj["ap_mode"].as<bool>());
             settingsManager.setPauseOnRunout(jsonObj["pause_on_runout"].as<bool>());
+            if (jsonObj.containsKey("pause_escalation"))
+            {
+                settingsManager.setPauseEscalation(jsonObj["pause_escalation"].as<bool>());
+            }
+            if (jsonObj.containsKey("pause_escalation_stop"))
+            {
+                settingsManager.setPauseEscalationStop(
+                    jsonObj["pause_escalation_stop"].as<bool>());
+            }
             settingsManager.setEnabled(jsonObj["enabled"].as<bool>());
             settingsManager.setStartPrintTimeout(jsonObj["start_print_timeout"].as<int>());
             if (jsonObj.containsKey("expected_deficit_mm"))
@@ -107,10 +338,68 @@ void WebServer::begin()
                 settingsManager.setMovementMmPerPulse(
                     jsonObj["movement_mm_per_pulse"].as<float>());
             }
+            if (jsonObj.containsKey("movement_min_edge_us"))
+            {
+                settingsManager.setMovementMinEdgeUs(jsonObj["movement_min_edge_us"].as<int>());
+            }
+            if (jsonObj.containsKey("flash_logging"))
+            {
+                settingsManager.setFlashLogging(jsonObj["flash_logging"].as<bool>());
+            }
+            if (jsonObj.containsKey("wifi_static_ip"))
+            {
+                settingsManager.setWifiStaticIp(jsonObj["wifi_static_ip"].as<String>());
+            }
+            if (jsonObj.containsKey("wifi_gateway"))
+            {
+                settingsManager.setWifiGateway(jsonObj["wifi_gateway"].as<String>());
+            }
+            if (jsonObj.containsKey("wifi_subnet"))
+            {
+                settingsManager.setWifiSubnet(jsonObj["wifi_subnet"].as<String>());
+            }
+            if (jsonObj.containsKey("wifi_dns"))
+            {
+                settingsManager.setWifiDns(jsonObj["wifi_dns"].as<String>());
+            }
+            if (jsonObj.containsKey("syslog_host"))
+            {
+                settingsManager.setSyslogHost(jsonObj["syslog_host"].as<String>());
+            }
+            if (jsonObj.containsKey("syslog_port"))
+            {
+                settingsManager.setSyslogPort(jsonObj["syslog_port"].as<int>());
+            }
+            if (jsonObj.containsKey("syslog_level"))
+            {
+                settingsManager.setSyslogLevel(jsonObj["syslog_level"].as<int>());
+            }
+            if (jsonObj.containsKey("notify_url"))
+            {
+                settingsManager.setNotifyUrl(jsonObj["notify_url"].as<String>());
+            }
+            if (jsonObj.containsKey("notify_template"))
+            {
+                settingsManager.setNotifyTemplate(jsonObj["notify_template"].as<String>());
+            }
+            if (jsonObj.containsKey("notify_events"))
+            {
+                settingsManager.setNotifyEvents(jsonObj["notify_events"].as<int>());
+            }
+            if (jsonObj.containsKey("detection_profiles"))
+            {
+                settingsManager.setDetectionProfiles(
+                    jsonObj["detection_profiles"].as<JsonArrayConst>());
+            }
+            if (jsonObj.containsKey("detection_profile"))
+            {
+                settingsManager.setDetectionProfile(jsonObj["detection_profile"].as<String>());
+            }
             settingsManager.save();
             jsonObj.clear();
             request->send(200, "text/plain", "ok");
-        }));
+        },
+        4096));
 
     server.on("/discover_printer", HTTP_GET,
               [](AsyncWebServerRequest *request)
@@ -145,56 +434,630 @@ void WebServer::begin()
               [this](AsyncWebServerRequest *request)
               {
                   // Add elegoo status information using singleton
-                  printer_info_t elegooStatus = elegooCC.getCurrentInformation();
+                  printer_info_t      elegooStatus = elegooCC.getCurrentInformation();
+                  detection_profile_t profile      = settingsManager.getActiveProfile();
 
-                  DynamicJsonDocument jsonDoc(512);
-                  jsonDoc["stopped"]        = elegooStatus.filamentStopped;
-                  jsonDoc["filamentRunout"] = elegooStatus.filamentRunout;
-
-                  jsonDoc["elegoo"]["mainboardID"]          = elegooStatus.mainboardID;
-                  jsonDoc["elegoo"]["printStatus"]          = (int) elegooStatus.printStatus;
-                  jsonDoc["elegoo"]["isPrinting"]           = elegooStatus.isPrinting;
-                  jsonDoc["elegoo"]["currentLayer"]         = elegooStatus.currentLayer;
-                  jsonDoc["elegoo"]["totalLayer"]           = elegooStatus.totalLayer;
-                  jsonDoc["elegoo"]["progress"]             = elegooStatus.progress;
-                  jsonDoc["elegoo"]["currentTicks"]         = elegooStatus.currentTicks;
-                  jsonDoc["elegoo"]["totalTicks"]           = elegooStatus.totalTicks;
-                  jsonDoc["elegoo"]["PrintSpeedPct"]        = elegooStatus.PrintSpeedPct;
-                  jsonDoc["elegoo"]["isWebsocketConnected"] = elegooStatus.isWebsocketConnected;
-                  jsonDoc["elegoo"]["currentZ"]             = elegooStatus.currentZ;
-                  jsonDoc["elegoo"]["expectedFilament"]     = elegooStatus.expectedFilamentMM;
-                  jsonDoc["elegoo"]["actualFilament"]       = elegooStatus.actualFilamentMM;
-                  jsonDoc["elegoo"]["expectedDelta"]        = elegooStatus.lastExpectedDeltaMM;
-                  jsonDoc["elegoo"]["telemetryAvailable"]   = elegooStatus.telemetryAvailable;
-                  jsonDoc["elegoo"]["currentDeficitMm"]     = elegooStatus.currentDeficitMm;
-                  jsonDoc["elegoo"]["deficitThresholdMm"]   = elegooStatus.deficitThresholdMm;
-                  jsonDoc["elegoo"]["deficitRatio"]         = elegooStatus.deficitRatio;
-                  jsonDoc["elegoo"]["movementPulses"]       = (uint32_t) elegooStatus.movementPulseCount;
-                  jsonDoc["elegoo"]["uiRefreshIntervalMs"]  = settingsManager.getUiRefreshIntervalMs();
-                  jsonDoc["elegoo"]["flowTelemetryStaleMs"] = settingsManager.getFlowTelemetryStaleMs();
+                  DynamicJsonDocument jsonDoc(672);
+                  sensorStatusToJson(elegooStatus, settingsManager.getUiRefreshIntervalMs(),
+                                     settingsManager.getFlowTelemetryStaleMs(), profile.name,
+                                     jsonDoc);
 
                   String jsonResponse;
                   serializeJson(jsonDoc, jsonResponse);
                   request->send(200, "application/json", jsonResponse);
               });
 
-    // Logs endpoint
+    // Logs endpoint. The history is streamed in chunks straight out of the
+    // compressed log store instead of being rendered into one String.
+    // Optional filters (see parseLogFilter) are applied on the device while
+    // streaming; blocks that cannot match are never decompressed.
     server.on("/api/logs", HTTP_GET,
               [](AsyncWebServerRequest *request)
               {
-                  String jsonResponse = logger.getLogsAsJson();
-                  request->send(200, "application/json", jsonResponse);
+                  LogStore::Filter filter;
+                  String           text;
+                  String           error;
+                  if (!parseLogFilter(request, filter, text, error))
+                  {
+                      request->send(400, "text/plain", error);
+                      return;
+                  }
+                  std::shared_ptr<LogReadCursor> cursor =
+                      std::make_shared<LogReadCursor>(logger.beginRead(true, filter));
+                  sendStream(request, "application/json", logger.getRawBytes(),
+                             [cursor](uint8_t *buffer, size_t maxLen, bool &done)
+                             {
+                                 size_t length = logger.readLogChunk(*cursor, buffer, maxLen);
+                                 done          = cursor->done();
+                                 return length;
+                             });
               });
 
-    // Raw text logs endpoint
+    // Raw text logs endpoint; same filters as /api/logs
     server.on("/api/logs_text", HTTP_GET,
               [](AsyncWebServerRequest *request)
               {
-                  String textResponse = logger.getLogsAsText();
-                  AsyncWebServerResponse *response =
-                      request->beginResponse(200, "text/plain", textResponse);
-                  response->addHeader("Content-Disposition", "attachment; filename=\"logs.txt\"");
-                  request->send(response);
+                  LogStore::Filter filter;
+                  String           text;
+                  String           error;
+                  if (!parseLogFilter(request, filter, text, error))
+                  {
+                      request->send(400, "text/plain", error);
+                      return;
+                  }
+                  std::shared_ptr<LogReadCursor> cursor =
+                      std::make_shared<LogReadCursor>(logger.beginRead(false, filter));
+                  sendStream(
+                      request, "text/plain", logger.getRawBytes(),
+                      [cursor](uint8_t *buffer, size_t maxLen, bool &done)
+                      {
+                          size_t length = logger.readLogChunk(*cursor, buffer, maxLen);
+                          done          = cursor->done();
+                          return length;
+                      },
+                      "logs.txt");
+              });
+
+    // Log from the previous boot, as persisted by the flash log sink
+    server.on("/api/logs_previous", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  if (!logFileSink.hasPreviousLog())
+                  {
+                      request->send(404, "text/plain", "No previous boot log");
+                      return;
+                  }
+                  std::shared_ptr<PreviousLogCursor> cursor =
+                      std::make_shared<PreviousLogCursor>(logFileSink.beginPreviousRead());
+                  sendStream(
+                      request, "text/plain", logFileSink.previousLogSize(),
+                      [cursor](uint8_t *buffer, size_t maxLen, bool &done)
+                      {
+                          size_t length = logFileSink.readPrevious(*cursor, buffer, maxLen);
+                          done          = cursor->done();
+                          return length;
+                      },
+                      "logs_previous.txt");
+              });
+
+    // Log store occupancy and per-block compression cost
+    server.on("/api/logs_stats", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  LogStore::Stats     stats = logger.getStats();
+                  DynamicJsonDocument jsonDoc(1024);
+                  jsonDoc["capacityBytes"]   = logger.getCapacity();
+                  jsonDoc["records"]         = logger.getLogCount();
+                  jsonDoc["sealedBlocks"]    = stats.sealedBlocks;
+                  jsonDoc["liveBlocks"]      = stats.liveBlocks;
+                  jsonDoc["liveRawBytes"]    = stats.liveRawBytes;
+                  jsonDoc["liveStoredBytes"] = stats.liveStoredBytes;
+                  jsonDoc["compressionRatio"] =
+                      stats.liveStoredBytes > 0
+                          ? (float) stats.liveRawBytes / (float) stats.liveStoredBytes
+                          : 0.0f;
+                  jsonDoc["lastCompressUs"] = stats.lastCompressUs;
+                  jsonDoc["maxCompressUs"]  = stats.maxCompressUs;
+                  jsonDoc["avgCompressUs"] =
+                      stats.sealedBlocks > 0 ? stats.totalCompressUs / stats.sealedBlocks : 0;
+
+                  log_file_sink_stats_t flash = logFileSink.getStats();
+                  jsonDoc["flash"]["enabled"]          = flash.enabled;
+                  jsonDoc["flash"]["stagedBytes"]      = flash.stagedBytes;
+                  jsonDoc["flash"]["bytesWritten"]     = flash.bytesWritten;
+                  jsonDoc["flash"]["chunksWritten"]    = flash.chunksWritten;
+                  jsonDoc["flash"]["droppedBytes"]     = flash.droppedBytes;
+                  jsonDoc["flash"]["rotations"]        = flash.rotations;
+                  jsonDoc["flash"]["currentFileBytes"] = flash.currentFileBytes;
+
+                  udp_syslog_stats_t syslog = udpSyslogSink.getStats();
+                  jsonDoc["syslog"]["enabled"]       = syslog.enabled;
+                  jsonDoc["syslog"]["queuedBytes"]   = syslog.queuedBytes;
+                  jsonDoc["syslog"]["queuedLines"]   = syslog.queuedLines;
+                  jsonDoc["syslog"]["datagramsSent"] = syslog.datagramsSent;
+                  jsonDoc["syslog"]["linesSent"]     = syslog.linesSent;
+                  jsonDoc["syslog"]["sendErrors"]    = syslog.sendErrors;
+                  jsonDoc["syslog"]["dropped"]       = syslog.dropped;
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    // Heap health, per-task stack high-water marks and what has been shed
+    server.on("/api/memory", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  const MemoryHealth    &health   = memoryMonitor.getHealth();
+                  const memory_sample_t &internal = health.lastSample();
+                  MemoryHealth::Stats    stats    = health.getStats();
+
+                  DynamicJsonDocument jsonDoc(1536);
+                  jsonDoc["level"]      = MemoryHealth::levelName(health.level());
+                  jsonDoc["worstLevel"] =
+                      MemoryHealth::levelName(static_cast<memory_level_t>(stats.worstLevel));
+                  JsonObject heap       = jsonDoc.createNestedObject("internal");
+                  heap["free"]          = internal.freeBytes;
+                  heap["minFree"]       = internal.minFreeBytes;
+                  heap["largestBlock"]  = internal.largestBlock;
+                  heap["fragmentation"] = MemoryHealth::fragmentationPct(internal);
+                  if (memoryMonitor.hasPsram())
+                  {
+                      memory_sample_t psram   = memoryMonitor.getPsramSample();
+                      JsonObject      spiram  = jsonDoc.createNestedObject("psram");
+                      spiram["free"]          = psram.freeBytes;
+                      spiram["minFree"]       = psram.minFreeBytes;
+                      spiram["largestBlock"]  = psram.largestBlock;
+                      spiram["fragmentation"] = MemoryHealth::fragmentationPct(psram);
+                  }
+
+                  JsonObject tasks = jsonDoc.createNestedObject("stackFreeMin");
+                  for (size_t i = 0; i < memoryMonitor.taskCount(); i++)
+                  {
+                      const task_stack_t &task = memoryMonitor.task(i);
+                      if (task.found)
+                      {
+                          tasks[task.name] = task.stackFreeMin;
+                      }
+                  }
+
+                  JsonArray shed = jsonDoc.createNestedArray("shed");
+                  for (size_t i = 0; i < health.shedderCount(); i++)
+                  {
+                      if (health.shedderFired(i))
+                      {
+                          shed.add(health.shedderName(i));
+                      }
+                  }
+                  jsonDoc["levelChanges"] = stats.levelChanges;
+                  jsonDoc["shedRuns"]     = stats.shedRuns;
+                  jsonDoc["bytesShed"]    = stats.bytesShed;
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    // Bytes on the air for streamed responses and what gzip costs per KB
+    server.on("/api/http_stats", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  StaticJsonDocument<384> jsonDoc;
+                  jsonDoc["gzipMinBytes"]   = GZIP_MIN_BYTES;
+                  jsonDoc["gzipResponses"]  = responseStats.gzipResponses;
+                  jsonDoc["plainResponses"] = responseStats.plainResponses;
+                  jsonDoc["rawBytes"]       = responseStats.rawBytes;
+                  jsonDoc["sentBytes"]      = responseStats.sentBytes;
+                  jsonDoc["savedBytes"]     = responseStats.rawBytes - responseStats.sentBytes;
+                  jsonDoc["compressUs"]     = responseStats.compressUs;
+                  jsonDoc["compressUsPerKb"] =
+                      responseStats.gzipRawBytes > 0
+                          ? (float) responseStats.compressUs * 1024.0f / responseStats.gzipRawBytes
+                          : 0.0f;
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    // Boot phase timings, relative to power-on
+    server.on("/api/boot", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  DynamicJsonDocument jsonDoc(768);
+                  JsonObject          phases = jsonDoc.createNestedObject("phases");
+                  for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+                  {
+                      boot_phase_t phase = static_cast<boot_phase_t>(i);
+                      if (bootTimeline.hasReached(phase))
+                      {
+                          phases[BootTimeline::phaseName(phase)] =
+                              bootTimeline.getPhaseUs(phase) / 1000;
+                      }
+                  }
+                  if (bootTimeline.hasReached(BOOT_PHASE_PROTECTING))
+                  {
+                      jsonDoc["timeToProtectionMs"] =
+                          bootTimeline.getPhaseUs(BOOT_PHASE_PROTECTING) / 1000;
+                  }
+                  jsonDoc["uptimeMs"] = millis();
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    // Event bus counters: per-type publishes, drops and queue depth
+    server.on("/api/events", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  event_bus_stats_t stats = eventBus.getStats();
+
+                  StaticJsonDocument<512> jsonDoc;
+                  JsonObject published = jsonDoc.createNestedObject("published");
+                  for (int t = 0; t < EVENT_TYPE_COUNT; t++)
+                  {
+                      published[EventBus::typeName(static_cast<event_type_t>(t))] =
+                          stats.published[t];
+                  }
+                  jsonDoc["dispatched"] = stats.dispatched;
+                  jsonDoc["dropped"]    = stats.dropped;
+                  jsonDoc["unheard"]    = stats.unheard;
+                  jsonDoc["highWater"]  = stats.highWater;
+                  jsonDoc["pending"]    = eventBus.pending();
+                  jsonDoc["queueSize"]  = EventBus::QUEUE_SIZE;
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    server.on("/api/printer_clock", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  PrinterClock        clock = elegooCC.getPrinterClock();
+                  PrinterClock::Stats stats = clock.getStats();
+
+                  StaticJsonDocument<512> jsonDoc;
+                  jsonDoc["locked"]     = stats.locked;
+                  jsonDoc["samples"]    = stats.samples;
+                  jsonDoc["resets"]     = stats.resets;
+                  jsonDoc["frameAgeMs"] = stats.lastAgeMs;
+                  jsonDoc["meanAgeMs"]  = stats.meanAgeMs;
+                  jsonDoc["maxAgeMs"]   = stats.maxAgeMs;
+                  jsonDoc["quantumMs"]  = stats.quantumMs;
+                  jsonDoc["skewPpm"]    = stats.skewPpm;
+                  jsonDoc["lastRttMs"]  = stats.lastRttMs;
+                  jsonDoc["minRttMs"]   = stats.minRttMs;
+
+                  // Printer clock minus ours, once both are anchored
+                  uint64_t nowUs = timeService.nowUs();
+                  if (stats.locked && timeService.hasEpoch())
+                  {
+                      int64_t localMs   = (int64_t) (nowUs / 1000);
+                      int64_t epochMs   = (int64_t) (timeService.toEpochUs(nowUs) / 1000);
+                      int64_t printerMs = clock.printerTimeAt(localMs);
+                      jsonDoc["printerAheadMs"] = (long) (printerMs - epochMs);
+                  }
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    server.on("/api/link", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  LinkLiveness        link  = elegooCC.getLinkLiveness();
+                  LinkLiveness::Stats stats = link.getStats();
+
+                  StaticJsonDocument<384> jsonDoc;
+                  jsonDoc["state"]            = LinkLiveness::stateName(link.state());
+                  jsonDoc["silenceTimeoutMs"] = link.silenceTimeoutMs();
+                  jsonDoc["probeTimeoutMs"]   = link.probeTimeoutMs();
+                  jsonDoc["p99GapMs"]         = stats.p99GapMs;
+                  jsonDoc["frames"]           = stats.frames;
+                  jsonDoc["probes"]           = stats.probes;
+                  jsonDoc["probesAnswered"]   = stats.probesAnswered;
+                  jsonDoc["lastProbeRttMs"]   = stats.lastProbeRttMs;
+                  jsonDoc["losses"]           = stats.losses;
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    server.on("/api/wifi", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  wifi_cache_t              cache   = wifiConnect.getCache();
+                  const WifiConnectHistory &history = wifiConnect.getHistory();
+
+                  StaticJsonDocument<2048> jsonDoc;
+                  jsonDoc["rssi"]    = WiFi.RSSI();
+                  jsonDoc["channel"] = WiFi.channel();
+
+                  JsonObject cached  = jsonDoc.createNestedObject("cache");
+                  cached["valid"]    = wifiConnect.hasCache();
+                  cached["channel"]  = cache.channel;
+                  char bssid[18];
+                  snprintf(bssid, sizeof(bssid), "%02x:%02x:%02x:%02x:%02x:%02x", cache.bssid[0],
+                           cache.bssid[1], cache.bssid[2], cache.bssid[3], cache.bssid[4],
+                           cache.bssid[5]);
+                  cached["bssid"]       = bssid;
+                  cached["hasLease"]    = wifiCacheHasLease(cache);
+                  cached["leaseReuses"] = cache.leaseReuses;
+
+                  JsonObject paths = jsonDoc.createNestedObject("paths");
+                  for (int p = 0; p < WIFI_PATH_COUNT; p++)
+                  {
+                      wifi_connect_path_t           path  = (wifi_connect_path_t) p;
+                      WifiConnectHistory::PathStats stats = history.pathStats(path);
+                      JsonObject entry = paths.createNestedObject(WifiConnectHistory::pathName(path));
+                      entry["attempts"] = stats.attempts;
+                      entry["failures"] = stats.failures;
+                      entry["lastMs"]   = stats.lastMs;
+                      entry["bestMs"]   = stats.bestMs;
+                  }
+
+                  JsonArray recent = jsonDoc.createNestedArray("history");
+                  for (size_t i = 0; i < history.count(); i++)
+                  {
+                      const wifi_connect_record_t &record = history.get(i);
+                      JsonObject                   entry  = recent.createNestedObject();
+                      entry["path"]     = WifiConnectHistory::pathName(
+                          (wifi_connect_path_t) record.path);
+                      entry["success"]     = record.success;
+                      entry["staticIp"]    = record.staticIp;
+                      entry["associateMs"] = record.associateMs;
+                      entry["dhcpMs"]      = record.dhcpMs;
+                      entry["totalMs"]     = record.totalMs;
+                  }
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    // Registered before /api/notify, which would otherwise match it as a prefix
+    server.on("/api/notify/test", HTTP_POST,
+              [](AsyncWebServerRequest *request)
+              {
+                  if (!notifier.enqueueTest())
+                  {
+                      request->send(429, "text/plain", "A test notification was sent recently");
+                      return;
+                  }
+                  request->send(202, "text/plain", "queued");
+              });
+
+    // Webhook queue and delivery counters
+    server.on("/api/notify", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  notifier_stats_t stats = notifier.getStats();
+
+                  StaticJsonDocument<384> jsonDoc;
+                  jsonDoc["enabled"]    = stats.enabled;
+                  jsonDoc["queued"]     = stats.queue.queued;
+                  jsonDoc["accepted"]   = stats.queue.accepted;
+                  jsonDoc["sent"]       = stats.queue.sent;
+                  jsonDoc["retries"]    = stats.queue.retries;
+                  jsonDoc["failed"]     = stats.queue.failed;
+                  jsonDoc["dropped"]    = stats.queue.dropped;
+                  jsonDoc["suppressed"] = stats.queue.suppressed;
+                  jsonDoc["lastStatus"] = stats.lastStatus;
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    server.on("/api/pause_traces", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  PauseTracer tracer = elegooCC.getPauseTracer();
+
+                  DynamicJsonDocument jsonDoc(6144);
+                  JsonArray           traces = jsonDoc.createNestedArray("traces");
+                  for (size_t i = 0; i < tracer.historyCount(); i++)
+                  {
+                      const PauseTrace &trace = tracer.history(i);
+                      JsonObject        entry = traces.createNestedObject();
+                      entry["id"]             = trace.id;
+                      entry["trigger"]        = trace.runout ? "runout" : "jam";
+                      entry["complete"]       = trace.complete;
+                      if (trace.hasStage(PAUSE_STAGE_JAM_ONSET))
+                      {
+                          entry["overrunMm"] = trace.overrunMm();
+                      }
+                      JsonObject offsets = entry.createNestedObject("offsetsUs");
+                      for (int s = 0; s < PAUSE_STAGE_COUNT; s++)
+                      {
+                          pause_stage_t stage = static_cast<pause_stage_t>(s);
+                          if (trace.hasStage(stage))
+                          {
+                              offsets[PauseTracer::stageName(stage)] = trace.offsetUs(stage);
+                          }
+                      }
+                  }
+                  jsonDoc["inProgress"] = tracer.isActive();
+
+                  JsonObject summary = jsonDoc.createNestedObject("summary");
+                  for (int s = 0; s < PAUSE_STAGE_COUNT; s++)
+                  {
+                      pause_stage_t       stage = static_cast<pause_stage_t>(s);
+                      PauseLatencySummary stats = tracer.stageSummary(stage);
+                      if (stats.samples == 0)
+                      {
+                          continue;
+                      }
+                      JsonObject entry = summary.createNestedObject(PauseTracer::stageName(stage));
+                      entry["samples"] = stats.samples;
+                      entry["p50Us"]   = stats.p50Us;
+                      entry["p90Us"]   = stats.p90Us;
+                      entry["maxUs"]   = stats.maxUs;
+                  }
+                  PauseOverrunSummary overrun = tracer.overrunSummary();
+                  if (overrun.samples > 0)
+                  {
+                      JsonObject entry = summary.createNestedObject("overrun");
+                      entry["samples"] = overrun.samples;
+                      entry["p50Mm"]   = overrun.p50Mm;
+                      entry["p90Mm"]   = overrun.p90Mm;
+                      entry["maxMm"]   = overrun.maxMm;
+                  }
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    server.on("/api/pause_verifications", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  PauseVerifier verifier = elegooCC.getPauseVerifier();
+
+                  DynamicJsonDocument jsonDoc(8192);
+                  JsonArray verifications = jsonDoc.createNestedArray("verifications");
+                  for (size_t i = 0; i < verifier.historyCount(); i++)
+                  {
+                      const PauseVerification &record = verifier.history(i);
+                      JsonObject               entry  = verifications.createNestedObject();
+                      entry["id"]         = record.id;
+                      entry["outcome"]    = PauseVerifier::outcomeName(
+                          static_cast<pause_outcome_t>(record.outcome));
+                      entry["durationMs"] = record.durationMs;
+                      entry["totalMm"]    = record.totalMm();
+                      JsonArray steps     = entry.createNestedArray("steps");
+                      for (uint8_t s = 0; s < record.steps; s++)
+                      {
+                          JsonObject step  = steps.createNestedObject();
+                          step["step"]     = PauseVerifier::stepName(static_cast<pause_step_t>(s));
+                          step["offsetMs"] = record.stepOffsetMs[s];
+                          step["mm"]       = record.stepMm[s];
+                      }
+                  }
+                  jsonDoc["inProgress"] = verifier.isActive();
+
+                  PauseVerifier::Stats stats = verifier.getStats();
+                  JsonObject           counts = jsonDoc.createNestedObject("stats");
+                  counts["verifications"]  = stats.verifications;
+                  counts["stopped"]        = stats.stopped;
+                  counts["repause"]        = stats.escalations[PAUSE_STEP_REPAUSE];
+                  counts["stopFeeding"]    = stats.escalations[PAUSE_STEP_STOP_FEEDING];
+                  counts["stop"]           = stats.escalations[PAUSE_STEP_STOP];
+                  counts["stillExtruding"] = stats.stillExtruding;
+                  counts["noTelemetry"]    = stats.noTelemetry;
+                  counts["cancelled"]      = stats.cancelled;
+
+                  PauseEffectSummary summary = verifier.summary();
+                  if (summary.samples > 0)
+                  {
+                      JsonObject entry = jsonDoc.createNestedObject("afterPause");
+                      entry["samples"] = summary.samples;
+                      entry["p50Mm"]   = summary.p50Mm;
+                      entry["p90Mm"]   = summary.p90Mm;
+                      entry["maxMm"]   = summary.maxMm;
+                  }
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    // Per-layer flow for the current or last print. Up to 256 buckets, so it
+    // is streamed rather than built as one document.
+    server.on("/api/layers", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  // The loop merges buckets as layers grow, so stream from a
+                  // copy (about 6 KB) rather than the live array
+                  if (memoryMonitor.level() == MEMORY_CRITICAL)
+                  {
+                      request->send(503, "text/plain", "Low memory");
+                      return;
+                  }
+                  std::shared_ptr<LayerFlowStats> stats = std::make_shared<LayerFlowStats>();
+                  elegooCC.copyLayerStats(*stats);
+                  std::shared_ptr<LayerJsonCursor> cursor =
+                      std::make_shared<LayerJsonCursor>(stats->beginJson());
+                  // Roughly 120 bytes of JSON per bucket
+                  sendStream(request, "application/json", stats->getBucketCount() * 120,
+                             [stats, cursor](uint8_t *buffer, size_t maxLen, bool &done)
+                             {
+                                 size_t length = stats->readJson(*cursor, (char *) buffer, maxLen);
+                                 done          = cursor->done();
+                                 return length;
+                             });
+              });
+
+    // What each detection profile would have done on the current print
+    server.on("/api/detector_shadow", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  static const char *modeNames[] = {"tracker", "delta", "total"};
+                  shadow_snapshot_t   shadow      = elegooCC.getShadowSnapshot();
+                  detection_profile_t active      = settingsManager.getActiveProfile();
+
+                  StaticJsonDocument<2048> jsonDoc;
+                  jsonDoc["mode"]   = modeNames[shadow.mode];
+                  jsonDoc["active"] = active.name;
+                  JsonArray profiles = jsonDoc.createNestedArray("profiles");
+                  for (size_t i = 0; i < shadow.count; i++)
+                  {
+                      const shadow_result_t &result = shadow.results[i];
+                      JsonObject             entry  = profiles.createNestedObject();
+                      entry["name"]             = result.name;
+                      entry["thresholdMm"]      = result.thresholdMm;
+                      entry["holdMs"]           = result.holdMs;
+                      entry["deficitMm"]        = result.deficitMm;
+                      entry["satisfied"]        = result.satisfied;
+                      entry["firstSatisfiedMs"] = result.firstSatisfiedMs;
+                  }
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
+              });
+
+    // Capture stress test: injects synthetic pulses from an IRAM timer interrupt
+    // while hammering LittleFS, to verify no edges are lost while flash writes
+    // have the cache disabled. Refused while printing.
+    server.on("/api/debug/capture_stress", HTTP_POST,
+              [](AsyncWebServerRequest *request)
+              {
+                  if (elegooCC.getCurrentInformation().isPrinting)
+                  {
+                      request->send(409, "text/plain", "Refusing to run while printing");
+                      return;
+                  }
+
+                  uint32_t durationMs = 5000;
+                  uint32_t intervalUs = 1000;
+                  if (request->hasParam("duration_ms"))
+                  {
+                      durationMs = request->getParam("duration_ms")->value().toInt();
+                  }
+                  if (request->hasParam("interval_us"))
+                  {
+                      intervalUs = request->getParam("interval_us")->value().toInt();
+                  }
+                  durationMs = constrain(durationMs, 100, 60000);
+                  intervalUs = constrain(intervalUs, 100, 1000000);
+
+                  if (!pulseCapture.startStressTest(durationMs, intervalUs))
+                  {
+                      request->send(409, "text/plain", "Stress test already running");
+                      return;
+                  }
+                  request->send(202, "text/plain", "started");
+              });
+
+    server.on("/api/debug/capture_stress", HTTP_GET,
+              [](AsyncWebServerRequest *request)
+              {
+                  capture_stress_result_t result = pulseCapture.getStressResult();
+
+                  DynamicJsonDocument jsonDoc(512);
+                  jsonDoc["running"]           = result.running;
+                  jsonDoc["completed"]         = result.completed;
+                  jsonDoc["durationMs"]        = result.durationMs;
+                  jsonDoc["intervalUs"]        = result.intervalUs;
+                  jsonDoc["injected"]          = result.injected;
+                  jsonDoc["delivered"]         = result.delivered;
+                  jsonDoc["overflowed"]        = result.overflowed;
+                  jsonDoc["lost"]              = result.injected - result.delivered;
+                  jsonDoc["maxInjectGapUs"]    = result.maxInjectGapUs;
+                  jsonDoc["flashWrites"]       = result.flashWrites;
+                  jsonDoc["flashBytesWritten"] = result.flashBytesWritten;
+                  jsonDoc["movementEdges"]     = pulseCapture.getMovementEdgeCount();
+                  jsonDoc["runoutEdges"]       = pulseCapture.getRunoutEdgeCount();
+                  jsonDoc["rejectedEdges"]     = pulseCapture.getRejectedEdgeCount();
+
+                  String jsonResponse;
+                  serializeJson(jsonDoc, jsonResponse);
+                  request->send(200, "application/json", jsonResponse);
               });
 
     // Version endpoint
@@ -204,6 +1067,7 @@ void WebServer::begin()
                   DynamicJsonDocument jsonDoc(256);
                   jsonDoc["firmware_version"] = firmwareVersion;
                   jsonDoc["chip_family"]      = chipFamily;
+                  jsonDoc["hostname"]         = (const char *) deviceHostname;
                   jsonDoc["build_date"]       = __DATE__;
                   jsonDoc["build_time"]       = __TIME__;
 
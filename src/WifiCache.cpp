@@ -0,0 +1,104 @@
+#include "WifiCache.h"
+
+#include <string.h>
+
+static uint32_t fnv1a(uint32_t hash, const char *text)
+{
+    for (; text != nullptr && *text != '\0'; text++)
+    {
+        hash ^= (uint8_t) *text;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t wifiCredentialHash(const char *ssid, const char *password)
+{
+    uint32_t hash = fnv1a(2166136261u, ssid);
+    hash          = fnv1a(hash ^ 0xFF, password);  // "ab"+"c" differs from "a"+"bc"
+    return hash == 0 ? 1 : hash;
+}
+
+bool wifiCacheUsable(const wifi_cache_t &cache, uint32_t credentialHash)
+{
+    if (cache.version != WIFI_CACHE_VERSION || cache.credentialHash != credentialHash)
+    {
+        return false;
+    }
+    if (cache.channel < 1 || cache.channel > 14)
+    {
+        return false;
+    }
+    static const uint8_t zero[6] = {0};
+    return memcmp(cache.bssid, zero, sizeof(zero)) != 0;
+}
+
+bool wifiCacheHasLease(const wifi_cache_t &cache)
+{
+    return cache.ip != 0 && cache.gateway != 0 && cache.subnet != 0;
+}
+
+WifiConnectHistory::WifiConnectHistory()
+{
+    memset(records, 0, sizeof(records));
+    memset(stats, 0, sizeof(stats));
+    next    = 0;
+    entries = 0;
+}
+
+void WifiConnectHistory::add(const wifi_connect_record_t &record)
+{
+    records[next] = record;
+    next          = (next + 1) % HISTORY_SIZE;
+    if (entries < HISTORY_SIZE)
+    {
+        entries++;
+    }
+
+    if (record.path >= WIFI_PATH_COUNT)
+    {
+        return;
+    }
+    PathStats &path = stats[record.path];
+    path.attempts++;
+    if (!record.success)
+    {
+        path.failures++;
+        return;
+    }
+    path.lastMs = record.totalMs;
+    if (path.bestMs == 0 || record.totalMs < path.bestMs)
+    {
+        path.bestMs = record.totalMs;
+    }
+}
+
+const wifi_connect_record_t &WifiConnectHistory::get(size_t newestFirst) const
+{
+    return records[(next + HISTORY_SIZE - 1 - newestFirst % HISTORY_SIZE) % HISTORY_SIZE];
+}
+
+WifiConnectHistory::PathStats WifiConnectHistory::pathStats(wifi_connect_path_t path) const
+{
+    if (path >= WIFI_PATH_COUNT)
+    {
+        PathStats none = {};
+        return none;
+    }
+    return stats[path];
+}
+
+const char *WifiConnectHistory::pathName(wifi_connect_path_t path)
+{
+    switch (path)
+    {
+        case WIFI_PATH_FAST:
+            return "fast";
+        case WIFI_PATH_FULL:
+            return "full";
+        case WIFI_PATH_AUTO:
+            return "auto";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef WIFI_CACHE_H
+#define WIFI_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// What is needed to rejoin the last network without a scan or a DHCP
+// exchange. Kept in NVS by WifiConnect; addresses are stored the way
+// IPAddress converts to uint32_t.
+typedef struct
+{
+    uint32_t version;
+    uint32_t credentialHash;  // the cache only applies to these credentials
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    uint8_t  leaseReuses;  // fast connects on the lease since DHCP last ran
+    uint32_t ip;           // last DHCP lease; 0 if none was seen
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+} wifi_cache_t;
+
+#define WIFI_CACHE_VERSION 1
+
+// FNV-1a over SSID and password; never 0
+uint32_t wifiCredentialHash(const char *ssid, const char *password);
+// True if the cache can drive a directed connect for these credentials
+bool wifiCacheUsable(const wifi_cache_t &cache, uint32_t credentialHash);
+bool wifiCacheHasLease(const wifi_cache_t &cache);
+
+typedef enum
+{
+    WIFI_PATH_FAST = 0,  // directed at the cached BSSID/channel
+    WIFI_PATH_FULL = 1,  // scan for the SSID
+    WIFI_PATH_AUTO = 2,  // reconnect driven by the WiFi driver after a drop
+    WIFI_PATH_COUNT
+} wifi_connect_path_t;
+
+typedef struct
+{
+    uint8_t  path;         // wifi_connect_path_t
+    bool     success;
+    bool     staticIp;     // no DHCP exchange (configured or cached lease)
+    uint32_t associateMs;  // start -> associated with the AP
+    uint32_t dhcpMs;       // associated -> got an IP
+    uint32_t totalMs;      // start -> got an IP, or -> given up
+} wifi_connect_record_t;
+
+// Recent connect attempts, newest first, so the effect of the cache on
+// reconnect time can be compared against full scans.
+class WifiConnectHistory
+{
+   public:
+    static const size_t HISTORY_SIZE = 8;
+
+    struct PathStats
+    {
+        uint32_t attempts;
+        uint32_t failures;
+        uint32_t lastMs;  // total of the last successful connect
+        uint32_t bestMs;
+    };
+
+    WifiConnectHistory();
+
+    void                         add(const wifi_connect_record_t &record);
+    size_t                       count() const { return entries; }
+    const wifi_connect_record_t &get(size_t newestFirst) const;
+    PathStats                    pathStats(wifi_connect_path_t path) const;
+
+    static const char *pathName(wifi_connect_path_t path);
+
+   private:
+    wifi_connect_record_t records[HISTORY_SIZE];
+    size_t                next;
+    size_t                entries;
+    PathStats             stats[WIFI_PATH_COUNT];
+};
+
+#endif  // WIFI_CACHE_H
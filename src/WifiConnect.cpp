@@ -0,0 +1,275 @@
+#include "WifiConnect.h"
+
+#include <Preferences.h>
+
+#include "Logger.h"
+#include "SettingsManager.h"
+
+#define WIFI_CACHE_NAMESPACE "wifi"
+#define WIFI_CACHE_KEY "cache"
+
+WifiConnect &WifiConnect::getInstance()
+{
+    static WifiConnect instance;
+    return instance;
+}
+
+WifiConnect::WifiConnect()
+{
+    memset(&cache, 0, sizeof(cache));
+    credentialHash = 0;
+    attemptActive  = false;
+    attemptPath    = WIFI_PATH_FULL;
+    attemptStatic  = false;
+    attemptStartMs = 0;
+    associated     = false;
+    associatedMs   = 0;
+    gotIp          = false;
+    gotIpMs        = 0;
+    dropped        = false;
+    droppedMs      = 0;
+    apNotFound     = false;
+}
+
+void WifiConnect::begin()
+{
+    Preferences prefs;
+    if (prefs.begin(WIFI_CACHE_NAMESPACE, true))
+    {
+        if (prefs.getBytes(WIFI_CACHE_KEY, &cache, sizeof(cache)) != sizeof(cache))
+        {
+            memset(&cache, 0, sizeof(cache));
+        }
+        prefs.end();
+    }
+    credentialHash = wifiCredentialHash(settingsManager.getSSID().c_str(),
+                                        settingsManager.getPassword().c_str());
+    WiFi.onEvent(onWifiEvent);
+}
+
+void WifiConnect::onWifiEvent(arduino_event_id_t event, arduino_event_info_t info)
+{
+    WifiConnect &self = getInstance();
+    switch (event)
+    {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+            self.associatedMs = millis();
+            self.associated   = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            self.gotIpMs = millis();
+            self.gotIp   = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            if (info.wifi_sta_disconnected.reason == WIFI_REASON_NO_AP_FOUND)
+            {
+                self.apNotFound = true;
+            }
+            if (!self.dropped)
+            {
+                self.droppedMs = millis();
+                self.dropped   = true;
+            }
+            self.associated = false;
+            break;
+        default:
+            break;
+    }
+}
+
+bool WifiConnect::hasCache() const
+{
+    return wifiCacheUsable(cache, credentialHash);
+}
+
+void WifiConnect::clearCache()
+{
+    memset(&cache, 0, sizeof(cache));
+    Preferences prefs;
+    if (prefs.begin(WIFI_CACHE_NAMESPACE, false))
+    {
+        prefs.remove(WIFI_CACHE_KEY);
+        prefs.end();
+    }
+}
+
+bool WifiConnect::applyIpConfig(bool reuseLease)
+{
+    IPAddress ip, gateway, subnet, dns;
+    if (ip.fromString(settingsManager.getWifiStaticIp()) &&
+        gateway.fromString(settingsManager.getWifiGateway()) &&
+        subnet.fromString(settingsManager.getWifiSubnet()))
+    {
+        if (!dns.fromString(settingsManager.getWifiDns()))
+        {
+            dns = gateway;
+        }
+        WiFi.config(ip, gateway, subnet, dns);
+        return true;
+    }
+
+    if (reuseLease)
+    {
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet),
+                    IPAddress(cache.dns != 0 ? cache.dns : cache.gateway));
+        return true;
+    }
+
+    // All zero switches the station back to DHCP
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    return false;
+}
+
+void WifiConnect::connect(const String &newSsid, const String &newPassword)
+{
+    unsigned long now = millis();
+    if (attemptActive)
+    {
+        finishAttempt(false, now);
+    }
+    ssid           = newSsid;
+    password       = newPassword;
+    credentialHash = wifiCredentialHash(ssid.c_str(), password.c_str());
+    startAttempt(wifiCacheUsable(cache, credentialHash) ? WIFI_PATH_FAST : WIFI_PATH_FULL, now);
+}
+
+void WifiConnect::startAttempt(wifi_connect_path_t path, unsigned long now)
+{
+    associated     = false;
+    gotIp          = false;
+    dropped        = false;
+    apNotFound     = false;
+    attemptActive  = true;
+    attemptPath    = path;
+    attemptStartMs = now;
+
+    if (path == WIFI_PATH_FAST)
+    {
+        bool reuseLease = wifiCacheHasLease(cache) && cache.leaseReuses < MAX_LEASE_REUSES;
+        attemptStatic   = applyIpConfig(reuseLease);
+        logger.logf("WiFi fast connect: channel %u, %s", cache.channel,
+                    reuseLease ? "cached lease" : (attemptStatic ? "static IP" : "DHCP"));
+        WiFi.begin(ssid.c_str(), password.c_str(), cache.channel, cache.bssid, true);
+    }
+    else
+    {
+        attemptStatic = applyIpConfig(false);
+        WiFi.begin(ssid.c_str(), password.c_str());
+    }
+}
+
+void WifiConnect::finishAttempt(bool success, unsigned long now)
+{
+    wifi_connect_record_t record = {};
+    record.path                  = attemptPath;
+    record.success               = success;
+    record.staticIp              = attemptStatic;
+    record.totalMs               = (success ? gotIpMs : now) - attemptStartMs;
+    if (associated || success)
+    {
+        record.associateMs = associatedMs - attemptStartMs;
+        record.dhcpMs      = success ? gotIpMs - associatedMs : 0;
+    }
+    history.add(record);
+    attemptActive = false;
+
+    logger.logf("WiFi %s connect %s in %lu ms (associate %lu ms, IP %lu ms)",
+                WifiConnectHistory::pathName((wifi_connect_path_t) record.path),
+                success ? "succeeded" : "failed", (unsigned long) record.totalMs,
+                (unsigned long) record.associateMs, (unsigned long) record.dhcpMs);
+}
+
+// Refreshes the cache from the live connection; writes NVS only on change
+void WifiConnect::storeCache()
+{
+    wifi_cache_t next = {};
+    next.version        = WIFI_CACHE_VERSION;
+    next.credentialHash = credentialHash;
+    uint8_t *bssid      = WiFi.BSSID();
+    if (bssid != nullptr)
+    {
+        memcpy(next.bssid, bssid, sizeof(next.bssid));
+    }
+    next.channel = (uint8_t) WiFi.channel();
+
+    bool sameNetwork = wifiCacheUsable(cache, credentialHash);
+    if (!attemptStatic)
+    {
+        // A fresh DHCP lease
+        next.ip          = (uint32_t) WiFi.localIP();
+        next.gateway     = (uint32_t) WiFi.gatewayIP();
+        next.subnet      = (uint32_t) WiFi.subnetMask();
+        next.dns         = (uint32_t) WiFi.dnsIP(0);
+        next.leaseReuses = 0;
+    }
+    else if (sameNetwork)
+    {
+        next.ip          = cache.ip;
+        next.gateway     = cache.gateway;
+        next.subnet      = cache.subnet;
+        next.dns         = cache.dns;
+        next.leaseReuses = cache.leaseReuses;
+        if (attemptPath == WIFI_PATH_FAST && wifiCacheHasLease(cache) &&
+            settingsManager.getWifiStaticIp().isEmpty())
+        {
+            next.leaseReuses++;
+        }
+    }
+
+    if (memcmp(&next, &cache, sizeof(cache)) == 0)
+    {
+        return;
+    }
+    cache = next;
+    Preferences prefs;
+    if (prefs.begin(WIFI_CACHE_NAMESPACE, false))
+    {
+        prefs.putBytes(WIFI_CACHE_KEY, &cache, sizeof(cache));
+        prefs.end();
+    }
+}
+
+void WifiConnect::loop(unsigned long currentTime)
+{
+    if (attemptActive)
+    {
+        // Associating and getting an address time out separately. The
+        // association event can land after currentTime was taken.
+        bool fastTimedOut =
+            associated ? (long) (currentTime - associatedMs) >= (long) FAST_DHCP_TIMEOUT_MS
+                       : apNotFound || currentTime - attemptStartMs >= FAST_CONNECT_TIMEOUT_MS;
+        if (gotIp)
+        {
+            finishAttempt(true, currentTime);
+            storeCache();
+            gotIp   = false;
+            dropped = false;
+        }
+        else if (attemptPath == WIFI_PATH_FAST && fastTimedOut)
+        {
+            // The AP moved channel, changed BSSID or is gone, or the cached
+            // network no longer hands out an address
+            finishAttempt(false, currentTime);
+            clearCache();
+            WiFi.disconnect();
+            startAttempt(WIFI_PATH_FULL, currentTime);
+        }
+        return;
+    }
+
+    if (dropped && gotIp)
+    {
+        // The driver rejoined on its own after a drop
+        wifi_connect_record_t record = {};
+        record.path                  = WIFI_PATH_AUTO;
+        record.success               = true;
+        record.staticIp              = attemptStatic;
+        record.associateMs           = associatedMs - droppedMs;
+        record.dhcpMs                = gotIpMs - associatedMs;
+        record.totalMs               = gotIpMs - droppedMs;
+        history.add(record);
+        logger.logf("WiFi rejoined after a drop in %lu ms", (unsigned long) record.totalMs);
+        dropped = false;
+        gotIp   = false;
+    }
+}
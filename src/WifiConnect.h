@@ -0,0 +1,83 @@
+#ifndef WIFI_CONNECT_H
+#define WIFI_CONNECT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "WifiCache.h"
+
+// Joins the configured network as quickly as it can.
+//
+// After each successful connect, the BSSID, channel and DHCP lease are cached
+// in NVS. The next connect with the same credentials goes straight to that
+// access point on that channel, with the cached lease applied statically,
+// skipping both the scan and the DHCP exchange. If that hasn't associated
+// within FAST_CONNECT_TIMEOUT_MS, or the AP is gone, the cache is dropped and
+// a normal scan + DHCP connect follows. Once associated, getting an address
+// has FAST_DHCP_TIMEOUT_MS of its own before the same fallback, so a slow
+// DHCP server doesn't cost a good association. The lease is reused at most
+// MAX_LEASE_REUSES times in a row before DHCP runs again to refresh it. A
+// static IP from settings, when set, replaces DHCP on both paths.
+//
+// Every attempt, and every reconnect the WiFi driver makes by itself after a
+// drop, is timed per phase (associate, DHCP) into a WifiConnectHistory.
+class WifiConnect
+{
+   public:
+    static const unsigned long FAST_CONNECT_TIMEOUT_MS = 3000;
+    static const unsigned long FAST_DHCP_TIMEOUT_MS    = 10000;  // after associating
+    static const uint8_t       MAX_LEASE_REUSES        = 3;
+
+    static WifiConnect &getInstance();
+
+    // Call once from setup(); loads the cache and hooks the WiFi events
+    void begin();
+    // Starts joining the network (non-blocking); poll loop() until connected
+    void connect(const String &ssid, const String &password);
+    // Falls back from a failed fast attempt, records timings and stores a
+    // new cache. Call every loop pass and while waiting for a connection.
+    void loop(unsigned long currentTime);
+    void clearCache();
+
+    bool                      hasCache() const;
+    wifi_cache_t              getCache() const { return cache; }
+    const WifiConnectHistory &getHistory() const { return history; }
+
+   private:
+    wifi_cache_t       cache;
+    uint32_t           credentialHash;
+    WifiConnectHistory history;
+    String             ssid;
+    String             password;
+
+    bool          attemptActive;
+    uint8_t       attemptPath;  // wifi_connect_path_t
+    bool          attemptStatic;
+    unsigned long attemptStartMs;
+
+    // Written from the WiFi event task, consumed by loop()
+    volatile bool          associated;
+    volatile unsigned long associatedMs;
+    volatile bool          gotIp;
+    volatile unsigned long gotIpMs;
+    volatile bool          dropped;
+    volatile unsigned long droppedMs;
+    volatile bool          apNotFound;
+
+    WifiConnect();
+
+    WifiConnect(const WifiConnect &)            = delete;
+    WifiConnect &operator=(const WifiConnect &) = delete;
+
+    static void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info);
+
+    void startAttempt(wifi_connect_path_t path, unsigned long now);
+    void finishAttempt(bool success, unsigned long now);
+    // Returns true if the station will skip DHCP
+    bool applyIpConfig(bool reuseLease);
+    void storeCache();
+};
+
+#define wifiConnect WifiConnect::getInstance()
+
+#endif  // WIFI_CONNECT_H
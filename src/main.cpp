@@ -1,12 +1,24 @@
 #include <Arduino.h>
 #include <ESPmDNS.h>
 #include <WiFi.h>
+#include <esp_sntp.h>
+#include <sys/time.h>
 
+#include "BootTimeline.h"
 #include "ElegooCC.h"
+#include "EventBus.h"
 #include "LittleFS.h"
+#include "LogFileSink.h"
 #include "Logger.h"
+#include "MdnsTxt.h"
+#include "MemoryMonitor.h"
+#include "Notifier.h"
+#include "PulseCapture.h"
+#include "UdpSyslogSink.h"
 #include "SettingsManager.h"
+#include "TimeService.h"
 #include "WebServer.h"
+#include "WifiConnect.h"
 #include "improv.h"
 #include "time.h"
 
@@ -32,6 +44,9 @@ const char* chipFamily      = GET_VERSION_STRING(CHIP_FAMILY_RAW, "Unknown");
 #define WIFI_CHECK_INTERVAL 30000     // Check WiFi every 30 seconds
 #define WIFI_RECONNECT_TIMEOUT 10000  // Wait 10 seconds for reconnection
 #define NTP_SYNC_INTERVAL 3600000     // Re-sync with NTP every hour (3600000 ms)
+#define NTP_SYNC_GRACE 60000          // Slack past the interval before a sync counts as missed
+#define WIFI_CONNECT_POLL_MS 100      // How often to poll for station connection
+#define WIFI_CONNECT_TIMEOUT 30000    // Give up on a station connection after 30 seconds
 
 // NTP server to request epoch time
 const char* ntpServer = "pool.ntp.org";
@@ -49,11 +64,20 @@ bool isElegooSetup    = false;
 bool isWebServerSetup = false;
 bool isNtpSetup       = false;
 
+// Last station state published on the event bus
+bool wasWifiConnected = false;
+
+// Per-device mDNS name and the live status advertised in _ccsfs._tcp TXT records
+char           deviceHostname[24] = MDNS_HOSTNAME_PREFIX;
+MdnsTxtRecords mdnsTxt;
+bool           isMdnsStarted      = false;
+bool           mdnsStatusStale    = true;
+
 // Used by improv-wifi to parse serial data
 uint8_t x_buffer[16];
 uint8_t x_position = 0;
 
-// Variables to track NTP synchronization
+// Variables to track NTP synchronization (last completed sync or retry)
 unsigned long lastNTPSyncAttempt = 0;
 
 // If wifi fails, revert to AP mode and restart (only if never connected before);
@@ -88,11 +112,13 @@ void startAPMode()
     WiFi.softAP("ElegooXBTTSFS20", "elegooccsfs20");
     // Stop mDNS as it's not needed in AP mode
     MDNS.end();
+    isMdnsStarted = false;
 }
 
 void handleSuccessfulWifiConnection()
 {
     logger.log("WiFi Connected");
+    bootTimeline.mark(BOOT_PHASE_WIFI_CONNECTED);
 
     // Mark that WiFi has successfully connected at least once
     if (!settingsManager.getHasConnected())
@@ -107,10 +133,60 @@ void handleSuccessfulWifiConnection()
 
     // Start/restart mDNS for station mode
     MDNS.end();
-    if (!MDNS.begin("ccxsfs20"))
+    isMdnsStarted = false;
+    if (!MDNS.begin(deviceHostname))
     {
         logger.log("Error setting up MDNS responder!");
+        return;
     }
+    MDNS.addService("http", "tcp", 80);
+    MDNS.addService(MDNS_SERVICE_NAME, MDNS_SERVICE_PROTO, 80);
+    logger.logf("mDNS: %s.local advertising _%s._%s", deviceHostname, MDNS_SERVICE_NAME,
+                MDNS_SERVICE_PROTO);
+    // The new responder has no TXT records yet; send them all on the next pass
+    mdnsTxt.markAllDirty();
+    isMdnsStarted = true;
+}
+
+void markMdnsStatusStale(const event_t&, void*)
+{
+    mdnsStatusStale = true;
+}
+
+// Refreshes the TXT values after printer events and pushes changed ones,
+// rate limited by MdnsTxtRecords.
+void updateMdnsTxt(unsigned long currentTime)
+{
+    if (!isMdnsStarted)
+    {
+        return;
+    }
+    if (mdnsStatusStale)
+    {
+        mdnsStatusStale     = false;
+        printer_info_t info = elegooCC.getCurrentInformation();
+        char           state[8];
+        snprintf(state, sizeof(state), "%d", (int) info.printStatus);
+        mdnsTxt.set("fw", firmwareVersion);
+        mdnsTxt.set("printer", settingsManager.getElegooIP().c_str());
+        mdnsTxt.set("state", state);
+        mdnsTxt.set("jam", info.filamentStopped ? "1" : "0");
+        mdnsTxt.set("runout", info.filamentRunout ? "1" : "0");
+        mdnsTxt.set("ws", info.isWebsocketConnected ? "1" : "0");
+    }
+    if (!mdnsTxt.due(currentTime))
+    {
+        return;
+    }
+    for (size_t i = 0; i < mdnsTxt.count(); i++)
+    {
+        if (mdnsTxt.isDirty(i))
+        {
+            MDNS.addServiceTxt(MDNS_SERVICE_NAME, MDNS_SERVICE_PROTO, mdnsTxt.key(i),
+                               mdnsTxt.value(i));
+        }
+    }
+    mdnsTxt.markPushed(currentTime);
 }
 
 bool connectToWifiStation(bool isReconnect = false)
@@ -118,14 +194,22 @@ bool connectToWifiStation(bool isReconnect = false)
     const char* action = isReconnect ? "Reconnecting to" : "Connecting to";
     logger.logf("%s WiFi: %s", action, settingsManager.getSSID().c_str());
 
-    WiFi.begin(settingsManager.getSSID().c_str(), settingsManager.getPassword().c_str());
+    wifiConnect.connect(settingsManager.getSSID(), settingsManager.getPassword());
 
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 30)
+    // Poll at a short interval so we move on as soon as the station is up,
+    // rather than rounding every connect up to the next whole second.
+    unsigned long connectStart = millis();
+    unsigned long lastDot      = connectStart;
+    while (WiFi.status() != WL_CONNECTED && (millis() - connectStart) < WIFI_CONNECT_TIMEOUT)
     {
-        Serial.print('.');
-        delay(1000);
-        attempts++;
+        if (millis() - lastDot >= 1000)
+        {
+            Serial.print('.');
+            lastDot = millis();
+        }
+        delay(WIFI_CONNECT_POLL_MS);
+        // Falls back to a full scan if the cached AP doesn't answer
+        wifiConnect.loop(millis());
     }
 
     Serial.println();
@@ -209,7 +293,7 @@ void checkWifiConnection()
         if (!isReconnecting)
         {
             logger.log("WiFi disconnected, attempting to reconnect...");
-            WiFi.begin(settingsManager.getSSID().c_str(), settingsManager.getPassword().c_str());
+            wifiConnect.connect(settingsManager.getSSID(), settingsManager.getPassword());
             wifiReconnectStart = millis();
             isReconnecting     = true;
         }
@@ -240,6 +324,48 @@ void checkWifiConnection()
     }
 }
 
+void handleSettingsChanged(const event_t& event, void* context)
+{
+    uint32_t changed = event.data.settingsChanged.changed;
+    if (changed & SETTINGS_CHANGED_SYSLOG)
+    {
+        udpSyslogSink.configure(settingsManager.getSyslogHost(),
+                                (uint16_t) settingsManager.getSyslogPort(),
+                                (log_level_t) settingsManager.getSyslogLevel());
+    }
+    if (changed & SETTINGS_CHANGED_NOTIFY)
+    {
+        notifier.configure(settingsManager.getNotifyUrl(), settingsManager.getNotifyTemplate(),
+                           (uint32_t) settingsManager.getNotifyEvents());
+    }
+    if (changed & SETTINGS_CHANGED_FLASH_LOG)
+    {
+        logFileSink.setEnabled(settingsManager.getFlashLogging());
+    }
+    if (changed & SETTINGS_CHANGED_SENSOR)
+    {
+        pulseCapture.setMinEdgeIntervalUs((uint32_t) settingsManager.getMovementMinEdgeUs());
+    }
+    if (changed & SETTINGS_CHANGED_WIFI)
+    {
+        reconnectWifiWithNewCredentials();
+    }
+}
+
+void publishWifiLink(bool connected)
+{
+    if (connected == wasWifiConnected)
+    {
+        return;
+    }
+    wasWifiConnected     = connected;
+    event_t event        = {};
+    event.type           = connected ? EVENT_LINK_UP : EVENT_LINK_DOWN;
+    event.timestampUs    = timeService.nowUs();
+    event.data.link.link = EVENT_LINK_WIFI;
+    eventBus.publish(event);
+}
+
 void setup()
 {
     // put your setup code here, to run once:
@@ -249,28 +375,95 @@ void setup()
 
     // Initialize logging system
     logger.log("ESP SFS System starting up...");
+    bootTimeline.mark(BOOT_PHASE_SETUP_START);
     logger.logf("Firmware version: %s", firmwareVersion);
     logger.logf("Chip family: %s", chipFamily);
 
     SPIFFS.begin();  // note: this must be done before wifi/server setup
     logger.log("Filesystem initialized");
+    bootTimeline.mark(BOOT_PHASE_FILESYSTEM_MOUNTED);
 
     // Load settings early
     settingsManager.load();
     logger.log("Settings Manager Loaded");
+    bootTimeline.mark(BOOT_PHASE_SETTINGS_LOADED);
+
+    // Cached BSSID/channel/lease for the fast connect path
+    wifiConnect.begin();
+
+    uint64_t efuseMac = ESP.getEfuseMac();
+    uint8_t  mac[6];
+    for (int i = 0; i < 6; i++)
+    {
+        mac[i] = (uint8_t) (efuseMac >> (8 * i));
+    }
+    mdnsHostnameFromMac(mac, deviceHostname, sizeof(deviceHostname));
+    logger.logf("Device hostname: %s", deviceHostname);
+    udpSyslogSink.setHostname(deviceHostname);
+
+    // Keeps the previous boot's log and starts persisting this one
+    logFileSink.begin(settingsManager.getFlashLogging());
+    // Lines queue until WiFi is up, then ship to the collector (if any)
+    udpSyslogSink.configure(settingsManager.getSyslogHost(),
+                            (uint16_t) settingsManager.getSyslogPort(),
+                            (log_level_t) settingsManager.getSyslogLevel());
+    // Webhook notifications; saved ones from before a reboot go out first
+    notifier.setHostname(deviceHostname);
+    notifier.configure(settingsManager.getNotifyUrl(), settingsManager.getNotifyTemplate(),
+                       (uint32_t) settingsManager.getNotifyEvents());
+    notifier.begin();
+
+    eventBus.subscribe(EVENT_BIT(EVENT_SETTINGS_CHANGED), handleSettingsChanged);
+    eventBus.subscribe(EVENT_BIT(EVENT_PRINT_STATE) | EVENT_BIT(EVENT_FRAME) |
+                           EVENT_BIT(EVENT_JAM) | EVENT_BIT(EVENT_SETTINGS_CHANGED) |
+                           EVENT_BIT(EVENT_LINK_UP) | EVENT_BIT(EVENT_LINK_DOWN),
+                       markMdnsStatusStale);
+
+    memoryMonitor.begin();
+
+    // Sensor edges are captured by IRAM interrupt handlers from here on
+    pulseCapture.setMinEdgeIntervalUs((uint32_t) settingsManager.getMovementMinEdgeUs());
+    pulseCapture.begin();
 }
 
+// Maps the monotonic log/event clock onto the wall-clock time SNTP just set.
+// Stored timestamps are converted through this offset on export, so a
+// correction moves history as a whole instead of leaving a jump in it.
+void updateEpochFromSystemTime()
+{
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    uint64_t epochUs = (uint64_t) now.tv_sec * 1000000ULL + (uint64_t) now.tv_usec;
+    bool     resync  = timeService.hasEpoch();
+    timeService.setEpoch(epochUs, timeService.nowUs());
+    if (resync)
+    {
+        logger.logf("Clock offset corrected by %lld us", (long long) timeService.getLastStepUs());
+    }
+}
+
+// SNTP reports each completed sync once, then resets the status. The system
+// clock can't tell us this: once set, getLocalTime() succeeds whether or not
+// the server answered since.
 void syncTimeWithNTP(unsigned long currentTime)
 {
-    struct tm timeinfo;
-    lastNTPSyncAttempt = currentTime;
-    if (getLocalTime(&timeinfo))
+    if (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED)
     {
+        lastNTPSyncAttempt = currentTime;
+        updateEpochFromSystemTime();
         logger.log("NTP time synchronization successful");
+        if (!bootTimeline.hasReached(BOOT_PHASE_NTP_SYNCED))
+        {
+            bootTimeline.mark(BOOT_PHASE_NTP_SYNCED);
+        }
     }
-    else
+    else if (currentTime - lastNTPSyncAttempt >= NTP_SYNC_INTERVAL + NTP_SYNC_GRACE)
     {
+        // Nothing for a whole interval; ask SNTP to try again now. Don't wait
+        // for it here, a blocking wait stalls the websocket and detection loop.
+        lastNTPSyncAttempt = currentTime;
         logger.log("NTP time synchronization failed");
+        sntp_restart();
     }
 }
 
@@ -433,23 +626,13 @@ void loop()
         isWifiSetup = wifiSetup();
         isWifiSetup = true;
         logger.log("Wifi setup complete");
-        return;  //
-    }
-    if (!isWebServerSetup)
-    {
-        webServer.begin();
-        isWebServerSetup = true;
-        logger.log("Webserver setup complete");
-        return;  //
+        // Carry on in this same pass so the printer websocket starts right away
+        isWifiConnected = !settingsManager.isAPMode() && WiFi.status() == WL_CONNECTED;
     }
 
-    // Check if WiFi reconnection is requested
-
-    if (settingsManager.requestWifiReconnect)
-    {
-        settingsManager.requestWifiReconnect = false;
-        reconnectWifiWithNewCredentials();
-    }
+    publishWifiLink(isWifiConnected);
+    // Settings changes, link changes and printer events reach subscribers here
+    eventBus.dispatch();
 
     if (isWifiConnected)
     {
@@ -457,18 +640,22 @@ void loop()
         {
             elegooCC.setup();
             logger.log("Elegoo setup complete");
+            bootTimeline.mark(BOOT_PHASE_ELEGOO_STARTED);
             isElegooSetup = true;
         }
         elegooCC.loop();
+        updateMdnsTxt(currentTime);
 
         if (!isNtpSetup)
         {
+            // SNTP syncs in the background; detection doesn't wait for it.
+            sntp_set_sync_interval(NTP_SYNC_INTERVAL);
             configTime(0, 0, ntpServer);
-            syncTimeWithNTP(currentTime);
+            lastNTPSyncAttempt = currentTime;
             logger.log("NTP setup complete");
             isNtpSetup = true;
         }
-        else if (currentTime - lastNTPSyncAttempt >= NTP_SYNC_INTERVAL)
+        else
         {
             syncTimeWithNTP(currentTime);
         }
@@ -478,5 +665,15 @@ void loop()
         checkWifiConnection();
     }
 
+    if (!isWebServerSetup)
+    {
+        webServer.begin();
+        isWebServerSetup = true;
+        logger.log("Webserver setup complete");
+        bootTimeline.mark(BOOT_PHASE_WEBSERVER_STARTED);
+    }
+
     webServer.loop();
+    wifiConnect.loop(currentTime);
+    memoryMonitor.loop(currentTime);
 }
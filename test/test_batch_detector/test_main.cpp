@@ -0,0 +1,249 @@
+#include <unity.h>
+
+#include "../../src/BatchDetector.h"
+#include "../../src/AggregatedBacklog.cpp"
+#include "../../src/BatchDetector.cpp"
+#include "../../src/FilamentFlowTracker.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static const size_t CONFIGS = 12;
+
+static float configThreshold(size_t i)
+{
+    return i == 0 ? 0.0f : 2.0f + 1.5f * (float) (i % 6);
+}
+
+static uint32_t configHold(size_t i)
+{
+    return (uint32_t) (500 + 250 * (i % 5));
+}
+
+static float configMmPerPulse(size_t i)
+{
+    return i == 1 ? 0.0f : 0.9f + 0.17f * (float) i;
+}
+
+static uint32_t rng = 12345;
+
+static uint32_t nextRandom()
+{
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// Status frames every 250 ms with deltas and a running total, pulses in
+// between. Stretches with no pulses are jams, long enough to overflow the
+// tracker's chunk ring; occasional negative deltas are retractions.
+template <typename Each>
+static void runStream(Each each)
+{
+    rng         = 12345;
+    float total = 0;
+    for (uint32_t step = 0; step < 4000; step++)
+    {
+        uint32_t now    = 1000 + step * 50;
+        bool     jammed = (step / 400) % 3 == 2;
+        if (step % 5 == 0)
+        {
+            float delta = (float) (nextRandom() % 400) / 100.0f;
+            if (nextRandom() % 10 == 0)
+            {
+                delta = -delta * 0.5f;
+            }
+            total += delta;
+            each(0, now, delta, total);
+        }
+        if (!jammed && nextRandom() % 3 != 0)
+        {
+            each(1, now, 0.0f, 0.0f);
+        }
+        if (step == 2100)
+        {
+            each(3, now, 0.0f, total);
+        }
+        each(2, now, 0.0f, 0.0f);
+    }
+}
+
+void test_tracker_mode_matches_flow_tracker()
+{
+    BatchDetector       batch;
+    FilamentFlowTracker trackers[CONFIGS];
+    for (size_t i = 0; i < CONFIGS; i++)
+    {
+        batch.addConfig(configThreshold(i), configHold(i), configMmPerPulse(i));
+    }
+
+    size_t mismatches = 0;
+    size_t triggers   = 0;
+    runStream(
+        [&](int kind, uint32_t now, float delta, float total)
+        {
+            (void) total;
+            if (kind == 0)
+            {
+                batch.onTelemetry(true, total, true, delta);
+            }
+            else if (kind == 1)
+            {
+                batch.onPulse();
+            }
+            else if (kind == 3)
+            {
+                batch.resume(total);
+            }
+            else
+            {
+                batch.evaluate(now);
+            }
+            for (size_t i = 0; i < CONFIGS; i++)
+            {
+                float mm = configMmPerPulse(i) > 0 ? configMmPerPulse(i) : 1.5f;
+                if (kind == 0 && delta > 0)
+                {
+                    trackers[i].addExpected(delta, now, 0);
+                }
+                else if (kind == 0 && delta < 0)
+                {
+                    trackers[i].addActual(-delta);
+                }
+                else if (kind == 1)
+                {
+                    trackers[i].addActual(mm);
+                }
+                else if (kind == 3)
+                {
+                    trackers[i].reset();
+                }
+                else if (kind == 2)
+                {
+                    float value = trackers[i].outstanding(now, 0);
+                    bool  sat   = trackers[i].deficitSatisfied(value, now, configThreshold(i),
+                                                               configHold(i));
+                    if (value != batch.deficitMm(i) || sat != batch.satisfied(i))
+                    {
+                        mismatches++;
+                    }
+                    triggers += sat ? 1 : 0;
+                }
+            }
+        });
+
+    TEST_ASSERT_EQUAL(0, mismatches);
+    TEST_ASSERT_TRUE(triggers > 0);
+}
+
+static void checkAggregatedMode(batch_mode_t mode)
+{
+    // One AggregatedBacklog per configuration, as ElegooCC runs it
+    BatchDetector     batch;
+    AggregatedBacklog scalar[CONFIGS];
+    batch.setMode(mode);
+    for (size_t i = 0; i < CONFIGS; i++)
+    {
+        batch.addConfig(configThreshold(i), configHold(i), configMmPerPulse(i));
+    }
+
+    size_t mismatches = 0;
+    size_t triggers   = 0;
+    runStream(
+        [&](int kind, uint32_t now, float delta, float total)
+        {
+            if (kind == 0)
+            {
+                batch.onTelemetry(true, total, true, delta);
+            }
+            else if (kind == 1)
+            {
+                batch.onPulse();
+            }
+            else if (kind == 3)
+            {
+                batch.resume(total);
+            }
+            else
+            {
+                batch.evaluate(now);
+            }
+            for (size_t i = 0; i < CONFIGS; i++)
+            {
+                float mm = configMmPerPulse(i) > 0 ? configMmPerPulse(i) : 1.5f;
+                if (kind == 0)
+                {
+                    scalar[i].onTelemetry(mode, true, total, true, delta);
+                }
+                else if (kind == 1)
+                {
+                    scalar[i].onPulse(mode, mm);
+                }
+                else if (kind == 3)
+                {
+                    scalar[i].resume(mode, total);
+                }
+                else
+                {
+                    float value = scalar[i].outstanding() < 0 ? 0 : scalar[i].outstanding();
+                    bool  sat   = scalar[i].deficitSatisfied(value, now, configThreshold(i),
+                                                             configHold(i));
+                    if (value != batch.deficitMm(i) || sat != batch.satisfied(i))
+                    {
+                        mismatches++;
+                    }
+                    triggers += sat ? 1 : 0;
+                }
+            }
+        });
+
+    TEST_ASSERT_EQUAL(0, mismatches);
+    TEST_ASSERT_TRUE(triggers > 0);
+}
+
+void test_delta_mode_matches_aggregated_backlog()
+{
+    checkAggregatedMode(BATCH_MODE_DELTA);
+}
+
+void test_total_mode_matches_aggregated_backlog()
+{
+    checkAggregatedMode(BATCH_MODE_TOTAL);
+}
+
+void test_first_trigger_and_capacity()
+{
+    BatchDetector batch;
+    batch.setMode(BATCH_MODE_DELTA);
+    TEST_ASSERT_EQUAL(0, batch.addConfig(5.0f, 1000, 1.0f));
+    TEST_ASSERT_EQUAL(1, batch.addConfig(20.0f, 1000, 1.0f));
+    for (size_t i = 2; i < BatchDetector::MAX_CONFIGS; i++)
+    {
+        batch.addConfig(5.0f, 1000, 1.0f);
+    }
+    TEST_ASSERT_EQUAL(-1, batch.addConfig(5.0f, 1000, 1.0f));
+
+    batch.onTelemetry(false, 0, true, 10.0f);
+    batch.evaluate(100);
+    TEST_ASSERT_FALSE(batch.satisfied(0));
+    TEST_ASSERT_EQUAL(BatchDetector::MAX_CONFIGS - 1, batch.evaluate(1100));
+    TEST_ASSERT_EQUAL(1100, batch.firstSatisfiedMs(0));
+    TEST_ASSERT_EQUAL(0, batch.firstSatisfiedMs(1));
+
+    // Stays at the first trigger while the deficit holds
+    batch.evaluate(1500);
+    TEST_ASSERT_EQUAL(1100, batch.firstSatisfiedMs(0));
+
+    batch.reset();
+    TEST_ASSERT_EQUAL(0, batch.firstSatisfiedMs(0));
+    TEST_ASSERT_EQUAL(0, batch.evaluate(2000));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tracker_mode_matches_flow_tracker);
+    RUN_TEST(test_delta_mode_matches_aggregated_backlog);
+    RUN_TEST(test_total_mode_matches_aggregated_backlog);
+    RUN_TEST(test_first_trigger_and_capacity);
+    return UNITY_END();
+}
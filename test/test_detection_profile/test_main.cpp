@@ -0,0 +1,110 @@
+#include <unity.h>
+
+#include "../../src/DetectionProfile.h"
+#include "../../src/DetectionProfile.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static void addMaterials(DetectionProfiles &profiles)
+{
+    profiles.add("TPU", "tpu|tpe|95a", 20.0f, 4000, 1.4f);
+    profiles.add("PETG", "petg", 10.0f, 2000, 1.5f);
+}
+
+void test_default_profile_until_something_matches()
+{
+    DetectionProfiles profiles;
+    profiles.setDefault(8.4f, 1500, 1.5f);
+    addMaterials(profiles);
+
+    TEST_ASSERT_EQUAL_STRING("default", profiles.active().name);
+    const detection_profile_t &selected = profiles.selectForJob("", "benchy_PLA_0.2mm.gcode");
+    TEST_ASSERT_EQUAL_STRING("default", selected.name);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 8.4f, selected.expectedDeficitMm);
+}
+
+void test_filename_match_is_case_insensitive_and_first_wins()
+{
+    DetectionProfiles profiles;
+    addMaterials(profiles);
+
+    TEST_ASSERT_EQUAL_STRING("TPU", profiles.selectForJob("", "Phone_Case_TPE.gcode").name);
+    TEST_ASSERT_EQUAL_STRING("PETG", profiles.selectForJob(nullptr, "bracket-PETG.gcode").name);
+    TEST_ASSERT_EQUAL_STRING("TPU", profiles.selectForJob("", "gasket_95A_petg.gcode").name);
+    TEST_ASSERT_EQUAL_UINT32(4000, profiles.active().flowWindowMs);
+}
+
+void test_forced_profile_overrides_filename()
+{
+    DetectionProfiles profiles;
+    addMaterials(profiles);
+
+    TEST_ASSERT_EQUAL_STRING("PETG", profiles.selectForJob("PETG", "case_tpu.gcode").name);
+    TEST_ASSERT_EQUAL_STRING("default", profiles.selectForJob("default", "case_tpu.gcode").name);
+    // Unknown forced name falls back to matching.
+    TEST_ASSERT_EQUAL_STRING("TPU", profiles.selectForJob("ABS", "case_tpu.gcode").name);
+}
+
+void test_rejects_duplicates_reserved_names_and_overflow()
+{
+    DetectionProfiles profiles;
+    TEST_ASSERT_TRUE(profiles.add("A", "a", 1, 1, 1));
+    TEST_ASSERT_FALSE(profiles.add("A", "b", 1, 1, 1));
+    TEST_ASSERT_FALSE(profiles.add("default", "c", 1, 1, 1));
+    TEST_ASSERT_FALSE(profiles.add("", "d", 1, 1, 1));
+    const char *names[] = {"B", "C", "D", "E", "F", "G"};
+    for (const char *name : names)
+    {
+        profiles.add(name, "", 1, 1, 1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(DetectionProfiles::MAX_PROFILES, profiles.count());
+    TEST_ASSERT_FALSE(profiles.selectByName("G"));
+
+    profiles.add("a-very-long-profile-name", "x", 1, 1, 1);
+    TEST_ASSERT_EQUAL_UINT32(DetectionProfiles::MAX_PROFILES, profiles.count());
+}
+
+void test_reload_keeps_active_profile_by_name()
+{
+    DetectionProfiles profiles;
+    addMaterials(profiles);
+    profiles.selectByName("PETG");
+
+    profiles.clear();
+    profiles.add("PETG", "petg", 12.0f, 2500, 1.5f);
+    profiles.add("TPU", "tpu", 20.0f, 4000, 1.4f);
+    TEST_ASSERT_EQUAL_STRING("PETG", profiles.active().name);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 12.0f, profiles.active().expectedDeficitMm);
+
+    profiles.clear();
+    profiles.add("TPU", "tpu", 20.0f, 4000, 1.4f);
+    TEST_ASSERT_EQUAL_STRING("default", profiles.active().name);
+}
+
+void test_copy_is_independent_of_the_original()
+{
+    DetectionProfiles profiles;
+    addMaterials(profiles);
+    profiles.selectByName("TPU");
+
+    // Settings swap in a rebuilt copy while the loop holds the old one
+    DetectionProfiles copy = profiles;
+    profiles.clear();
+    profiles.add("PLA", "pla", 5.0f, 1000, 1.5f);
+    TEST_ASSERT_EQUAL_STRING("TPU", copy.active().name);
+    TEST_ASSERT_EQUAL_UINT32(4000, copy.active().flowWindowMs);
+    TEST_ASSERT_EQUAL_STRING("default", profiles.active().name);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_default_profile_until_something_matches);
+    RUN_TEST(test_filename_match_is_case_insensitive_and_first_wins);
+    RUN_TEST(test_forced_profile_overrides_filename);
+    RUN_TEST(test_rejects_duplicates_reserved_names_and_overflow);
+    RUN_TEST(test_reload_keeps_active_profile_by_name);
+    RUN_TEST(test_copy_is_independent_of_the_original);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+#include <unity.h>
+
+#include "../../src/EventBus.h"
+#include "../../src/EventBus.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+struct Recorder
+{
+    event_t   events[64];
+    size_t    count;
+    EventBus *bus;  // set to publish a follow-up from inside the handler
+};
+
+static void record(const event_t &event, void *context)
+{
+    Recorder *recorder = static_cast<Recorder *>(context);
+    recorder->events[recorder->count++] = event;
+    if (recorder->bus != nullptr && event.type == EVENT_JAM)
+    {
+        event_t ack               = {};
+        ack.type                  = EVENT_PAUSE_ACK;
+        ack.data.pauseAck.command = 129;
+        recorder->bus->publish(ack);
+    }
+}
+
+static event_t makeEvent(event_type_t type, uint64_t timestampUs)
+{
+    event_t event     = {};
+    event.type        = type;
+    event.timestampUs = timestampUs;
+    return event;
+}
+
+void test_events_reach_matching_subscribers_in_order()
+{
+    EventBus bus;
+    Recorder all  = {};
+    Recorder link = {};
+    TEST_ASSERT_TRUE(bus.subscribe(0xFFFFFFFFUL, record, &all));
+    TEST_ASSERT_TRUE(
+        bus.subscribe(EVENT_BIT(EVENT_LINK_UP) | EVENT_BIT(EVENT_LINK_DOWN), record, &link));
+
+    event_t frame                = makeEvent(EVENT_FRAME, 10);
+    frame.data.frame.printStatus = 13;
+    frame.data.frame.expectedMm  = 42.5f;
+    event_t up                   = makeEvent(EVENT_LINK_UP, 20);
+    up.data.link.link            = EVENT_LINK_PRINTER;
+    bus.publish(frame);
+    bus.publish(up);
+
+    // Nothing is delivered until dispatch().
+    TEST_ASSERT_EQUAL_UINT32(0, all.count);
+    TEST_ASSERT_EQUAL_UINT32(2, bus.pending());
+    TEST_ASSERT_EQUAL_UINT32(2, bus.dispatch());
+
+    TEST_ASSERT_EQUAL_UINT32(2, all.count);
+    TEST_ASSERT_EQUAL_UINT8(EVENT_FRAME, all.events[0].type);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 42.5f, all.events[0].data.frame.expectedMm);
+    TEST_ASSERT_EQUAL_UINT32(1, link.count);
+    TEST_ASSERT_EQUAL_UINT8(EVENT_LINK_PRINTER, link.events[0].data.link.link);
+}
+
+void test_full_ring_drops_and_counts()
+{
+    EventBus bus;
+    Recorder recorder = {};
+    bus.subscribe(EVENT_BIT(EVENT_PULSE) | EVENT_BIT(EVENT_JAM), record, &recorder);
+    for (size_t i = 0; i < EventBus::QUEUE_SIZE; i++)
+    {
+        TEST_ASSERT_TRUE(bus.publish(makeEvent(EVENT_PULSE, i)));
+    }
+    TEST_ASSERT_FALSE(bus.publish(makeEvent(EVENT_JAM, 99)));
+
+    event_bus_stats_t stats = bus.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(EventBus::QUEUE_SIZE, stats.published[EVENT_PULSE]);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.published[EVENT_JAM]);
+    TEST_ASSERT_EQUAL_UINT32(EventBus::QUEUE_SIZE, stats.highWater);
+
+    TEST_ASSERT_EQUAL_UINT32(5, bus.dispatch(5));
+    TEST_ASSERT_EQUAL_UINT32(EventBus::QUEUE_SIZE - 5, bus.pending());
+}
+
+void test_handlers_can_publish_during_dispatch()
+{
+    EventBus bus;
+    Recorder recorder = {};
+    recorder.bus      = &bus;
+    bus.subscribe(EVENT_BIT(EVENT_JAM) | EVENT_BIT(EVENT_PAUSE_ACK), record, &recorder);
+
+    bus.publish(makeEvent(EVENT_JAM, 1));
+    TEST_ASSERT_EQUAL_UINT32(2, bus.dispatch());
+    TEST_ASSERT_EQUAL_UINT8(EVENT_PAUSE_ACK, recorder.events[1].type);
+    TEST_ASSERT_EQUAL_INT32(129, recorder.events[1].data.pauseAck.command);
+}
+
+void test_types_without_subscribers_are_not_queued()
+{
+    EventBus bus;
+    Recorder recorder = {};
+    bus.subscribe(EVENT_BIT(EVENT_JAM), record, &recorder);
+
+    for (size_t i = 0; i < EventBus::QUEUE_SIZE * 2; i++)
+    {
+        TEST_ASSERT_TRUE(bus.publish(makeEvent(EVENT_PULSE, i)));
+    }
+    TEST_ASSERT_TRUE(bus.publish(makeEvent(EVENT_JAM, 99)));
+    TEST_ASSERT_EQUAL_UINT32(1, bus.pending());
+
+    event_bus_stats_t stats = bus.getStats();
+    TEST_ASSERT_EQUAL_UINT32(EventBus::QUEUE_SIZE * 2, stats.published[EVENT_PULSE]);
+    TEST_ASSERT_EQUAL_UINT32(EventBus::QUEUE_SIZE * 2, stats.unheard);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+
+    TEST_ASSERT_EQUAL_UINT32(1, bus.dispatch());
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.count);
+    TEST_ASSERT_EQUAL_UINT8(EVENT_JAM, recorder.events[0].type);
+}
+
+void test_rejects_bad_types_and_too_many_subscribers()
+{
+    EventBus bus;
+    Recorder recorder = {};
+    TEST_ASSERT_FALSE(bus.publish(makeEvent(EVENT_TYPE_COUNT, 0)));
+    TEST_ASSERT_FALSE(bus.subscribe(EVENT_BIT(EVENT_JAM), nullptr));
+    for (size_t i = 0; i < EventBus::MAX_SUBSCRIBERS; i++)
+    {
+        TEST_ASSERT_TRUE(bus.subscribe(EVENT_BIT(EVENT_JAM), record, &recorder));
+    }
+    TEST_ASSERT_FALSE(bus.subscribe(EVENT_BIT(EVENT_JAM), record, &recorder));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_events_reach_matching_subscribers_in_order);
+    RUN_TEST(test_full_ring_drops_and_counts);
+    RUN_TEST(test_handlers_can_publish_during_dispatch);
+    RUN_TEST(test_types_without_subscribers_are_not_queued);
+    RUN_TEST(test_rejects_bad_types_and_too_many_subscribers);
+    return UNITY_END();
+}
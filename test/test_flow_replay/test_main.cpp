@@ -0,0 +1,219 @@
+#include <string.h>
+#include <unity.h>
+
+#include "../../src/BatchDetector.h"
+#include "../../src/BatchDetector.cpp"
+#include "../../src/FilamentFlowTracker.cpp"
+#include "../../src/FlowReplay.h"
+#include "../../src/FlowReplay.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static const size_t     MAX_RECORDS = 100000;
+static trace_record_t   records[MAX_RECORDS];
+static size_t           recordCount = 0;
+static trace_keyframe_t keyframes[64];
+static uint8_t          states[64 * 1024];
+
+static void addRecord(uint32_t timeMs, trace_kind_t kind, uint8_t flags, float a, float b)
+{
+    trace_record_t &record = records[recordCount++];
+    memset(&record, 0, sizeof(record));
+    record.timeMs = timeMs;
+    record.kind   = kind;
+    record.flags  = flags;
+    record.a      = a;
+    record.b      = b;
+}
+
+// About 40 minutes of printing: status frames every 250 ms, pulses most
+// 50 ms ticks, a jam every few minutes with a resume after it, and a
+// second print at the end.
+static void buildTrace()
+{
+    recordCount   = 0;
+    uint32_t seed = 777;
+    float    total = 0;
+    addRecord(0, TRACE_RESET, 0, 0, 0);
+    for (uint32_t step = 1; step < 48000 && recordCount + 4 < MAX_RECORDS; step++)
+    {
+        uint32_t now = step * 50;
+        seed         = seed * 1103515245u + 12345u;
+        bool jammed  = (step % 4000) > 3000;
+        if (step % 5 == 0)
+        {
+            float delta = (float) ((seed >> 8) % 300) / 100.0f;
+            total += delta;
+            addRecord(now, TRACE_TELEMETRY, TRACE_HAS_TOTAL | TRACE_HAS_DELTA, total, delta);
+        }
+        if (!jammed && ((seed >> 4) % 4) != 0)
+        {
+            addRecord(now, TRACE_PULSE, 0, 0, 0);
+        }
+        if (step % 4000 == 3999)
+        {
+            addRecord(now, TRACE_RESUME, 0, total, 0);
+        }
+        if (step == 40000)
+        {
+            total = 0;
+            addRecord(now, TRACE_RESET, 0, 0, 0);
+        }
+        addRecord(now, TRACE_EVALUATE, 0, 0, 0);
+    }
+}
+
+static void configure(BatchDetector &detector, batch_mode_t mode)
+{
+    detector.clearConfigs();
+    detector.setMode(mode);
+    detector.reset();
+    for (size_t i = 0; i < 6; i++)
+    {
+        detector.addConfig(4.0f + 2.0f * (float) i, 500 + 400 * (uint32_t) i,
+                           1.0f + 0.2f * (float) i);
+    }
+}
+
+static bool sameState(const BatchDetector &a, const BatchDetector &b)
+{
+    static uint8_t left[BatchDetector::MAX_STATE_SIZE];
+    static uint8_t right[BatchDetector::MAX_STATE_SIZE];
+    size_t         leftSize  = a.saveState(left, sizeof(left));
+    size_t         rightSize = b.saveState(right, sizeof(right));
+    return leftSize != 0 && leftSize == rightSize && memcmp(left, right, leftSize) == 0;
+}
+
+static void checkSeeksMatchFullReplay(batch_mode_t mode)
+{
+    buildTrace();
+    BatchDetector indexed;
+    configure(indexed, mode);
+    FlowReplay replay(indexed);
+    replay.attach(records, recordCount);
+    replay.attachIndex(keyframes, 64, states, sizeof(states));
+    TEST_ASSERT_TRUE(replay.buildIndex(60000) >= 30);
+
+    const uint32_t targets[] = {2399000, 10, 61234, 60000, 1800000, 1981000, 1990000, 599999, 2000000, 0};
+    for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++)
+    {
+        BatchDetector reference;
+        configure(reference, mode);
+        FlowReplay full(reference);
+        full.attach(records, recordCount);
+        full.runUntil(targets[t]);
+
+        TEST_ASSERT_TRUE(replay.seek(targets[t]));
+        TEST_ASSERT_EQUAL(full.position(), replay.position());
+        TEST_ASSERT_TRUE(sameState(reference, indexed));
+        // Never more than about one interval of records replayed
+        TEST_ASSERT_TRUE(replay.lastSeekReplayed() <= 2600);
+    }
+}
+
+void test_tracker_seek_matches_full_replay()
+{
+    checkSeeksMatchFullReplay(BATCH_MODE_TRACKER);
+}
+
+void test_total_seek_matches_full_replay()
+{
+    checkSeeksMatchFullReplay(BATCH_MODE_TOTAL);
+}
+
+void test_state_round_trip_and_validation()
+{
+    buildTrace();
+    BatchDetector detector;
+    configure(detector, BATCH_MODE_TRACKER);
+    FlowReplay replay(detector);
+    replay.attach(records, recordCount);
+    replay.runUntil(1990000);  // mid-jam, chunk rings full
+
+    static uint8_t state[BatchDetector::MAX_STATE_SIZE];
+    size_t         size = detector.saveState(state, sizeof(state));
+    TEST_ASSERT_TRUE(size > BatchDetector::STATE_HEADER_SIZE);
+    TEST_ASSERT_EQUAL(0, detector.saveState(state, size - 1));
+
+    BatchDetector restored;
+    TEST_ASSERT_TRUE(restored.loadState(state, size));
+    TEST_ASSERT_TRUE(sameState(detector, restored));
+    TEST_ASSERT_EQUAL(detector.count(), restored.count());
+
+    // Both continue identically
+    for (size_t i = replay.position(); i < recordCount; i++)
+    {
+        FlowReplay::apply(detector, records[i]);
+        FlowReplay::apply(restored, records[i]);
+    }
+    TEST_ASSERT_TRUE(sameState(detector, restored));
+
+    TEST_ASSERT_FALSE(restored.loadState(state, size - 1));
+    state[0] ^= 0xFF;
+    TEST_ASSERT_FALSE(restored.loadState(state, size));
+    TEST_ASSERT_TRUE(sameState(detector, restored));
+}
+
+void test_retune_after_seek_matches_live_retune()
+{
+    buildTrace();
+    const uint32_t forkMs = 1200000;
+
+    BatchDetector indexed;
+    configure(indexed, BATCH_MODE_DELTA);
+    FlowReplay replay(indexed);
+    replay.attach(records, recordCount);
+    replay.attachIndex(keyframes, 64, states, sizeof(states));
+    replay.buildIndex(60000);
+
+    for (int variant = 0; variant < 3; variant++)
+    {
+        float threshold = 3.0f + 3.0f * (float) variant;
+
+        BatchDetector reference;
+        configure(reference, BATCH_MODE_DELTA);
+        FlowReplay full(reference);
+        full.attach(records, recordCount);
+        full.runUntil(forkMs);
+        reference.setConfig(2, threshold, 700, 1.4f);
+        full.runUntil(UINT32_MAX);
+
+        TEST_ASSERT_TRUE(replay.seek(forkMs));
+        indexed.setConfig(2, threshold, 700, 1.4f);
+        replay.runUntil(UINT32_MAX);
+        TEST_ASSERT_TRUE(sameState(reference, indexed));
+    }
+}
+
+void test_small_index_still_seeks_exactly()
+{
+    buildTrace();
+    BatchDetector indexed;
+    configure(indexed, BATCH_MODE_TRACKER);
+    FlowReplay replay(indexed);
+    replay.attach(records, recordCount);
+    static uint8_t small[1024];
+    replay.attachIndex(keyframes, 64, small, sizeof(small));
+    size_t built = replay.buildIndex(60000);
+    TEST_ASSERT_TRUE(built > 0 && built < 30);
+
+    BatchDetector reference;
+    configure(reference, BATCH_MODE_TRACKER);
+    FlowReplay full(reference);
+    full.attach(records, recordCount);
+    full.runUntil(2300000);
+    TEST_ASSERT_TRUE(replay.seek(2300000));
+    TEST_ASSERT_TRUE(sameState(reference, indexed));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tracker_seek_matches_full_replay);
+    RUN_TEST(test_total_seek_matches_full_replay);
+    RUN_TEST(test_state_round_trip_and_validation);
+    RUN_TEST(test_retune_after_seek_matches_live_retune);
+    RUN_TEST(test_small_index_still_seeks_exactly);
+    return UNITY_END();
+}
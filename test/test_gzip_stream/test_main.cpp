@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "../../src/GzipStream.h"
+#include "../../src/GzipStream.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// Minimal inflater for the fixed-Huffman blocks GzipStream emits, so the
+// round trip is checked without linking zlib. Helpers report failure by
+// return value and the tests assert on it.
+struct BitReader
+{
+    const uint8_t *data;
+    size_t         length;
+    size_t         bitPos;
+    bool           overrun;
+
+    uint32_t bits(int count)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < count; i++, bitPos++)
+        {
+            if (bitPos / 8 >= length)
+            {
+                overrun = true;
+                return 0;
+            }
+            value |= ((data[bitPos / 8] >> (bitPos % 8)) & 1u) << i;
+        }
+        return value;
+    }
+
+    uint32_t code(int count)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < count; i++)
+        {
+            value = (value << 1) | bits(1);
+        }
+        return value;
+    }
+
+    int fixedSymbol()
+    {
+        uint32_t c = code(7);
+        if (c <= 0x17)
+        {
+            return 256 + c;
+        }
+        c = (c << 1) | bits(1);
+        if (c >= 0x30 && c <= 0xBF)
+        {
+            return c - 0x30;
+        }
+        if (c >= 0xC0 && c <= 0xC7)
+        {
+            return 280 + (c - 0xC0);
+        }
+        c = (c << 1) | bits(1);
+        return 144 + (c - 0x190);
+    }
+};
+
+static uint32_t readLe32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static bool gunzip(const std::vector<uint8_t> &gz, std::vector<uint8_t> &result)
+{
+    result.clear();
+    if (gz.size() < GzipStream::HEADER_SIZE + GzipStream::TRAILER_SIZE || gz[0] != 0x1F ||
+        gz[1] != 0x8B || gz[2] != 8)
+    {
+        return false;
+    }
+    BitReader reader = {gz.data() + GzipStream::HEADER_SIZE,
+                        gz.size() - GzipStream::HEADER_SIZE - GzipStream::TRAILER_SIZE, 0, false};
+    bool      final  = false;
+    while (!final && !reader.overrun)
+    {
+        final = reader.bits(1) != 0;
+        if (reader.bits(2) != 1)
+        {
+            return false;
+        }
+        while (!reader.overrun)
+        {
+            int symbol = reader.fixedSymbol();
+            if (symbol < 256)
+            {
+                result.push_back((uint8_t) symbol);
+                continue;
+            }
+            if (symbol == 256)
+            {
+                break;
+            }
+            if (symbol > 285)
+            {
+                return false;
+            }
+            int    lengthCode = symbol - 257;
+            size_t length     = LENGTH_BASE[lengthCode] + reader.bits(LENGTH_EXTRA[lengthCode]);
+            int    distCode   = (int) reader.code(5);
+            if (distCode > 29)
+            {
+                return false;
+            }
+            size_t distance = DIST_BASE[distCode] + reader.bits(DIST_EXTRA[distCode]);
+            if (distance > result.size() || distance > GzipStream::WINDOW_SIZE)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < length; i++)
+            {
+                result.push_back(result[result.size() - distance]);
+            }
+        }
+    }
+    const uint8_t *trailer = gz.data() + gz.size() - GzipStream::TRAILER_SIZE;
+    return !reader.overrun &&
+           readLe32(trailer) == crc32Update(0, result.data(), result.size()) &&
+           readLe32(trailer + 4) == result.size();
+}
+
+// Feeds `input` through the encoder the way the chunked response does:
+// each call gets at most inputBudget(chunkCapacity) raw bytes. Returns false
+// if a call produced nothing or overran the chunk.
+static bool gzipChunked(const std::vector<uint8_t> &input, size_t chunkCapacity,
+                        std::vector<uint8_t> &gz)
+{
+    GzipStream          *gzip = new GzipStream();
+    std::vector<uint8_t> chunk(chunkCapacity);
+    size_t               offset = 0;
+    bool                 ok     = true;
+    gz.clear();
+    while (ok && !gzip->isFinished())
+    {
+        size_t budget = GzipStream::inputBudget(chunkCapacity);
+        size_t n      = input.size() - offset < budget ? input.size() - offset : budget;
+        if (n > 0)
+        {
+            memcpy(gzip->inputBuffer(), input.data() + offset, n);
+            offset += n;
+        }
+        size_t written = gzip->compress(n, n == 0, chunk.data(), chunk.size());
+        ok             = written > 0 && written <= chunkCapacity;
+        gz.insert(gz.end(), chunk.begin(), chunk.begin() + written);
+    }
+    ok = ok && gzip->rawBytes() == input.size() && gzip->compressedBytes() == gz.size();
+    delete gzip;
+    return ok;
+}
+
+static bool roundTrips(const std::vector<uint8_t> &input, size_t chunkCapacity,
+                       std::vector<uint8_t> &gz)
+{
+    std::vector<uint8_t> decoded;
+    return gzipChunked(input, chunkCapacity, gz) && gunzip(gz, decoded) && decoded == input;
+}
+
+static std::vector<uint8_t> sampleLog(size_t lines)
+{
+    std::vector<uint8_t> text;
+    char                 line[160];
+    for (size_t i = 0; i < lines; i++)
+    {
+        int n = snprintf(line, sizeof(line),
+                         "{\"timestamp\":%u,\"message\":\"Flow debug: cycle tele=1 "
+                         "expected=%.2fmm actual=%.2fmm pulses=%u\"},\n",
+                         (unsigned) (1700000000 + i), i * 0.37, i * 0.35, (unsigned) i);
+        text.insert(text.end(), line, line + n);
+    }
+    return text;
+}
+
+void test_empty_stream_round_trips()
+{
+    std::vector<uint8_t> gz;
+    TEST_ASSERT_TRUE(roundTrips(std::vector<uint8_t>(), 64, gz));
+}
+
+void test_text_round_trips_and_shrinks()
+{
+    std::vector<uint8_t> text = sampleLog(400);
+    std::vector<uint8_t> gz;
+    TEST_ASSERT_TRUE(roundTrips(text, 1436, gz));
+    // Repetitive JSON log lines compress well even with the small window
+    TEST_ASSERT_TRUE(gz.size() * 3 < text.size());
+}
+
+void test_small_chunks_round_trip()
+{
+    std::vector<uint8_t> gz;
+    TEST_ASSERT_TRUE(roundTrips(sampleLog(50), 40, gz));
+}
+
+void test_incompressible_input_stays_within_budget()
+{
+    std::vector<uint8_t> noise(5000);
+    uint32_t             state = 12345;
+    for (size_t i = 0; i < noise.size(); i++)
+    {
+        state    = state * 1103515245u + 12345u;
+        noise[i] = (uint8_t) (0x90 + ((state >> 16) % 0x70));  // all 9-bit literals
+    }
+    std::vector<uint8_t> gz;
+    TEST_ASSERT_TRUE(roundTrips(noise, 300, gz));
+}
+
+void test_long_runs_use_max_length_matches()
+{
+    std::vector<uint8_t> run(70000, 'a');
+    std::vector<uint8_t> gz;
+    TEST_ASSERT_TRUE(roundTrips(run, 1436, gz));
+    TEST_ASSERT_TRUE(gz.size() < run.size() / 50);
+}
+
+void test_rejects_output_below_budget()
+{
+    GzipStream gzip;
+    memset(gzip.inputBuffer(), 'x', 100);
+    uint8_t out[64];
+    TEST_ASSERT_EQUAL_UINT32(0, GzipStream::inputBudget(GzipStream::HEADER_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(0, gzip.compress(100, false, out, sizeof(out)));
+    TEST_ASSERT_FALSE(gzip.isFinished());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_stream_round_trips);
+    RUN_TEST(test_text_round_trips_and_shrinks);
+    RUN_TEST(test_small_chunks_round_trip);
+    RUN_TEST(test_incompressible_input_stays_within_budget);
+    RUN_TEST(test_long_runs_use_max_length_matches);
+    RUN_TEST(test_rejects_output_below_budget);
+    return UNITY_END();
+}
@@ -0,0 +1,117 @@
+#include <unity.h>
+
+#include <string.h>
+
+#include "../../src/JobIdentity.h"
+#include "../../src/JobIdentity.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static sdcp_print_info_t printInfo(const char *taskId, const char *filename, int32_t totalLayer,
+                                   int32_t totalTicks, int32_t currentTicks)
+{
+    sdcp_print_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.status = SDCP_PRINT_STATUS_PRINTING;
+    strncpy(info.taskId, taskId, sizeof(info.taskId) - 1);
+    strncpy(info.filename, filename, sizeof(info.filename) - 1);
+    info.totalLayer   = totalLayer;
+    info.totalTicks   = totalTicks;
+    info.currentTicks = currentTicks;
+    return info;
+}
+
+void test_same_job_through_transitional_statuses()
+{
+    JobTracker tracker;
+    TEST_ASSERT_FALSE(tracker.hasJob());
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NEW, tracker.observe(printInfo("t1", "cube.gcode", 200, 5000, 0)));
+    TEST_ASSERT_EQUAL_UINT32(1, tracker.jobNumber());
+
+    static const int16_t STATUSES[] = {SDCP_PRINT_STATUS_HEATING, SDCP_PRINT_STATUS_UNKNOWN_15,
+                                       SDCP_PRINT_STATUS_PRINTING, SDCP_PRINT_STATUS_UNKNOWN_18,
+                                       SDCP_PRINT_STATUS_UNKNOWN_21, SDCP_PRINT_STATUS_PRINTING};
+    int32_t ticks = 0;
+    for (int16_t status : STATUSES)
+    {
+        sdcp_print_info_t info = printInfo("t1", "cube.gcode", 200, 5000, ticks);
+        info.status            = status;
+        TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(info));
+        ticks += 100;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, tracker.jobNumber());
+}
+
+void test_unknown_fields_are_learned_not_compared()
+{
+    JobTracker tracker;
+    // Idle frames carry no job at all
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("", "", 0, 0, 0)));
+    TEST_ASSERT_FALSE(tracker.hasJob());
+
+    // The printer fills in the layer and tick counts after file checking
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NEW, tracker.observe(printInfo("", "vase.gcode", 0, 0, 0)));
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("", "vase.gcode", 310, 0, 0)));
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("", "vase.gcode", 310, 9000, 20)));
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("t9", "vase.gcode", 310, 9000, 40)));
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("", "", 0, 0, 0)));
+    TEST_ASSERT_EQUAL_STRING("t9", tracker.current().taskId);
+    TEST_ASSERT_EQUAL_INT32(310, tracker.current().totalLayer);
+    TEST_ASSERT_EQUAL_INT32(9000, tracker.current().totalTicks);
+
+    // Once known, a different layer count is a different job
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NEW, tracker.observe(printInfo("", "vase.gcode", 311, 0, 0)));
+    TEST_ASSERT_EQUAL_UINT32(2, tracker.jobNumber());
+    TEST_ASSERT_EQUAL_STRING("", tracker.current().taskId);
+}
+
+void test_task_id_outranks_tick_estimate()
+{
+    JobTracker tracker;
+    tracker.observe(printInfo("t1", "part.gcode", 80, 4000, 10));
+    // Re-estimated TotalTicks within one task is the same job
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("t1", "part.gcode", 80, 4100, 20)));
+    // A new task for the same file is a new job
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NEW, tracker.observe(printInfo("t2", "part.gcode", 80, 4100, 0)));
+
+    // Without a task ID a re-estimate is still the same job
+    JobTracker untasked;
+    untasked.observe(printInfo("", "part.gcode", 80, 4000, 10));
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, untasked.observe(printInfo("", "part.gcode", 80, 4100, 20)));
+    TEST_ASSERT_EQUAL_UINT32(1, untasked.jobNumber());
+    TEST_ASSERT_EQUAL_INT32(4100, untasked.current().totalTicks);
+    // and reprinting it is told apart by CurrentTicks going back
+    TEST_ASSERT_EQUAL(JOB_CHANGE_RESTARTED,
+                      untasked.observe(printInfo("", "part.gcode", 80, 4000, 5)));
+}
+
+void test_rewinding_ticks_is_a_restart()
+{
+    JobTracker tracker;
+    tracker.observe(printInfo("", "cube.gcode", 200, 5000, 0));
+    tracker.observe(printInfo("", "cube.gcode", 200, 5000, 4990));
+    // Completed job still reported while idle, then reprinted
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("", "cube.gcode", 200, 5000, 4990)));
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("", "cube.gcode", 200, 5000, 0)));
+    TEST_ASSERT_EQUAL(JOB_CHANGE_RESTARTED,
+                      tracker.observe(printInfo("", "cube.gcode", 200, 5000, 3)));
+    TEST_ASSERT_EQUAL_UINT32(2, tracker.jobNumber());
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("", "cube.gcode", 200, 5000, 3)));
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NONE, tracker.observe(printInfo("", "cube.gcode", 200, 5000, 50)));
+    TEST_ASSERT_EQUAL_STRING("restarted", JobTracker::changeName(JOB_CHANGE_RESTARTED));
+
+    tracker.reset();
+    TEST_ASSERT_FALSE(tracker.hasJob());
+    TEST_ASSERT_EQUAL(JOB_CHANGE_NEW, tracker.observe(printInfo("", "cube.gcode", 200, 5000, 60)));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_same_job_through_transitional_statuses);
+    RUN_TEST(test_unknown_fields_are_learned_not_compared);
+    RUN_TEST(test_task_id_outranks_tick_estimate);
+    RUN_TEST(test_rewinding_ticks_is_a_restart);
+    return UNITY_END();
+}
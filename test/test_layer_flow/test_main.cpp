@@ -0,0 +1,196 @@
+#include <unity.h>
+
+#include <string>
+
+#include "../../src/LayerFlowStats.h"
+#include "../../src/LayerFlowStats.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// Prints `layers` layers, each extruding 10mm with actual flow `ratio` and
+// taking 1s, sampled every 250ms.
+static void printLayers(LayerFlowStats &stats, int firstLayer, int layers, float ratio,
+                        float &expected, float &actual, uint32_t &pulses, unsigned long &now)
+{
+    for (int layer = firstLayer; layer < firstLayer + layers; layer++)
+    {
+        for (int step = 0; step < 4; step++)
+        {
+            expected += 2.5f;
+            actual += 2.5f * ratio;
+            pulses += 1;
+            now += 250;
+            stats.sample(layer, expected, actual, pulses, 2.5f * (1.0f - ratio) * step, now);
+        }
+    }
+}
+
+void test_deltas_are_credited_to_the_current_layer()
+{
+    LayerFlowStats stats;
+    stats.begin(10);
+    float         expected = 0, actual = 0;
+    uint32_t      pulses   = 0;
+    unsigned long now      = 0;
+    stats.sample(0, expected, actual, pulses, 0.0f, now);  // baseline
+    printLayers(stats, 0, 2, 1.0f, expected, actual, pulses, now);
+    printLayers(stats, 2, 1, 0.5f, expected, actual, pulses, now);
+
+    TEST_ASSERT_EQUAL_UINT32(1, stats.getLayersPerBucket());
+    TEST_ASSERT_EQUAL_UINT32(3, stats.getBucketCount());
+    const layer_flow_bucket_t &good = stats.getBucket(1);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, good.expectedMm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, good.actualMm);
+    TEST_ASSERT_EQUAL_UINT32(4, good.pulses);
+    TEST_ASSERT_EQUAL_UINT32(1000, good.durationMs);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, good.minFlowRatio);
+
+    const layer_flow_bucket_t &starved = stats.getBucket(2);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 5.0f, starved.actualMm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.5f, starved.minFlowRatio);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 3.75f, starved.peakDeficitMm);
+}
+
+void test_ratio_waits_for_enough_expected_filament()
+{
+    LayerFlowStats stats;
+    stats.begin(0);
+    stats.sample(0, 0.0f, 0.0f, 0, 0.0f, 0);
+    stats.sample(0, 2.0f, 0.0f, 0, 2.0f, 100);
+    TEST_ASSERT_TRUE(stats.getBucket(0).minFlowRatio < 0.0f);
+    stats.sample(0, 6.0f, 4.5f, 3, 1.5f, 200);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.75f, stats.getBucket(0).minFlowRatio);
+}
+
+void test_tall_print_is_planned_coarse()
+{
+    LayerFlowStats stats;
+    stats.begin(1000);
+    TEST_ASSERT_EQUAL_INT(4, stats.getLayersPerBucket());
+
+    float         expected = 0, actual = 0;
+    uint32_t      pulses   = 0;
+    unsigned long now      = 0;
+    stats.sample(0, expected, actual, pulses, 0.0f, now);
+    printLayers(stats, 996, 4, 1.0f, expected, actual, pulses, now);
+    TEST_ASSERT_EQUAL_UINT32(250, stats.getBucketCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 40.0f, stats.getBucket(249).expectedMm);
+}
+
+void test_unknown_height_coarsens_and_keeps_totals()
+{
+    LayerFlowStats stats;
+    stats.begin(0);
+    float         expected = 0, actual = 0;
+    uint32_t      pulses   = 0;
+    unsigned long now      = 0;
+    stats.sample(0, expected, actual, pulses, 0.0f, now);
+    printLayers(stats, 0, 256, 1.0f, expected, actual, pulses, now);
+    printLayers(stats, 256, 1, 0.5f, expected, actual, pulses, now);
+
+    TEST_ASSERT_EQUAL_INT(2, stats.getLayersPerBucket());
+    TEST_ASSERT_EQUAL_UINT32(129, stats.getBucketCount());
+
+    float    totalExpected = 0;
+    uint32_t totalPulses   = 0;
+    for (size_t i = 0; i < stats.getBucketCount(); i++)
+    {
+        totalExpected += stats.getBucket(i).expectedMm;
+        totalPulses += stats.getBucket(i).pulses;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, expected, totalExpected);
+    TEST_ASSERT_EQUAL_UINT32(pulses, totalPulses);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, stats.getBucket(0).expectedMm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.5f, stats.getBucket(128).minFlowRatio);
+}
+
+void test_reset_totals_start_a_new_baseline()
+{
+    LayerFlowStats stats;
+    stats.begin(5);
+    stats.sample(0, 0.0f, 0.0f, 0, 0.0f, 0);
+    stats.sample(0, 10.0f, 9.0f, 6, 1.0f, 1000);
+    stats.sample(1, 0.0f, 0.0f, 0, 0.0f, 1100);  // tracking reset
+    stats.sample(1, 3.0f, 3.0f, 2, 0.0f, 1400);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, stats.getBucket(0).expectedMm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 3.0f, stats.getBucket(1).expectedMm);
+    TEST_ASSERT_EQUAL_UINT32(300, stats.getBucket(1).durationMs);
+}
+
+void test_resync_skips_paused_time()
+{
+    LayerFlowStats stats;
+    stats.begin(5);
+    stats.sample(2, 0.0f, 0.0f, 0, 0.0f, 0);
+    stats.sample(2, 4.0f, 4.0f, 3, 0.0f, 800);
+    stats.resync();  // paused for a minute
+    stats.sample(2, 4.5f, 4.0f, 3, 0.5f, 60800);
+    stats.sample(2, 6.0f, 5.5f, 4, 0.5f, 61000);
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.getBucket(2).durationMs);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 5.5f, stats.getBucket(2).expectedMm);
+}
+
+void test_json_streams_in_small_chunks()
+{
+    LayerFlowStats stats;
+    stats.begin(3);
+    stats.sample(0, 0.0f, 0.0f, 0, 0.0f, 0);
+    stats.sample(0, 2.0f, 1.5f, 1, 0.5f, 500);
+    stats.sample(1, 8.0f, 7.5f, 5, 0.5f, 1000);
+
+    LayerJsonCursor cursor = stats.beginJson();
+    std::string     json;
+    char            chunk[256];
+    size_t          n;
+    while ((n = stats.readJson(cursor, chunk, sizeof(chunk))) > 0)
+    {
+        TEST_ASSERT_TRUE(n <= sizeof(chunk));
+        json.append(chunk, n);
+    }
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"totalLayers\":3,\"layersPerBucket\":1,\"layers\":["
+        "{\"firstLayer\":0,\"lastLayer\":0,\"expectedMm\":2.00,\"actualMm\":1.50,"
+        "\"peakDeficitMm\":0.50,\"minFlowRatio\":null,\"pulses\":1,\"durationMs\":500},"
+        "{\"firstLayer\":1,\"lastLayer\":1,\"expectedMm\":6.00,\"actualMm\":6.00,"
+        "\"peakDeficitMm\":0.50,\"minFlowRatio\":1.000,\"pulses\":4,\"durationMs\":500}]}",
+        json.c_str());
+}
+
+void test_json_waits_for_room()
+{
+    LayerFlowStats stats;
+    stats.begin(1);
+    stats.sample(0, 0.0f, 0.0f, 0, 0.0f, 0);
+    stats.sample(0, 2.0f, 1.5f, 1, 0.5f, 500);
+
+    // Too small for the next piece: nothing written, but not finished
+    LayerJsonCursor cursor = stats.beginJson();
+    char            chunk[256];
+    TEST_ASSERT_EQUAL_UINT32(0, stats.readJson(cursor, chunk, 8));
+    TEST_ASSERT_FALSE(cursor.done());
+
+    std::string json;
+    size_t      n;
+    while ((n = stats.readJson(cursor, chunk, sizeof(chunk))) > 0)
+    {
+        json.append(chunk, n);
+    }
+    TEST_ASSERT_TRUE(cursor.done());
+    TEST_ASSERT_EQUAL_UINT32(0, json.find("{\"totalLayers\":1,"));
+    TEST_ASSERT_EQUAL_INT('}', json[json.size() - 1]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_deltas_are_credited_to_the_current_layer);
+    RUN_TEST(test_ratio_waits_for_enough_expected_filament);
+    RUN_TEST(test_tall_print_is_planned_coarse);
+    RUN_TEST(test_unknown_height_coarsens_and_keeps_totals);
+    RUN_TEST(test_reset_totals_start_a_new_baseline);
+    RUN_TEST(test_resync_skips_paused_time);
+    RUN_TEST(test_json_streams_in_small_chunks);
+    RUN_TEST(test_json_waits_for_room);
+    return UNITY_END();
+}
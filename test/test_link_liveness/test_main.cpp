@@ -0,0 +1,120 @@
+#include <unity.h>
+
+#include "../../src/LinkLiveness.h"
+#include "../../src/LinkLiveness.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// Frames every `periodMs` with a little jitter; returns the last frame time.
+static uint32_t feedFrames(LinkLiveness &link, uint32_t startMs, uint32_t periodMs, int count)
+{
+    uint32_t now = startMs;
+    for (int i = 0; i < count; i++)
+    {
+        now += periodMs + (i % 3) * 20;
+        link.update(now);
+        link.onFrame(now);
+    }
+    return now;
+}
+
+// Advances in 10 ms steps until update() reports something or `untilMs`.
+static link_action_t advance(LinkLiveness &link, uint32_t &now, uint32_t untilMs)
+{
+    while (now < untilMs)
+    {
+        now += 10;
+        link_action_t action = link.update(now);
+        if (action != LINK_ACTION_NONE)
+        {
+            return action;
+        }
+    }
+    return LINK_ACTION_NONE;
+}
+
+void test_default_timeout_until_gaps_are_learned()
+{
+    LinkLiveness link;
+    link.reset(0);
+    uint32_t now = feedFrames(link, 0, 500, 5);
+    TEST_ASSERT_EQUAL_UINT32(LinkLiveness::DEFAULT_TIMEOUT_MS, link.silenceTimeoutMs());
+    TEST_ASSERT_EQUAL(LINK_ACTION_NONE, advance(link, now, now + 9000));
+}
+
+void test_chatty_link_fails_within_about_two_seconds()
+{
+    LinkLiveness link;
+    link.reset(0);
+    uint32_t lastFrame = feedFrames(link, 0, 500, 100);
+    TEST_ASSERT_EQUAL_UINT32(540, link.getStats().p99GapMs);
+    TEST_ASSERT_EQUAL_UINT32(810, link.silenceTimeoutMs());
+
+    uint32_t now = lastFrame;
+    TEST_ASSERT_EQUAL(LINK_ACTION_PROBE, advance(link, now, lastFrame + 5000));
+    TEST_ASSERT_EQUAL(LINK_STATE_PROBING, link.state());
+    TEST_ASSERT_EQUAL(LINK_ACTION_LOST, advance(link, now, lastFrame + 5000));
+    TEST_ASSERT_EQUAL(LINK_STATE_LOST, link.state());
+    TEST_ASSERT_TRUE(now - lastFrame <= 2000);
+    TEST_ASSERT_EQUAL_UINT32(1, link.getStats().losses);
+}
+
+void test_answered_probe_keeps_link_alive_and_adapts()
+{
+    LinkLiveness link;
+    link.reset(0);
+    uint32_t now = feedFrames(link, 0, 500, 100);
+
+    // The printer goes quiet between prints and now pushes every 5 s; each
+    // silence draws a probe that it answers in 60 ms.
+    int probes = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        uint32_t nextPush = now + 5000;
+        if (advance(link, now, nextPush) == LINK_ACTION_PROBE)
+        {
+            probes++;
+            now += 60;
+        }
+        else
+        {
+            now = nextPush;
+        }
+        link.onFrame(now);
+        TEST_ASSERT_EQUAL(LINK_STATE_ALIVE, link.state());
+    }
+    // Answered probes back the timeout off until the quantile has learned
+    // the new interval
+    TEST_ASSERT_TRUE(probes >= 1 && probes <= 3);
+    TEST_ASSERT_EQUAL(LINK_ACTION_NONE, advance(link, now, now + 5000));
+    TEST_ASSERT_TRUE(link.silenceTimeoutMs() > 5000);
+    TEST_ASSERT_EQUAL_UINT32(0, link.getStats().losses);
+    TEST_ASSERT_EQUAL_UINT32(60, link.getStats().lastProbeRttMs);
+    TEST_ASSERT_EQUAL_UINT32(LinkLiveness::MIN_PROBE_TIMEOUT_MS, link.probeTimeoutMs());
+}
+
+void test_reset_restarts_silence_but_keeps_history()
+{
+    LinkLiveness link;
+    link.reset(0);
+    uint32_t now = feedFrames(link, 0, 500, 100);
+    TEST_ASSERT_EQUAL(LINK_ACTION_PROBE, advance(link, now, now + 5000));
+    TEST_ASSERT_EQUAL(LINK_ACTION_LOST, advance(link, now, now + 5000));
+
+    link.reset(now + 3000);
+    TEST_ASSERT_EQUAL(LINK_STATE_ALIVE, link.state());
+    TEST_ASSERT_EQUAL_UINT32(810, link.silenceTimeoutMs());
+    now += 3000;
+    TEST_ASSERT_EQUAL(LINK_ACTION_NONE, advance(link, now, now + 800));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_default_timeout_until_gaps_are_learned);
+    RUN_TEST(test_chatty_link_fails_within_about_two_seconds);
+    RUN_TEST(test_answered_probe_keeps_link_alive_and_adapts);
+    RUN_TEST(test_reset_restarts_silence_but_keeps_history);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Keep ERROR, WARN and INFO; DEBUG and VERBOSE must compile out.
+#define LOG_LEVEL_FLOOR 2
+
+#include "../../src/LogCategory.h"
+
+// Stand-in for Logger: records what the enabled calls formatted.
+struct FakeLogger
+{
+    int            calls;
+    log_level_t    lastLevel;
+    log_category_t lastCategory;
+    char           last[128];
+
+    void logf(log_level_t level, log_category_t category, const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(last, sizeof(last), format, args);
+        va_end(args);
+        lastLevel    = level;
+        lastCategory = category;
+        calls++;
+    }
+};
+
+static FakeLogger fakeLogger;
+#define logger fakeLogger
+
+volatile uint32_t logCategoryMask = LOG_CATEGORY_BIT(LOG_CAT_GENERAL);
+
+static int evaluations = 0;
+static int sideEffect()
+{
+    return ++evaluations;
+}
+
+void setUp()
+{
+    fakeLogger.calls = 0;
+    evaluations      = 0;
+    logCategoryMask  = LOG_CATEGORY_BIT(LOG_CAT_GENERAL);
+}
+
+void tearDown() {}
+
+void test_disabled_category_skips_call_and_arguments()
+{
+    LOGI(LOG_CAT_FLOW_SUMMARY, "summary %d", sideEffect());
+    TEST_ASSERT_EQUAL(0, fakeLogger.calls);
+    TEST_ASSERT_EQUAL(0, evaluations);
+
+    logCategoryMask |= LOG_CATEGORY_BIT(LOG_CAT_FLOW_SUMMARY);
+    LOGI(LOG_CAT_FLOW_SUMMARY, "summary %d", sideEffect());
+    TEST_ASSERT_EQUAL(1, fakeLogger.calls);
+    TEST_ASSERT_EQUAL(1, evaluations);
+    TEST_ASSERT_EQUAL(LOG_LEVEL_INFO, fakeLogger.lastLevel);
+    TEST_ASSERT_EQUAL(LOG_CAT_FLOW_SUMMARY, fakeLogger.lastCategory);
+    TEST_ASSERT_EQUAL_STRING("summary 1", fakeLogger.last);
+}
+
+void test_levels_below_floor_compile_out()
+{
+    logCategoryMask = 0xFFFFFFFF;
+    LOGE(LOG_CAT_GENERAL, "e");
+    LOGW(LOG_CAT_GENERAL, "w");
+    LOGI(LOG_CAT_GENERAL, "i");
+    LOGD(LOG_CAT_FLOW, "d %d", sideEffect());
+    LOGV(LOG_CAT_PACKET, "v %d", sideEffect());
+    TEST_ASSERT_EQUAL(3, fakeLogger.calls);
+    TEST_ASSERT_EQUAL(0, evaluations);
+}
+
+void test_general_category_is_on_by_default()
+{
+    LOGW(LOG_CAT_GENERAL, "warn %s", "x");
+    TEST_ASSERT_EQUAL(1, fakeLogger.calls);
+    TEST_ASSERT_EQUAL(LOG_LEVEL_WARN, fakeLogger.lastLevel);
+}
+
+// The cost of a disabled call is timed by the logger.logf_category_disabled
+// bench; here only that it never reaches the formatter or its arguments.
+void test_disabled_categories_never_evaluate_arguments()
+{
+    for (int c = LOG_CAT_FLOW; c < LOG_CAT_COUNT; c++)
+    {
+        log_category_t category = static_cast<log_category_t>(c);
+        LOGE(category, "e %d %d", sideEffect(), sideEffect());
+        LOGW(category, "w %d", sideEffect());
+        LOGI(category, "i %d", sideEffect());
+    }
+    TEST_ASSERT_EQUAL(0, fakeLogger.calls);
+    TEST_ASSERT_EQUAL(0, evaluations);
+
+    // Switched off again at runtime, as a settings save does
+    logCategoryMask |= LOG_CATEGORY_BIT(LOG_CAT_PACKET);
+    LOGI(LOG_CAT_PACKET, "p %d", sideEffect());
+    logCategoryMask &= ~LOG_CATEGORY_BIT(LOG_CAT_PACKET);
+    LOGI(LOG_CAT_PACKET, "p %d", sideEffect());
+    TEST_ASSERT_EQUAL(1, fakeLogger.calls);
+    TEST_ASSERT_EQUAL(1, evaluations);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_category_skips_call_and_arguments);
+    RUN_TEST(test_levels_below_floor_compile_out);
+    RUN_TEST(test_general_category_is_on_by_default);
+    RUN_TEST(test_disabled_categories_never_evaluate_arguments);
+    return UNITY_END();
+}
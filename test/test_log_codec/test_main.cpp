@@ -0,0 +1,133 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/LogCodec.h"
+#include "../../src/LogCodec.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static uint16_t hashTable[LogCodec::HASH_ENTRIES];
+
+static size_t buildFlowLog(uint8_t *out, size_t capacity)
+{
+    size_t used  = 0;
+    float  total = 1234.5f;
+    int    i     = 0;
+    while (true)
+    {
+        char line[160];
+        int  n = snprintf(line, sizeof(line),
+                          "Flow debug: cycle tele=1 expected=%.2fmm actual=%.2fmm deficit=%.2fmm "
+                          "threshold=8.40mm ratio=%.2f pulses=%d",
+                          total, total - 3.1f, 3.1f + (i % 7) * 0.1f, (3.1f + (i % 7) * 0.1f) / 8.4f,
+                          812 + i);
+        if (used + 6 + (size_t) n > capacity)
+        {
+            return used;
+        }
+        uint16_t len = (uint16_t) n;
+        uint32_t ts  = 1750974868u + (uint32_t) (i / 4);
+        memcpy(out + used, &len, 2);
+        memcpy(out + used + 2, &ts, 4);
+        memcpy(out + used + 6, line, (size_t) n);
+        used += 6 + (size_t) n;
+        total += 0.37f;
+        i++;
+    }
+}
+
+void test_round_trip_repetitive_log_text()
+{
+    static uint8_t input[4096];
+    static uint8_t packed[4096];
+    static uint8_t output[4096];
+
+    size_t length = buildFlowLog(input, sizeof(input));
+    size_t packedLength =
+        LogCodec::compress(input, length, packed, sizeof(packed), hashTable);
+    TEST_ASSERT_GREATER_THAN(0, packedLength);
+
+    char message[96];
+    snprintf(message, sizeof(message), "flow debug block: %u -> %u bytes (%.1fx)",
+             (unsigned) length, (unsigned) packedLength, (double) length / packedLength);
+    TEST_MESSAGE(message);
+    // Flow debug lines are highly repetitive; expect a substantial ratio.
+    TEST_ASSERT_GREATER_OR_EQUAL(length / 3, length - packedLength);
+    TEST_ASSERT_LESS_THAN(length / 3, packedLength);
+
+    size_t outLength = LogCodec::decompress(packed, packedLength, output, sizeof(output));
+    TEST_ASSERT_EQUAL_size_t(length, outLength);
+    TEST_ASSERT_EQUAL_MEMORY(input, output, length);
+}
+
+void test_round_trip_random_data_or_reports_no_fit()
+{
+    static uint8_t input[4096];
+    static uint8_t packed[4096 + 256];
+    static uint8_t output[4096];
+
+    srand(1234);
+    for (size_t i = 0; i < sizeof(input); i++)
+    {
+        input[i] = (uint8_t) (rand() & 0xFF);
+    }
+
+    size_t packedLength =
+        LogCodec::compress(input, sizeof(input), packed, sizeof(packed), hashTable);
+    TEST_ASSERT_GREATER_THAN(0, packedLength);
+    size_t outLength = LogCodec::decompress(packed, packedLength, output, sizeof(output));
+    TEST_ASSERT_EQUAL_size_t(sizeof(input), outLength);
+    TEST_ASSERT_EQUAL_MEMORY(input, output, sizeof(input));
+
+    // Too small an output buffer is reported rather than overrun.
+    TEST_ASSERT_EQUAL_size_t(0, LogCodec::compress(input, sizeof(input), packed, 1024,
+                                                   hashTable));
+}
+
+void test_long_runs_and_overlapping_matches()
+{
+    static uint8_t input[3000];
+    static uint8_t packed[3000];
+    static uint8_t output[3000];
+
+    memset(input, 'a', 1000);
+    for (size_t i = 1000; i < sizeof(input); i++)
+    {
+        input[i] = (uint8_t) ("abcabcabd"[i % 9]);
+    }
+
+    size_t packedLength =
+        LogCodec::compress(input, sizeof(input), packed, sizeof(packed), hashTable);
+    TEST_ASSERT_GREATER_THAN(0, packedLength);
+    TEST_ASSERT_LESS_THAN(100, packedLength);
+    TEST_ASSERT_EQUAL_size_t(sizeof(input),
+                             LogCodec::decompress(packed, packedLength, output, sizeof(output)));
+    TEST_ASSERT_EQUAL_MEMORY(input, output, sizeof(input));
+}
+
+void test_malformed_input_is_rejected()
+{
+    uint8_t output[64];
+    // Back-reference before the start of the output.
+    const uint8_t badReference[] = {0x00, 'x', 0x20, 0x05};
+    TEST_ASSERT_EQUAL_size_t(0, LogCodec::decompress(badReference, sizeof(badReference), output,
+                                                     sizeof(output)));
+    // Literal run longer than the remaining input.
+    const uint8_t truncated[] = {0x05, 'a', 'b'};
+    TEST_ASSERT_EQUAL_size_t(0, LogCodec::decompress(truncated, sizeof(truncated), output,
+                                                     sizeof(output)));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_repetitive_log_text);
+    RUN_TEST(test_round_trip_random_data_or_reports_no_fit);
+    RUN_TEST(test_long_runs_and_overlapping_matches);
+    RUN_TEST(test_malformed_input_is_rejected);
+    return UNITY_END();
+}
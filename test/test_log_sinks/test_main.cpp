@@ -0,0 +1,182 @@
+#include <unity.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "../../src/LogQueue.h"
+#include "../../src/LogQueue.cpp"
+#include "../../src/LogSink.h"
+#include "../../src/SyslogFormatter.h"
+#include "../../src/SyslogFormatter.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+class CountingSink : public LogSink
+{
+   public:
+    int         accepted = 0;
+    bool        full     = false;
+    const char *name() const override { return "counting"; }
+
+   protected:
+    bool enqueue(log_level_t, uint64_t, const char *, size_t) override
+    {
+        if (full)
+        {
+            return false;
+        }
+        accepted++;
+        return true;
+    }
+};
+
+void test_sink_filters_by_level_and_counts_drops()
+{
+    CountingSink sink;
+    sink.setMinLevel(LOG_LEVEL_WARN);
+    sink.offer(LOG_LEVEL_ERROR, 0, "e", 1);
+    sink.offer(LOG_LEVEL_WARN, 0, "w", 1);
+    sink.offer(LOG_LEVEL_INFO, 0, "i", 1);
+    sink.offer(LOG_LEVEL_VERBOSE, 0, "v", 1);
+    TEST_ASSERT_EQUAL(2, sink.accepted);
+    TEST_ASSERT_EQUAL_UINT32(0, sink.getDropped());
+
+    sink.full = true;
+    sink.offer(LOG_LEVEL_ERROR, 0, "e", 1);
+    TEST_ASSERT_EQUAL_UINT32(1, sink.getDropped());
+}
+
+void test_queue_is_fifo_across_wrap_and_rejects_when_full()
+{
+    uint8_t  buffer[100];
+    LogQueue queue;
+    queue.attach(buffer, sizeof(buffer));
+
+    char            message[64];
+    LogQueue::Entry entry;
+    for (int round = 0; round < 20; round++)
+    {
+        char text[32];
+        int  n = snprintf(text, sizeof(text), "line %d", round);
+        TEST_ASSERT_TRUE(queue.push(LOG_LEVEL_INFO, round, round * 10, text, n));
+        if (round % 3 == 0)
+        {
+            continue;  // let the queue build up so writes wrap the ring
+        }
+        while (queue.count() > 1)
+        {
+            TEST_ASSERT_TRUE(queue.peek(entry, message, sizeof(message)));
+            queue.pop();
+        }
+    }
+    TEST_ASSERT_TRUE(queue.peek(entry, message, sizeof(message)));
+    TEST_ASSERT_EQUAL_UINT32(19, entry.timestamp);
+    TEST_ASSERT_EQUAL_UINT32(190, entry.enqueuedMs);
+    TEST_ASSERT_EQUAL_STRING_LEN("line 19", message, entry.length);
+
+    while (queue.push(LOG_LEVEL_INFO, 0, 0, "x", 1))
+    {
+    }
+    uint32_t countWhenFull = queue.count();
+    TEST_ASSERT_FALSE(queue.push(LOG_LEVEL_INFO, 0, 0, "x", 1));
+    TEST_ASSERT_EQUAL_UINT32(countWhenFull, queue.count());
+    TEST_ASSERT_TRUE(queue.usedBytes() <= queue.capacity());
+}
+
+void test_format_line_is_rfc5424()
+{
+    char   line[256];
+    size_t n = SyslogFormatter::formatLine(line, sizeof(line), LOG_LEVEL_WARN, 1700000000UL,
+                                           "ccxsfs20", "sfs", "jam\ndetected", 12);
+    line[n]  = '\0';
+    // local0 (16) * 8 + warning (4) = 132
+    TEST_ASSERT_EQUAL_STRING("<132>1 2023-11-14T22:13:20Z ccxsfs20 sfs - - - jam detected", line);
+
+    n       = SyslogFormatter::formatLine(line, sizeof(line), LOG_LEVEL_DEBUG, 42, "h", "sfs",
+                                          "boot", 4);
+    line[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING("<135>1 - h sfs - - - boot", line);
+}
+
+void test_format_line_truncates_to_capacity()
+{
+    char        line[40];
+    std::string longMessage(200, 'x');
+    size_t      n = SyslogFormatter::formatLine(line, sizeof(line), LOG_LEVEL_INFO, 0, "h", "sfs",
+                                                longMessage.c_str(), longMessage.size());
+    TEST_ASSERT_EQUAL(sizeof(line), n);
+}
+
+void test_datagram_packs_lines_until_full()
+{
+    SyslogDatagram datagram;
+    std::string    line(300, 'a');
+    int            packed = 0;
+    while (datagram.append(line.c_str(), line.size()))
+    {
+        packed++;
+    }
+    TEST_ASSERT_EQUAL(4, packed);  // 4 * 300 + 3 separators fits in 1400
+    TEST_ASSERT_EQUAL_UINT32(4, datagram.lineCount());
+    TEST_ASSERT_EQUAL(1203, datagram.size());
+    TEST_ASSERT_EQUAL('\n', datagram.data()[300]);
+}
+
+void test_datagram_reaches_local_udp_listener()
+{
+    int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    int sender   = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT_TRUE(receiver >= 0 && sender >= 0);
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = 0;
+    TEST_ASSERT_EQUAL(0, bind(receiver, (sockaddr *) &address, sizeof(address)));
+    socklen_t length = sizeof(address);
+    getsockname(receiver, (sockaddr *) &address, &length);
+
+    SyslogDatagram datagram;
+    char           line[256];
+    for (int i = 0; i < 3; i++)
+    {
+        char text[16];
+        int  n = snprintf(text, sizeof(text), "msg %d", i);
+        datagram.append(line, SyslogFormatter::formatLine(line, sizeof(line), LOG_LEVEL_INFO, 0,
+                                                          "dev", "sfs", text, n));
+    }
+    TEST_ASSERT_EQUAL((ssize_t) datagram.size(),
+                      sendto(sender, datagram.data(), datagram.size(), 0, (sockaddr *) &address,
+                             sizeof(address)));
+
+    char    received[SyslogFormatter::MAX_DATAGRAM + 1];
+    ssize_t got = recv(receiver, received, sizeof(received) - 1, 0);
+    TEST_ASSERT_EQUAL((ssize_t) datagram.size(), got);
+    received[got] = '\0';
+    TEST_ASSERT_EQUAL_STRING("<134>1 - dev sfs - - - msg 0\n"
+                             "<134>1 - dev sfs - - - msg 1\n"
+                             "<134>1 - dev sfs - - - msg 2",
+                             received);
+
+    close(sender);
+    close(receiver);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sink_filters_by_level_and_counts_drops);
+    RUN_TEST(test_queue_is_fifo_across_wrap_and_rejects_when_full);
+    RUN_TEST(test_format_line_is_rfc5424);
+    RUN_TEST(test_format_line_truncates_to_capacity);
+    RUN_TEST(test_datagram_packs_lines_until_full);
+    RUN_TEST(test_datagram_reaches_local_udp_listener);
+    return UNITY_END();
+}
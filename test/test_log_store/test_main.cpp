@@ -0,0 +1,372 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../../src/LogCodec.h"
+#include "../../src/LogCodec.cpp"
+#include "../../src/LogStore.h"
+#include "../../src/LogStore.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+struct Collected
+{
+    uint32_t count;
+    uint32_t firstSeq;
+    uint32_t lastSeq;
+    uint32_t lastTimestamp;
+    uint32_t stopAfter;
+    char     last[128];
+    bool     ordered;
+    bool     contentMatches;
+};
+
+static int formatMessage(char *out, size_t size, uint32_t i)
+{
+    return snprintf(out, size, "Flow debug: cycle tele=1 expected=%lu.%02lumm pulses=%lu%s",
+                    (unsigned long) (i * 7), (unsigned long) (i % 100), (unsigned long) i,
+                    (i % 5) ? "" : " (five)");
+}
+
+static bool collect(const LogStore::Record &record, void *context)
+{
+    Collected *c = static_cast<Collected *>(context);
+    if (c->stopAfter != 0 && c->count >= c->stopAfter)
+    {
+        return false;
+    }
+    if (c->count > 0 && record.seq != c->lastSeq + 1)
+    {
+        c->ordered = false;
+    }
+    if (c->count == 0)
+    {
+        c->firstSeq = record.seq;
+    }
+
+    char expected[128];
+    int  n = formatMessage(expected, sizeof(expected), record.timestamp);
+    if ((size_t) n != record.length || memcmp(expected, record.message, record.length) != 0)
+    {
+        c->contentMatches = false;
+    }
+
+    c->count++;
+    c->lastSeq       = record.seq;
+    c->lastTimestamp = record.timestamp;
+    size_t len       = record.length < sizeof(c->last) - 1 ? record.length : sizeof(c->last) - 1;
+    memcpy(c->last, record.message, len);
+    c->last[len] = '\0';
+    return true;
+}
+
+static Collected emptyCollected()
+{
+    Collected c;
+    memset(&c, 0, sizeof(c));
+    c.ordered        = true;
+    c.contentMatches = true;
+    return c;
+}
+
+static void appendMessages(LogStore &store, uint32_t from, uint32_t to)
+{
+    char message[128];
+    for (uint32_t i = from; i < to; i++)
+    {
+        int n = formatMessage(message, sizeof(message), i);
+        store.append(i, message, (size_t) n);
+    }
+}
+
+static uint32_t fakeMicros = 0;
+static uint32_t fakeClock()
+{
+    fakeMicros += 50;
+    return fakeMicros;
+}
+
+void test_rejects_too_small_buffer()
+{
+    static uint8_t buffer[LogStore::MIN_CAPACITY - 1];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+    store.append(1, "hello", 5);
+    TEST_ASSERT_FALSE(store.isAttached());
+    TEST_ASSERT_EQUAL_UINT32(0, store.count());
+}
+
+void test_active_block_records_visible_before_seal()
+{
+    static uint8_t buffer[LogStore::MIN_CAPACITY];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+
+    appendMessages(store, 0, 3);
+
+    Collected c = emptyCollected();
+    store.forEach(collect, &c);
+    TEST_ASSERT_EQUAL_UINT32(3, c.count);
+    TEST_ASSERT_TRUE(c.ordered);
+    TEST_ASSERT_TRUE(c.contentMatches);
+    TEST_ASSERT_EQUAL_UINT32(0, store.getStats().sealedBlocks);
+}
+
+void test_sealed_blocks_round_trip_and_evict()
+{
+    static uint8_t buffer[32 * 1024];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+    store.setClock(fakeClock);
+
+    appendMessages(store, 0, 5000);
+
+    Collected c = emptyCollected();
+    store.forEach(collect, &c);
+    TEST_ASSERT_EQUAL_UINT32(store.count(), c.count);
+    TEST_ASSERT_TRUE(c.ordered);
+    TEST_ASSERT_TRUE(c.contentMatches);
+    TEST_ASSERT_EQUAL_UINT32(4999, c.lastSeq);
+    TEST_ASSERT_EQUAL_UINT32(store.firstSeq(), c.firstSeq);
+    TEST_ASSERT_TRUE(store.firstSeq() > 0);
+    TEST_ASSERT_TRUE(store.usedBytes() <= sizeof(buffer));
+
+    LogStore::Stats stats = store.getStats();
+    TEST_ASSERT_GREATER_THAN(stats.liveBlocks, stats.sealedBlocks);
+    TEST_ASSERT_EQUAL_UINT32(50, stats.lastCompressUs);
+    TEST_ASSERT_EQUAL_UINT32(stats.sealedBlocks * 50, stats.totalCompressUs);
+}
+
+void test_compression_multiplies_history()
+{
+    // Same budget as a plain packed ring of raw records.
+    static uint8_t buffer[64 * 1024];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+
+    appendMessages(store, 0, 20000);
+
+    size_t rawBytesHeld = 0;
+    char   message[128];
+    for (uint32_t i = store.firstSeq(); i < store.nextSeq(); i++)
+    {
+        rawBytesHeld += 6 + (size_t) formatMessage(message, sizeof(message), i);
+    }
+
+    char summary[128];
+    snprintf(summary, sizeof(summary), "held %u records, %u raw bytes in a %u byte buffer",
+             (unsigned) store.count(), (unsigned) rawBytesHeld, (unsigned) sizeof(buffer));
+    TEST_MESSAGE(summary);
+    TEST_ASSERT_GREATER_THAN(2 * sizeof(buffer), rawBytesHeld);
+}
+
+void test_visit_from_cursor_resumes_and_clamps()
+{
+    static uint8_t buffer[16 * 1024];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+
+    appendMessages(store, 0, 3000);
+
+    // A cursor older than the oldest record is clamped.
+    Collected first = emptyCollected();
+    first.stopAfter = 10;
+    uint32_t next   = store.visitFrom(0, collect, &first);
+    TEST_ASSERT_EQUAL_UINT32(10, first.count);
+    TEST_ASSERT_EQUAL_UINT32(store.firstSeq(), first.firstSeq);
+    TEST_ASSERT_EQUAL_UINT32(store.firstSeq() + 10, next);
+
+    // Resuming picks up exactly where the last walk stopped.
+    Collected rest = emptyCollected();
+    uint32_t  end  = store.visitFrom(next, collect, &rest);
+    TEST_ASSERT_EQUAL_UINT32(next, rest.firstSeq);
+    TEST_ASSERT_EQUAL_UINT32(store.nextSeq(), end);
+    TEST_ASSERT_EQUAL_UINT32(store.count() - 10, rest.count);
+    TEST_ASSERT_TRUE(rest.ordered);
+    TEST_ASSERT_TRUE(rest.contentMatches);
+}
+
+void test_clear_keeps_sequence_monotonic()
+{
+    static uint8_t buffer[LogStore::MIN_CAPACITY];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+
+    appendMessages(store, 0, 2);
+    store.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, store.count());
+    TEST_ASSERT_EQUAL_UINT32(2, store.firstSeq());
+
+    appendMessages(store, 2, 3);
+    Collected c = emptyCollected();
+    store.forEach(collect, &c);
+    TEST_ASSERT_EQUAL_UINT32(1, c.count);
+    TEST_ASSERT_EQUAL_UINT32(2, c.lastSeq);
+}
+
+// Flow debug lines throughout, with a burst of tagged pause lines in the
+// middle; returns how many pause lines were appended
+static uint32_t appendMixed(LogStore &store, uint32_t count)
+{
+    char     message[128];
+    uint32_t pauses = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i >= 2000 && i < 2030 && (i % 3) == 0)
+        {
+            int n = snprintf(message, sizeof(message), "Pause condition met: deficit %lu",
+                             (unsigned long) i);
+            store.append(i, message, (size_t) n, LOG_LEVEL_WARN, LOG_CAT_GENERAL);
+            pauses++;
+        }
+        else
+        {
+            int n = formatMessage(message, sizeof(message), i);
+            store.append(i, message, (size_t) n, LOG_LEVEL_DEBUG, LOG_CAT_FLOW);
+        }
+    }
+    return pauses;
+}
+
+struct Matched
+{
+    const LogStore::Filter *filter;
+    uint32_t                count;
+    uint32_t                lastSeq;
+    bool                    allMatch;
+};
+
+static bool countMatching(const LogStore::Record &record, void *context)
+{
+    Matched *m = static_cast<Matched *>(context);
+    m->allMatch &= LogStore::matches(*m->filter, record);
+    m->count++;
+    m->lastSeq = record.seq;
+    return true;
+}
+
+// Reference answer: every record through matches()
+static uint32_t bruteForceCount(LogStore &store, const LogStore::Filter &filter)
+{
+    struct Counter
+    {
+        const LogStore::Filter *filter;
+        uint32_t                count;
+    } counter = {&filter, 0};
+    store.forEach(
+        [](const LogStore::Record &record, void *context)
+        {
+            Counter *c = static_cast<Counter *>(context);
+            c->count += LogStore::matches(*c->filter, record) ? 1 : 0;
+            return true;
+        },
+        &counter);
+    return counter.count;
+}
+
+void test_records_keep_level_and_category()
+{
+    static uint8_t buffer[128 * 1024];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+    uint32_t pauses = appendMixed(store, 3000);
+
+    LogStore::Filter filter;
+    filter.categoryMask = LOG_CATEGORY_BIT(LOG_CAT_GENERAL);
+    Matched m           = {&filter, 0, 0, true};
+    store.visitFrom(0, filter, countMatching, &m);
+    TEST_ASSERT_EQUAL_UINT32(pauses, m.count);
+    TEST_ASSERT_TRUE(m.allMatch);
+
+    filter              = LogStore::Filter();
+    filter.maxLevel     = LOG_LEVEL_WARN;
+    m                   = {&filter, 0, 0, true};
+    store.visitFrom(0, filter, countMatching, &m);
+    TEST_ASSERT_EQUAL_UINT32(pauses, m.count);
+}
+
+void test_filtered_walk_skips_blocks_that_cannot_match()
+{
+    static uint8_t buffer[128 * 1024];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+    uint32_t pauses = appendMixed(store, 3000);
+    TEST_ASSERT_EQUAL_UINT32(0, store.firstSeq());
+
+    LogStore::Filter filter;
+    filter.maxLevel = LOG_LEVEL_WARN;
+    filter.text     = "PAUSE CONDITION";
+    LogStore::Scan scan;
+    Matched        m    = {&filter, 0, 0, true};
+    uint32_t       next = store.visitFrom(0, filter, countMatching, &m, &scan);
+
+    TEST_ASSERT_EQUAL_UINT32(pauses, m.count);
+    TEST_ASSERT_EQUAL_UINT32(store.nextSeq(), next);
+    // The burst spans one or two blocks; everything else is ruled out
+    // from the block headers alone
+    TEST_ASSERT_TRUE(scan.blocksRead >= 1 && scan.blocksRead <= 2);
+    TEST_ASSERT_EQUAL_UINT32(store.getStats().liveBlocks, scan.blocksRead + scan.blocksSkipped);
+
+    // Time range on monotonic timestamps (here equal to the index)
+    filter        = LogStore::Filter();
+    filter.fromUs = 1000;
+    filter.toUs   = 1099;
+    scan          = LogStore::Scan();
+    m             = {&filter, 0, 0, true};
+    store.visitFrom(0, filter, countMatching, &m, &scan);
+    TEST_ASSERT_EQUAL_UINT32(100, m.count);
+    TEST_ASSERT_TRUE(m.allMatch);
+    TEST_ASSERT_TRUE(scan.blocksSkipped > scan.blocksRead);
+
+    // Substring alone can't use the summaries but must agree with matches()
+    filter      = LogStore::Filter();
+    filter.text = "(five)";
+    m           = {&filter, 0, 0, true};
+    store.visitFrom(0, filter, countMatching, &m);
+    TEST_ASSERT_EQUAL_UINT32(bruteForceCount(store, filter), m.count);
+    TEST_ASSERT_TRUE(m.count > 0);
+}
+
+void test_block_budget_resumes_without_losing_records()
+{
+    static uint8_t buffer[128 * 1024];
+    LogStore       store;
+    store.attach(buffer, sizeof(buffer));
+    appendMixed(store, 3000);
+
+    LogStore::Filter filter;
+    filter.text = "pulses=1";
+    LogStore::Scan scan;
+    scan.blockBudget = 1;
+    Matched  m       = {&filter, 0, 0, true};
+    uint32_t seq     = 0;
+    uint32_t calls   = 0;
+    while (seq < store.nextSeq())
+    {
+        uint32_t next = store.visitFrom(seq, filter, countMatching, &m, &scan);
+        TEST_ASSERT_TRUE(next > seq);
+        seq = next;
+        calls++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(bruteForceCount(store, filter), m.count);
+    TEST_ASSERT_TRUE(m.allMatch);
+    TEST_ASSERT_EQUAL_UINT32(store.getStats().liveBlocks, scan.blocksRead);
+    TEST_ASSERT_TRUE(calls >= scan.blocksRead);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_too_small_buffer);
+    RUN_TEST(test_active_block_records_visible_before_seal);
+    RUN_TEST(test_sealed_blocks_round_trip_and_evict);
+    RUN_TEST(test_compression_multiplies_history);
+    RUN_TEST(test_visit_from_cursor_resumes_and_clamps);
+    RUN_TEST(test_clear_keeps_sequence_monotonic);
+    RUN_TEST(test_records_keep_level_and_category);
+    RUN_TEST(test_filtered_walk_skips_blocks_that_cannot_match);
+    RUN_TEST(test_block_budget_resumes_without_losing_records);
+    return UNITY_END();
+}
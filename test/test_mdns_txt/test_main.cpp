@@ -0,0 +1,90 @@
+#include <unity.h>
+
+#include "../../src/MdnsTxt.h"
+#include "../../src/MdnsTxt.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+void test_hostname_uses_mac_suffix()
+{
+    const uint8_t mac[6] = {0x24, 0x6f, 0x28, 0x1a, 0xb2, 0x0c};
+    char          hostname[24];
+    mdnsHostnameFromMac(mac, hostname, sizeof(hostname));
+    TEST_ASSERT_EQUAL_STRING("ccxsfs20-b20c", hostname);
+}
+
+void test_only_changed_records_are_dirty()
+{
+    MdnsTxtRecords txt;
+    TEST_ASSERT_TRUE(txt.set("fw", "1.2.0"));
+    TEST_ASSERT_TRUE(txt.set("state", "13"));
+    TEST_ASSERT_TRUE(txt.due(0));
+    txt.markPushed(0);
+
+    TEST_ASSERT_FALSE(txt.set("fw", "1.2.0"));
+    TEST_ASSERT_TRUE(txt.set("state", "6"));
+    TEST_ASSERT_FALSE(txt.isDirty(0));
+    TEST_ASSERT_TRUE(txt.isDirty(1));
+    TEST_ASSERT_EQUAL_STRING("6", txt.value(1));
+    TEST_ASSERT_EQUAL_UINT32(2, txt.count());
+}
+
+void test_pushes_are_rate_limited()
+{
+    MdnsTxtRecords txt;
+    txt.set("jam", "0");
+    TEST_ASSERT_TRUE(txt.due(1000));
+    txt.markPushed(1000);
+
+    TEST_ASSERT_FALSE(txt.due(1500));  // nothing changed
+    txt.set("jam", "1");
+    TEST_ASSERT_FALSE(txt.due(1500));
+    TEST_ASSERT_FALSE(txt.due(1000 + MdnsTxtRecords::MIN_PUSH_INTERVAL_MS - 1));
+    TEST_ASSERT_TRUE(txt.due(1000 + MdnsTxtRecords::MIN_PUSH_INTERVAL_MS));
+
+    // Several changes inside one interval collapse into the latest value
+    txt.set("jam", "0");
+    txt.set("jam", "1");
+    TEST_ASSERT_EQUAL_STRING("1", txt.value(0));
+}
+
+void test_mark_all_dirty_resends_immediately()
+{
+    MdnsTxtRecords txt;
+    txt.set("fw", "dev");
+    txt.markPushed(5000);
+    txt.markAllDirty();
+    TEST_ASSERT_TRUE(txt.isDirty(0));
+    TEST_ASSERT_TRUE(txt.due(5001));
+}
+
+void test_long_values_are_truncated_and_table_is_bounded()
+{
+    MdnsTxtRecords txt;
+    char           longValue[80];
+    memset(longValue, 'x', sizeof(longValue) - 1);
+    longValue[sizeof(longValue) - 1] = '\0';
+    txt.set("printer", longValue);
+    TEST_ASSERT_EQUAL_UINT32(MdnsTxtRecords::VALUE_SIZE - 1, strlen(txt.value(0)));
+    TEST_ASSERT_FALSE(txt.set("printer", longValue));
+
+    char key[4];
+    for (size_t i = 1; i < MdnsTxtRecords::MAX_RECORDS; i++)
+    {
+        snprintf(key, sizeof(key), "k%u", (unsigned) i);
+        TEST_ASSERT_TRUE(txt.set(key, "v"));
+    }
+    TEST_ASSERT_FALSE(txt.set("extra", "v"));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_hostname_uses_mac_suffix);
+    RUN_TEST(test_only_changed_records_are_dirty);
+    RUN_TEST(test_pushes_are_rate_limited);
+    RUN_TEST(test_mark_all_dirty_resends_immediately);
+    RUN_TEST(test_long_values_are_truncated_and_table_is_bounded);
+    return UNITY_END();
+}
@@ -0,0 +1,109 @@
+#include <unity.h>
+
+#include "../../src/MemoryHealth.h"
+#include "../../src/MemoryHealth.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static memory_thresholds_t testThresholds()
+{
+    memory_thresholds_t thresholds;
+    thresholds.lowFreeBytes         = 40000;
+    thresholds.criticalFreeBytes    = 20000;
+    thresholds.lowLargestBlock      = 16000;
+    thresholds.criticalLargestBlock = 8000;
+    thresholds.hysteresisBytes      = 4000;
+    return thresholds;
+}
+
+static memory_sample_t sample(uint32_t freeBytes, uint32_t largestBlock)
+{
+    memory_sample_t s;
+    s.freeBytes    = freeBytes;
+    s.minFreeBytes = freeBytes;
+    s.largestBlock = largestBlock;
+    return s;
+}
+
+static size_t shedCalls[2];
+
+static size_t shedCache(void *context)
+{
+    shedCalls[*static_cast<int *>(context)]++;
+    return 1000;
+}
+
+void test_levels_follow_free_and_largest_block()
+{
+    MemoryHealth health;
+    health.setThresholds(testThresholds());
+    TEST_ASSERT_EQUAL(MEMORY_OK, health.update(sample(100000, 60000)));
+    TEST_ASSERT_EQUAL(MEMORY_LOW, health.update(sample(39000, 30000)));
+    TEST_ASSERT_EQUAL(MEMORY_CRITICAL, health.update(sample(19000, 15000)));
+
+    // Plenty free but splintered: the largest block decides
+    MemoryHealth fragmented;
+    fragmented.setThresholds(testThresholds());
+    TEST_ASSERT_EQUAL(MEMORY_CRITICAL, fragmented.update(sample(90000, 7000)));
+    TEST_ASSERT_EQUAL_UINT8(93, MemoryHealth::fragmentationPct(sample(90000, 7000)));
+}
+
+void test_recovery_needs_headroom()
+{
+    MemoryHealth health;
+    health.setThresholds(testThresholds());
+    health.update(sample(39000, 30000));
+    TEST_ASSERT_EQUAL(MEMORY_LOW, health.update(sample(41000, 30000)));  // just above the line
+    TEST_ASSERT_EQUAL(MEMORY_LOW, health.update(sample(43999, 30000)));
+    TEST_ASSERT_EQUAL(MEMORY_OK, health.update(sample(44000, 30000)));
+    TEST_ASSERT_EQUAL_UINT32(2, health.getStats().levelChanges);
+    TEST_ASSERT_EQUAL_UINT8(MEMORY_LOW, health.getStats().worstLevel);
+}
+
+void test_shedders_run_once_per_episode_by_level()
+{
+    MemoryHealth health;
+    health.setThresholds(testThresholds());
+    int lowIndex = 0, criticalIndex = 1;
+    shedCalls[0] = shedCalls[1] = 0;
+    TEST_ASSERT_TRUE(health.addShedder("logs", MEMORY_LOW, shedCache, &lowIndex));
+    TEST_ASSERT_TRUE(health.addShedder("syslog", MEMORY_CRITICAL, shedCache, &criticalIndex));
+    TEST_ASSERT_FALSE(health.addShedder("never", MEMORY_OK, shedCache, &lowIndex));
+
+    health.update(sample(39000, 30000));
+    health.update(sample(38000, 30000));
+    TEST_ASSERT_EQUAL_UINT32(1, shedCalls[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, shedCalls[1]);
+
+    health.update(sample(15000, 10000));
+    TEST_ASSERT_EQUAL_UINT32(1, shedCalls[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, shedCalls[1]);
+    TEST_ASSERT_TRUE(health.shedderFired(1));
+
+    // Recovery re-arms both
+    health.update(sample(100000, 60000));
+    TEST_ASSERT_FALSE(health.shedderFired(0));
+    health.update(sample(15000, 10000));
+    TEST_ASSERT_EQUAL_UINT32(2, shedCalls[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, shedCalls[1]);
+    TEST_ASSERT_EQUAL_UINT32(4, health.getStats().shedRuns);
+    TEST_ASSERT_EQUAL_UINT32(4000, health.getStats().bytesShed);
+}
+
+void test_fragmentation_edge_cases()
+{
+    TEST_ASSERT_EQUAL_UINT8(0, MemoryHealth::fragmentationPct(sample(0, 0)));
+    TEST_ASSERT_EQUAL_UINT8(0, MemoryHealth::fragmentationPct(sample(5000, 5000)));
+    TEST_ASSERT_EQUAL_UINT8(50, MemoryHealth::fragmentationPct(sample(5000, 2500)));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_levels_follow_free_and_largest_block);
+    RUN_TEST(test_recovery_needs_headroom);
+    RUN_TEST(test_shedders_run_once_per_episode_by_level);
+    RUN_TEST(test_fragmentation_edge_cases);
+    return UNITY_END();
+}
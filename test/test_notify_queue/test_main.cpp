@@ -0,0 +1,182 @@
+#include <unity.h>
+
+#include <string.h>
+
+#include "../../src/NotifyQueue.h"
+#include "../../src/NotifyQueue.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+void test_delivers_in_order_and_dedupes()
+{
+    NotifyQueue queue;
+    TEST_ASSERT_TRUE(queue.push(NOTIFY_JAM, 10, 0, 12.5f, 40, 1000));
+    TEST_ASSERT_TRUE(queue.push(NOTIFY_PRINT_COMPLETE, 20, 0, 0.0f, 200, 1500));
+
+    // Same kind within DEDUPE_MS of acceptance, queued or already sent
+    TEST_ASSERT_FALSE(queue.push(NOTIFY_JAM, 30, 0, 13.0f, 41, 2000));
+    notify_record_t record;
+    TEST_ASSERT_TRUE(queue.due(2000, record));
+    TEST_ASSERT_EQUAL(NOTIFY_JAM, record.kind);
+    TEST_ASSERT_EQUAL_UINT32(1, record.id);
+    queue.markSent();
+    TEST_ASSERT_FALSE(
+        queue.push(NOTIFY_JAM, 40, 0, 13.0f, 41, 1000 + NotifyQueue::DEDUPE_MS - 1));
+    TEST_ASSERT_TRUE(queue.push(NOTIFY_JAM, 50, 0, 14.0f, 42, 1000 + NotifyQueue::DEDUPE_MS));
+
+    TEST_ASSERT_TRUE(queue.due(70000, record));
+    TEST_ASSERT_EQUAL(NOTIFY_PRINT_COMPLETE, record.kind);
+    queue.markSent();
+    TEST_ASSERT_TRUE(queue.due(70000, record));
+    TEST_ASSERT_EQUAL(NOTIFY_JAM, record.kind);
+    TEST_ASSERT_EQUAL_UINT32(3, record.id);
+
+    notify_stats_t stats = queue.getStats();
+    TEST_ASSERT_EQUAL_UINT32(3, stats.accepted);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.sent);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.suppressed);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.queued);
+}
+
+void test_failed_delivery_backs_off_then_gives_up()
+{
+    TEST_ASSERT_EQUAL_UINT32(0, NotifyQueue::backoffMs(0));
+    TEST_ASSERT_EQUAL_UINT32(5000, NotifyQueue::backoffMs(1));
+    TEST_ASSERT_EQUAL_UINT32(10000, NotifyQueue::backoffMs(2));
+    TEST_ASSERT_EQUAL_UINT32(160000, NotifyQueue::backoffMs(6));
+    TEST_ASSERT_EQUAL_UINT32(NotifyQueue::RETRY_MAX_MS, NotifyQueue::backoffMs(7));
+    TEST_ASSERT_EQUAL_UINT32(NotifyQueue::RETRY_MAX_MS, NotifyQueue::backoffMs(200));
+
+    NotifyQueue queue;
+    queue.push(NOTIFY_RUNOUT, 0, 0, 0.0f, 0, 0);
+    queue.push(NOTIFY_LINK_LOST, 0, 0, 0.0f, 0, 0);
+
+    notify_record_t record;
+    uint32_t        now = 0;
+    for (uint8_t attempt = 1; attempt < NotifyQueue::MAX_ATTEMPTS; attempt++)
+    {
+        TEST_ASSERT_TRUE(queue.due(now, record));
+        TEST_ASSERT_EQUAL(NOTIFY_RUNOUT, record.kind);
+        queue.markFailed(now);
+        // Nothing is due until the backoff has passed, not even the next kind
+        TEST_ASSERT_FALSE(queue.due(now + NotifyQueue::backoffMs(attempt) - 1, record));
+        now += NotifyQueue::backoffMs(attempt);
+    }
+    TEST_ASSERT_TRUE(queue.due(now, record));
+    queue.markFailed(now);
+
+    TEST_ASSERT_TRUE(queue.due(now, record));
+    TEST_ASSERT_EQUAL(NOTIFY_LINK_LOST, record.kind);
+    notify_stats_t stats = queue.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.failed);
+    TEST_ASSERT_EQUAL_UINT32(NotifyQueue::MAX_ATTEMPTS - 1, stats.retries);
+}
+
+void test_full_queue_drops_oldest()
+{
+    // An endpoint that stays down for hours while jams keep happening
+    NotifyQueue queue;
+    for (uint32_t i = 0; i < NotifyQueue::CAPACITY + 3; i++)
+    {
+        TEST_ASSERT_TRUE(
+            queue.push(NOTIFY_JAM, i, 0, 0.0f, (int32_t) i, i * NotifyQueue::DEDUPE_MS));
+    }
+    TEST_ASSERT_EQUAL(NotifyQueue::CAPACITY, queue.count());
+    TEST_ASSERT_EQUAL_UINT32(3, queue.getStats().dropped);
+
+    notify_record_t record;
+    TEST_ASSERT_TRUE(queue.due((NotifyQueue::CAPACITY + 3) * NotifyQueue::DEDUPE_MS, record));
+    TEST_ASSERT_EQUAL_UINT32(4, record.id);
+}
+
+void test_state_round_trip_and_validation()
+{
+    NotifyQueue queue;
+    queue.push(NOTIFY_JAM, 111, 1700000000, 9.5f, 12, 0);
+    queue.push(NOTIFY_PRINT_COMPLETE, 222, 0, 0.0f, 300, 0);
+    notify_record_t record;
+    queue.due(0, record);
+    queue.markFailed(0);
+    TEST_ASSERT_TRUE(queue.takeDirty());
+    TEST_ASSERT_FALSE(queue.takeDirty());
+
+    uint8_t state[NotifyQueue::MAX_STATE_SIZE];
+    size_t  size = queue.saveState(state, sizeof(state));
+    TEST_ASSERT_EQUAL(NotifyQueue::STATE_HEADER + 2 * sizeof(notify_record_t), size);
+    TEST_ASSERT_EQUAL(0, queue.saveState(state, size - 1));
+
+    NotifyQueue restored;
+    TEST_ASSERT_FALSE(restored.loadState(state, size - 1));
+    uint8_t corrupt[NotifyQueue::MAX_STATE_SIZE];
+    memcpy(corrupt, state, size);
+    corrupt[0] ^= 0xFF;
+    TEST_ASSERT_FALSE(restored.loadState(corrupt, size));
+    TEST_ASSERT_EQUAL(0, restored.count());
+
+    TEST_ASSERT_TRUE(restored.loadState(state, size));
+    TEST_ASSERT_EQUAL(2, restored.count());
+    // Backoff deadlines belonged to the previous boot
+    TEST_ASSERT_TRUE(restored.due(0, record));
+    TEST_ASSERT_EQUAL(NOTIFY_JAM, record.kind);
+    TEST_ASSERT_EQUAL(1, record.attempts);
+    // The monotonic time is from the previous boot; the wall-clock time stays
+    TEST_ASSERT_TRUE(record.timestampUs == 0);
+    TEST_ASSERT_EQUAL_UINT32(1700000000, record.epochSeconds);
+    restored.markSent();
+    TEST_ASSERT_TRUE(restored.due(0, record));
+    TEST_ASSERT_EQUAL_INT32(300, record.layer);
+    TEST_ASSERT_EQUAL_UINT32(0, record.epochSeconds);
+
+    // Ids continue after the saved ones
+    restored.markSent();
+    restored.push(NOTIFY_TEST, 0, 0, 0.0f, 0, 0);
+    TEST_ASSERT_TRUE(restored.due(0, record));
+    TEST_ASSERT_EQUAL_UINT32(3, record.id);
+}
+
+void test_render_escapes_and_bounds()
+{
+    notify_record_t record = {};
+    record.id              = 42;
+    record.kind            = NOTIFY_JAM;
+    record.deficitMm       = 12.345f;
+    record.layer           = 17;
+    notify_context_t context = {"sfs \"bench\"\\1", 1700000000};
+
+    char   body[NotifyQueue::MAX_BODY_LENGTH];
+    size_t length = NotifyQueue::render(nullptr, record, context, body, sizeof(body));
+    TEST_ASSERT_EQUAL(strlen(body), length);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"event\":\"jam\",\"message\":\"Filament jam detected\","
+        "\"device\":\"sfs \\\"bench\\\"\\\\1\",\"time\":1700000000,\"deficitMm\":12.35,"
+        "\"layer\":17,\"id\":42}",
+        body);
+
+    length = NotifyQueue::render("{\"text\":\"{{device}}: {{message}} {{unknown}} {{\"}", record,
+                                 context, body, sizeof(body));
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"text\":\"sfs \\\"bench\\\"\\\\1: Filament jam detected {{unknown}} {{\"}",
+        body);
+
+    // Too small: nothing half-written
+    TEST_ASSERT_EQUAL(0, NotifyQueue::render(nullptr, record, context, body, 40));
+    TEST_ASSERT_EQUAL_STRING("", body);
+
+    // An unknown time is left out rather than sent as 1970
+    context.epochSeconds = 0;
+    NotifyQueue::render("{\"time\":{{time}}}", record, context, body, sizeof(body));
+    TEST_ASSERT_EQUAL_STRING("{\"time\":null}", body);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_delivers_in_order_and_dedupes);
+    RUN_TEST(test_failed_delivery_backs_off_then_gives_up);
+    RUN_TEST(test_full_queue_drops_oldest);
+    RUN_TEST(test_state_round_trip_and_validation);
+    RUN_TEST(test_render_escapes_and_bounds);
+    return UNITY_END();
+}
@@ -0,0 +1,121 @@
+#include <unity.h>
+
+#include "../../src/PauseTrace.h"
+#include "../../src/PauseTrace.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// Jam at onsetUs, pause decided 2s later, printer paused after another 1.5s.
+static void recordJamPause(PauseTracer &tracer, uint32_t onsetUs, float expectedAtOnset,
+                           float expectedAtStop)
+{
+    uint32_t decideUs = onsetUs + 2000000;
+    tracer.begin(false, decideUs);
+    tracer.mark(PAUSE_STAGE_JAM_ONSET, onsetUs);
+    tracer.setExpectedAtOnset(expectedAtOnset);
+    tracer.mark(PAUSE_STAGE_THRESHOLD_CROSSED, onsetUs + 500000);
+    tracer.mark(PAUSE_STAGE_HOLD_SATISFIED, decideUs);
+    tracer.mark(PAUSE_STAGE_COMMAND_BUILT, decideUs + 300);
+    tracer.mark(PAUSE_STAGE_SOCKET_WRITTEN, decideUs + 900);
+    tracer.mark(PAUSE_STAGE_ACK_RECEIVED, decideUs + 80000);
+    tracer.markStopped(PAUSE_STAGE_PAUSING, decideUs + 500000, expectedAtStop);
+    tracer.markStopped(PAUSE_STAGE_PAUSED, decideUs + 1500000, expectedAtStop + 5.0f);
+}
+
+void test_complete_trace_records_offsets_from_onset()
+{
+    PauseTracer tracer;
+    recordJamPause(tracer, 1000000, 100.0f, 112.5f);
+
+    TEST_ASSERT_FALSE(tracer.isActive());
+    TEST_ASSERT_EQUAL_UINT32(1, tracer.historyCount());
+    const PauseTrace &trace = tracer.history(0);
+    TEST_ASSERT_TRUE(trace.complete);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.offsetUs(PAUSE_STAGE_JAM_ONSET));
+    TEST_ASSERT_EQUAL_UINT32(2000900, trace.offsetUs(PAUSE_STAGE_SOCKET_WRITTEN));
+    TEST_ASSERT_EQUAL_UINT32(3500000, trace.offsetUs(PAUSE_STAGE_PAUSED));
+    // Expected extrusion is taken from the first stop frame, not PAUSED.
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 12.5f, trace.overrunMm());
+}
+
+void test_first_mark_wins_and_offsets_survive_wraparound()
+{
+    PauseTracer tracer;
+    uint32_t    onsetUs = 0xFFFFFF00u;
+    tracer.begin(false, onsetUs + 1000);
+    tracer.mark(PAUSE_STAGE_JAM_ONSET, onsetUs);
+    tracer.mark(PAUSE_STAGE_COMMAND_BUILT, onsetUs + 1000);
+    tracer.mark(PAUSE_STAGE_COMMAND_BUILT, onsetUs + 9000);
+    tracer.markStopped(PAUSE_STAGE_PAUSED, onsetUs + 4000, 0.0f);
+
+    const PauseTrace &trace = tracer.history(0);
+    TEST_ASSERT_EQUAL_UINT32(1000, trace.offsetUs(PAUSE_STAGE_COMMAND_BUILT));
+    TEST_ASSERT_EQUAL_UINT32(4000, trace.offsetUs(PAUSE_STAGE_PAUSED));
+}
+
+void test_runout_trace_without_onset_has_no_overrun()
+{
+    PauseTracer tracer;
+    tracer.begin(true, 5000);
+    tracer.mark(PAUSE_STAGE_COMMAND_BUILT, 5000);
+    tracer.markStopped(PAUSE_STAGE_PAUSED, 905000, 250.0f);
+
+    const PauseTrace &trace = tracer.history(0);
+    TEST_ASSERT_TRUE(trace.runout);
+    TEST_ASSERT_FALSE(trace.hasStage(PAUSE_STAGE_JAM_ONSET));
+    TEST_ASSERT_EQUAL_UINT32(900000, trace.offsetUs(PAUSE_STAGE_PAUSED));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, trace.overrunMm());
+    TEST_ASSERT_EQUAL_UINT32(0, tracer.overrunSummary().samples);
+}
+
+void test_expired_and_superseded_traces_are_incomplete()
+{
+    PauseTracer tracer;
+    uint32_t    first = tracer.begin(false, 0);
+    tracer.expire(PauseTracer::TIMEOUT_US);
+    TEST_ASSERT_TRUE(tracer.isActive());
+    tracer.expire(PauseTracer::TIMEOUT_US + 1);
+    TEST_ASSERT_FALSE(tracer.isActive());
+
+    uint32_t second = tracer.begin(false, 100);
+    tracer.begin(false, 200);
+    TEST_ASSERT_EQUAL_UINT32(2, tracer.historyCount());
+    TEST_ASSERT_EQUAL_UINT32(second, tracer.history(0).id);
+    TEST_ASSERT_EQUAL_UINT32(first, tracer.history(1).id);
+    TEST_ASSERT_FALSE(tracer.history(0).complete);
+    TEST_ASSERT_EQUAL_UINT32(0, tracer.stageSummary(PAUSE_STAGE_PAUSED).samples);
+}
+
+void test_summary_percentiles_over_bounded_history()
+{
+    PauseTracer tracer;
+    // Overruns 1..20mm; only the 16 most recent (5..20) are kept.
+    for (int i = 1; i <= 20; i++)
+    {
+        recordJamPause(tracer, i * 10000000u, 0.0f, (float) i);
+    }
+    TEST_ASSERT_EQUAL_UINT32(PauseTracer::HISTORY_SIZE, tracer.historyCount());
+
+    PauseOverrunSummary overrun = tracer.overrunSummary();
+    TEST_ASSERT_EQUAL_UINT32(16, overrun.samples);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 12.0f, overrun.p50Mm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 19.0f, overrun.p90Mm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, overrun.maxMm);
+
+    PauseLatencySummary paused = tracer.stageSummary(PAUSE_STAGE_PAUSED);
+    TEST_ASSERT_EQUAL_UINT32(16, paused.samples);
+    TEST_ASSERT_EQUAL_UINT32(3500000, paused.p50Us);
+    TEST_ASSERT_EQUAL_UINT32(3500000, paused.maxUs);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_complete_trace_records_offsets_from_onset);
+    RUN_TEST(test_first_mark_wins_and_offsets_survive_wraparound);
+    RUN_TEST(test_runout_trace_without_onset_has_no_overrun);
+    RUN_TEST(test_expired_and_superseded_traces_are_incomplete);
+    RUN_TEST(test_summary_percentiles_over_bounded_history);
+    return UNITY_END();
+}
@@ -0,0 +1,242 @@
+#include <unity.h>
+
+#include "../../src/PauseVerifier.h"
+#include "../../src/PauseVerifier.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// Status frames every 500 ms from `fromMs` to `toMs`, TotalExtrusion growing
+// by `mmPerFrame`. Returns the last total sent.
+static float feedFrames(PauseVerifier &verifier, uint32_t fromMs, uint32_t toMs, float total,
+                        float mmPerFrame, pause_action_t *firstAction = nullptr)
+{
+    for (uint32_t t = fromMs; t <= toMs; t += 500)
+    {
+        total += mmPerFrame;
+        verifier.onTelemetry(t, false, true, total, true, mmPerFrame);
+        pause_action_t action = verifier.update(t);
+        if (action != PAUSE_ACTION_NONE && firstAction != nullptr &&
+            *firstAction == PAUSE_ACTION_NONE)
+        {
+            *firstAction = action;
+            return total;
+        }
+    }
+    return total;
+}
+
+void test_pause_that_takes_is_confirmed_with_its_overrun()
+{
+    PauseVerifier verifier;
+    verifier.onTelemetry(0, false, true, 100.0f, false, 0.0f);
+    verifier.begin(7, 1000);
+
+    // The printer finishes its move during the settle time, then stops
+    float          total  = feedFrames(verifier, 1500, 3000, 100.0f, 1.0f);
+    pause_action_t action = PAUSE_ACTION_NONE;
+    feedFrames(verifier, 3500, 20000, total, 0.0f, &action);
+
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_FINISHED, action);
+    TEST_ASSERT_FALSE(verifier.isActive());
+    const PauseVerification &record = verifier.history(0);
+    TEST_ASSERT_EQUAL_UINT32(7, record.id);
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_STOPPED, record.outcome);
+    TEST_ASSERT_EQUAL(1, record.steps);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.0f, record.stepMm[PAUSE_STEP_PAUSE]);
+    TEST_ASSERT_EQUAL_UINT32(PauseVerifier::SETTLE_MS + PauseVerifier::WINDOW_MS,
+                             record.durationMs);
+
+    PauseEffectSummary summary = verifier.summary();
+    TEST_ASSERT_EQUAL_UINT32(1, summary.samples);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.0f, summary.maxMm);
+    TEST_ASSERT_EQUAL_UINT32(1, verifier.getStats().stopped);
+}
+
+void test_ignored_pause_escalates_through_every_step()
+{
+    PauseVerifier verifier;
+    verifier.setEscalation(PAUSE_STEP_STOP);
+    verifier.onTelemetry(0, false, true, 50.0f, false, 0.0f);
+    verifier.begin(1, 0);
+
+    static const pause_action_t EXPECTED[] = {PAUSE_ACTION_REPAUSE, PAUSE_ACTION_STOP_FEEDING,
+                                              PAUSE_ACTION_STOP, PAUSE_ACTION_FINISHED};
+    float    total = 50.0f;
+    uint32_t now   = 0;
+    for (pause_action_t expected : EXPECTED)
+    {
+        pause_action_t action = PAUSE_ACTION_NONE;
+        uint32_t       start  = now + 500;
+        total                 = feedFrames(verifier, start, start + 60000, total, 1.0f, &action);
+        TEST_ASSERT_EQUAL(expected, action);
+        // Escalation happens as soon as the watch window sees > 2 mm
+        now = verifier.isActive()
+                  ? verifier.current().stepOffsetMs[verifier.current().steps - 1]
+                  : verifier.history(0).durationMs;
+        TEST_ASSERT_EQUAL_UINT32(start + PauseVerifier::SETTLE_MS + 500, now);
+    }
+
+    const PauseVerification &record = verifier.history(0);
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_STILL_EXTRUDING, record.outcome);
+    TEST_ASSERT_EQUAL(PAUSE_STEP_COUNT, record.steps);
+    for (int i = 0; i < PAUSE_STEP_COUNT; i++)
+    {
+        // 1 mm per frame from +500 ms through the third frame after settling
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, record.stepMm[i]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 40.0f, record.totalMm());
+    PauseVerifier::Stats stats = verifier.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.escalations[PAUSE_STEP_REPAUSE]);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.escalations[PAUSE_STEP_STOP]);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.stillExtruding);
+    TEST_ASSERT_EQUAL_UINT32(0, verifier.summary().samples);
+}
+
+void test_default_escalation_stops_after_repause()
+{
+    PauseVerifier verifier;
+    verifier.onTelemetry(0, false, true, 50.0f, false, 0.0f);
+    verifier.begin(9, 0);
+    pause_action_t action = PAUSE_ACTION_NONE;
+    float          total  = feedFrames(verifier, 500, 20000, 50.0f, 1.0f, &action);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_REPAUSE, action);
+    action = PAUSE_ACTION_NONE;
+    feedFrames(verifier, 5500, 40000, total, 1.0f, &action);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_FINISHED, action);
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_STILL_EXTRUDING, verifier.history(0).outcome);
+    TEST_ASSERT_EQUAL(2, verifier.history(0).steps);
+    TEST_ASSERT_EQUAL_UINT32(0, verifier.getStats().escalations[PAUSE_STEP_STOP_FEEDING]);
+    TEST_ASSERT_EQUAL_UINT32(0, verifier.getStats().escalations[PAUSE_STEP_STOP]);
+}
+
+void test_sensor_movement_escalates_without_telemetry_growth()
+{
+    PauseVerifier verifier;
+    verifier.begin(2, 0);
+    // Still reported as printing: the pause was not taken
+    verifier.onTelemetry(5000, true, true, 10.0f, false, 0.0f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_NONE, verifier.update(5000));
+    verifier.onMovement(5100, 1.5f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_NONE, verifier.update(5100));
+    verifier.onMovement(5200, 1.5f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_REPAUSE, verifier.update(5200));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 3.0f, verifier.current().stepMm[PAUSE_STEP_PAUSE]);
+
+    // Movement during the settle time of the next step is allowed
+    verifier.onMovement(6000, 1.5f);
+    verifier.onMovement(7000, 1.5f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_NONE, verifier.update(7000));
+}
+
+void test_sensor_movement_while_paused_is_ignored()
+{
+    PauseVerifier verifier;
+    verifier.onTelemetry(0, false, true, 10.0f, false, 0.0f);
+    verifier.begin(10, 0);
+    // Paused, TotalExtrusion flat: filament pulled by hand or unloaded
+    verifier.onTelemetry(5000, false, true, 10.0f, false, 0.0f);
+    for (uint32_t t = 5100; t < 7000; t += 100)
+    {
+        verifier.onMovement(t, 1.5f);
+        TEST_ASSERT_EQUAL(PAUSE_ACTION_NONE, verifier.update(t));
+    }
+    verifier.onTelemetry(8000, false, true, 10.0f, false, 0.0f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_FINISHED, verifier.update(8000));
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_STOPPED, verifier.history(0).outcome);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, verifier.history(0).totalMm());
+}
+
+void test_delta_only_telemetry_and_retractions()
+{
+    PauseVerifier verifier;
+    verifier.begin(3, 0);
+    // No TotalExtrusion: positive CurrentExtrusion counts, negative does not
+    verifier.onTelemetry(4500, false, false, 0.0f, true, 1.5f);
+    verifier.onTelemetry(5000, false, false, 0.0f, true, -3.0f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_NONE, verifier.update(5000));
+    verifier.onTelemetry(5500, false, false, 0.0f, true, 1.0f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_REPAUSE, verifier.update(5500));
+
+    // A falling total (retraction, new print) is not feed either
+    verifier.begin(4, 10000);
+    verifier.onTelemetry(10500, false, true, 200.0f, false, 0.0f);
+    verifier.onTelemetry(14500, false, true, 150.0f, false, 0.0f);
+    verifier.onTelemetry(15000, false, true, 151.0f, false, 0.0f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_NONE, verifier.update(16000));
+    verifier.onTelemetry(17500, false, true, 151.5f, false, 0.0f);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_FINISHED, verifier.update(17500));
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_STOPPED, verifier.history(0).outcome);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.5f, verifier.history(0).stepMm[PAUSE_STEP_PAUSE]);
+    // Beginning a new verification cancelled the escalating one
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_CANCELLED, verifier.history(1).outcome);
+    TEST_ASSERT_EQUAL(2, verifier.history(1).steps);
+}
+
+void test_escalation_off_records_without_acting()
+{
+    PauseVerifier verifier;
+    verifier.setEscalation(PAUSE_STEP_PAUSE);
+    verifier.onTelemetry(0, false, true, 0.0f, false, 0.0f);
+    verifier.begin(5, 0);
+    pause_action_t action = PAUSE_ACTION_NONE;
+    feedFrames(verifier, 500, 20000, 0.0f, 1.0f, &action);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_FINISHED, action);
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_STILL_EXTRUDING, verifier.history(0).outcome);
+    TEST_ASSERT_EQUAL(1, verifier.history(0).steps);
+    TEST_ASSERT_EQUAL_UINT32(0, verifier.getStats().escalations[PAUSE_STEP_REPAUSE]);
+}
+
+void test_silence_and_cancel()
+{
+    PauseVerifier verifier;
+    verifier.begin(6, 0);
+    // No frame after the settle time: no verdict until the telemetry timeout
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_NONE,
+                      verifier.update(PauseVerifier::SETTLE_MS + PauseVerifier::WINDOW_MS + 1000));
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_FINISHED,
+                      verifier.update(PauseVerifier::SETTLE_MS + PauseVerifier::NO_TELEMETRY_MS));
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_NO_TELEMETRY, verifier.history(0).outcome);
+
+    verifier.begin(8, 100000);
+    verifier.cancel(101000);
+    TEST_ASSERT_FALSE(verifier.isActive());
+    TEST_ASSERT_EQUAL(PAUSE_OUTCOME_CANCELLED, verifier.history(0).outcome);
+    TEST_ASSERT_EQUAL(PAUSE_ACTION_NONE, verifier.update(200000));
+    verifier.cancel(200000);
+    TEST_ASSERT_EQUAL(2, verifier.historyCount());
+    TEST_ASSERT_EQUAL_UINT32(1, verifier.getStats().cancelled);
+}
+
+void test_history_keeps_the_most_recent()
+{
+    PauseVerifier verifier;
+    for (uint32_t i = 0; i < PauseVerifier::HISTORY_SIZE + 3; i++)
+    {
+        verifier.begin(i, i * 100000);
+        verifier.onTelemetry(i * 100000 + 5000, false, true, (float) i, false, 0.0f);
+        verifier.update(i * 100000 + 8000);
+    }
+    TEST_ASSERT_EQUAL(PauseVerifier::HISTORY_SIZE, verifier.historyCount());
+    TEST_ASSERT_EQUAL_UINT32(PauseVerifier::HISTORY_SIZE + 2, verifier.history(0).id);
+    TEST_ASSERT_EQUAL_UINT32(3, verifier.history(PauseVerifier::HISTORY_SIZE - 1).id);
+    TEST_ASSERT_EQUAL_UINT32(PauseVerifier::HISTORY_SIZE, verifier.summary().samples);
+    TEST_ASSERT_EQUAL_STRING("stop_feeding", PauseVerifier::stepName(PAUSE_STEP_STOP_FEEDING));
+    TEST_ASSERT_EQUAL_STRING("no_telemetry",
+                             PauseVerifier::outcomeName(PAUSE_OUTCOME_NO_TELEMETRY));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pause_that_takes_is_confirmed_with_its_overrun);
+    RUN_TEST(test_ignored_pause_escalates_through_every_step);
+    RUN_TEST(test_default_escalation_stops_after_repause);
+    RUN_TEST(test_sensor_movement_escalates_without_telemetry_growth);
+    RUN_TEST(test_sensor_movement_while_paused_is_ignored);
+    RUN_TEST(test_delta_only_telemetry_and_retractions);
+    RUN_TEST(test_escalation_off_records_without_acting);
+    RUN_TEST(test_silence_and_cancel);
+    RUN_TEST(test_history_keeps_the_most_recent);
+    return UNITY_END();
+}
@@ -0,0 +1,119 @@
+#include <unity.h>
+
+#include "../../src/PrinterClock.h"
+#include "../../src/PrinterClock.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static const int64_t PRINTER_EPOCH_MS = 1700000000000LL;
+
+// Printer stamps whole seconds; frames leave every second at phase
+// `phaseMs` within the second and take `delayMs` to arrive.
+static uint32_t feedFrame(PrinterClock &clock, int64_t sendMs, int32_t delayMs)
+{
+    int64_t  printerMs = PRINTER_EPOCH_MS + sendMs;
+    uint16_t quantum   = 0;
+    int64_t  stamped   = PrinterClock::timestampToMs((uint64_t) (printerMs / 1000), quantum);
+    return clock.addSample(sendMs + delayMs, stamped, quantum);
+}
+
+void test_timestamp_units_are_detected()
+{
+    uint16_t quantum = 0;
+    TEST_ASSERT_TRUE(PrinterClock::timestampToMs(1700000000ULL, quantum) == 1700000000000LL);
+    TEST_ASSERT_EQUAL_UINT32(1000, quantum);
+    TEST_ASSERT_TRUE(PrinterClock::timestampToMs(1700000000123ULL, quantum) == 1700000000123LL);
+    TEST_ASSERT_EQUAL_UINT32(1, quantum);
+}
+
+void test_queued_frame_shows_its_extra_delay()
+{
+    PrinterClock clock;
+    for (int i = 0; i < 60; i++)
+    {
+        feedFrame(clock, 5000 + i * 1000 + 200, 30);
+    }
+    TEST_ASSERT_TRUE(clock.isLocked());
+    TEST_ASSERT_EQUAL_UINT32(0, clock.getStats().lastAgeMs);
+
+    // Held in a queue for 2.5 s on top of the usual 30 ms
+    uint32_t age = feedFrame(clock, 65200, 2530);
+    TEST_ASSERT_EQUAL_UINT32(2500, age);
+    TEST_ASSERT_EQUAL_UINT32(1500, clock.staleAgeMs(age));
+    TEST_ASSERT_EQUAL_UINT32(0, clock.staleAgeMs(800));
+
+    // The next prompt frame is fresh again
+    TEST_ASSERT_EQUAL_UINT32(0, feedFrame(clock, 66200, 30));
+}
+
+void test_ages_are_zero_until_locked()
+{
+    PrinterClock clock;
+    TEST_ASSERT_EQUAL_UINT32(0, feedFrame(clock, 1200, 30));
+    TEST_ASSERT_EQUAL_UINT32(0, feedFrame(clock, 2200, 3000));
+    TEST_ASSERT_FALSE(clock.isLocked());
+    TEST_ASSERT_EQUAL_UINT32(0, clock.staleAgeMs(5000));
+}
+
+void test_skew_is_tracked_across_buckets()
+{
+    PrinterClock clock;
+    // Printer clock runs 200 ppm slow against ours, millisecond stamps
+    for (int i = 0; i < 240; i++)
+    {
+        int64_t localMs   = 1000 + i * 1000;
+        int64_t printerMs = PRINTER_EPOCH_MS + localMs - localMs / 5000 - 20;
+        clock.addSample(localMs, printerMs, 1);
+    }
+    PrinterClock::Stats stats = clock.getStats();
+    TEST_ASSERT_TRUE(stats.skewPpm >= -205 && stats.skewPpm <= -195);
+    TEST_ASSERT_TRUE(stats.lastAgeMs <= 1);
+    // Round trips bound the delay the floor leaves out
+    clock.addRoundTrip(60);
+    clock.addRoundTrip(44);
+    TEST_ASSERT_EQUAL_UINT32(44, clock.getStats().minRttMs);
+    int64_t printerNow = clock.printerTimeAt(241000);
+    int64_t expected   = PRINTER_EPOCH_MS + 241000 - 241000 / 5000;
+    TEST_ASSERT_TRUE(printerNow - expected <= 3 && expected - printerNow <= 3);
+}
+
+void test_printer_clock_step_restarts_estimate()
+{
+    PrinterClock clock;
+    for (int i = 0; i < 20; i++)
+    {
+        feedFrame(clock, i * 1000 + 100, 30);
+    }
+
+    // Printer re-syncs its clock one minute back: frames look 60 s old, but
+    // only a run of them is treated as a step rather than a stalled link.
+    for (uint32_t i = 0; i < PrinterClock::STEP_CONFIRM_SAMPLES - 1; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(0, feedFrame(clock, 20100 + i * 1000 - 60000, 60030));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, clock.getStats().resets);
+    feedFrame(clock, 24100 - 60000, 60030);
+    TEST_ASSERT_EQUAL_UINT32(1, clock.getStats().resets);
+    TEST_ASSERT_FALSE(clock.isLocked());
+
+    // Forward steps reset at once
+    for (int i = 0; i < 10; i++)
+    {
+        feedFrame(clock, i * 1000 + 100, 30);
+    }
+    TEST_ASSERT_TRUE(clock.isLocked());
+    feedFrame(clock, 200000, -170000 + 30);
+    TEST_ASSERT_EQUAL_UINT32(2, clock.getStats().resets);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_timestamp_units_are_detected);
+    RUN_TEST(test_queued_frame_shows_its_extra_delay);
+    RUN_TEST(test_ages_are_zero_until_locked);
+    RUN_TEST(test_skew_is_tracked_across_buckets);
+    RUN_TEST(test_printer_clock_step_restarts_estimate);
+    return UNITY_END();
+}
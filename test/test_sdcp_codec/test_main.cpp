@@ -0,0 +1,442 @@
+#include <string.h>
+#include <unity.h>
+
+#include "../../src/SdcpCodec.h"
+#include "../../src/SdcpCodec.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// A status frame from a Centauri Carbon mid-print.
+static const char STATUS_FRAME[] =
+    "{\"Status\":{\"CurrentStatus\":[1],\"PreviousStatus\":0,\"PrintScreen\":0,"
+    "\"ReleaseFilm\":0,\"TempOfUVLED\":0,\"TimeLapseStatus\":0,\"TempOfNozzle\":220.12,"
+    "\"TempTargetNozzle\":220,\"TempOfHotbed\":60.03,\"TempTargetHotbed\":60,"
+    "\"TempOfBox\":31.5,\"TempTargetBox\":0,\"CurrenCoord\":\"112.40,98.21,12.60\","
+    "\"CurrentFanSpeed\":{\"ModelFan\":100,\"ModeFan\":100,\"AuxiliaryFan\":0,"
+    "\"BoxFan\":0},\"ZOffset\":0.0,\"LightStatus\":{\"SecondLight\":1},"
+    "\"PrintInfo\":{\"Status\":13,\"CurrentLayer\":63,\"TotalLayer\":240,"
+    "\"CurrentTicks\":2710,\"TotalTicks\":9840,\"Filename\":\"benchy_pla.gcode\","
+    "\"TaskId\":\"5d1e2f0a9b7c4e21a3f6d8b0c2e4f6a8\",\"PrintSpeedPct\":100,"
+    "\"Progress\":27,\"TotalExtrusion\":1834.52,\"CurrentExtrusion\":1.47}},"
+    "\"MainboardID\":\"a1b2c3d4e5f60718\",\"TimeStamp\":1700000123,"
+    "\"Topic\":\"sdcp/status/a1b2c3d4e5f60718\"}";
+
+static sdcp_message_t message;
+static sdcp_message_t again;
+static char           buffer[2048];
+
+static bool decodeText(const char *text, sdcp_message_t &out)
+{
+    return SdcpCodec::decode(text, strlen(text), out);
+}
+
+void test_decodes_status_frame()
+{
+    TEST_ASSERT_TRUE(decodeText(STATUS_FRAME, message));
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_STATUS, message.kind);
+    TEST_ASSERT_EQUAL_STRING("a1b2c3d4e5f60718", message.mainboardId);
+    TEST_ASSERT_TRUE(message.hasTimeStamp);
+    TEST_ASSERT_EQUAL_DOUBLE(1700000123.0, message.timeStamp);
+
+    const sdcp_status_t &status = message.status;
+    TEST_ASSERT_TRUE(status.hasMachineStatuses);
+    TEST_ASSERT_EQUAL(1, status.machineStatusCount);
+    TEST_ASSERT_EQUAL(SDCP_MACHINE_STATUS_PRINTING, status.machineStatuses[0]);
+    TEST_ASSERT_TRUE(status.hasCoord);
+    TEST_ASSERT_EQUAL_FLOAT(12.60f, status.coord[2]);
+
+    const sdcp_print_info_t &info = status.printInfo;
+    TEST_ASSERT_TRUE(status.hasPrintInfo);
+    TEST_ASSERT_EQUAL(SDCP_PRINT_STATUS_PRINTING, info.status);
+    TEST_ASSERT_EQUAL(63, info.currentLayer);
+    TEST_ASSERT_EQUAL(240, info.totalLayer);
+    TEST_ASSERT_EQUAL(9840, info.totalTicks);
+    TEST_ASSERT_EQUAL(27, info.progress);
+    TEST_ASSERT_EQUAL_STRING("benchy_pla.gcode", info.filename);
+    TEST_ASSERT_TRUE(info.hasTotalExtrusion);
+    TEST_ASSERT_EQUAL_FLOAT(1834.52f, info.totalExtrusion);
+    TEST_ASSERT_TRUE(info.hasCurrentExtrusion);
+    TEST_ASSERT_EQUAL_FLOAT(1.47f, info.currentExtrusion);
+}
+
+void test_hex_keys_nulls_and_wrong_types()
+{
+    // Hex alias used when the plain key is missing or null; plain wins
+    TEST_ASSERT_TRUE(decodeText(
+        "{\"Status\":{\"PrintInfo\":{\"Status\":\"13\",\"TotalExtrusion\":null,"
+        "\"54 6F 74 61 6C 45 78 74 72 75 73 69 6F 6E 00\":42.5,"
+        "\"43 75 72 72 65 6E 74 45 78 74 72 75 73 69 6F 6E 00\":1.5,"
+        "\"CurrentExtrusion\":-0.25,\"CurrentLayer\":7.9,\"Filename\":7},"
+        "\"CurrenCoord\":\"1,2\"},\"TimeStamp\":1e999}",
+        message));
+    const sdcp_print_info_t &info = message.status.printInfo;
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_STATUS, message.kind);
+    TEST_ASSERT_EQUAL(0, info.status);  // a string is not a number
+    TEST_ASSERT_TRUE(info.hasTotalExtrusion);
+    TEST_ASSERT_EQUAL_FLOAT(42.5f, info.totalExtrusion);
+    TEST_ASSERT_EQUAL_FLOAT(-0.25f, info.currentExtrusion);
+    TEST_ASSERT_EQUAL(7, info.currentLayer);
+    TEST_ASSERT_EQUAL_STRING("", info.filename);
+    TEST_ASSERT_FALSE(message.status.hasMachineStatuses);
+    TEST_ASSERT_FALSE(message.status.hasCoord);
+    TEST_ASSERT_FALSE(message.hasTimeStamp);  // out of range reads as absent
+
+    // Plain key first, hex key later: still the plain value
+    TEST_ASSERT_TRUE(decodeText(
+        "{\"Status\":{\"PrintInfo\":{\"TotalExtrusion\":3,"
+        "\"54 6F 74 61 6C 45 78 74 72 75 73 69 6F 6E 00\":9}}}",
+        message));
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, message.status.printInfo.totalExtrusion);
+
+    // More than five machine statuses keeps the first five
+    TEST_ASSERT_TRUE(decodeText("{\"Status\":{\"CurrentStatus\":[0,1,2,3,4,1,2]}}", message));
+    TEST_ASSERT_EQUAL(SDCP_MAX_MACHINE_STATUSES, message.status.machineStatusCount);
+    TEST_ASSERT_EQUAL(4, message.status.machineStatuses[4]);
+}
+
+void test_ack_request_and_simulator_frames()
+{
+    TEST_ASSERT_TRUE(decodeText(
+        "{\"Id\":\"x\",\"Data\":{\"Cmd\":129,\"Data\":{\"Ack\":0},"
+        "\"RequestID\":\"0123456789abcdef0123456789abcdef\",\"MainboardID\":\"m1\","
+        "\"TimeStamp\":1700000200.5},\"Topic\":\"sdcp/response/m1\"}",
+        message));
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_ACK, message.kind);
+    TEST_ASSERT_EQUAL(SDCP_COMMAND_PAUSE_PRINT, message.ack.cmd);
+    TEST_ASSERT_EQUAL(0, message.ack.ack);
+    TEST_ASSERT_EQUAL_STRING("0123456789abcdef0123456789abcdef", message.ack.requestId);
+    TEST_ASSERT_EQUAL_STRING("m1", message.mainboardId);
+    TEST_ASSERT_EQUAL_DOUBLE(1700000200.5, message.timeStamp);
+
+    // What ElegooCC::sendCommand sent before the codec, byte for byte
+    static const char PAUSE[] =
+        "{\"Id\":\"abc\",\"Data\":{\"Cmd\":129,\"RequestID\":\"abc\",\"MainboardID\":\"m1\","
+        "\"TimeStamp\":1700000123,\"From\":0,\"Data\":{},\"PrintStatus\":13,"
+        "\"CurrentStatus\":[1]},\"Topic\":\"sdcp/request/m1\"}";
+    memset(&message, 0, sizeof(message));
+    message.kind                       = SDCP_MESSAGE_REQUEST;
+    message.hasTimeStamp               = true;
+    message.timeStamp                  = 1700000123;
+    message.request.cmd                = SDCP_COMMAND_PAUSE_PRINT;
+    message.request.printStatus        = SDCP_PRINT_STATUS_PRINTING;
+    message.request.machineStatusCount = 1;
+    message.request.machineStatuses[0] = SDCP_MACHINE_STATUS_PRINTING;
+    strcpy(message.request.requestId, "abc");
+    strcpy(message.mainboardId, "m1");
+    TEST_ASSERT_EQUAL(sizeof(PAUSE) - 1, SdcpCodec::encode(message, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_STRING(PAUSE, buffer);
+    TEST_ASSERT_TRUE(decodeText(PAUSE, again));
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_REQUEST, again.kind);
+    TEST_ASSERT_EQUAL_MEMORY(&message, &again, sizeof(message));
+
+    // Without a MainboardID there is no Topic; "From" still marks a request
+    message.mainboardId[0] = '\0';
+    TEST_ASSERT_TRUE(SdcpCodec::encode(message, buffer, sizeof(buffer)) > 0);
+    TEST_ASSERT_NULL(strstr(buffer, "Topic"));
+    TEST_ASSERT_TRUE(decodeText(buffer, again));
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_REQUEST, again.kind);
+
+    // tools/gcode_flow_sim.py frames
+    TEST_ASSERT_TRUE(decodeText(
+        "{\"Topic\": \"status/simulator\", \"Status\": {\"CurrentStatus\": [1], "
+        "\"PrintInfo\": {\"Status\": 13, \"CurrentLayer\": 3, \"TotalLayer\": 100, "
+        "\"CurrentExtrusion\": 0.412345, \"TotalExtrusion\": 12.5}}}",
+        message));
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_STATUS, message.kind);
+    TEST_ASSERT_EQUAL_FLOAT(0.412345f, message.status.printInfo.currentExtrusion);
+
+    // Id and Data without Cmd/RequestID is nothing we act on
+    TEST_ASSERT_TRUE(decodeText("{\"Id\":\"x\",\"Data\":{\"Foo\":1}}", message));
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_UNKNOWN, message.kind);
+    TEST_ASSERT_EQUAL(0, SdcpCodec::encode(message, buffer, sizeof(buffer)));
+}
+
+void test_strings_escape_and_truncate()
+{
+    memset(&message, 0, sizeof(message));
+    message.kind = SDCP_MESSAGE_ATTRIBUTES;
+    strcpy(message.attributes.name, "CC \"lab\"\\\n\x01 \xc3\xa9");
+    strcpy(message.mainboardId, "m1");
+    TEST_ASSERT_TRUE(SdcpCodec::encode(message, buffer, sizeof(buffer)) > 0);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"Name\":\"CC \\\"lab\\\"\\\\\\u000a\\u0001 \xc3\xa9\""));
+    TEST_ASSERT_TRUE(decodeText(buffer, again));
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_ATTRIBUTES, again.kind);
+    TEST_ASSERT_EQUAL_STRING(message.attributes.name, again.attributes.name);
+
+    // \u escapes, surrogate pairs, lone surrogates and NUL
+    TEST_ASSERT_TRUE(decodeText(
+        "{\"Attributes\":{\"Name\":\"\\u00e9\\ud83d\\ude00\\ud800x\\u0000\\/\"}}", message));
+    TEST_ASSERT_EQUAL_STRING("\xc3\xa9\xf0\x9f\x98\x80\xef\xbf\xbdx\xef\xbf\xbd/",
+                             message.attributes.name);
+
+    // A long filename is cut before a two-byte character that would not fit
+    char frame[1024];
+    char name[301];
+    for (int i = 0; i < 150; i++)
+    {
+        name[2 * i]     = (char) 0xc3;
+        name[2 * i + 1] = (char) 0xa9;
+    }
+    name[300] = '\0';
+    snprintf(frame, sizeof(frame), "{\"Status\":{\"PrintInfo\":{\"Filename\":\"%s\"}}}", name);
+    TEST_ASSERT_TRUE(decodeText(frame, message));
+    TEST_ASSERT_EQUAL(SDCP_FILENAME_LENGTH - 2, strlen(message.status.printInfo.filename));
+
+    // Output that does not fit writes nothing
+    TEST_ASSERT_TRUE(decodeText(STATUS_FRAME, message));
+    TEST_ASSERT_EQUAL(0, SdcpCodec::encode(message, buffer, 100));
+    TEST_ASSERT_EQUAL_STRING("", buffer);
+}
+
+void test_rejects_malformed_and_deep_input()
+{
+    static const char *const BAD[] = {
+        "",
+        "[]",
+        "{",
+        "{\"Status\":}",
+        "{\"Status\":{\"PrintInfo\":{\"Status\":01}}}",
+        "{\"a\":\"\\x\"}",
+        "{\"a\":\"\\u12g4\"}",
+        "{\"a\":1,}",
+        "{\"a\":-}",
+        "{\"a\":1.}",
+        "{\"a\":tru}",
+        "{\"a\" 1}",
+        "{\"a\":\"unterminated}",
+    };
+    for (const char *text : BAD)
+    {
+        message.kind = SDCP_MESSAGE_STATUS;
+        TEST_ASSERT_FALSE_MESSAGE(decodeText(text, message), text);
+        TEST_ASSERT_EQUAL(SDCP_MESSAGE_UNKNOWN, message.kind);
+    }
+    TEST_ASSERT_FALSE(SdcpCodec::decode(nullptr, 0, message));
+
+    // Deep nesting in a skipped value is refused, not recursed into
+    static char deep[20010];
+    size_t      length = 0;
+    length += (size_t) snprintf(deep, sizeof(deep), "{\"x\":");
+    for (int i = 0; i < 10000; i++)
+    {
+        deep[length++] = '[';
+    }
+    for (int i = 0; i < 10000; i++)
+    {
+        deep[length++] = ']';
+    }
+    deep[length++] = '}';
+    TEST_ASSERT_FALSE(SdcpCodec::decode(deep, length, message));
+
+    char shallow[64];
+    snprintf(shallow, sizeof(shallow), "{\"x\":[[[[{\"y\":[1,{}]}]]]],\"Status\":{}}");
+    TEST_ASSERT_TRUE(decodeText(shallow, message));
+    TEST_ASSERT_EQUAL(SDCP_MESSAGE_STATUS, message.kind);
+}
+
+static uint32_t rngState = 12345;
+static uint32_t rng()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static void randomText(char *out, size_t capacity)
+{
+    size_t length = rng() % capacity;
+    for (size_t i = 0; i < length; i++)
+    {
+        // Any byte but NUL: quotes, backslashes, controls and high bytes
+        out[i] = (char) (1 + rng() % 255);
+    }
+    out[length] = '\0';
+}
+
+static float randomFloat()
+{
+    switch (rng() % 4)
+    {
+        case 0:
+            return (float) (int32_t) rng() / 1000.0f;
+        case 1:
+            return (float) (rng() % 100000) / 100.0f;
+        case 2:
+        {
+            float    value;
+            uint32_t bits = rng();
+            memcpy(&value, &bits, sizeof(value));
+            return isfinite(value) ? value : 0.0f;
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+static void randomStatuses(int16_t *statuses, uint8_t &count)
+{
+    count = (uint8_t) (rng() % (SDCP_MAX_MACHINE_STATUSES + 1));
+    for (uint8_t i = 0; i < count; i++)
+    {
+        statuses[i] = (int16_t) (rng() % 5);
+    }
+}
+
+static void randomMessage(sdcp_message_t &out)
+{
+    memset(&out, 0, sizeof(out));
+    out.kind         = (uint8_t) (1 + rng() % 4);
+    out.hasTimeStamp = rng() & 1;
+    if (out.hasTimeStamp)
+    {
+        out.timeStamp = (double) rng() + (double) (rng() % 1000) / 1000.0;
+    }
+    randomText(out.mainboardId, sizeof(out.mainboardId));
+
+    switch (out.kind)
+    {
+        case SDCP_MESSAGE_STATUS:
+        {
+            sdcp_status_t &status     = out.status;
+            status.hasMachineStatuses = rng() & 1;
+            if (status.hasMachineStatuses)
+            {
+                randomStatuses(status.machineStatuses, status.machineStatusCount);
+            }
+            status.hasCoord = rng() & 1;
+            if (status.hasCoord)
+            {
+                for (float &axis : status.coord)
+                {
+                    axis = randomFloat();
+                }
+            }
+            status.hasPrintInfo = rng() & 1;
+            if (status.hasPrintInfo)
+            {
+                sdcp_print_info_t &info = status.printInfo;
+                info.status             = (int16_t) rng();
+                info.currentLayer       = (int32_t) rng();
+                info.totalLayer         = (int32_t) rng();
+                info.currentTicks       = (int32_t) rng();
+                info.totalTicks         = (int32_t) rng();
+                info.progress           = (int32_t) (rng() % 101);
+                info.printSpeedPct      = (int32_t) (rng() % 200);
+                info.hasTotalExtrusion  = rng() & 1;
+                info.totalExtrusion     = info.hasTotalExtrusion ? randomFloat() : 0.0f;
+                info.hasCurrentExtrusion = rng() & 1;
+                info.currentExtrusion    = info.hasCurrentExtrusion ? randomFloat() : 0.0f;
+                randomText(info.filename, sizeof(info.filename));
+                randomText(info.taskId, sizeof(info.taskId));
+            }
+            break;
+        }
+        case SDCP_MESSAGE_ATTRIBUTES:
+            randomText(out.attributes.name, sizeof(out.attributes.name));
+            randomText(out.attributes.machineName, sizeof(out.attributes.machineName));
+            randomText(out.attributes.brandName, sizeof(out.attributes.brandName));
+            randomText(out.attributes.protocolVersion, sizeof(out.attributes.protocolVersion));
+            randomText(out.attributes.firmwareVersion, sizeof(out.attributes.firmwareVersion));
+            randomText(out.attributes.mainboardIp, sizeof(out.attributes.mainboardIp));
+            break;
+        case SDCP_MESSAGE_REQUEST:
+            out.request.cmd         = (int32_t) rng();
+            out.request.from        = (int32_t) (rng() % 3);
+            out.request.printStatus = (int16_t) rng();
+            randomText(out.request.requestId, sizeof(out.request.requestId));
+            randomStatuses(out.request.machineStatuses, out.request.machineStatusCount);
+            break;
+        default:
+            out.ack.cmd = (int32_t) rng();
+            out.ack.ack = (int32_t) rng();
+            randomText(out.ack.requestId, sizeof(out.ack.requestId));
+            break;
+    }
+}
+
+void test_round_trip_fuzz()
+{
+    for (int i = 0; i < 20000; i++)
+    {
+        randomMessage(message);
+        size_t length = SdcpCodec::encode(message, buffer, sizeof(buffer));
+        TEST_ASSERT_TRUE(length > 0);
+        TEST_ASSERT_EQUAL(strlen(buffer), length);
+        TEST_ASSERT_TRUE_MESSAGE(SdcpCodec::decode(buffer, length, again), buffer);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&message, &again, sizeof(message), buffer);
+    }
+}
+
+// Mutated frames must never read out of bounds (run under ASan), and
+// whatever decodes must encode and decode back to the same message.
+void test_mutation_fuzz()
+{
+    static const char ALPHABET[] = "{}[]\":,\\-0123456789.eEtfnulrsaxu \xc3\xa9";
+    static char       mutated[2048];
+    size_t            accepted = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        randomMessage(message);
+        size_t length = SdcpCodec::encode(message, mutated, sizeof(mutated) - 64);
+        if (i % 4 == 0)
+        {
+            length = strlen(STATUS_FRAME);
+            memcpy(mutated, STATUS_FRAME, length);
+        }
+
+        int edits = 1 + (int) (rng() % 4);
+        for (int e = 0; e < edits && length > 0; e++)
+        {
+            size_t at = rng() % length;
+            switch (rng() % 4)
+            {
+                case 0:
+                    mutated[at] = ALPHABET[rng() % (sizeof(ALPHABET) - 1)];
+                    break;
+                case 1:
+                    length = at;  // truncate
+                    break;
+                case 2:
+                    memmove(mutated + at, mutated + at + 1, length - at - 1);
+                    length--;
+                    break;
+                default:
+                    memmove(mutated + at + 1, mutated + at, length - at);
+                    mutated[at] = ALPHABET[rng() % (sizeof(ALPHABET) - 1)];
+                    length++;
+                    break;
+            }
+        }
+
+        // Exactly `length` bytes, no terminator to lean on
+        char *exact = new char[length > 0 ? length : 1];
+        memcpy(exact, mutated, length);
+        bool ok = SdcpCodec::decode(exact, length, message);
+        delete[] exact;
+        if (!ok || message.kind == SDCP_MESSAGE_UNKNOWN)
+        {
+            continue;
+        }
+        accepted++;
+        size_t encoded = SdcpCodec::encode(message, buffer, sizeof(buffer));
+        TEST_ASSERT_TRUE(encoded > 0);
+        TEST_ASSERT_TRUE(SdcpCodec::decode(buffer, encoded, again));
+        TEST_ASSERT_EQUAL_MEMORY(&message, &again, sizeof(message));
+    }
+    TEST_ASSERT_TRUE(accepted > 100);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decodes_status_frame);
+    RUN_TEST(test_hex_keys_nulls_and_wrong_types);
+    RUN_TEST(test_ack_request_and_simulator_frames);
+    RUN_TEST(test_strings_escape_and_truncate);
+    RUN_TEST(test_rejects_malformed_and_deep_input);
+    RUN_TEST(test_round_trip_fuzz);
+    RUN_TEST(test_mutation_fuzz);
+    return UNITY_END();
+}
@@ -0,0 +1,75 @@
+#include <unity.h>
+
+#include "../../src/TimeService.h"
+#include "../../src/TimeService.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static uint64_t fakeNowUs = 0;
+
+static uint64_t fakeClock()
+{
+    return fakeNowUs;
+}
+
+void test_monotonic_clock_is_64_bit()
+{
+    TimeService time(fakeClock);
+    fakeNowUs = 5000000000ULL;  // past the 32-bit micros() wrap at ~71 minutes
+    TEST_ASSERT_TRUE(time.nowUs() == 5000000000ULL);
+}
+
+void test_epoch_unknown_until_synced()
+{
+    TimeService time(fakeClock);
+    TEST_ASSERT_FALSE(time.hasEpoch());
+    TEST_ASSERT_TRUE(time.toEpochUs(123) == 0);
+    TEST_ASSERT_EQUAL_UINT32(0, time.toEpochSeconds(123));
+    uint64_t monotonic = 7;
+    TEST_ASSERT_FALSE(time.toMonotonicUs(1700000000000000ULL, monotonic));
+    TEST_ASSERT_TRUE(monotonic == 7);
+}
+
+void test_history_maps_through_latest_offset()
+{
+    TimeService time(fakeClock);
+    uint64_t    loggedAt = 2000000;  // logged 2 s after boot, before NTP
+
+    // NTP says it is 1700000000.5 s at 10 s after boot
+    time.setEpoch(1700000000500000ULL, 10000000);
+    TEST_ASSERT_TRUE(time.hasEpoch());
+    TEST_ASSERT_TRUE(time.toEpochUs(loggedAt) == 1699999992500000ULL);
+    TEST_ASSERT_EQUAL_UINT32(1699999992, time.toEpochSeconds(loggedAt));
+    TEST_ASSERT_TRUE(time.getLastStepUs() == 0);
+    uint64_t monotonic = 0;
+    TEST_ASSERT_TRUE(time.toMonotonicUs(1699999992500000ULL, monotonic));
+    TEST_ASSERT_TRUE(monotonic == loggedAt);
+    TEST_ASSERT_TRUE(time.toMonotonicUs(1600000000000000ULL, monotonic));
+    TEST_ASSERT_TRUE(monotonic == 0);
+
+    // A later sync finds the local clock 3 ms slow; the same stored
+    // timestamp now exports 3 ms later.
+    time.setEpoch(1700003600503000ULL, 3610000000ULL);
+    TEST_ASSERT_TRUE(time.toEpochUs(loggedAt) == 1699999992503000ULL);
+    TEST_ASSERT_TRUE(time.getLastStepUs() == 3000);
+    TEST_ASSERT_EQUAL_UINT32(2, time.getSyncCount());
+}
+
+void test_default_clock_is_monotonic()
+{
+    TimeService time;
+    uint64_t    first  = time.nowUs();
+    uint64_t    second = time.nowUs();
+    TEST_ASSERT_TRUE(second >= first);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_monotonic_clock_is_64_bit);
+    RUN_TEST(test_epoch_unknown_until_synced);
+    RUN_TEST(test_history_maps_through_latest_offset);
+    RUN_TEST(test_default_clock_is_monotonic);
+    return UNITY_END();
+}
@@ -0,0 +1,90 @@
+#include <unity.h>
+
+#include "../../src/WifiCache.h"
+#include "../../src/WifiCache.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static wifi_cache_t makeCache(uint32_t hash)
+{
+    wifi_cache_t cache   = {};
+    cache.version        = WIFI_CACHE_VERSION;
+    cache.credentialHash = hash;
+    cache.bssid[0]       = 0x24;
+    cache.bssid[5]       = 0x7c;
+    cache.channel        = 6;
+    return cache;
+}
+
+void test_credential_hash_separates_fields()
+{
+    uint32_t hash = wifiCredentialHash("shop", "secret");
+    TEST_ASSERT_TRUE(hash != 0);
+    TEST_ASSERT_EQUAL_UINT32(hash, wifiCredentialHash("shop", "secret"));
+    TEST_ASSERT_TRUE(hash != wifiCredentialHash("shop", "secret2"));
+    TEST_ASSERT_TRUE(wifiCredentialHash("ab", "c") != wifiCredentialHash("a", "bc"));
+}
+
+void test_cache_only_applies_to_its_credentials()
+{
+    uint32_t     hash  = wifiCredentialHash("shop", "secret");
+    wifi_cache_t cache = makeCache(hash);
+    TEST_ASSERT_TRUE(wifiCacheUsable(cache, hash));
+    TEST_ASSERT_FALSE(wifiCacheUsable(cache, wifiCredentialHash("shop", "other")));
+
+    wifi_cache_t stale = cache;
+    stale.version      = WIFI_CACHE_VERSION + 1;
+    TEST_ASSERT_FALSE(wifiCacheUsable(stale, hash));
+
+    wifi_cache_t noChannel = cache;
+    noChannel.channel      = 0;
+    TEST_ASSERT_FALSE(wifiCacheUsable(noChannel, hash));
+
+    wifi_cache_t noBssid = cache;
+    memset(noBssid.bssid, 0, sizeof(noBssid.bssid));
+    TEST_ASSERT_FALSE(wifiCacheUsable(noBssid, hash));
+
+    TEST_ASSERT_FALSE(wifiCacheHasLease(cache));
+    cache.ip      = 0x3201A8C0;
+    cache.gateway = 0x0101A8C0;
+    cache.subnet  = 0x00FFFFFF;
+    TEST_ASSERT_TRUE(wifiCacheHasLease(cache));
+}
+
+void test_history_keeps_newest_and_per_path_stats()
+{
+    WifiConnectHistory history;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        wifi_connect_record_t record = {};
+        record.path                  = (i % 2) ? WIFI_PATH_FAST : WIFI_PATH_FULL;
+        record.success               = i != 3;
+        record.totalMs               = (i % 2) ? 400 + i : 2500 + i;
+        history.add(record);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(WifiConnectHistory::HISTORY_SIZE, history.count());
+    TEST_ASSERT_EQUAL_UINT32(409, history.get(0).totalMs);
+    TEST_ASSERT_EQUAL_UINT32(2508, history.get(1).totalMs);
+
+    WifiConnectHistory::PathStats fast = history.pathStats(WIFI_PATH_FAST);
+    TEST_ASSERT_EQUAL_UINT32(5, fast.attempts);
+    TEST_ASSERT_EQUAL_UINT32(1, fast.failures);
+    TEST_ASSERT_EQUAL_UINT32(409, fast.lastMs);
+    TEST_ASSERT_EQUAL_UINT32(401, fast.bestMs);
+
+    WifiConnectHistory::PathStats full = history.pathStats(WIFI_PATH_FULL);
+    TEST_ASSERT_EQUAL_UINT32(5, full.attempts);
+    TEST_ASSERT_EQUAL_UINT32(2500, full.bestMs);
+    TEST_ASSERT_EQUAL_UINT32(0, history.pathStats(WIFI_PATH_AUTO).attempts);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_credential_hash_separates_fields);
+    RUN_TEST(test_cache_only_applies_to_its_credentials);
+    RUN_TEST(test_history_keeps_newest_and_per_path_stats);
+    return UNITY_END();
+}
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Compare two native benchmark runs and flag regressions.
+
+Both files are the JSON written by the native_bench program
+(`.pio/build/native_bench/program --json run.json`). Benchmarks are matched
+by name and compared on median ns/op; p90 is shown for context.
+
+Usage:
+    python tools/bench_compare.py baseline.json candidate.json [--threshold 10]
+
+Exits 1 when any benchmark's median is more than --threshold percent slower
+than the baseline, so it can gate a CI job. Benchmarks present in only one
+file are listed but never fail the comparison.
+"""
+
+import argparse
+import json
+import sys
+
+SCHEMA = 1
+
+
+def load(path):
+    with open(path, encoding="utf-8") as handle:
+        data = json.load(handle)
+    if data.get("schema") != SCHEMA:
+        sys.exit(f"{path}: unsupported schema {data.get('schema')!r}, expected {SCHEMA}")
+    return {result["name"]: result for result in data["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="JSON from the reference run")
+    parser.add_argument("candidate", help="JSON from the run under test")
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=10.0,
+        help="allowed median slowdown in percent (default 10)",
+    )
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    candidate = load(args.candidate)
+
+    regressions = 0
+    print(f"{'benchmark':<34} {'base p50':>10} {'new p50':>10} {'change':>8} {'new p90':>10}")
+    for name in sorted(set(baseline) | set(candidate)):
+        if name not in baseline or name not in candidate:
+            where = "baseline" if name in baseline else "candidate"
+            print(f"{name:<34} only in {where}")
+            continue
+        old = baseline[name]["ns_per_op"]
+        new = candidate[name]["ns_per_op"]
+        change = (new["p50"] - old["p50"]) / old["p50"] * 100.0 if old["p50"] > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(
+            f"{name:<34} {old['p50']:>10.1f} {new['p50']:>10.1f} {change:>+7.1f}% "
+            f"{new['p90']:>10.1f}{flag}"
+        )
+
+    if regressions:
+        print(f"\n{regressions} benchmark(s) slower than baseline by more than {args.threshold}%")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,497 @@
+// Host replay of detector traces with a keyframe index.
+//
+//   pio run -e native_replay
+//   .pio/build/native_replay/program pack trace.txt trace.bin --config 8.4:1500:1.5
+//   .pio/build/native_replay/program run trace.bin --from 18000000 --to 18600000
+//
+// Text traces (e.g. from tools/gcode_flow_sim.py --output trace) hold one
+// detector input per line:
+//
+//   <ms> T <total|-> <delta|->   SDCP TotalExtrusion / CurrentExtrusion
+//   <ms> P                       movement sensor pulse
+//   <ms> E                       detection loop pass
+//   <ms> R                       new print
+//   <ms> S <expected>            resume after a jam pause
+//   <ms> F <json>                raw SDCP websocket frame, decoded with the
+//                                firmware's SdcpCodec; a status frame's
+//                                PrintInfo becomes a T record, anything
+//                                else is skipped
+//
+// `pack` replays the trace once and writes the records, a keyframe every
+// --keyframe-ms of trace time, and the detector state at each keyframe.
+// `run` seeks to --from through the index, optionally retunes
+// configurations there (--retune I=T:H:MM), and reports what each
+// configuration does up to --to.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "../../src/BatchDetector.h"
+#include "../../src/FlowReplay.h"
+#include "../../src/SdcpCodec.h"
+
+static const uint32_t TRACE_FILE_MAGIC   = 0x31525446;  // "FTR1"
+static const uint32_t TRACE_FILE_VERSION = 1;
+
+struct TraceFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t keyframeCount;
+    uint32_t stateBytes;
+    uint32_t intervalMs;
+};
+
+struct Trace
+{
+    std::vector<trace_record_t>   records;
+    std::vector<trace_keyframe_t> keyframes;
+    std::vector<uint8_t>          states;
+    uint32_t                      intervalMs = 0;
+};
+
+static int usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s pack <trace.txt> <out.bin> [--mode tracker|delta|total]\n"
+            "          [--config THRESHOLD_MM:HOLD_MS:MM_PER_PULSE]... [--keyframe-ms N]\n"
+            "       %s run <trace.bin> [--from MS] [--to MS] [--retune I=T:H:MM]...\n",
+            program, program);
+    return 2;
+}
+
+static bool parseConfig(const char *text, float &threshold, uint32_t &holdMs, float &mmPerPulse)
+{
+    unsigned long hold = 0;
+    if (sscanf(text, "%f:%lu:%f", &threshold, &hold, &mmPerPulse) != 3)
+    {
+        return false;
+    }
+    holdMs = (uint32_t) hold;
+    return true;
+}
+
+static bool readText(const char *path, std::vector<trace_record_t> &records)
+{
+    FILE *in = fopen(path, "r");
+    if (in == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+
+    static char    line[4096];  // room for a full status frame
+    sdcp_message_t message;
+    size_t         lineNumber = 0;
+    while (fgets(line, sizeof(line), in) != nullptr)
+    {
+        lineNumber++;
+        if (strchr(line, '\n') == nullptr && !feof(in))
+        {
+            fprintf(stderr, "%s:%zu: line too long\n", path, lineNumber);
+            fclose(in);
+            return false;
+        }
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+        {
+            continue;
+        }
+
+        unsigned long  timeMs = 0;
+        char           kind   = 0;
+        char           first[32];
+        char           second[32];
+        trace_record_t record = {};
+        int            fields = sscanf(line, "%lu %c %31s %31s", &timeMs, &kind, first, second);
+        if (fields < 2)
+        {
+            fprintf(stderr, "%s:%zu: expected '<ms> <kind> ...'\n", path, lineNumber);
+            fclose(in);
+            return false;
+        }
+        record.timeMs = (uint32_t) timeMs;
+
+        switch (kind)
+        {
+            case 'T':
+                if (fields < 4)
+                {
+                    fprintf(stderr, "%s:%zu: T needs <total> <delta>\n", path, lineNumber);
+                    fclose(in);
+                    return false;
+                }
+                record.kind = TRACE_TELEMETRY;
+                if (strcmp(first, "-") != 0)
+                {
+                    record.flags |= TRACE_HAS_TOTAL;
+                    record.a = strtof(first, nullptr);
+                }
+                if (strcmp(second, "-") != 0)
+                {
+                    record.flags |= TRACE_HAS_DELTA;
+                    record.b = strtof(second, nullptr);
+                }
+                break;
+            case 'F':
+            {
+                int json = 0;
+                sscanf(line, "%lu %c %n", &timeMs, &kind, &json);
+                if (json == 0 || !SdcpCodec::decode(line + json, strlen(line + json), message))
+                {
+                    fprintf(stderr, "%s:%zu: F needs an SDCP JSON frame\n", path, lineNumber);
+                    fclose(in);
+                    return false;
+                }
+                if (message.kind != SDCP_MESSAGE_STATUS || !message.status.hasPrintInfo)
+                {
+                    continue;
+                }
+                const sdcp_print_info_t &info = message.status.printInfo;
+                record.kind                   = TRACE_TELEMETRY;
+                if (info.hasTotalExtrusion)
+                {
+                    record.flags |= TRACE_HAS_TOTAL;
+                    record.a = info.totalExtrusion;
+                }
+                if (info.hasCurrentExtrusion)
+                {
+                    record.flags |= TRACE_HAS_DELTA;
+                    record.b = info.currentExtrusion;
+                }
+                break;
+            }
+            case 'P':
+                record.kind = TRACE_PULSE;
+                break;
+            case 'E':
+                record.kind = TRACE_EVALUATE;
+                break;
+            case 'R':
+                record.kind = TRACE_RESET;
+                break;
+            case 'S':
+                record.kind = TRACE_RESUME;
+                record.a    = fields >= 3 ? strtof(first, nullptr) : 0.0f;
+                break;
+            default:
+                fprintf(stderr, "%s:%zu: unknown kind '%c'\n", path, lineNumber, kind);
+                fclose(in);
+                return false;
+        }
+
+        if (!records.empty() && record.timeMs < records.back().timeMs)
+        {
+            fprintf(stderr, "%s:%zu: time goes backwards\n", path, lineNumber);
+            fclose(in);
+            return false;
+        }
+        records.push_back(record);
+    }
+    fclose(in);
+    return true;
+}
+
+static bool writeTrace(const char *path, const Trace &trace)
+{
+    FILE *out = fopen(path, "wb");
+    if (out == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+    TraceFileHeader header = {TRACE_FILE_MAGIC,
+                              TRACE_FILE_VERSION,
+                              (uint32_t) trace.records.size(),
+                              (uint32_t) trace.keyframes.size(),
+                              (uint32_t) trace.states.size(),
+                              trace.intervalMs};
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(trace.records.data(), sizeof(trace_record_t), trace.records.size(), out) ==
+                  trace.records.size() &&
+              fwrite(trace.keyframes.data(), sizeof(trace_keyframe_t), trace.keyframes.size(),
+                     out) == trace.keyframes.size() &&
+              fwrite(trace.states.data(), 1, trace.states.size(), out) == trace.states.size();
+    ok = fclose(out) == 0 && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "%s: write failed\n", path);
+    }
+    return ok;
+}
+
+static bool readTrace(const char *path, Trace &trace)
+{
+    FILE *in = fopen(path, "rb");
+    if (in == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+    TraceFileHeader header;
+    bool            ok = fread(&header, sizeof(header), 1, in) == 1 &&
+              header.magic == TRACE_FILE_MAGIC && header.version == TRACE_FILE_VERSION;
+    if (ok)
+    {
+        trace.records.resize(header.recordCount);
+        trace.keyframes.resize(header.keyframeCount);
+        trace.states.resize(header.stateBytes);
+        trace.intervalMs = header.intervalMs;
+        ok = fread(trace.records.data(), sizeof(trace_record_t), header.recordCount, in) ==
+                 header.recordCount &&
+             fread(trace.keyframes.data(), sizeof(trace_keyframe_t), header.keyframeCount, in) ==
+                 header.keyframeCount &&
+             fread(trace.states.data(), 1, header.stateBytes, in) == header.stateBytes;
+    }
+    fclose(in);
+    if (!ok)
+    {
+        fprintf(stderr, "%s: not a flow trace (or truncated)\n", path);
+        return false;
+    }
+    for (size_t i = 0; i < trace.keyframes.size(); i++)
+    {
+        const trace_keyframe_t &keyframe = trace.keyframes[i];
+        if (keyframe.recordIndex > trace.records.size() ||
+            (uint64_t) keyframe.stateOffset + keyframe.stateSize > trace.states.size())
+        {
+            fprintf(stderr, "%s: keyframe %zu out of range\n", path, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static int pack(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        return usage(argv[0]);
+    }
+    const char   *inPath     = argv[2];
+    const char   *outPath    = argv[3];
+    batch_mode_t  mode       = BATCH_MODE_TRACKER;
+    uint32_t      intervalMs = 60000;
+    BatchDetector detector;
+
+    for (int i = 4; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+            if (strcmp(name, "tracker") == 0)
+            {
+                mode = BATCH_MODE_TRACKER;
+            }
+            else if (strcmp(name, "delta") == 0)
+            {
+                mode = BATCH_MODE_DELTA;
+            }
+            else if (strcmp(name, "total") == 0)
+            {
+                mode = BATCH_MODE_TOTAL;
+            }
+            else
+            {
+                return usage(argv[0]);
+            }
+        }
+        else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc)
+        {
+            float    threshold, mmPerPulse;
+            uint32_t holdMs;
+            if (!parseConfig(argv[++i], threshold, holdMs, mmPerPulse) ||
+                detector.addConfig(threshold, holdMs, mmPerPulse) < 0)
+            {
+                fprintf(stderr, "bad or too many --config (max %zu)\n",
+                        BatchDetector::MAX_CONFIGS);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--keyframe-ms") == 0 && i + 1 < argc)
+        {
+            intervalMs = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (detector.count() == 0)
+    {
+        // Firmware defaults
+        detector.addConfig(8.4f, 1500, 1.5f);
+    }
+    // setMode() only resets on a change; the state must start clean either way
+    detector.setMode(mode);
+    detector.reset();
+
+    Trace trace;
+    if (!readText(inPath, trace.records))
+    {
+        return 1;
+    }
+    trace.intervalMs = intervalMs;
+
+    // At most one keyframe per interval; each at most MAX_STATE_SIZE bytes
+    uint32_t span = trace.records.empty() ? 0
+                                          : trace.records.back().timeMs -
+                                                trace.records.front().timeMs;
+    size_t maxKeyframes = intervalMs == 0 ? 0 : span / intervalMs + 1;
+    trace.keyframes.resize(maxKeyframes);
+    trace.states.resize(maxKeyframes * BatchDetector::MAX_STATE_SIZE);
+
+    FlowReplay replay(detector);
+    replay.attach(trace.records.data(), trace.records.size());
+    replay.attachIndex(trace.keyframes.data(), trace.keyframes.size(), trace.states.data(),
+                       trace.states.size());
+    replay.buildIndex(intervalMs);
+    trace.keyframes.resize(replay.keyframeCount());
+    trace.states.resize(replay.stateBytes());
+
+    if (!writeTrace(outPath, trace))
+    {
+        return 1;
+    }
+    fprintf(stderr, "%zu records, %zu keyframes (%zu bytes of state), %zu configurations\n",
+            trace.records.size(), trace.keyframes.size(), trace.states.size(), detector.count());
+    return 0;
+}
+
+static int run(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        return usage(argv[0]);
+    }
+    uint32_t         fromMs = 0;
+    uint32_t         toMs   = UINT32_MAX;
+    std::vector<int> retuneIndex;
+    std::vector<float>    retuneThreshold, retuneMmPerPulse;
+    std::vector<uint32_t> retuneHold;
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--from") == 0 && i + 1 < argc)
+        {
+            fromMs = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc)
+        {
+            toMs = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--retune") == 0 && i + 1 < argc)
+        {
+            const char *text  = argv[++i];
+            const char *equal = strchr(text, '=');
+            float       threshold, mmPerPulse;
+            uint32_t    holdMs;
+            if (equal == nullptr || !parseConfig(equal + 1, threshold, holdMs, mmPerPulse))
+            {
+                return usage(argv[0]);
+            }
+            retuneIndex.push_back(atoi(text));
+            retuneThreshold.push_back(threshold);
+            retuneHold.push_back(holdMs);
+            retuneMmPerPulse.push_back(mmPerPulse);
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    Trace trace;
+    if (!readTrace(argv[2], trace))
+    {
+        return 1;
+    }
+
+    // The start state is the one pack used: the first keyframe's
+    // configurations with everything else cleared
+    BatchDetector detector;
+    if (!trace.keyframes.empty())
+    {
+        detector.loadState(trace.states.data() + trace.keyframes[0].stateOffset,
+                           trace.keyframes[0].stateSize);
+        detector.reset();
+    }
+    else
+    {
+        fprintf(stderr, "trace has no keyframes; replaying from the start\n");
+        detector.addConfig(8.4f, 1500, 1.5f);
+    }
+
+    FlowReplay replay(detector);
+    replay.attach(trace.records.data(), trace.records.size());
+    replay.attachIndex(trace.keyframes.data(), trace.keyframes.size(), trace.states.data(),
+                       trace.states.size());
+    replay.setIndex(trace.keyframes.size(), trace.states.size());
+    if (!replay.seek(fromMs))
+    {
+        fprintf(stderr, "seek to %u ms failed\n", (unsigned) fromMs);
+        return 1;
+    }
+    fprintf(stderr, "seek to %u ms replayed %zu of %zu records\n", (unsigned) fromMs,
+            replay.lastSeekReplayed(), replay.position());
+
+    for (size_t i = 0; i < retuneIndex.size(); i++)
+    {
+        if (!detector.setConfig((size_t) retuneIndex[i], retuneThreshold[i], retuneHold[i],
+                                retuneMmPerPulse[i]))
+        {
+            fprintf(stderr, "no configuration %d to retune\n", retuneIndex[i]);
+            return 2;
+        }
+    }
+
+    // Step one record at a time to report every pause decision in the window
+    std::vector<uint8_t> wasSatisfied(detector.count(), 0);
+    for (size_t i = 0; i < detector.count(); i++)
+    {
+        wasSatisfied[i] = detector.satisfied(i) ? 1 : 0;
+    }
+    while (replay.position() < replay.recordCount())
+    {
+        const trace_record_t &record = trace.records[replay.position()];
+        if (record.timeMs > toMs)
+        {
+            break;
+        }
+        replay.runUntil(record.timeMs);
+        for (size_t i = 0; i < detector.count(); i++)
+        {
+            bool satisfied = detector.satisfied(i);
+            if (satisfied && !wasSatisfied[i])
+            {
+                printf("%u ms: config %zu would pause (deficit %.2f mm)\n",
+                       (unsigned) record.timeMs, i, detector.deficitMm(i));
+            }
+            wasSatisfied[i] = satisfied ? 1 : 0;
+        }
+    }
+
+    for (size_t i = 0; i < detector.count(); i++)
+    {
+        printf("config %zu (%.2f mm, %u ms, first pause %u ms): deficit %.2f mm\n", i,
+               detector.thresholdMm(i), (unsigned) detector.holdWindowMs(i),
+               (unsigned) detector.firstSatisfiedMs(i), detector.deficitMm(i));
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "pack") == 0)
+    {
+        return pack(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "run") == 0)
+    {
+        return run(argc, argv);
+    }
+    return usage(argv[0]);
+}
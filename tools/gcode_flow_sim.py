@@ -110,6 +110,26 @@ def format_json(samples: Iterable[Tuple[int, float, float]]) -> str:
     )
 
 
+def format_trace(
+    samples: Iterable[Tuple[int, float, float]],
+    mm_per_pulse: float,
+    jam_at_ms: int | None,
+) -> str:
+    """Detector inputs for tools/flow_replay: telemetry, the pulses a healthy
+    sensor would give for it (none from --jam-at-ms on) and a loop pass."""
+    lines = ["# <ms> T <total> <delta> | P | E; see tools/flow_replay/main.cpp"]
+    moved = 0.0
+    for ts, delta, total in samples:
+        lines.append(f"{ts} T {total:.4f} {delta:.4f}")
+        if jam_at_ms is None or ts < jam_at_ms:
+            moved += max(delta, 0.0)
+            while moved >= mm_per_pulse:
+                moved -= mm_per_pulse
+                lines.append(f"{ts} P")
+        lines.append(f"{ts} E")
+    return "\n".join(lines)
+
+
 def build_arg_parser() -> argparse.ArgumentParser:
     parser = argparse.ArgumentParser(
         description="Convert a G-code file into synthetic extrusion samples "
@@ -132,10 +152,22 @@ def build_arg_parser() -> argparse.ArgumentParser:
     )
     parser.add_argument(
         "--output",
-        choices=("table", "json"),
+        choices=("table", "json", "trace"),
         default="table",
         help="Output format (default: table)",
     )
+    parser.add_argument(
+        "--mm-per-pulse",
+        type=float,
+        default=1.5,
+        help="Filament per movement sensor pulse for --output trace (default: 1.5)",
+    )
+    parser.add_argument(
+        "--jam-at-ms",
+        type=int,
+        default=None,
+        help="Stop emitting sensor pulses from this time on in --output trace",
+    )
     parser.add_argument(
         "--serve",
         action="store_true",
@@ -282,6 +314,9 @@ def main() -> None:
         if not samples:
             raise SystemExit("No extrusion moves found in the provided G-code.")
         asyncio.run(serve_samples(samples, args.host, args.port, args.repeat, args.speed))
+    elif args.output == "trace":
+        print(format_trace(samples, args.mm_per_pulse, args.jam_at_ms))
+        print(f"# Generated {len(samples)} samples.", flush=True)
     else:
         formatter = format_table if args.output == "table" else format_json
         print(formatter(samples))
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""Receive syslog datagrams from one or more SFS devices and print them.
+
+The firmware packs several RFC 5424 messages per UDP datagram, separated by
+newlines. This listener splits them back out, decodes the priority and
+prints one line per message, prefixed with the sender address.
+
+Usage:
+    python tools/syslog_listener.py [--port 5514] [--bind 0.0.0.0] [--raw]
+
+Point the device at it with the "Remote Syslog Server" setting (host = this
+machine, port = --port). Port 514 needs root on most systems, hence the
+5514 default.
+"""
+
+import argparse
+import re
+import socket
+import sys
+
+SEVERITIES = ["emerg", "alert", "crit", "err", "warning", "notice", "info", "debug"]
+HEADER = re.compile(r"^<(\d{1,3})>1 (\S+) (\S+) (\S+) (\S+) (\S+) (\S+) ?(.*)$")
+
+
+def format_message(sender, line):
+    match = HEADER.match(line)
+    if not match:
+        return f"{sender} [unparsed] {line}"
+    pri, timestamp, host, app, _procid, _msgid, _sd, message = match.groups()
+    pri = int(pri)
+    severity = SEVERITIES[pri & 7]
+    facility = pri >> 3
+    return f"{sender} {timestamp} {host} {app}[{facility}] {severity:<7} {message}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--bind", default="0.0.0.0", help="address to listen on")
+    parser.add_argument("--port", type=int, default=5514, help="UDP port to listen on")
+    parser.add_argument("--raw", action="store_true", help="print messages undecoded")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind((args.bind, args.port))
+    print(f"Listening for syslog on {args.bind}:{args.port}", file=sys.stderr)
+
+    datagrams = 0
+    lines = 0
+    try:
+        while True:
+            data, (address, _port) = sock.recvfrom(2048)
+            datagrams += 1
+            for line in data.decode("utf-8", errors="replace").split("\n"):
+                if not line:
+                    continue
+                lines += 1
+                print(line if args.raw else format_message(address, line), flush=True)
+    except KeyboardInterrupt:
+        print(f"\n{datagrams} datagrams, {lines} messages", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""Receive webhook notifications from one or more SFS devices and print them.
+
+Stands in for a real webhook endpoint: each POST is printed with its event
+header and body, and bodies that are not valid JSON are flagged (a custom
+template may legitimately produce other content). Deliveries that repeat an
+Idempotency-Key already seen are marked as duplicates, which is what a
+retried notification looks like when an earlier attempt did get through.
+
+Failing and slow endpoints can be simulated to watch the device back off:
+
+    --fail-first 3     answer the first 3 deliveries of each key with --status
+    --status 503       status used for failures (default 500)
+    --delay 8          wait this many seconds before answering (the device
+                       gives up on a request after 5)
+
+Usage:
+    python tools/webhook_listener.py [--port 8080] [--bind 0.0.0.0]
+
+Point the device at it with the "Webhook Notifications" setting
+(http://<this machine>:<port>/) and press "Send test".
+"""
+
+import argparse
+import json
+import sys
+import time
+from collections import Counter
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+def make_handler(args):
+    attempts = Counter()
+
+    class Handler(BaseHTTPRequestHandler):
+        def do_POST(self):
+            length = int(self.headers.get("Content-Length", 0))
+            body = self.rfile.read(length).decode("utf-8", errors="replace")
+            key = self.headers.get("Idempotency-Key", "")
+            event = self.headers.get("X-SFS-Event", "?")
+            attempts[key] += 1
+
+            failing = attempts[key] <= args.fail_first
+            duplicate = not failing and attempts[key] > args.fail_first + 1
+            try:
+                payload = json.dumps(json.loads(body), separators=(",", ":"))
+                note = ""
+            except ValueError:
+                payload = body
+                note = " [not JSON]"
+
+            stamp = time.strftime("%H:%M:%S")
+            status = args.status if failing else 200
+            flags = f" attempt {attempts[key]}"
+            if failing:
+                flags += f" -> {status}"
+            if duplicate:
+                flags += " [duplicate]"
+            print(f"{stamp} {self.client_address[0]} {event} key={key}{flags}{note}", flush=True)
+            print(f"    {payload}", flush=True)
+
+            if args.delay > 0:
+                time.sleep(args.delay)
+            self.send_response(status)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+
+        def log_message(self, format, *log_args):
+            pass
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--bind", default="0.0.0.0", help="address to listen on")
+    parser.add_argument("--port", type=int, default=8080, help="HTTP port to listen on")
+    parser.add_argument("--fail-first", type=int, default=0,
+                        help="fail this many deliveries of each notification")
+    parser.add_argument("--status", type=int, default=500, help="status for failed deliveries")
+    parser.add_argument("--delay", type=float, default=0.0, help="seconds to wait before answering")
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer((args.bind, args.port), make_handler(args))
+    print(f"Listening for webhooks on http://{args.bind}:{args.port}/", file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        print("", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
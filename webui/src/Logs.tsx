@@ -6,10 +6,18 @@ interface LogEntry {
   message: string
 }
 
+// Filters are applied on the device (see parseLogFilter in WebServer.cpp)
+const CATEGORIES = ['general', 'flow', 'flow_summary', 'packet', 'telemetry_compare', 'deficit_reset']
+const LEVELS = ['error', 'warn', 'info', 'debug', 'verbose']
+
 function Logs() {
   const [loading, setLoading] = createSignal(true)
   const [logs, setLogs] = createSignal<LogEntry[]>([])
   const [error, setError] = createSignal('')
+  const [category, setCategory] = createSignal('')
+  const [level, setLevel] = createSignal('')
+  const [search, setSearch] = createSignal('')
+  const [lastMinutes, setLastMinutes] = createSignal(0)
   const [isAtBottom, setIsAtBottom] = createSignal(true)
   let intervalId: number | null = null
   let logContainerRef: HTMLDivElement | undefined
@@ -23,11 +31,24 @@ function Logs() {
     }
   }
 
+  const logQuery = (): string => {
+    const params = new URLSearchParams()
+    if (category()) params.set('category', category())
+    if (level()) params.set('level', level())
+    if (search()) params.set('q', search())
+    if (lastMinutes() > 0) {
+      params.set('from', Math.floor(Date.now() / 1000 - lastMinutes() * 60).toString())
+    }
+    const query = params.toString()
+    return query ? `?${query}` : ''
+  }
+
   const fetchLogs = async () => {
     try {
-      const response = await fetch('/api/logs_text')
+      const response = await fetch(`/api/logs_text${logQuery()}`)
       if (!response.ok) {
-        throw new Error(`Failed to fetch logs: ${response.status} ${response.statusText}`)
+        const detail = response.status === 400 ? await response.text() : response.statusText
+        throw new Error(`Failed to fetch logs: ${response.status} ${detail}`)
       }
       const text = await response.text()
       const parsedLogs = text
@@ -121,6 +142,29 @@ function Logs() {
       )}
 
 
+      <div class="mb-4 flex flex-wrap items-center gap-2 text-sm">
+        <select class="select select-sm select-bordered" value={category()}
+          onChange={(e) => { setCategory(e.currentTarget.value); fetchLogs() }}>
+          <option value="">All categories</option>
+          {CATEGORIES.map((name) => <option value={name}>{name}</option>)}
+        </select>
+        <select class="select select-sm select-bordered" value={level()}
+          onChange={(e) => { setLevel(e.currentTarget.value); fetchLogs() }}>
+          <option value="">All levels</option>
+          {LEVELS.map((name) => <option value={name}>{name} and above</option>)}
+        </select>
+        <select class="select select-sm select-bordered" value={lastMinutes()}
+          onChange={(e) => { setLastMinutes(parseInt(e.currentTarget.value, 10)); fetchLogs() }}>
+          <option value="0">Whole history</option>
+          <option value="15">Last 15 minutes</option>
+          <option value="60">Last hour</option>
+          <option value="1440">Last 24 hours</option>
+        </select>
+        <input class="input input-sm input-bordered" type="search" placeholder="Contains..."
+          maxLength={63} value={search()}
+          onChange={(e) => { setSearch(e.currentTarget.value); fetchLogs() }} />
+      </div>
+
       {loading() && logs().length === 0 ? (
         <p><span class="loading loading-spinner loading-xl"></span></p>
       ) : (
@@ -139,9 +183,14 @@ function Logs() {
 
       <div class="mt-4 flex items-center justify-between flex-wrap gap-2 text-sm text-base-content/70">
         <p>Logs are automatically refreshed every 5 seconds.</p>
-        <a class="btn btn-xs btn-outline btn-primary" href="/api/logs_text" download="sfs-logs.txt">
-          Download full log
-        </a>
+        <div class="flex gap-2">
+          <a class="btn btn-xs btn-outline btn-primary" href="/api/logs_text" download="sfs-logs.txt">
+            Download full log
+          </a>
+          <a class="btn btn-xs btn-outline" href="/api/logs_previous" download="sfs-logs-previous-boot.txt">
+            Download previous boot log
+          </a>
+        </div>
       </div>
     </div>
   )
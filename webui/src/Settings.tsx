@@ -1,4 +1,23 @@
-import { createSignal, onMount } from 'solid-js'
+import { createSignal, Index, onMount } from 'solid-js'
+
+type DetectionProfile = {
+  name: string
+  match: string
+  expected_deficit_mm: number
+  expected_flow_window_ms: number
+  movement_mm_per_pulse: number
+}
+
+const MAX_DETECTION_PROFILES = 6
+
+// NOTIFY_BIT() values from NotifyQueue.h
+const NOTIFY_EVENTS = [
+  { bit: 1 << 0, label: 'Filament jam' },
+  { bit: 1 << 1, label: 'Filament runout' },
+  { bit: 1 << 2, label: 'Printer connection lost while printing' },
+  { bit: 1 << 3, label: 'Print complete' },
+]
+const NOTIFY_DEFAULT_EVENTS = 0b1111
 
 function Settings() {
   const [ssid, setSsid] = createSignal('')
@@ -12,14 +31,29 @@ function Settings() {
   const [saveSuccess, setSaveSuccess] = createSignal(false)
   const [apMode, setApMode] = createSignal<boolean | null>(null);
   const [pauseOnRunout, setPauseOnRunout] = createSignal(true);
+  const [pauseEscalation, setPauseEscalation] = createSignal(true);
+  const [pauseEscalationStop, setPauseEscalationStop] = createSignal(false);
   const [enabled, setEnabled] = createSignal(true);
   const [sdcpLossBehavior, setSdcpLossBehavior] = createSignal(2);
   const [devMode, setDevMode] = createSignal(false);
   const [verboseLogging, setVerboseLogging] = createSignal(false);
   const [flowSummaryLogging, setFlowSummaryLogging] = createSignal(false);
+  const [flashLogging, setFlashLogging] = createSignal(false);
+  const [syslogHost, setSyslogHost] = createSignal('')
+  const [wifiStaticIp, setWifiStaticIp] = createSignal('')
+  const [wifiGateway, setWifiGateway] = createSignal('')
+  const [wifiSubnet, setWifiSubnet] = createSignal('')
+  const [wifiDns, setWifiDns] = createSignal('')
+  const [syslogPort, setSyslogPort] = createSignal(514)
+  const [syslogLevel, setSyslogLevel] = createSignal(2)
+  const [notifyUrl, setNotifyUrl] = createSignal('')
+  const [notifyTemplate, setNotifyTemplate] = createSignal('')
+  const [notifyEvents, setNotifyEvents] = createSignal(NOTIFY_DEFAULT_EVENTS)
+  const [notifyTestStatus, setNotifyTestStatus] = createSignal('')
   const [discovering, setDiscovering] = createSignal(false);
   const [discoverSuccess, setDiscoverSuccess] = createSignal(false);
   const [movementPerPulse, setMovementPerPulse] = createSignal(1.5)
+  const [movementMinEdgeUs, setMovementMinEdgeUs] = createSignal(2000)
   const [flowTelemetryStaleMs, setFlowTelemetryStaleMs] = createSignal(1000)
   const [uiRefreshIntervalMs, setUiRefreshIntervalMs] = createSignal(1000)
   const [zeroDeficitLogging, setZeroDeficitLogging] = createSignal(false)
@@ -27,6 +61,9 @@ function Settings() {
   const [packetFlowLogging, setPacketFlowLogging] = createSignal(false)
   const [useTotalExtrusionDeficit, setUseTotalExtrusionDeficit] = createSignal(false)
   const [useTotalExtrusionBacklog, setUseTotalExtrusionBacklog] = createSignal(false)
+  const [detectionProfile, setDetectionProfile] = createSignal('')
+  const [detectionProfiles, setDetectionProfiles] = createSignal<DetectionProfile[]>([])
+  const [hostname, setHostname] = createSignal('ccxsfs20')
   // Load settings from the server and scan for WiFi networks
   onMount(async () => {
     try {
@@ -46,6 +83,8 @@ function Settings() {
       setStartPrintTimeout(settings.start_print_timeout || 10000)
       setApMode(settings.ap_mode || null)
       setPauseOnRunout(settings.pause_on_runout !== undefined ? settings.pause_on_runout : true)
+      setPauseEscalation(settings.pause_escalation !== undefined ? settings.pause_escalation : true)
+      setPauseEscalationStop(settings.pause_escalation_stop || false)
       setEnabled(settings.enabled !== undefined ? settings.enabled : true)
       setExpectedDeficit(settings.expected_deficit_mm !== undefined ? settings.expected_deficit_mm : 8.4)
       setExpectedWindow(settings.expected_flow_window_ms !== undefined ? settings.expected_flow_window_ms : 1500)
@@ -53,7 +92,19 @@ function Settings() {
       setDevMode(settings.dev_mode !== undefined ? settings.dev_mode : false)
       setVerboseLogging(settings.verbose_logging !== undefined ? settings.verbose_logging : false)
       setFlowSummaryLogging(settings.flow_summary_logging !== undefined ? settings.flow_summary_logging : false)
+      setFlashLogging(settings.flash_logging !== undefined ? settings.flash_logging : false)
+      setSyslogHost(settings.syslog_host || '')
+      setWifiStaticIp(settings.wifi_static_ip || '')
+      setWifiGateway(settings.wifi_gateway || '')
+      setWifiSubnet(settings.wifi_subnet || '')
+      setWifiDns(settings.wifi_dns || '')
+      setSyslogPort(settings.syslog_port !== undefined ? settings.syslog_port : 514)
+      setSyslogLevel(settings.syslog_level !== undefined ? settings.syslog_level : 2)
+      setNotifyUrl(settings.notify_url || '')
+      setNotifyTemplate(settings.notify_template || '')
+      setNotifyEvents(settings.notify_events !== undefined ? settings.notify_events : NOTIFY_DEFAULT_EVENTS)
       setMovementPerPulse(settings.movement_mm_per_pulse !== undefined ? settings.movement_mm_per_pulse : 1.5)
+      setMovementMinEdgeUs(settings.movement_min_edge_us !== undefined ? settings.movement_min_edge_us : 2000)
       setFlowTelemetryStaleMs(settings.flow_telemetry_stale_ms !== undefined ? settings.flow_telemetry_stale_ms : 1000)
       setUiRefreshIntervalMs(settings.ui_refresh_interval_ms !== undefined ? settings.ui_refresh_interval_ms : 1000)
       setZeroDeficitLogging(settings.zero_deficit_logging !== undefined ? settings.zero_deficit_logging : false)
@@ -61,6 +112,15 @@ function Settings() {
       setPacketFlowLogging(settings.packet_flow_logging !== undefined ? settings.packet_flow_logging : false)
       setUseTotalExtrusionDeficit(settings.use_total_extrusion_deficit !== undefined ? settings.use_total_extrusion_deficit : false)
       setUseTotalExtrusionBacklog(settings.use_total_extrusion_backlog !== undefined ? settings.use_total_extrusion_backlog : false)
+      setDetectionProfile(settings.detection_profile || '')
+      setDetectionProfiles(settings.detection_profiles || [])
+
+      // Each device advertises its own mDNS name (ccxsfs20-xxxx)
+      const versionResponse = await fetch('/version')
+      if (versionResponse.ok) {
+        const version = await versionResponse.json()
+        setHostname(version.hostname || 'ccxsfs20')
+      }
 
       setError('')
     } catch (err: any) {
@@ -83,6 +143,8 @@ function Settings() {
         ap_mode: false,
         elegooip: elegooip(),
         pause_on_runout: pauseOnRunout(),
+        pause_escalation: pauseEscalation(),
+        pause_escalation_stop: pauseEscalationStop(),
         start_print_timeout: startPrintTimeout(),
         enabled: enabled(),
         expected_deficit_mm: expectedDeficit(),
@@ -98,7 +160,21 @@ function Settings() {
         dev_mode: devMode(),
         verbose_logging: verboseLogging(),
         flow_summary_logging: flowSummaryLogging(),
+        flash_logging: flashLogging(),
+        syslog_host: syslogHost(),
+        wifi_static_ip: wifiStaticIp(),
+        wifi_gateway: wifiGateway(),
+        wifi_subnet: wifiSubnet(),
+        wifi_dns: wifiDns(),
+        syslog_port: syslogPort(),
+        syslog_level: syslogLevel(),
+        notify_url: notifyUrl(),
+        notify_template: notifyTemplate(),
+        notify_events: notifyEvents(),
         movement_mm_per_pulse: movementPerPulse(),
+        movement_min_edge_us: movementMinEdgeUs(),
+        detection_profile: detectionProfile(),
+        detection_profiles: detectionProfiles().filter((p) => p.name.trim() !== ''),
       }
 
       const response = await fetch('/update_settings', {
@@ -120,6 +196,42 @@ function Settings() {
       console.error('Failed to save settings:', err)
     }
   }
+  const toggleNotifyEvent = (bit: number, on: boolean) => {
+    setNotifyEvents(on ? notifyEvents() | bit : notifyEvents() & ~bit)
+  }
+
+  // Queues a test event on the device; save first so it uses the current URL
+  const sendTestNotification = async () => {
+    try {
+      const response = await fetch('/api/notify/test', { method: 'POST' })
+      setNotifyTestStatus(response.ok ? 'Test notification queued' : await response.text())
+    } catch (err: any) {
+      setNotifyTestStatus(`Error: ${err.message || 'Unknown error'}`)
+    }
+    setTimeout(() => setNotifyTestStatus(''), 5000)
+  }
+
+  const updateProfile = (index: number, changes: Partial<DetectionProfile>) => {
+    setDetectionProfiles(detectionProfiles().map((p, i) => (i === index ? { ...p, ...changes } : p)))
+  }
+
+  const addProfile = () => {
+    setDetectionProfiles([
+      ...detectionProfiles(),
+      {
+        name: '',
+        match: '',
+        expected_deficit_mm: expectedDeficit(),
+        expected_flow_window_ms: expectedWindow(),
+        movement_mm_per_pulse: movementPerPulse(),
+      },
+    ])
+  }
+
+  const removeProfile = (index: number) => {
+    setDetectionProfiles(detectionProfiles().filter((_, i) => i !== index))
+  }
+
   const handleDiscover = async () => {
     try {
       setDiscoverSuccess(false)
@@ -198,8 +310,8 @@ function Settings() {
 
 
               <div role="alert" class="mt-4 alert alert-info alert-soft">
-                <span>Note: after changing the wifi network you may need to enter a new IP address to get to this device. If the wifi connection fails, the device will revert to AP mode and you can reconnect by connecting to the Wifi network named ElegooXBTTSFS20. If your network supports MDNS discovery you can also find this device at <a class="link link-accent" href="http://ccxsfs20.local">
-                  ccxsfs20.local</a></span>
+                <span>Note: after changing the wifi network you may need to enter a new IP address to get to this device. If the wifi connection fails, the device will revert to AP mode and you can reconnect by connecting to the Wifi network named ElegooXBTTSFS20. If your network supports MDNS discovery you can also find this device at <a class="link link-accent" href={`http://${hostname()}.local`}>
+                  {hostname()}.local</a></span>
               </div>
             </div>
           )
@@ -210,6 +322,45 @@ function Settings() {
             )
           }
 
+          <fieldset class="fieldset mt-4">
+            <legend class="fieldset-legend">Static IP (optional)</legend>
+            <input
+              type="text"
+              id="wifiStaticIp"
+              value={wifiStaticIp()}
+              onInput={(e) => setWifiStaticIp(e.target.value)}
+              placeholder="IP address (empty for DHCP)"
+              class="input"
+            />
+            <input
+              type="text"
+              id="wifiGateway"
+              value={wifiGateway()}
+              onInput={(e) => setWifiGateway(e.target.value)}
+              placeholder="Gateway"
+              class="input mt-2"
+            />
+            <input
+              type="text"
+              id="wifiSubnet"
+              value={wifiSubnet()}
+              onInput={(e) => setWifiSubnet(e.target.value)}
+              placeholder="Subnet mask, e.g. 255.255.255.0"
+              class="input mt-2"
+            />
+            <input
+              type="text"
+              id="wifiDns"
+              value={wifiDns()}
+              onInput={(e) => setWifiDns(e.target.value)}
+              placeholder="DNS (empty uses the gateway)"
+              class="input mt-2"
+            />
+            <p class="label">
+              Skips DHCP so the device is back online faster after a reboot or drop. Pick an address outside your router's DHCP pool.
+            </p>
+          </fieldset>
+
           <h2 class="text-lg font-bold mb-4 mt-10">Device Settings</h2>
 
 
@@ -287,6 +438,102 @@ function Settings() {
             </p>
           </fieldset>
 
+          <fieldset class="fieldset">
+            <legend class="fieldset-legend">Minimum Sensor Edge Interval (µs)</legend>
+            <input
+              type="number"
+              id="movementMinEdgeUs"
+              value={movementMinEdgeUs()}
+              onInput={(e) => setMovementMinEdgeUs(parseInt(e.target.value) || 0)}
+              min="0"
+              max="20000"
+              step="100"
+              class="input"
+            />
+            <p class="label">
+              Sensor edges that follow the previous one faster than this are treated as contact bounce and not counted as movement. 0 counts every edge.
+            </p>
+          </fieldset>
+
+          <fieldset class="fieldset">
+            <legend class="fieldset-legend">Detection Profiles</legend>
+            <select
+              id="detectionProfile"
+              class="select"
+              value={detectionProfile()}
+              onChange={(e) => setDetectionProfile(e.target.value)}
+            >
+              <option value="">Pick by job filename</option>
+              <option value="default">Always use the values above</option>
+              <Index each={detectionProfiles()}>
+                {(profile) => <option value={profile().name}>Always use {profile().name}</option>}
+              </Index>
+            </select>
+            <Index each={detectionProfiles()}>
+              {(profile, i) => (
+                <div class="grid grid-cols-6 gap-2 mt-2 items-center">
+                  <input
+                    type="text"
+                    value={profile().name}
+                    onInput={(e) => updateProfile(i, { name: e.target.value })}
+                    maxlength="15"
+                    placeholder="Name"
+                    class="input"
+                  />
+                  <input
+                    type="text"
+                    value={profile().match}
+                    onInput={(e) => updateProfile(i, { match: e.target.value })}
+                    maxlength="31"
+                    placeholder="tpu|tpe"
+                    class="input"
+                  />
+                  <input
+                    type="number"
+                    value={profile().expected_deficit_mm}
+                    onInput={(e) => updateProfile(i, { expected_deficit_mm: parseFloat(e.target.value) || 0 })}
+                    min="1"
+                    max="100"
+                    step="0.1"
+                    title="Expected deficit threshold (mm)"
+                    class="input"
+                  />
+                  <input
+                    type="number"
+                    value={profile().expected_flow_window_ms}
+                    onInput={(e) => updateProfile(i, { expected_flow_window_ms: parseInt(e.target.value) || 0 })}
+                    min="250"
+                    max="5000"
+                    step="250"
+                    title="Expected flow window (ms)"
+                    class="input"
+                  />
+                  <input
+                    type="number"
+                    value={profile().movement_mm_per_pulse}
+                    onInput={(e) => updateProfile(i, { movement_mm_per_pulse: parseFloat(e.target.value) || 0 })}
+                    min="0.1"
+                    max="10"
+                    step="0.01"
+                    title="Filament movement per pulse (mm)"
+                    class="input"
+                  />
+                  <button class="btn btn-soft" onClick={() => removeProfile(i)}>Remove</button>
+                </div>
+              )}
+            </Index>
+            <button
+              class="btn btn-soft mt-2"
+              disabled={detectionProfiles().length >= MAX_DETECTION_PROFILES}
+              onClick={addProfile}
+            >
+              Add Profile
+            </button>
+            <p class="label">
+              Per-material deficit threshold (mm), flow window (ms) and mm per pulse. When a print starts, the first profile whose pattern (|-separated, case-insensitive) appears in the job filename is used; otherwise the values above apply.
+            </p>
+          </fieldset>
+
           <fieldset class="fieldset">
             <legend class="fieldset-legend">Start Print Timeout</legend>
             <input
@@ -317,6 +564,31 @@ function Settings() {
             </label>
           </fieldset>
 
+          <fieldset class="fieldset">
+            <legend class="fieldset-legend">Escalate Ignored Pauses</legend>
+            <label class="label cursor-pointer">
+              <input
+                type="checkbox"
+                id="pauseEscalation"
+                checked={pauseEscalation()}
+                onChange={(e) => setPauseEscalation(e.target.checked)}
+                class="checkbox checkbox-accent"
+              />
+              <span class="label-text">If the printer keeps extruding after a pause, pause again</span>
+            </label>
+            <label class="label cursor-pointer">
+              <input
+                type="checkbox"
+                id="pauseEscalationStop"
+                checked={pauseEscalationStop()}
+                disabled={!pauseEscalation()}
+                onChange={(e) => setPauseEscalationStop(e.target.checked)}
+                class="checkbox checkbox-accent"
+              />
+              <span class="label-text">If that does not take either, stop feeding and then stop the print</span>
+            </label>
+          </fieldset>
+
           <fieldset class="fieldset">
             <legend class="fieldset-legend">Behavior when SDCP replies are lost</legend>
             <select
@@ -486,6 +758,98 @@ function Settings() {
             </label>
           </fieldset>
 
+          <fieldset class="fieldset">
+            <legend class="fieldset-legend">Keep Logs Across Reboots</legend>
+            <label class="label cursor-pointer">
+              <input
+                type="checkbox"
+                id="flashLogging"
+                checked={flashLogging()}
+                onChange={(e) => setFlashLogging(e.target.checked)}
+                class="checkbox checkbox-accent"
+              />
+              <span class="label-text">When enabled, logs are also written to flash in 4 KB batches so the log leading up to a crash or power loss can be downloaded after the next boot. Applies as soon as settings are saved.</span>
+            </label>
+          </fieldset>
+
+          <fieldset class="fieldset">
+            <legend class="fieldset-legend">Remote Syslog Server</legend>
+            <input
+              type="text"
+              id="syslogHost"
+              value={syslogHost()}
+              onInput={(e) => setSyslogHost(e.target.value)}
+              placeholder="host or IP (empty to disable)"
+              class="input"
+            />
+            <input
+              type="number"
+              id="syslogPort"
+              value={syslogPort()}
+              onInput={(e) => setSyslogPort(parseInt(e.target.value) || 514)}
+              min="1"
+              max="65535"
+              class="input mt-2"
+            />
+            <select
+              id="syslogLevel"
+              class="select mt-2"
+              value={syslogLevel()}
+              onChange={(e) => setSyslogLevel(parseInt(e.target.value))}
+            >
+              <option value={0}>Errors only</option>
+              <option value={1}>Warnings and errors</option>
+              <option value={2}>Info</option>
+              <option value={3}>Debug</option>
+              <option value={4}>Verbose</option>
+            </select>
+            <p class="label">
+              Ships logs as RFC 5424 syslog over UDP, several lines per datagram. Use tools/syslog_listener.py to receive them locally.
+            </p>
+          </fieldset>
+
+          <fieldset class="fieldset">
+            <legend class="fieldset-legend">Webhook Notifications</legend>
+            <input
+              type="text"
+              id="notifyUrl"
+              value={notifyUrl()}
+              onInput={(e) => setNotifyUrl(e.target.value)}
+              placeholder="http://host:port/path (empty to disable)"
+              maxLength={159}
+              class="input"
+            />
+            {NOTIFY_EVENTS.map((event) => (
+              <label class="label cursor-pointer">
+                <input
+                  type="checkbox"
+                  checked={(notifyEvents() & event.bit) !== 0}
+                  onChange={(e) => toggleNotifyEvent(event.bit, e.target.checked)}
+                  class="checkbox checkbox-accent"
+                />
+                <span class="label-text">{event.label}</span>
+              </label>
+            ))}
+            <textarea
+              id="notifyTemplate"
+              value={notifyTemplate()}
+              onInput={(e) => setNotifyTemplate(e.target.value)}
+              placeholder="Body template (empty for the default JSON)"
+              maxLength={511}
+              rows={3}
+              class="textarea mt-2 font-mono"
+            />
+            <p class="label">
+              {'Placeholders: {{event}} {{message}} {{device}} {{time}} {{deficit}} {{layer}} {{id}}. Failed posts are retried with backoff; use tools/webhook_listener.py to receive them locally.'}
+            </p>
+            <div class="flex items-center gap-2">
+              <button class="btn btn-sm btn-outline" onClick={sendTestNotification}>
+                Send test
+              </button>
+              <span class="text-sm">{notifyTestStatus()}</span>
+            </div>
+          </fieldset>
+
           <fieldset class="fieldset">
             <legend class="fieldset-legend">Enabled</legend>
             <label class="label cursor-pointer">
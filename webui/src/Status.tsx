@@ -49,6 +49,7 @@ function Status() {
       movementPulses: 0,
       uiRefreshIntervalMs: 1000,
       flowTelemetryStaleMs: 1000,
+      detectionProfile: 'default',
     }
   })
 
@@ -188,6 +189,10 @@ function Status() {
                   <h3 class="font-bold">Movement Pulses</h3>
                   <p>{sensorStatus().elegoo.movementPulses}</p>
                 </div>
+                <div>
+                  <h3 class="font-bold">Detection Profile</h3>
+                  <p>{sensorStatus().elegoo.detectionProfile}</p>
+                </div>
               </div>
 
               <div class="divider mt-4 mb-2"></div>